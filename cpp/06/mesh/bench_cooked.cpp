@@ -0,0 +1,84 @@
+// Compares parsing a text .obj against loading its cooked .mesh.
+//
+// Usage: ./bin/bench_cooked [directory]
+//        Run ./bin/cooker first so that the .mesh files exist.
+//
+// 'cooked load' maps the file, validates it (every index included) and copies
+// the vertex and index blobs out, which is the same amount of work
+// glBufferData does when it uploads them.
+
+#include "mesh.hpp"
+#include "meshfile.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cstring>
+
+// Best of a few runs, in milliseconds
+template<typename Function>
+double TimeBestOf(int runs, Function function){
+    double best = 1e30;
+    for(int i=0; i < runs; ++i){
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double,std::milli>(end-start).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv){
+    std::filesystem::path directory = argc > 1 ? argv[1] : "./../../common/objects";
+
+    std::cout << std::left << std::setw(40) << "asset"
+              << std::right << std::setw(12) << "text (ms)"
+              << std::setw(14) << "cooked (ms)"
+              << std::setw(10) << "speedup" << std::endl;
+
+    std::vector<char> staging;
+    for(const auto& entry : std::filesystem::recursive_directory_iterator(directory)){
+        if(!entry.is_regular_file() || entry.path().extension() != ".obj"){
+            continue;
+        }
+        std::filesystem::path cookedPath = entry.path();
+        cookedPath.replace_extension(".mesh");
+        if(!std::filesystem::exists(cookedPath)){
+            std::cout << entry.path().string() << ": not cooked, run ./bin/cooker first" << std::endl;
+            continue;
+        }
+
+        // One untimed load first, so that any warnings about the .obj
+        // (e.g. a missing .mtl) are printed once. The timed loads run with
+        // std::cout silenced, so printing is not part of what is measured.
+        const unsigned int triangles = Mesh(entry.path().string()).GetTriangleCount();
+        std::streambuf* console = std::cout.rdbuf(nullptr);
+        double text = TimeBestOf(5, [&](){
+            Mesh mesh(entry.path().string());
+        });
+        std::cout.rdbuf(console);
+
+        double cooked = TimeBestOf(5, [&](){
+            MeshFile file;
+            if(!file.Open(cookedPath.string())){
+                return;
+            }
+            uint64_t vertexBytes = file.GetVertexDataSizeInBytes();
+            uint64_t indexBytes  = (uint64_t)file.GetIndexCount()*sizeof(uint32_t);
+            staging.resize(vertexBytes + indexBytes);
+            std::memcpy(staging.data(), file.GetVertexData(), vertexBytes);
+            std::memcpy(staging.data()+vertexBytes, file.GetIndexData(), indexBytes);
+        });
+
+        std::string name = std::filesystem::relative(entry.path(), directory).string();
+        std::cout << std::left << std::setw(40) << name
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << text
+                  << std::setw(14) << cooked
+                  << std::setw(9) << std::setprecision(1) << text/cooked << "x"
+                  << "   (" << triangles << " triangles)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Measures .obj parsing throughput (MB/s) for every .obj file
+// under a directory.
+//
+// Usage: ./bin/bench_obj [directory] [runs]
+//        directory defaults to ./../../common/objects
+//
+// Afterwards the larger files are loaded again with 1, 2, 4 and 8
+// threads, and each result is checked against the single threaded one.
+
+#include "mesh.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+
+// Best of several runs in seconds, so we measure the parser and not a cold page cache
+template<typename Function>
+double TimeBestOf(int runs, Function function){
+    double best = 1e30;
+    for(int i=0; i < runs; ++i){
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end-start).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv){
+    std::filesystem::path directory = argc > 1 ? argv[1] : "./../../common/objects";
+    int runs = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    std::cout << std::left << std::setw(40) << "asset"
+              << std::right << std::setw(10) << "KB"
+              << std::setw(10) << "ms"
+              << std::setw(10) << "MB/s"
+              << std::setw(12) << "vertices"
+              << std::setw(12) << "triangles" << std::endl;
+
+    double totalBytes = 0.0, totalSeconds = 0.0;
+    for(const auto& entry : std::filesystem::recursive_directory_iterator(directory)){
+        if(!entry.is_regular_file() || entry.path().extension() != ".obj"){
+            continue;
+        }
+        double bytes = (double)entry.file_size();
+
+        unsigned int vertices = 0, triangles = 0;
+        double best = TimeBestOf(runs, [&](){
+            Mesh mesh(entry.path().string());
+            vertices = mesh.GetVertexCount();
+            triangles = mesh.GetTriangleCount();
+        });
+        totalBytes += bytes;
+        totalSeconds += best;
+
+        std::string name = std::filesystem::relative(entry.path(), directory).string();
+        std::cout << std::left << std::setw(40) << name
+                  << std::right << std::fixed
+                  << std::setw(10) << std::setprecision(0) << bytes/1024.0
+                  << std::setw(10) << std::setprecision(3) << best*1000.0
+                  << std::setw(10) << std::setprecision(1) << bytes/(1024.0*1024.0)/best
+                  << std::setw(12) << vertices
+                  << std::setw(12) << triangles << std::endl;
+    }
+    std::cout << "total: " << std::fixed << std::setprecision(1)
+              << totalBytes/(1024.0*1024.0) << " MB in " << totalSeconds*1000.0 << " ms = "
+              << totalBytes/(1024.0*1024.0)/totalSeconds << " MB/s" << std::endl;
+
+    // Thread scaling. Small files are not split up, see Mesh::Mesh
+    const unsigned int threadCounts[] = {1,2,4,8};
+    std::cout << std::endl << "threads (hardware: " << std::thread::hardware_concurrency() << ")" << std::endl;
+    std::cout << std::left << std::setw(40) << "asset" << std::right;
+    for(unsigned int threads : threadCounts){
+        std::cout << std::setw(9) << threads << "t";
+    }
+    std::cout << "   identical" << std::endl;
+
+    bool allIdentical = true;
+    for(const auto& entry : std::filesystem::recursive_directory_iterator(directory)){
+        if(!entry.is_regular_file() || entry.path().extension() != ".obj" || entry.file_size() < 512*1024){
+            continue;
+        }
+        Mesh reference(entry.path().string());
+        std::string name = std::filesystem::relative(entry.path(), directory).string();
+        std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3);
+
+        bool identical = true;
+        for(unsigned int threads : threadCounts){
+            double best = TimeBestOf(runs, [&](){
+                Mesh mesh(entry.path().string(), threads);
+                identical = identical && mesh.vertices == reference.vertices && mesh.indices == reference.indices;
+            });
+            std::cout << std::setw(8) << best*1000.0 << "ms";
+        }
+        std::cout << "   " << (identical ? "yes" : "NO") << std::endl;
+        allIdentical = allIdentical && identical;
+    }
+    return allIdentical ? 0 : 1;
+}
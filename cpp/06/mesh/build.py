@@ -0,0 +1,50 @@
+# Run with: python3 build.py
+import os
+import platform
+
+# (1)==================== COMMON CONFIGURATION OPTIONS ======================= #
+COMPILER="g++ -O2 -g -std=c++20" # The compiler we want to use
+                                #(Optimizations are on, as we are benchmarking)
+# Source files shared by every program
+SOURCE="./mesh.cpp ./material.cpp ./meshfile.cpp ./mappedfile.cpp"
+# Each program has its own file containing 'main'
+#   main         - loads an .obj and prints its vertices, triangles and materials
+#   cooker       - converts every .obj in common/objects to a cooked .mesh
+#   bench_cooked - times parsing an .obj against loading the cooked .mesh
+#   bench_obj    - .obj parsing throughput in MB/s
+PROGRAMS=["main","cooker","bench_cooked","bench_obj"]
+OUTPUT_DIR="./bin/"             # Where the executables are placed
+# ======================= COMMON CONFIGURATION OPTIONS ======================= #
+
+# (2)=================== Platform specific configuration ===================== #
+# For each platform we need to set the following items
+ARGUMENTS=""            # Arguments needed for our program (Add others as you see fit)
+INCLUDE_DIR="-I ./"     # Which directories do we want to include.
+LIBRARIES=""            # What libraries do we want to include
+EXTENSION=""            # File extension of the executable
+
+if platform.system()=="Linux":
+    ARGUMENTS="-D LINUX" # -D is a #define sent to preprocessor
+    LIBRARIES="-lpthread"
+elif platform.system()=="Darwin":
+    ARGUMENTS="-D MAC" # -D is a #define sent to the preprocessor.
+elif platform.system()=="Windows":
+    ARGUMENTS="-D MINGW -static-libgcc -static-libstdc++"
+    EXTENSION=".exe"
+# (2)=================== Platform specific configuration ===================== #
+
+# (3)====================== Building the Executables ========================= #
+print("===============================================================================")
+print("====================== Compiling on: "+platform.system()+" =============================")
+print("===============================================================================")
+if not os.path.isdir(OUTPUT_DIR):
+    os.makedirs(OUTPUT_DIR)
+
+exit_code = 0
+for program in PROGRAMS:
+    compileString=COMPILER+" "+ARGUMENTS+" ./"+program+".cpp "+SOURCE+" -o "+OUTPUT_DIR+program+EXTENSION+" "+INCLUDE_DIR+" "+LIBRARIES
+    print(compileString)
+    if os.system(compileString) != 0:
+        exit_code = 1
+exit(exit_code)
+# ========================= Building the Executables ========================= #
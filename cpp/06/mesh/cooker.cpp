@@ -0,0 +1,78 @@
+// The mesh 'cooker' converts every .obj file found under a directory
+// into the cooked .mesh format (see meshfile.hpp). The .mesh file is
+// written next to the .obj it came from.
+//
+// Usage: ./bin/cooker [directory] [--force]
+//        directory defaults to ./../../common/objects
+//        --force re-cooks meshes that are already up to date
+
+#include "mesh.hpp"
+#include "meshfile.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <chrono>
+
+int main(int argc, char** argv){
+    std::filesystem::path directory = "./../../common/objects";
+    bool force = false;
+    for(int i=1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--force"){
+            force = true;
+        }else{
+            directory = arg;
+        }
+    }
+
+    if(!std::filesystem::is_directory(directory)){
+        std::cout << "cooker: " << directory << " is not a directory" << std::endl;
+        return 1;
+    }
+
+    int cooked = 0, skipped = 0, failed = 0;
+    for(const auto& entry : std::filesystem::recursive_directory_iterator(directory)){
+        if(!entry.is_regular_file() || entry.path().extension() != ".obj"){
+            continue;
+        }
+        std::filesystem::path source = entry.path();
+        std::filesystem::path target = source;
+        target.replace_extension(".mesh");
+
+        // Only re-cook if the source changed since we last cooked it
+        if(!force && std::filesystem::exists(target) &&
+           std::filesystem::last_write_time(target) >= std::filesystem::last_write_time(source)){
+            ++skipped;
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Mesh mesh(source.string());
+        if(mesh.GetTriangleCount() == 0){
+            std::cout << "cooker: no triangles in " << source << std::endl;
+            ++failed;
+            continue;
+        }
+        if(!WriteMeshFile(target.string(), mesh)){
+            ++failed;
+            continue;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        MeshFile check;
+        check.Open(target.string());
+        std::cout << "cooked " << source.string() << " -> " << target.filename().string()
+                  << " (" << mesh.GetVertexCount() << " vertices, "
+                  << mesh.GetTriangleCount() << " triangles, "
+                  << mesh.materials.size() << " materials, "
+                  << check.GetHeader().lodCount << " LODs, "
+                  << check.GetHeader().meshletCount << " meshlets, "
+                  << std::chrono::duration<double,std::milli>(end-start).count() << " ms)" << std::endl;
+        ++cooked;
+    }
+
+    std::cout << "cooker: " << cooked << " cooked, " << skipped << " up to date, "
+              << failed << " failed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -1,9 +1,30 @@
-// include SDL, GLM, etc.
-// Setup SDL, OpengL, etc.
+// Loads a Wavefront .obj and prints what the loader made of it.
+//
+// Usage: ./bin/main [file.obj]
+//        file defaults to ./../../common/objects/cube.obj
 
 #include "mesh.hpp"
 
-int main(){
+#include <iostream>
+#include <string>
 
+int main(int argc, char** argv){
+    std::string filename = argc > 1 ? argv[1] : "./../../common/objects/cube.obj";
 
+    Mesh mesh(filename);
+    std::cout << filename << ": " << mesh.GetVertexCount() << " vertices, "
+              << mesh.GetTriangleCount() << " triangles" << std::endl;
+    std::cout << "bounds: (" << mesh.boundsMin[0] << ", " << mesh.boundsMin[1] << ", " << mesh.boundsMin[2] << ") to ("
+              << mesh.boundsMax[0] << ", " << mesh.boundsMax[1] << ", " << mesh.boundsMax[2] << ")" << std::endl;
+
+    // One draw per subset
+    for(const MeshSubset& subset : mesh.subsets){
+        const Material& material = mesh.materials[subset.material];
+        std::cout << "  " << material.name << ": " << subset.indexCount/3 << " triangles";
+        if(!material.diffuseMap.empty()){
+            std::cout << ", diffuse map " << material.diffuseMap;
+        }
+        std::cout << std::endl;
+    }
+    return 0;
 }
@@ -0,0 +1,104 @@
+#include "mappedfile.hpp"
+
+#include <fstream>
+#include <utility>
+
+#if defined(LINUX) || defined(MAC)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+static MappedFile::OpenHook s_openHook;
+
+void MappedFile::SetOpenHook(OpenHook hook){
+    s_openHook = std::move(hook);
+}
+
+MappedFile::MappedFile(){
+}
+
+MappedFile::~MappedFile(){
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept{
+    if(this != &other){
+        Close();
+        m_fallback = std::move(other.m_fallback);
+        m_size = other.m_size;
+        m_mapped = other.m_mapped;
+        // The fallback buffer moved with us, so point at our own copy
+        m_data = m_fallback.empty() ? other.m_data : m_fallback.data();
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_mapped = false;
+    }
+    return *this;
+}
+
+bool MappedFile::Open(const std::string& filename){
+    Close();
+    if(s_openHook && s_openHook(filename, m_fallback, m_data, m_size)){
+        return true;
+    }
+#if defined(LINUX) || defined(MAC)
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0){
+        close(fd);
+        return false;
+    }
+    m_size = static_cast<std::size_t>(info.st_size);
+    if(m_size == 0){
+        // mmap refuses zero length mappings, an empty file is
+        // still a valid (empty) file though.
+        close(fd);
+        m_data = "";
+        return true;
+    }
+    void* ptr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if(ptr == MAP_FAILED){
+        m_size = 0;
+        return false;
+    }
+    // We read files front to back
+    madvise(ptr, m_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const char*>(ptr);
+    m_mapped = true;
+    return true;
+#else
+    std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+    if(!file.is_open()){
+        return false;
+    }
+    m_size = static_cast<std::size_t>(file.tellg());
+    file.seekg(0);
+    m_fallback.resize(m_size + 1, '\0');
+    file.read(m_fallback.data(), m_size);
+    m_data = m_fallback.data();
+    return true;
+#endif
+}
+
+void MappedFile::Close(){
+#if defined(LINUX) || defined(MAC)
+    if(m_mapped){
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_mapped = false;
+    m_fallback.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,50 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+// A read-only view of an entire file.
+// On Linux and Mac the file is memory mapped, so opening
+// a file does not copy anything -- pages are brought in by the
+// operating system as we touch them.
+// On Windows (MINGW) we fall back to reading the file into memory.
+class MappedFile{
+public:
+    MappedFile();
+    ~MappedFile();
+    // A mapping owns its memory, so it can be moved but not copied
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Map a file. Returns false if the file could not be opened.
+    bool Open(const std::string& filename);
+    // Release the mapping
+    void Close();
+
+    const char* Data() const { return m_data; }
+    std::size_t Size() const { return m_size; }
+    bool IsOpen() const { return m_data != nullptr; }
+
+    // Lets files come from somewhere other than the disk (e.g. an archive).
+    // The hook is asked first; if it returns true, 'data' and 'size'
+    // describe the file. 'data' must either stay valid for the rest of the
+    // program, or point into 'storage', which the MappedFile then keeps.
+    using OpenHook = std::function<bool(const std::string& filename, std::vector<char>& storage,
+                                        const char*& data, std::size_t& size)>;
+    static void SetOpenHook(OpenHook hook);
+
+private:
+    const char* m_data{nullptr};
+    std::size_t m_size{0};
+    // True if m_data is our own mapping, which has to be unmapped
+    bool m_mapped{false};
+    // Used when memory mapping is not available, or by the open hook
+    std::vector<char> m_fallback;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "material.hpp"
+#include "mappedfile.hpp"
+
+#include <iostream>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+
+// Returns the rest of the line after the keyword, without
+// leading or trailing whitespace
+static std::string_view Argument(const char* p, const char* end){
+    while(p < end && (*p==' ' || *p=='\t')){
+        ++p;
+    }
+    while(end > p && (end[-1]==' ' || end[-1]=='\t' || end[-1]=='\r')){
+        --end;
+    }
+    return std::string_view(p, end-p);
+}
+
+// Reads up to 'count' floats, leaving the defaults for any that are missing
+static void ParseFloats(std::string_view argument, float* out, int count){
+    const char* p = argument.data();
+    const char* end = p + argument.size();
+    for(int i=0; i < count; ++i){
+        while(p < end && (*p==' ' || *p=='\t' || *p=='+')){
+            ++p;
+        }
+        auto [next, error] = std::from_chars(p, end, out[i]);
+        if(error != std::errc()){
+            return;
+        }
+        p = next;
+    }
+}
+
+// Splits the first word off 'text', and skips the spaces after it
+static std::string_view NextWord(std::string_view& text){
+    std::size_t space = text.find_first_of(" \t");
+    std::string_view word = text.substr(0, space);
+    std::size_t next = text.find_first_not_of(" \t", word.size());
+    text = next == std::string_view::npos ? std::string_view() : text.substr(next);
+    return word;
+}
+
+// True if all of 'word' is a number
+static bool IsNumber(std::string_view word){
+    float value;
+    auto [next, error] = std::from_chars(word.data(), word.data()+word.size(), value);
+    return error == std::errc() && next == word.data()+word.size();
+}
+
+// Texture maps may have options in front of the file name
+// (e.g. 'map_Bump -bm 1.0 normal.ppm'). The options and their values are
+// skipped, and the rest of the line is the file, which may have spaces.
+static std::string TexturePath(std::string_view argument, const std::filesystem::path& folder){
+    while(!argument.empty() && argument[0]=='-'){
+        std::string_view option = NextWord(argument);
+        if(option == "-o" || option == "-s" || option == "-t"){
+            // One to three numbers (u, and optionally v and w)
+            for(int i=0; i < 3 && !argument.empty(); ++i){
+                std::string_view rest = argument;
+                if(!IsNumber(NextWord(rest))){
+                    break;
+                }
+                argument = rest;
+            }
+        }else{
+            // -mm takes a base and a gain. -blendu, -blendv, -boost,
+            // -clamp, -bm, -texres, -imfchan and -type take one value.
+            int values = option == "-mm" ? 2 : 1;
+            for(int i=0; i < values && !argument.empty(); ++i){
+                NextWord(argument);
+            }
+        }
+    }
+    if(argument.empty()){
+        return "";
+    }
+    return (folder / std::filesystem::path(argument)).string();
+}
+
+bool SameSurface(const Material& a, const Material& b){
+    return std::memcmp(a.ambient, b.ambient, sizeof(a.ambient))==0 &&
+           std::memcmp(a.diffuse, b.diffuse, sizeof(a.diffuse))==0 &&
+           std::memcmp(a.specular, b.specular, sizeof(a.specular))==0 &&
+           a.shininess == b.shininess && a.opacity == b.opacity &&
+           a.diffuseMap == b.diffuseMap && a.normalMap == b.normalMap &&
+           a.specularMap == b.specularMap;
+}
+
+bool LoadMaterialLibrary(const std::string& filename, std::vector<Material>& materials){
+    MappedFile file;
+    if(!file.Open(filename)){
+        std::cout << "Material: unable to open " << filename << std::endl;
+        return false;
+    }
+    const std::filesystem::path folder = std::filesystem::path(filename).parent_path();
+
+    Material* current = nullptr;
+    const char* p = file.Data();
+    const char* end = file.Data()+file.Size();
+    while(p < end){
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end-p));
+        if(lineEnd == nullptr){
+            lineEnd = end;
+        }
+        while(p < lineEnd && (*p==' ' || *p=='\t')){
+            ++p;
+        }
+        // Split the line into a keyword and its argument
+        const char* keywordEnd = p;
+        while(keywordEnd < lineEnd && *keywordEnd!=' ' && *keywordEnd!='\t' && *keywordEnd!='\r'){
+            ++keywordEnd;
+        }
+        std::string_view keyword(p, keywordEnd-p);
+        std::string_view argument = Argument(keywordEnd, lineEnd);
+        p = lineEnd+1;
+
+        if(keyword == "newmtl"){
+            materials.push_back(Material{});
+            current = &materials.back();
+            current->name = argument;
+            continue;
+        }
+        if(current == nullptr){
+            // Comments and anything before the first 'newmtl'
+            continue;
+        }
+        if(keyword == "Ka"){
+            ParseFloats(argument, current->ambient, 3);
+        }else if(keyword == "Kd"){
+            ParseFloats(argument, current->diffuse, 3);
+        }else if(keyword == "Ks"){
+            ParseFloats(argument, current->specular, 3);
+        }else if(keyword == "Ns"){
+            ParseFloats(argument, &current->shininess, 1);
+        }else if(keyword == "d"){
+            ParseFloats(argument, &current->opacity, 1);
+        }else if(keyword == "Tr"){
+            float transparency = 0.0f;
+            ParseFloats(argument, &transparency, 1);
+            current->opacity = 1.0f - transparency;
+        }else if(keyword == "map_Kd"){
+            current->diffuseMap = TexturePath(argument, folder);
+        }else if(keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump"){
+            current->normalMap = TexturePath(argument, folder);
+        }else if(keyword == "map_Ks"){
+            current->specularMap = TexturePath(argument, folder);
+        }
+        // Ke, Ni, illum, etc. are not used by our shaders
+    }
+    return true;
+}
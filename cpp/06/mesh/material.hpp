@@ -0,0 +1,31 @@
+#ifndef MATERIAL_HPP
+#define MATERIAL_HPP
+
+#include <vector>
+#include <string>
+
+// A surface description from a Wavefront .mtl material library.
+// Only the parts our shaders can use are kept.
+struct Material{
+    std::string name;
+    float ambient[3]{1.0f,1.0f,1.0f};   // Ka
+    float diffuse[3]{1.0f,1.0f,1.0f};   // Kd
+    float specular[3]{0.0f,0.0f,0.0f};  // Ks
+    float shininess{0.0f};              // Ns
+    float opacity{1.0f};                // d (or 1-Tr)
+    // Texture paths, already relative to the working directory
+    // (i.e. the folder of the .mtl file has been prepended).
+    // Empty if the material does not use that map.
+    std::string diffuseMap;             // map_Kd
+    std::string normalMap;              // map_Bump / bump
+    std::string specularMap;            // map_Ks
+};
+
+// Two materials that only differ by name draw exactly the same
+bool SameSurface(const Material& a, const Material& b);
+
+// Parses every 'newmtl' in a .mtl file and appends them to 'materials'.
+// Returns false if the file could not be opened.
+bool LoadMaterialLibrary(const std::string& filename, std::vector<Material>& materials);
+
+#endif
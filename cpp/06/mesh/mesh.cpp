@@ -1,9 +1,610 @@
 #include "mesh.hpp"
+#include "mappedfile.hpp"
 
-Mesh::Mesh(std::string filename){
-    // parsing each line
-    // -- detect if line starts with 'v '
-    // -- detect if line starts with 'vn'
-    // -- detect if line starts with 'f'
+#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+#include <thread>
+#include <filesystem>
+#include <unordered_map>
+#include <tuple>
 
+// ==================== Parsing helpers ====================
+// The file is memory mapped and parsed in place with pointers,
+// std::from_chars does the number conversion without allocating,
+// copying into a std::string, or looking at the C locale.
+//
+// Loading happens in three steps so that the file can be split into
+// chunks that are worked on at the same time:
+//      (1) ParseObj          - each chunk reads its lines (in parallel)
+//      (2) DeduplicateChunk  - each chunk finds its unique corners (in parallel)
+//      (3) Mesh::Mesh        - merges the chunks, in file order, so the result
+//                              is identical no matter how many threads were used
+// Triangles are grouped by material on the way out, so each material
+// ends up as one contiguous range of indices.
+
+// A face corner as it will be looked up: 0-based indices of the
+// position, texture coordinate and normal (-1 if not present).
+struct ObjCorner{
+    int32_t v, vt, vn;
+};
+
+// Everything parsed out of (part of) an .obj file
+struct ObjChunk{
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    std::vector<float> normals;
+    std::vector<ObjCorner> corners;     // Every face corner, in file order
+    std::vector<uint32_t> faceSizes;    // How many corners each face has
+    // Negative indices count back from the current line, and a chunk does
+    // not know how much came before it. These are resolved against the
+    // start of the chunk, and remembered here (as corner*3 + component)
+    // so they can be shifted once the sizes of earlier chunks are known.
+    std::vector<uint32_t> relative;
+    // 'mtllib' file names, and every 'usemtl' with the face it starts at
+    std::vector<std::string> libraries;
+    struct MaterialSwitch{
+        uint32_t face;
+        std::string name;
+        uint32_t material;              // Filled in once the libraries are loaded
+    };
+    std::vector<MaterialSwitch> switches;
+    uint32_t firstMaterial{0};          // Material in use when the chunk starts
+
+    // Filled in by DeduplicateChunk
+    std::vector<ObjCorner> unique;      // Unique corners, in order of first use
+    std::vector<uint32_t> cornerVertex; // For each corner, its slot in 'unique' (or SKIPPED)
+    std::vector<uint32_t> materialTriangles; // Triangles per material
+    bool valid{true};
+};
+
+// Marks the corners of faces that reference attributes that do not exist
+constexpr uint32_t SKIPPED = 0xFFFFFFFF;
+
+static inline const char* SkipSpaces(const char* p, const char* end){
+    while(p < end && (*p==' ' || *p=='\t' || *p=='\r')){
+        ++p;
+    }
+    return p;
+}
+
+static inline const char* ParseFloat(const char* p, const char* end, float& value){
+    p = SkipSpaces(p,end);
+    // from_chars does not accept a leading '+'
+    if(p < end && *p=='+'){
+        ++p;
+    }
+    value = 0.0f;
+    return std::from_chars(p, end, value).ptr;
+}
+
+// Reads 'count' floats from the rest of the line into 'out'
+static inline const char* ParseFloats(const char* p, const char* end, std::vector<float>& out, int count){
+    for(int i=0; i < count; ++i){
+        float value;
+        p = ParseFloat(p, end, value);
+        out.push_back(value);
+    }
+    return p;
+}
+
+// Turns an index as written in the file into a 0-based index.
+// Positive indices count from the start of the file (starting at 1),
+// negative indices count backwards from the most recent element.
+static inline int32_t ResolveIndex(int32_t written, std::size_t seenSoFar){
+    if(written > 0){
+        return written-1;
+    }
+    return (int32_t)seenSoFar + written;
+}
+
+// Reads one index of a corner. Fails on anything that is not a non-zero
+// integer (OBJ indices start at 1).
+static inline const char* ParseIndex(const char* p, const char* end, int32_t& written){
+    auto [next, error] = std::from_chars(p, end, written);
+    if(error != std::errc() || written == 0){
+        return nullptr;
+    }
+    return next;
+}
+
+// Parses "v", "v/vt", "v//vn" or "v/vt/vn". Returns nullptr if the corner is
+// malformed.
+static inline const char* ParseCorner(const char* p, const char* end, ObjChunk& chunk, ObjCorner& corner){
+    const uint32_t slot = chunk.corners.size()*3;
+    int32_t written = 0;
+    corner = ObjCorner{-1,-1,-1};
+    if((p = ParseIndex(p, end, written)) == nullptr){
+        return nullptr;
+    }
+    corner.v = ResolveIndex(written, chunk.positions.size()/3);
+    if(written < 0){
+        chunk.relative.push_back(slot+0);
+    }
+    if(p < end && *p=='/'){
+        ++p;
+        if(p < end && *p!='/'){
+            if((p = ParseIndex(p, end, written)) == nullptr){
+                return nullptr;
+            }
+            corner.vt = ResolveIndex(written, chunk.texCoords.size()/2);
+            if(written < 0){
+                chunk.relative.push_back(slot+1);
+            }
+        }
+        if(p < end && *p=='/'){
+            ++p;
+            if((p = ParseIndex(p, end, written)) == nullptr){
+                return nullptr;
+            }
+            corner.vn = ResolveIndex(written, chunk.normals.size()/3);
+            if(written < 0){
+                chunk.relative.push_back(slot+2);
+            }
+        }
+    }
+    return p;
+}
+
+// Parses every line between 'begin' and 'end'
+static void ParseObj(const char* begin, const char* end, ObjChunk& chunk){
+    const char* p = begin;
+    while(p < end){
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end-p));
+        if(lineEnd == nullptr){
+            lineEnd = end;
+        }
+        p = SkipSpaces(p, lineEnd);
+
+        if(lineEnd-p >= 2 && p[0]=='v'){
+            // -- detect if line starts with 'v ', 'vt' or 'vn'
+            if(p[1]==' ' || p[1]=='\t'){
+                ParseFloats(p+2, lineEnd, chunk.positions, 3);
+            }else if(p[1]=='t'){
+                ParseFloats(p+2, lineEnd, chunk.texCoords, 2);
+            }else if(p[1]=='n'){
+                ParseFloats(p+2, lineEnd, chunk.normals, 3);
+            }
+        }else if(lineEnd-p >= 2 && p[0]=='f' && (p[1]==' ' || p[1]=='\t')){
+            // -- detect if line starts with 'f'
+            // A face with a malformed corner is dropped as a whole.
+            const std::size_t cornersBefore = chunk.corners.size();
+            const std::size_t relativeBefore = chunk.relative.size();
+            p += 2;
+            uint32_t count = 0;
+            bool malformed = false;
+            while(true){
+                p = SkipSpaces(p, lineEnd);
+                if(p >= lineEnd || !(std::isdigit((unsigned char)*p) || *p=='-')){
+                    break;
+                }
+                ObjCorner corner;
+                p = ParseCorner(p, lineEnd, chunk, corner);
+                if(p == nullptr){
+                    malformed = true;
+                    break;
+                }
+                chunk.corners.push_back(corner);
+                ++count;
+            }
+            if(malformed){
+                chunk.corners.resize(cornersBefore);
+                chunk.relative.resize(relativeBefore);
+            }else{
+                chunk.faceSizes.push_back(count);
+            }
+        }else if(lineEnd-p > 7 && std::memcmp(p, "usemtl", 6)==0){
+            // -- the faces that follow use this material
+            const char* name = SkipSpaces(p+6, lineEnd);
+            const char* nameEnd = lineEnd;
+            while(nameEnd > name && (nameEnd[-1]==' ' || nameEnd[-1]=='\t' || nameEnd[-1]=='\r')){
+                --nameEnd;
+            }
+            chunk.switches.push_back({(uint32_t)chunk.faceSizes.size(), std::string(name, nameEnd), 0});
+        }else if(lineEnd-p > 7 && std::memcmp(p, "mtllib", 6)==0){
+            // -- one or more material libraries, separated by spaces
+            p = SkipSpaces(p+6, lineEnd);
+            while(p < lineEnd){
+                const char* nameEnd = p;
+                while(nameEnd < lineEnd && *nameEnd!=' ' && *nameEnd!='\t' && *nameEnd!='\r'){
+                    ++nameEnd;
+                }
+                chunk.libraries.emplace_back(p, nameEnd);
+                p = SkipSpaces(nameEnd, lineEnd);
+            }
+        }
+        // Comments, groups, smoothing groups, etc. are skipped
+        p = lineEnd+1;
+    }
+}
+
+// ==================== Vertex de-duplication ====================
+// An open addressing hash table from (v,vt,vn) to the vertex it became.
+// Entries live in one flat array, so a lookup is a hash and (usually)
+// a single cache line -- much cheaper than std::unordered_map's node
+// allocations.
+class CornerMap{
+public:
+    explicit CornerMap(std::size_t expected){
+        std::size_t capacity = 16;
+        while(capacity < expected*2){
+            capacity <<= 1;
+        }
+        m_slots.assign(capacity, Slot{ObjCorner{-1,-1,-1}, EMPTY});
+    }
+
+    // Returns the existing index for 'corner', or inserts 'next'
+    // and returns it.
+    uint32_t FindOrInsert(const ObjCorner& corner, uint32_t next, bool& inserted){
+        if((m_size+1)*2 > m_slots.size()){
+            Grow();
+        }
+        std::size_t mask = m_slots.size()-1;
+        std::size_t i = Hash(corner) & mask;
+        while(true){
+            Slot& slot = m_slots[i];
+            if(slot.index == EMPTY){
+                slot.corner = corner;
+                slot.index = next;
+                ++m_size;
+                inserted = true;
+                return next;
+            }
+            if(slot.corner.v==corner.v && slot.corner.vt==corner.vt && slot.corner.vn==corner.vn){
+                inserted = false;
+                return slot.index;
+            }
+            i = (i+1) & mask;
+        }
+    }
+
+private:
+    static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+    struct Slot{
+        ObjCorner corner;
+        uint32_t index;
+    };
+
+    static std::size_t Hash(const ObjCorner& c){
+        uint64_t h = (uint64_t)(uint32_t)c.v * 0x9E3779B97F4A7C15ull;
+        h ^= ((uint64_t)(uint32_t)c.vt << 32 | (uint32_t)c.vn) * 0xC2B2AE3D27D4EB4Full;
+        h ^= h >> 29;
+        return (std::size_t)h;
+    }
+
+    void Grow(){
+        std::vector<Slot> old;
+        old.swap(m_slots);
+        m_slots.assign(old.size()*2, Slot{ObjCorner{-1,-1,-1}, EMPTY});
+        m_size = 0;
+        bool inserted;
+        for(const Slot& slot : old){
+            if(slot.index != EMPTY){
+                FindOrInsert(slot.corner, slot.index, inserted);
+            }
+        }
+    }
+
+    std::vector<Slot> m_slots;
+    std::size_t m_size{0};
+};
+
+// Shifts the negative indices of a chunk by the number of positions,
+// texture coordinates and normals in all of the chunks before it.
+static void ResolveRelative(ObjChunk& chunk, const int32_t offsets[3]){
+    for(uint32_t slot : chunk.relative){
+        int32_t* component = &chunk.corners[slot/3].v + slot%3;
+        *component += offsets[slot%3];
+    }
+}
+
+// Finds the unique corners of one chunk, in the order they are first used,
+// and counts how many triangles use each material.
+// 'counts' are the total number of positions, texture coordinates and
+// normals in the whole file, used to skip faces with invalid indices.
+static void DeduplicateChunk(ObjChunk& chunk, const int32_t counts[3], std::size_t materialCount){
+    CornerMap map(chunk.corners.size()/2);
+    chunk.unique.reserve(chunk.corners.size()/2);
+    chunk.cornerVertex.resize(chunk.corners.size());
+    chunk.materialTriangles.assign(materialCount, 0);
+
+    std::size_t next = 0;
+    std::size_t nextSwitch = 0;
+    uint32_t material = chunk.firstMaterial;
+    for(std::size_t face=0; face < chunk.faceSizes.size(); ++face){
+        while(nextSwitch < chunk.switches.size() && chunk.switches[nextSwitch].face == face){
+            material = chunk.switches[nextSwitch++].material;
+        }
+        const uint32_t faceSize = chunk.faceSizes[face];
+        const ObjCorner* corners = chunk.corners.data() + next;
+        uint32_t* out = chunk.cornerVertex.data() + next;
+        next += faceSize;
+        for(uint32_t i=0; i < faceSize; ++i){
+            const ObjCorner& c = corners[i];
+            if(c.v < 0 || c.v >= counts[0] || c.vt >= counts[1] || c.vn >= counts[2]){
+                // Skip the whole face rather than draw part of it
+                std::fill(out, out+faceSize, SKIPPED);
+                chunk.valid = false;
+                break;
+            }
+            bool inserted;
+            out[i] = map.FindOrInsert(c, chunk.unique.size(), inserted);
+            if(inserted){
+                chunk.unique.push_back(c);
+            }
+        }
+        if(faceSize >= 3 && out[0] != SKIPPED){
+            chunk.materialTriangles[material] += faceSize-2;
+        }
+    }
+}
+
+// Loads the material libraries named in the file and gives every 'usemtl'
+// a slot in 'table'. Materials with the same surface share a slot, and
+// only materials that are actually used are added. Slot 0 is for faces
+// that come before any 'usemtl'.
+static void ResolveMaterials(std::vector<ObjChunk>& chunks, const std::string& filename, std::vector<Material>& table){
+    const std::filesystem::path folder = std::filesystem::path(filename).parent_path();
+    std::vector<Material> library;
+    for(const ObjChunk& chunk : chunks){
+        for(const std::string& name : chunk.libraries){
+            LoadMaterialLibrary((folder / name).string(), library);
+        }
+    }
+    // If a name is defined twice, the first definition wins
+    std::unordered_map<std::string, std::size_t> byName;
+    for(std::size_t i=0; i < library.size(); ++i){
+        byName.emplace(library[i].name, i);
+    }
+
+    table.assign(1, Material{});
+    table[0].name = "default";
+    uint32_t current = 0;
+    for(ObjChunk& chunk : chunks){
+        chunk.firstMaterial = current;
+        for(ObjChunk::MaterialSwitch& change : chunk.switches){
+            Material material;
+            auto found = byName.find(change.name);
+            if(found != byName.end()){
+                material = library[found->second];
+            }else{
+                std::cout << "Mesh: " << filename << " uses unknown material '" << change.name << "'" << std::endl;
+                material.name = change.name;
+                byName.emplace(change.name, library.size());
+                library.push_back(material);
+            }
+            auto same = std::find_if(table.begin(), table.end(), [&](const Material& m){
+                return SameSurface(m, material);
+            });
+            if(same == table.end()){
+                same = table.insert(table.end(), material);
+            }
+            change.material = current = same - table.begin();
+        }
+    }
+}
+
+// Runs 'function(i)' for i in [0,count), each on its own thread
+template<typename Function>
+static void ParallelFor(unsigned int count, Function function){
+    std::vector<std::thread> threads;
+    for(unsigned int i=1; i < count; ++i){
+        threads.emplace_back(function, i);
+    }
+    // The calling thread does the first piece of work itself
+    if(count > 0){
+        function(0);
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+}
+
+// ==================== Mesh ====================
+
+Mesh::Mesh(){
+}
+
+Mesh::Mesh(std::string filename) : Mesh(filename, 1){
+}
+
+Mesh::Mesh(std::string filename, unsigned int threadCount){
+    MappedFile file;
+    if(!file.Open(filename)){
+        std::cout << "Mesh: unable to open " << filename << std::endl;
+        return;
+    }
+    if(threadCount == 0){
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Small files are not worth splitting up
+    constexpr std::size_t MIN_CHUNK_BYTES = 64*1024;
+    threadCount = std::max<std::size_t>(1, std::min<std::size_t>(threadCount, file.Size()/MIN_CHUNK_BYTES));
+
+    // (1) ======= Split the file on line boundaries and parse each piece
+    std::vector<const char*> bounds(threadCount+1);
+    const char* begin = file.Data();
+    const char* end = file.Data()+file.Size();
+    bounds[0] = begin;
+    bounds[threadCount] = end;
+    for(unsigned int i=1; i < threadCount; ++i){
+        const char* split = std::max(bounds[i-1], begin + file.Size()*i/threadCount);
+        const char* newline = static_cast<const char*>(std::memchr(split, '\n', end-split));
+        bounds[i] = newline ? newline+1 : end;
+    }
+
+    std::vector<ObjChunk> chunks(threadCount);
+    ParallelFor(threadCount, [&](unsigned int i){
+        // A rough guess from typical line lengths saves most re-allocation
+        std::size_t expectedLines = (bounds[i+1]-bounds[i])/32;
+        chunks[i].positions.reserve(expectedLines);
+        chunks[i].corners.reserve(expectedLines);
+        ParseObj(bounds[i], bounds[i+1], chunks[i]);
+    });
+
+    // (2) ======= A prefix sum gives each chunk where its attributes start
+    std::vector<int32_t> offsets((threadCount+1)*3, 0);
+    for(unsigned int i=0; i < threadCount; ++i){
+        offsets[(i+1)*3+0] = offsets[i*3+0] + chunks[i].positions.size()/3;
+        offsets[(i+1)*3+1] = offsets[i*3+1] + chunks[i].texCoords.size()/2;
+        offsets[(i+1)*3+2] = offsets[i*3+2] + chunks[i].normals.size()/3;
+    }
+    const int32_t* counts = &offsets[threadCount*3];
+    std::vector<Material> table;
+    ResolveMaterials(chunks, filename, table);
+    const std::size_t materialCount = table.size();
+    ParallelFor(threadCount, [&](unsigned int i){
+        ResolveRelative(chunks[i], &offsets[i*3]);
+        DeduplicateChunk(chunks[i], counts, materialCount);
+    });
+
+    // Gather the attributes of every chunk into one array each
+    std::vector<float> positions, texCoords, normals;
+    if(threadCount == 1){
+        positions.swap(chunks[0].positions);
+        texCoords.swap(chunks[0].texCoords);
+        normals.swap(chunks[0].normals);
+    }else{
+        positions.reserve(counts[0]*3);
+        texCoords.reserve(counts[1]*2);
+        normals.reserve(counts[2]*3);
+        for(ObjChunk& chunk : chunks){
+            positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+            texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+            normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+        }
+    }
+
+    // (3) ======= Merge the unique corners of each chunk, in file order.
+    // Every vertex keeps the position it would have had if the file was
+    // read front to back by a single thread.
+    std::vector<ObjCorner> unique;
+    std::vector<std::vector<uint32_t>> remap(threadCount);
+    if(threadCount == 1){
+        unique.swap(chunks[0].unique);
+    }else{
+        std::size_t total = 0;
+        for(const ObjChunk& chunk : chunks){
+            total += chunk.unique.size();
+        }
+        CornerMap map(total);
+        unique.reserve(total);
+        for(unsigned int i=0; i < threadCount; ++i){
+            remap[i].resize(chunks[i].unique.size());
+            for(std::size_t j=0; j < chunks[i].unique.size(); ++j){
+                bool inserted;
+                remap[i][j] = map.FindOrInsert(chunks[i].unique[j], unique.size(), inserted);
+                if(inserted){
+                    unique.push_back(chunks[i].unique[j]);
+                }
+            }
+        }
+    }
+
+    // Unused materials are dropped, and materials that share a texture are
+    // put next to each other (otherwise keeping the order of first use)
+    std::vector<std::size_t> triangles(materialCount, 0);
+    bool valid = true;
+    for(const ObjChunk& chunk : chunks){
+        for(std::size_t m=0; m < materialCount; ++m){
+            triangles[m] += chunk.materialTriangles[m];
+        }
+        valid = valid && chunk.valid;
+    }
+    std::vector<std::size_t> order;
+    for(std::size_t m=0; m < materialCount; ++m){
+        if(triangles[m] > 0){
+            order.push_back(m);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b){
+        const Material& x = table[a];
+        const Material& y = table[b];
+        return std::tie(x.diffuseMap, x.normalMap, x.specularMap) < std::tie(y.diffuseMap, y.normalMap, y.specularMap);
+    });
+
+    // Each material is one subset. Within it, the triangles of each chunk
+    // follow each other in file order, so every chunk knows where to write.
+    std::vector<std::size_t> firstIndex(threadCount*materialCount, 0);
+    std::size_t indexCount = 0;
+    for(std::size_t m : order){
+        subsets.push_back(MeshSubset{(unsigned int)materials.size(), (unsigned int)indexCount, (unsigned int)triangles[m]*3});
+        materials.push_back(table[m]);
+        for(unsigned int i=0; i < threadCount; ++i){
+            firstIndex[i*materialCount+m] = indexCount;
+            indexCount += chunks[i].materialTriangles[m]*3;
+        }
+    }
+    vertices.resize(unique.size()*stride);
+    indices.resize(indexCount);
+
+    ParallelFor(threadCount, [&](unsigned int i){
+        // Interleave the attributes of our share of the vertices
+        std::size_t first = unique.size()*i/threadCount;
+        std::size_t last  = unique.size()*(i+1)/threadCount;
+        for(std::size_t j=first; j < last; ++j){
+            const ObjCorner& c = unique[j];
+            vertex out{};
+            std::memcpy(&out.x, &positions[c.v*3], 3*sizeof(float));
+            if(c.vn >= 0){
+                std::memcpy(&out.nx, &normals[c.vn*3], 3*sizeof(float));
+            }
+            if(c.vt >= 0){
+                std::memcpy(&out.s, &texCoords[c.vt*2], 2*sizeof(float));
+            }
+            std::memcpy(&vertices[j*stride], &out, sizeof(vertex));
+        }
+
+        // Faces with more than three corners become a fan of triangles
+        const ObjChunk& chunk = chunks[i];
+        std::size_t* cursor = &firstIndex[i*materialCount];
+        std::size_t next = 0;
+        std::size_t nextSwitch = 0;
+        uint32_t material = chunk.firstMaterial;
+        auto global = [&](uint32_t local){
+            return threadCount == 1 ? local : remap[i][local];
+        };
+        for(std::size_t f=0; f < chunk.faceSizes.size(); ++f){
+            while(nextSwitch < chunk.switches.size() && chunk.switches[nextSwitch].face == f){
+                material = chunk.switches[nextSwitch++].material;
+            }
+            const uint32_t faceSize = chunk.faceSizes[f];
+            const uint32_t* face = chunk.cornerVertex.data() + next;
+            next += faceSize;
+            if(faceSize < 3 || face[0] == SKIPPED){
+                continue;
+            }
+            unsigned int* out = indices.data() + cursor[material];
+            for(uint32_t k=1; k+1 < faceSize; ++k){
+                *out++ = global(face[0]);
+                *out++ = global(face[k]);
+                *out++ = global(face[k+1]);
+            }
+            cursor[material] += (faceSize-2)*3;
+        }
+    });
+
+    if(!valid){
+        std::cout << "Mesh: " << filename << " has faces with out of range indices, they were skipped" << std::endl;
+    }
+    ComputeBounds();
+}
+
+void Mesh::ComputeBounds(){
+    if(vertices.empty()){
+        return;
+    }
+    for(int axis=0; axis < 3; ++axis){
+        boundsMin[axis] = vertices[axis];
+        boundsMax[axis] = vertices[axis];
+    }
+    for(std::size_t i=0; i < vertices.size(); i+=stride){
+        for(int axis=0; axis < 3; ++axis){
+            boundsMin[axis] = std::min(boundsMin[axis], vertices[i+axis]);
+            boundsMax[axis] = std::max(boundsMax[axis], vertices[i+axis]);
+        }
+    }
 }
@@ -1,21 +1,64 @@
 #ifndef MESH_HPP
 #define MESH_HPP
 
+#include "material.hpp"
+
 #include <vector>
 #include <string>
 
 struct vertex{
     float x,y,z;
     float nx,ny,nz;
+    float s,t;
+};
+
+// A run of indices that all use the same material, drawn with
+// one glDrawElements(GL_TRIANGLES, indexCount, ..., indexOffset*4)
+struct MeshSubset{
+    unsigned int material;      // Index into Mesh::materials
+    unsigned int indexOffset;   // First index in Mesh::indices
+    unsigned int indexCount;
 };
 
 struct Mesh{
-    // Other strategy is to have std::vector<vertex> vertices
-    std::vector<float> positions;
-    std::vector<float> normals;
+    // Number of floats per vertex in 'vertices'.
+    // The layout matches VERTEX3TN in MeshMaker:
+    //      x,y,z, nx,ny,nz, s,t
+    static constexpr unsigned int stride = sizeof(vertex)/sizeof(float);
 
+    // Each unique (position, texture coordinate, normal) combination
+    // becomes one interleaved vertex.
+    std::vector<float> vertices;
+    // Three indices per triangle into 'vertices'
+    std::vector<unsigned int> indices;
+    // Materials used by the mesh, with duplicates (same surface under a
+    // different name) merged and unused ones dropped. Materials sharing
+    // a diffuse map are next to each other, so textures change as
+    // rarely as possible when the subsets are drawn in order.
+    std::vector<Material> materials;
+    // One subset per material, in the same order as 'materials'.
+    // Triangles are sorted by material when loading, so each
+    // material is exactly one draw.
+    std::vector<MeshSubset> subsets;
+
+    // Axis-aligned bounding box of all positions
+    float boundsMin[3]{0.0f,0.0f,0.0f};
+    float boundsMax[3]{0.0f,0.0f,0.0f};
+
+    // An empty mesh
+    Mesh();
+    // Parse a Wavefront .obj file
     Mesh(std::string filename);
+    // Parse a Wavefront .obj file, splitting the work over 'threadCount'
+    // threads (0 uses one per core). The result is the same as the
+    // single threaded constructor, vertex for vertex.
+    Mesh(std::string filename, unsigned int threadCount);
+
+    unsigned int GetVertexCount() const { return vertices.size()/stride; }
+    unsigned int GetTriangleCount() const { return indices.size()/3; }
 
+    // Recompute boundsMin and boundsMax from the vertices
+    void ComputeBounds();
 };
 
 
@@ -0,0 +1,343 @@
+#include "meshfile.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+
+// GL_FLOAT, so we do not need to include OpenGL in our tools
+constexpr uint32_t MESHFILE_GL_FLOAT = 0x1406;
+
+// The vertex layout every cooked mesh uses, which is Mesh's layout
+static const MeshFileAttribute MESHFILE_ATTRIBUTES[3] = {
+    {0, 3, MESHFILE_GL_FLOAT, offsetof(vertex,x)},     // position
+    {1, 3, MESHFILE_GL_FLOAT, offsetof(vertex,nx)},    // normal
+    {2, 2, MESHFILE_GL_FLOAT, offsetof(vertex,s)},     // texture coordinate
+};
+
+// Rounds 'value' up to the next multiple of 16
+static uint64_t Align16(uint64_t value){
+    return (value + 15) & ~uint64_t(15);
+}
+
+// Bounding sphere around a set of vertices (center of the box, farthest vertex)
+static void BoundingSphere(const std::vector<float>& vertices, const uint32_t* which, uint32_t count,
+                           float center[3], float& radius){
+    float lo[3]={0,0,0}, hi[3]={0,0,0};
+    for(uint32_t i=0; i < count; ++i){
+        const float* p = &vertices[(which ? which[i] : i)*Mesh::stride];
+        for(int axis=0; axis < 3; ++axis){
+            lo[axis] = (i==0) ? p[axis] : std::min(lo[axis], p[axis]);
+            hi[axis] = (i==0) ? p[axis] : std::max(hi[axis], p[axis]);
+        }
+    }
+    float r2 = 0.0f;
+    for(int axis=0; axis < 3; ++axis){
+        center[axis] = (lo[axis]+hi[axis])*0.5f;
+    }
+    for(uint32_t i=0; i < count; ++i){
+        const float* p = &vertices[(which ? which[i] : i)*Mesh::stride];
+        float dx=p[0]-center[0], dy=p[1]-center[1], dz=p[2]-center[2];
+        r2 = std::max(r2, dx*dx+dy*dy+dz*dz);
+    }
+    radius = std::sqrt(r2);
+}
+
+// Simplify by snapping every vertex to a grid and collapsing
+// each cell to the first vertex that landed in it. Triangles
+// whose corners end up in fewer than three cells disappear.
+// The result references the original vertices, so every LOD
+// shares one vertex buffer.
+static std::vector<uint32_t> ClusterLOD(const Mesh& mesh, float cellSize){
+    std::unordered_map<uint64_t,uint32_t> cells;
+    std::vector<uint32_t> representative(mesh.GetVertexCount());
+    for(uint32_t i=0; i < mesh.GetVertexCount(); ++i){
+        const float* p = &mesh.vertices[i*Mesh::stride];
+        uint64_t key = 0;
+        for(int axis=0; axis < 3; ++axis){
+            uint64_t cell = (uint64_t)((p[axis]-mesh.boundsMin[axis])/cellSize) & 0x1FFFFF;
+            key = (key << 21) | cell;
+        }
+        representative[i] = cells.try_emplace(key, i).first->second;
+    }
+    std::vector<uint32_t> result;
+    for(std::size_t i=0; i+2 < mesh.indices.size(); i+=3){
+        uint32_t a = representative[mesh.indices[i+0]];
+        uint32_t b = representative[mesh.indices[i+1]];
+        uint32_t c = representative[mesh.indices[i+2]];
+        if(a!=b && b!=c && a!=c){
+            result.push_back(a);
+            result.push_back(b);
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
+// Greedily walk the triangles, starting a new meshlet whenever
+// the current one would exceed its vertex or triangle limit.
+static void BuildMeshlets(const Mesh& mesh,
+                          std::vector<MeshFileMeshlet>& meshlets,
+                          std::vector<uint32_t>& meshletVertices,
+                          std::vector<uint8_t>& meshletTriangles){
+    // Maps a mesh vertex to its slot in the current meshlet (0xFF = not used)
+    std::vector<uint8_t> localIndex(mesh.GetVertexCount(), 0xFF);
+    MeshFileMeshlet current{};
+
+    auto finish = [&](){
+        if(current.triangleCount == 0){
+            return;
+        }
+        BoundingSphere(mesh.vertices, &meshletVertices[current.vertexOffset], current.vertexCount,
+                       current.center, current.radius);
+        for(uint32_t i=0; i < current.vertexCount; ++i){
+            localIndex[meshletVertices[current.vertexOffset+i]] = 0xFF;
+        }
+        meshlets.push_back(current);
+        current = MeshFileMeshlet{};
+        current.vertexOffset = meshletVertices.size();
+        current.triangleOffset = meshletTriangles.size();
+    };
+
+    for(std::size_t i=0; i+2 < mesh.indices.size(); i+=3){
+        uint32_t newVertices = 0;
+        for(int corner=0; corner < 3; ++corner){
+            newVertices += (localIndex[mesh.indices[i+corner]] == 0xFF);
+        }
+        if(current.vertexCount + newVertices > MESHLET_MAX_VERTICES ||
+           current.triangleCount + 1 > MESHLET_MAX_TRIANGLES){
+            finish();
+        }
+        for(int corner=0; corner < 3; ++corner){
+            uint32_t v = mesh.indices[i+corner];
+            if(localIndex[v] == 0xFF){
+                localIndex[v] = current.vertexCount++;
+                meshletVertices.push_back(v);
+            }
+            meshletTriangles.push_back(localIndex[v]);
+        }
+        current.triangleCount++;
+    }
+    finish();
+}
+
+bool WriteMeshFile(const std::string& filename, const Mesh& mesh, uint32_t lodCount){
+    // (1) ======= Gather every section in memory
+    std::vector<MeshFileLOD> lods;
+    std::vector<uint32_t> indices(mesh.indices.begin(), mesh.indices.end());
+    lods.push_back({0, (uint32_t)indices.size(), 0.0f, 0});
+
+    float extent = 0.0f;
+    for(int axis=0; axis < 3; ++axis){
+        extent = std::max(extent, mesh.boundsMax[axis]-mesh.boundsMin[axis]);
+    }
+    // Each coarser LOD halves the grid resolution, starting at 64 cells
+    float cellSize = extent/64.0f;
+    for(uint32_t lod=1; lod < lodCount && extent > 0.0f; ++lod){
+        std::vector<uint32_t> simplified = ClusterLOD(mesh, cellSize);
+        if(simplified.empty() || simplified.size() >= lods.back().indexCount){
+            break;
+        }
+        lods.push_back({(uint32_t)indices.size(), (uint32_t)simplified.size(), cellSize, 0});
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        cellSize *= 2.0f;
+    }
+
+    std::vector<MeshFileMeshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+    BuildMeshlets(mesh, meshlets, meshletVertices, meshletTriangles);
+
+    // (2) ======= Fill in the header and work out where everything goes
+    MeshFileHeader header{};
+    std::memcpy(header.magic, MESHFILE_MAGIC, 4);
+    header.version          = MESHFILE_VERSION;
+    header.vertexCount      = mesh.GetVertexCount();
+    header.vertexStride     = sizeof(vertex);
+    header.indexCount       = indices.size();
+    header.attributeCount   = std::size(MESHFILE_ATTRIBUTES);
+    header.lodCount         = lods.size();
+    header.meshletCount     = meshlets.size();
+    std::memcpy(header.boundsMin, mesh.boundsMin, sizeof(header.boundsMin));
+    std::memcpy(header.boundsMax, mesh.boundsMax, sizeof(header.boundsMax));
+    BoundingSphere(mesh.vertices, nullptr, mesh.GetVertexCount(), header.center, header.radius);
+
+    uint64_t offset = Align16(sizeof(MeshFileHeader));
+    header.attributeOffset      = offset; offset = Align16(offset + sizeof(MESHFILE_ATTRIBUTES));
+    header.lodOffset            = offset; offset = Align16(offset + lods.size()*sizeof(MeshFileLOD));
+    header.meshletOffset        = offset; offset = Align16(offset + meshlets.size()*sizeof(MeshFileMeshlet));
+    header.vertexOffset         = offset; offset = Align16(offset + mesh.vertices.size()*sizeof(float));
+    header.indexOffset          = offset; offset = Align16(offset + indices.size()*sizeof(uint32_t));
+    header.meshletVertexOffset  = offset; offset = Align16(offset + meshletVertices.size()*sizeof(uint32_t));
+    header.meshletVertexCount   = meshletVertices.size();
+    header.meshletTriangleOffset= offset; offset = Align16(offset + meshletTriangles.size());
+    header.meshletTriangleBytes = meshletTriangles.size();
+    header.fileSize             = offset;
+
+    // (3) ======= Write it out
+    std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+    if(!out.is_open()){
+        std::cout << "WriteMeshFile: unable to open " << filename << std::endl;
+        return false;
+    }
+    auto write = [&out](uint64_t at, const void* data, uint64_t bytes){
+        // Pad with zeros up to the aligned start of this section
+        static const char zeros[16] = {};
+        while((uint64_t)out.tellp() < at){
+            out.write(zeros, std::min<uint64_t>(16, at-(uint64_t)out.tellp()));
+        }
+        out.write(static_cast<const char*>(data), bytes);
+    };
+    write(0, &header, sizeof(header));
+    write(header.attributeOffset, MESHFILE_ATTRIBUTES, sizeof(MESHFILE_ATTRIBUTES));
+    write(header.lodOffset, lods.data(), lods.size()*sizeof(MeshFileLOD));
+    write(header.meshletOffset, meshlets.data(), meshlets.size()*sizeof(MeshFileMeshlet));
+    write(header.vertexOffset, mesh.vertices.data(), mesh.vertices.size()*sizeof(float));
+    write(header.indexOffset, indices.data(), indices.size()*sizeof(uint32_t));
+    write(header.meshletVertexOffset, meshletVertices.data(), meshletVertices.size()*sizeof(uint32_t));
+    write(header.meshletTriangleOffset, meshletTriangles.data(), meshletTriangles.size());
+    write(header.fileSize, nullptr, 0);
+    return out.good();
+}
+
+MeshFile::MeshFile(){
+}
+
+bool MeshFile::Open(const std::string& filename){
+    m_header = nullptr;
+    if(!m_file.Open(filename)){
+        std::cout << "MeshFile: unable to open " << filename << std::endl;
+        return false;
+    }
+    if(m_file.Size() < sizeof(MeshFileHeader)){
+        std::cout << "MeshFile: " << filename << " is too small to be a mesh" << std::endl;
+        return false;
+    }
+    const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(m_file.Data());
+    if(std::memcmp(header->magic, MESHFILE_MAGIC, 4) != 0 || header->version != MESHFILE_VERSION){
+        std::cout << "MeshFile: " << filename << " is not a version " << MESHFILE_VERSION << " mesh" << std::endl;
+        return false;
+    }
+    if(header->fileSize > m_file.Size()){
+        std::cout << "MeshFile: " << filename << " is truncated" << std::endl;
+        return false;
+    }
+    // The vertices must be laid out the way Mesh (and ToMesh) expects
+    if(header->vertexStride != sizeof(vertex) || header->attributeCount != std::size(MESHFILE_ATTRIBUTES)){
+        std::cout << "MeshFile: " << filename << " does not use the x,y,z, nx,ny,nz, s,t vertex layout" << std::endl;
+        return false;
+    }
+    // Every section must be 16 byte aligned and inside the file
+    struct Section{ uint64_t offset; uint64_t bytes; };
+    const Section sections[] = {
+        {header->attributeOffset,       (uint64_t)header->attributeCount*sizeof(MeshFileAttribute)},
+        {header->lodOffset,             (uint64_t)header->lodCount*sizeof(MeshFileLOD)},
+        {header->meshletOffset,         (uint64_t)header->meshletCount*sizeof(MeshFileMeshlet)},
+        {header->vertexOffset,          (uint64_t)header->vertexCount*header->vertexStride},
+        {header->indexOffset,           (uint64_t)header->indexCount*sizeof(uint32_t)},
+        {header->meshletVertexOffset,   (uint64_t)header->meshletVertexCount*sizeof(uint32_t)},
+        {header->meshletTriangleOffset, (uint64_t)header->meshletTriangleBytes},
+    };
+    for(const Section& section : sections){
+        if(section.offset % 16 != 0 || section.offset > header->fileSize || section.bytes > header->fileSize - section.offset){
+            std::cout << "MeshFile: " << filename << " is truncated" << std::endl;
+            return false;
+        }
+    }
+    // There is always LOD 0, and every LOD and meshlet must point inside
+    // its blob
+    bool valid = header->lodCount > 0;
+    const MeshFileLOD* lods = reinterpret_cast<const MeshFileLOD*>(m_file.Data() + header->lodOffset);
+    for(uint32_t i=0; valid && i < header->lodCount; ++i){
+        valid = lods[i].indexOffset <= header->indexCount && lods[i].indexCount <= header->indexCount - lods[i].indexOffset;
+    }
+    const MeshFileMeshlet* meshlets = reinterpret_cast<const MeshFileMeshlet*>(m_file.Data() + header->meshletOffset);
+    for(uint32_t i=0; valid && i < header->meshletCount; ++i){
+        valid = meshlets[i].vertexOffset <= header->meshletVertexCount &&
+                meshlets[i].vertexCount <= header->meshletVertexCount - meshlets[i].vertexOffset &&
+                meshlets[i].triangleOffset <= header->meshletTriangleBytes &&
+                (uint64_t)meshlets[i].triangleCount*3 <= header->meshletTriangleBytes - meshlets[i].triangleOffset;
+    }
+    if(!valid){
+        std::cout << "MeshFile: " << filename << " has a level of detail or meshlet outside of its data" << std::endl;
+        return false;
+    }
+    const MeshFileAttribute* attributes = reinterpret_cast<const MeshFileAttribute*>(m_file.Data() + header->attributeOffset);
+    if(std::memcmp(attributes, MESHFILE_ATTRIBUTES, sizeof(MESHFILE_ATTRIBUTES)) != 0){
+        std::cout << "MeshFile: " << filename << " does not use the x,y,z, nx,ny,nz, s,t vertex layout" << std::endl;
+        return false;
+    }
+    // Every index has to name a vertex, and every meshlet triangle one of
+    // its meshlet's vertices
+    const uint32_t* indices = reinterpret_cast<const uint32_t*>(m_file.Data() + header->indexOffset);
+    for(uint32_t i=0; valid && i < header->indexCount; ++i){
+        valid = indices[i] < header->vertexCount;
+    }
+    const uint32_t* meshletVertices = reinterpret_cast<const uint32_t*>(m_file.Data() + header->meshletVertexOffset);
+    for(uint32_t i=0; valid && i < header->meshletVertexCount; ++i){
+        valid = meshletVertices[i] < header->vertexCount;
+    }
+    const uint8_t* meshletTriangles = reinterpret_cast<const uint8_t*>(m_file.Data() + header->meshletTriangleOffset);
+    for(uint32_t i=0; valid && i < header->meshletCount; ++i){
+        const uint8_t* triangle = meshletTriangles + meshlets[i].triangleOffset;
+        for(uint32_t j=0; valid && j < meshlets[i].triangleCount*3; ++j){
+            valid = triangle[j] < meshlets[i].vertexCount;
+        }
+    }
+    if(!valid){
+        std::cout << "MeshFile: " << filename << " has an index that names no vertex" << std::endl;
+        return false;
+    }
+    m_header = header;
+    return true;
+}
+
+const MeshFileAttribute* MeshFile::GetAttributes() const{
+    return reinterpret_cast<const MeshFileAttribute*>(m_file.Data() + m_header->attributeOffset);
+}
+
+const MeshFileLOD* MeshFile::GetLODs() const{
+    return reinterpret_cast<const MeshFileLOD*>(m_file.Data() + m_header->lodOffset);
+}
+
+const MeshFileMeshlet* MeshFile::GetMeshlets() const{
+    return reinterpret_cast<const MeshFileMeshlet*>(m_file.Data() + m_header->meshletOffset);
+}
+
+const float* MeshFile::GetVertexData() const{
+    return reinterpret_cast<const float*>(m_file.Data() + m_header->vertexOffset);
+}
+
+uint64_t MeshFile::GetVertexDataSizeInBytes() const{
+    return (uint64_t)m_header->vertexCount * m_header->vertexStride;
+}
+
+const uint32_t* MeshFile::GetIndexData(uint32_t lod) const{
+    const uint32_t* indices = reinterpret_cast<const uint32_t*>(m_file.Data() + m_header->indexOffset);
+    return indices + GetLODs()[std::min(lod, m_header->lodCount-1)].indexOffset;
+}
+
+uint32_t MeshFile::GetIndexCount(uint32_t lod) const{
+    return GetLODs()[std::min(lod, m_header->lodCount-1)].indexCount;
+}
+
+const uint32_t* MeshFile::GetMeshletVertices() const{
+    return reinterpret_cast<const uint32_t*>(m_file.Data() + m_header->meshletVertexOffset);
+}
+
+const uint8_t* MeshFile::GetMeshletTriangles() const{
+    return reinterpret_cast<const uint8_t*>(m_file.Data() + m_header->meshletTriangleOffset);
+}
+
+void MeshFile::ToMesh(Mesh& mesh) const{
+    const float* v = GetVertexData();
+    mesh.vertices.assign(v, v + m_header->vertexCount*Mesh::stride);
+    mesh.indices.assign(GetIndexData(0), GetIndexData(0) + GetIndexCount(0));
+    std::memcpy(mesh.boundsMin, m_header->boundsMin, sizeof(mesh.boundsMin));
+    std::memcpy(mesh.boundsMax, m_header->boundsMax, sizeof(mesh.boundsMax));
+}
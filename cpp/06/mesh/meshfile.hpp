@@ -0,0 +1,121 @@
+#ifndef MESHFILE_HPP
+#define MESHFILE_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "mesh.hpp"
+#include "mappedfile.hpp"
+
+// A 'cooked' mesh is a Mesh that has already been parsed and
+// indexed, written to disk exactly as it will be sent to the GPU.
+// Loading one is just mapping the file and handing pointers to
+// glBufferData -- there is no text to parse.
+//
+// Layout on disk (little endian, every section 16 byte aligned):
+//
+//      MeshFileHeader
+//      MeshFileAttribute   [attributeCount]
+//      MeshFileLOD         [lodCount]
+//      MeshFileMeshlet     [meshletCount]
+//      vertex blob         vertexCount * vertexStride bytes
+//      index blob          uint32 indices, LOD 0 first, then each coarser LOD
+//      meshlet vertices    uint32 indices into the vertex blob
+//      meshlet triangles   uint8 triples into a meshlet's vertices
+
+constexpr char     MESHFILE_MAGIC[4]  = {'M','E','S','H'};
+constexpr uint32_t MESHFILE_VERSION   = 1;
+// Limits used when splitting a mesh into meshlets
+constexpr uint32_t MESHLET_MAX_VERTICES  = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// Describes one vertex attribute, the same information
+// that is passed to glVertexAttribPointer.
+struct MeshFileAttribute{
+    uint32_t location;      // layout(location=...) in the shader
+    uint32_t components;    // 1 to 4
+    uint32_t type;          // GL type enum (e.g. GL_FLOAT = 0x1406)
+    uint32_t offset;        // Byte offset within a vertex
+};
+
+// A level of detail is a range of the index blob.
+struct MeshFileLOD{
+    uint32_t indexOffset;   // In indices, not bytes
+    uint32_t indexCount;
+    float    error;         // Size of the grid cell used to simplify
+    uint32_t reserved;
+};
+
+// A meshlet is a small cluster of triangles that share vertices.
+struct MeshFileMeshlet{
+    uint32_t vertexOffset;      // Into the meshlet vertices blob
+    uint32_t triangleOffset;    // Into the meshlet triangles blob (in bytes)
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+    float    center[3];         // Bounding sphere
+    float    radius;
+};
+
+struct MeshFileHeader{
+    char     magic[4];
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t vertexStride;      // In bytes
+    uint32_t indexCount;        // Total indices over all LODs
+    uint32_t attributeCount;
+    uint32_t lodCount;
+    uint32_t meshletCount;
+    float    boundsMin[3];
+    float    boundsMax[3];
+    float    center[3];         // Bounding sphere of the whole mesh
+    float    radius;
+    uint64_t attributeOffset;   // All offsets are in bytes from the start of the file
+    uint64_t lodOffset;
+    uint64_t meshletOffset;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t meshletVertexOffset;
+    uint32_t meshletVertexCount;
+    uint32_t meshletTriangleBytes;
+    uint64_t meshletTriangleOffset;
+    uint64_t fileSize;
+};
+
+// Writes a mesh in the cooked format.
+// lodCount includes LOD 0 (the original triangles).
+// Returns false if the file could not be written.
+bool WriteMeshFile(const std::string& filename, const Mesh& mesh, uint32_t lodCount=3);
+
+// Read-only access to a cooked mesh.
+// All pointers point straight into the mapped file and stay
+// valid for the lifetime of the MeshFile.
+class MeshFile{
+public:
+    MeshFile();
+    // Maps and validates a cooked mesh. Returns false on failure.
+    bool Open(const std::string& filename);
+
+    const MeshFileHeader&    GetHeader() const { return *m_header; }
+    const MeshFileAttribute* GetAttributes() const;
+    const MeshFileLOD*       GetLODs() const;
+    const MeshFileMeshlet*   GetMeshlets() const;
+
+    // Interleaved vertex data, ready for glBufferData
+    const float*    GetVertexData() const;
+    uint64_t        GetVertexDataSizeInBytes() const;
+    // Index data for a level of detail, ready for glBufferData
+    const uint32_t* GetIndexData(uint32_t lod=0) const;
+    uint32_t        GetIndexCount(uint32_t lod=0) const;
+
+    const uint32_t* GetMeshletVertices() const;
+    const uint8_t*  GetMeshletTriangles() const;
+
+    // Copies LOD 0 back into a Mesh (e.g. for tools that edit meshes)
+    void ToMesh(Mesh& mesh) const;
+
+private:
+    MappedFile m_file;
+    const MeshFileHeader* m_header{nullptr};
+};
+
+#endif
@@ -0,0 +1,143 @@
+// Measures how long it takes to load a large .stl file.
+//
+// Usage: ./bench_stl [triangles] [runs]
+//        triangles defaults to 2000000
+//
+// A bumpy grid with the requested number of triangles is written out as
+// both a binary and an ASCII .stl (in the temp directory), and then
+// loaded with:
+//      - the line by line std::stringstream parser STLFile used to have
+//      - STLMesh, from the ASCII file
+//      - STLMesh, from the binary file
+// The temporary files are removed at the end.
+
+#include "STLMesh.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+// Best of a few runs, in milliseconds
+template<typename Function>
+double TimeBestOf(int runs, Function function){
+	double best = 1e30;
+	for(int i=0; i < runs; ++i){
+		auto start = std::chrono::steady_clock::now();
+		function();
+		auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double,std::milli>(end-start).count());
+	}
+	return best;
+}
+
+// Writes a size x size grid of quads (two triangles each) as
+// binary and ASCII STL files
+static void WriteGrid(unsigned int size, const std::string& binaryPath, const std::string& asciiPath){
+	auto height = [](unsigned int x, unsigned int z){
+		return 0.1f*std::sin(x*0.05f)*std::cos(z*0.07f);
+	};
+	std::ofstream binary(binaryPath, std::ios::binary);
+	FILE* ascii = std::fopen(asciiPath.c_str(), "w");
+
+	char header[80] = "bench_stl grid";
+	uint32_t triangleCount = size*size*2;
+	binary.write(header, sizeof(header));
+	binary.write((const char*)&triangleCount, sizeof(triangleCount));
+	std::fprintf(ascii, "solid grid\n");
+
+	for(unsigned int z=0; z < size; ++z){
+		for(unsigned int x=0; x < size; ++x){
+			float p[4][3] = {{(float)x,   height(x,z),     (float)z},
+			                 {(float)x+1, height(x+1,z),   (float)z},
+			                 {(float)x+1, height(x+1,z+1), (float)z+1},
+			                 {(float)x,   height(x,z+1),   (float)z+1}};
+			const int triangles[2][3] = {{0,2,1},{0,3,2}};
+			for(const auto& t : triangles){
+				float record[12] = {0.0f,1.0f,0.0f};
+				uint16_t attribute = 0;
+				std::memcpy(record+3, p[t[0]], sizeof(p[0]));
+				std::memcpy(record+6, p[t[1]], sizeof(p[0]));
+				std::memcpy(record+9, p[t[2]], sizeof(p[0]));
+				binary.write((const char*)record, sizeof(record));
+				binary.write((const char*)&attribute, sizeof(attribute));
+
+				std::fprintf(ascii, "facet normal 0 1 0\nouter loop\n");
+				for(int i=0; i < 3; ++i){
+					std::fprintf(ascii, "vertex %.9g %.9g %.9g\n", p[t[i]][0], p[t[i]][1], p[t[i]][2]);
+				}
+				std::fprintf(ascii, "endloop\nendfacet\n");
+			}
+		}
+	}
+	std::fprintf(ascii, "endsolid grid\n");
+	std::fclose(ascii);
+}
+
+// The ASCII parsing STLFile used to do, without the OpenGL parts
+static std::size_t LoadWithStringstream(const std::string& filepath){
+	std::ifstream myFile(filepath);
+	std::vector<float> vertices;
+	std::string line;
+	while(std::getline(myFile,line)){
+		auto vertex_pos = line.find("vertex ");
+		if(vertex_pos != std::string::npos){
+			std::stringstream stream(line.substr(vertex_pos+7));
+			std::string token;
+			while(stream >> token){
+				vertices.push_back(std::stof(token.c_str()));
+			}
+		}
+	}
+	return vertices.size()/9;
+}
+
+int main(int argc, char** argv){
+	unsigned long triangles = argc > 1 ? std::stoul(argv[1]) : 2000000;
+	int runs = argc > 2 ? std::stoi(argv[2]) : 3;
+	unsigned int size = std::max(1u, (unsigned int)std::sqrt(triangles/2.0));
+
+	std::filesystem::path folder = std::filesystem::temp_directory_path();
+	std::string binaryPath = (folder / "bench_stl_binary.stl").string();
+	std::string asciiPath  = (folder / "bench_stl_ascii.stl").string();
+	WriteGrid(size, binaryPath, asciiPath);
+	double binaryMB = std::filesystem::file_size(binaryPath)/(1024.0*1024.0);
+	double asciiMB  = std::filesystem::file_size(asciiPath)/(1024.0*1024.0);
+
+	STLMesh mesh;
+	std::cout << "grid of " << size*size*2 << " triangles" << std::endl;
+	std::cout << std::left << std::setw(28) << "loader"
+	          << std::right << std::setw(10) << "MB"
+	          << std::setw(12) << "ms"
+	          << std::setw(10) << "MB/s" << std::endl;
+	auto report = [](const char* name, double megabytes, double ms){
+		std::cout << std::left << std::setw(28) << name
+		          << std::right << std::fixed << std::setprecision(1)
+		          << std::setw(10) << megabytes
+		          << std::setw(12) << ms
+		          << std::setw(10) << megabytes/(ms/1000.0) << std::endl;
+	};
+
+	// The old parser is slow, once is enough
+	double old = TimeBestOf(1, [&](){ LoadWithStringstream(asciiPath); });
+	report("ASCII, getline+stringstream", asciiMB, old);
+	double ascii = TimeBestOf(runs, [&](){ mesh.Load(asciiPath); });
+	report("ASCII, STLMesh", asciiMB, ascii);
+	unsigned int asciiVertices = mesh.GetVertexCount();
+	double binary = TimeBestOf(runs, [&](){ mesh.Load(binaryPath); });
+	report("binary, STLMesh", binaryMB, binary);
+
+	std::cout << "welded " << mesh.GetTriangleCount()*3 << " corners into "
+	          << mesh.GetVertexCount() << " vertices (expected " << (size+1)*(size+1) << ")" << std::endl;
+
+	std::filesystem::remove(binaryPath);
+	std::filesystem::remove(asciiPath);
+	bool ok = mesh.GetVertexCount() == (size+1)*(size+1) && asciiVertices == mesh.GetVertexCount();
+	return ok ? 0 : 1;
+}
@@ -1,11 +1,14 @@
 # Run with: python3 build.py
 import os
+import sys
 import platform
 
 # (1)==================== COMMON CONFIGURATION OPTIONS ======================= #
 COMPILER="g++ -g -std=c++17"   # The compiler we want to use 
                                 #(You may try g++ if you have trouble)
 SOURCE="./src/*.cpp"    # Where the source code lives
+# Memory mapped file reading is shared with the mesh example in 06
+SOURCE+=" ./../../06/mesh/mappedfile.cpp"
 EXECUTABLE="prog"        # Name of the final executable
 # ======================= COMMON CONFIGURATION OPTIONS ======================= #
 
@@ -17,20 +20,27 @@ LIBRARIES=""            # What libraries do we want to include
 
 if platform.system()=="Linux":
     ARGUMENTS="-D LINUX" # -D is a #define sent to preprocessor
-    INCLUDE_DIR="-I ./include/ -I ./../../common/thirdparty/glm/"
+    INCLUDE_DIR="-I ./include/ -I ./../../06/mesh/ -I ./../../common/thirdparty/glm/"
     LIBRARIES="-lSDL2 -ldl"
 elif platform.system()=="Darwin":
     ARGUMENTS="-D MAC" # -D is a #define sent to the preprocessor.
-    INCLUDE_DIR="-I ./include/ -I/Library/Frameworks/SDL2.framework/Headers -I./../../common/thirdparty/old/glm"
+    INCLUDE_DIR="-I ./include/ -I ./../../06/mesh/ -I/Library/Frameworks/SDL2.framework/Headers -I./../../common/thirdparty/old/glm"
     LIBRARIES="-F/Library/Frameworks -framework SDL2"
 elif platform.system()=="Windows":
     ARGUMENTS="-D MINGW -static-libgcc -static-libstdc++" 
-    INCLUDE_DIR="-I./include/ -I./../../common/thirdparty/old/glm/"
+    INCLUDE_DIR="-I./include/ -I./../../06/mesh/ -I./../../common/thirdparty/old/glm/"
     EXECUTABLE="prog.exe"
     LIBRARIES="-lmingw32 -lSDL2main -lSDL2 -mwindows"
 # (2)=================== Platform specific configuration ===================== #
 
 # (3)====================== Building the Executable ========================== #
+# 'python3 build.py bench' instead builds the STL loading benchmark,
+# which does not need SDL or OpenGL.
+if len(sys.argv) > 1 and sys.argv[1]=="bench":
+    benchString="g++ -O2 -std=c++17 "+ARGUMENTS+" ./bench/bench_stl.cpp ./src/STLMesh.cpp ./../../06/mesh/mappedfile.cpp -o bench_stl -I ./include/ -I ./../../06/mesh/"
+    print(benchString)
+    exit(0 if os.system(benchString)==0 else 1)
+
 # Build a string of our compile commands that we run in the terminal
 compileString=COMPILER+" "+ARGUMENTS+" "+SOURCE+" -o "+EXECUTABLE+" "+" "+INCLUDE_DIR+" "+LIBRARIES
 # Print out the compile string
@@ -9,6 +9,7 @@
 
 #include <glad/glad.h>
 #include "util.hpp"
+#include "STLMesh.hpp"
 
 #include "globals.hpp"
 
@@ -16,25 +17,26 @@
 // one normal per triangle, and then the following three triangles
 // The .stl bunny was obtained from: https://en.m.wikipedia.org/wiki/File:Stanford_Bunny.stl
 // And then modified in blender3D.
+//
+// The file is loaded (binary or ASCII) and welded into an indexed
+// mesh by STLMesh, then drawn with glDrawElements.
 struct STLFile{
 	private:
 		std::string mFilepath;
-		std::vector<float> mVertices;
-		std::vector<float> mNormals;
-		std::vector<float> mColors;
+		STLMesh mMesh;
 
 		GLuint mVAO= 0;
-		GLuint mVBO[3];
+		GLuint mVBO= 0;	// Interleaved positions and normals
+		GLuint mIBO= 0;	// Indices
 
 		GLuint mShaderID	= 0;
 	public:
-		STLFile();
+		STLFile(const std::string& filepath);
 		~STLFile();
 		void Initialize();
         void PreDraw();
 		void Draw();
-		std::vector<float> GetVertices() const;
-		std::vector<float> GetNormals() const;
+		const STLMesh& GetMesh() const;
 };
 
 
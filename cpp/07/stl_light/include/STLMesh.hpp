@@ -0,0 +1,33 @@
+#ifndef STL_MESH_HPP
+#define STL_MESH_HPP
+
+#include <vector>
+#include <string>
+
+// The triangles of an .stl file, welded into an indexed mesh.
+//
+// STL stores every triangle on its own ('triangle soup'), so a vertex
+// shared by six triangles is written out six times. Loading welds
+// vertices with exactly the same position back together, and gives each
+// one a smooth normal by averaging the normals of the triangles around
+// it (weighted by their area). The normals in the file are ignored,
+// exporters do not always get them right.
+//
+// This part does not use OpenGL, so it can be timed on its own
+// (see bench/bench_stl.cpp).
+struct STLMesh{
+	// Interleaved x,y,z, nx,ny,nz
+	static constexpr unsigned int mStride = 6;
+	std::vector<float> mVertices;
+	// Three indices per triangle into mVertices
+	std::vector<unsigned int> mIndices;
+
+	// Loads a binary or ASCII .stl file. Returns false if the file could
+	// not be opened or is not an STL file.
+	bool Load(const std::string& filepath);
+
+	unsigned int GetVertexCount() const { return mVertices.size()/mStride; }
+	unsigned int GetTriangleCount() const { return mIndices.size()/3; }
+};
+
+#endif
@@ -2,8 +2,6 @@
 
 #include <iostream>
 #include <vector>
-#include <sstream>
-#include <fstream>
 #include <string>
 
 #include <glm/glm.hpp>
@@ -18,81 +16,18 @@
 
 
 // Load the STL File
-STLFile::STLFile(){
-    // File input stream for our file
-    std::ifstream myFile("bunny_centered.stl");
-
-    // Check for file existance before proceeding.
-    if(myFile.is_open()){
-        std::string line;
-        while(std::getline(myFile,line)){
-            auto vertex_pos = line.find("vertex ");
-            auto normal_pos = line.find("facet normal ");
-
-            if(vertex_pos != std::string::npos){ 
-                std::string s = line.substr(vertex_pos+7); // "vertex " -- 7 characters including the space
-                std::stringstream stream(s);   
-                std::string token;
-                while(stream >> token){
-                    mVertices.push_back(std::stof(token.c_str()));
-                }
-                
-            }else if(normal_pos != std::string::npos){
-                std::string s = line.substr(normal_pos+13); // "facet normal " -- 13 characters including the space
-                std::stringstream stream(s);   
-                std::string token;
-                while(stream >> token){
-                    //std::cout << "normal: " << token << std::endl;
-                    mNormals.push_back(std::stof(token.c_str()));
-                }
-                // Copy the normals twice somce STL files only provide 1 normal
-                int threeBack = mNormals.size()-1-3;
-                mNormals.push_back(threeBack);
-                mNormals.push_back(threeBack+1);
-                mNormals.push_back(threeBack+2);
-                threeBack = mNormals.size()-1-3;
-                mNormals.push_back(threeBack);
-                mNormals.push_back(threeBack+1);
-                mNormals.push_back(threeBack+2);
-            }
-        }
-
-		// Compute the surface normal manually -- STL file is not trustworthy...
-        // Iterate through 9 vertices at a time
-        for(int i=0; i < mVertices.size(); i+=9){
-            glm::vec3 v1 (mVertices[i],mVertices[i+1],mVertices[i+2]);
-            glm::vec3 v2 (mVertices[i+3],mVertices[i+4],mVertices[i+5]);
-            glm::vec3 v3 (mVertices[i+6],mVertices[i+7],mVertices[i+8]);
-
-            glm::vec3 edge1 = v2 - v1;
-            glm::vec3 edge2 = v3 - v2;
-
-            glm::vec3 normal = cross(edge1,edge2);
-            std::cout << "mine:" << normal.x << "," << normal.y << "," << normal.z << std::endl;
-            std::cout << "them:" <<  mNormals[i] << "," << mNormals[i+1] << "," <<  mNormals[i+2] << std::endl;
-
-            // Replace the normlals
-            mNormals[i+0] = normal.x;
-            mNormals[i+1] = normal.y;
-            mNormals[i+2] = normal.z;
-
-            mNormals[i+3] = normal.x;
-            mNormals[i+4] = normal.y;
-            mNormals[i+5] = normal.z;
-
-            mNormals[i+6] = normal.x;
-            mNormals[i+7] = normal.y;
-            mNormals[i+8] = normal.z;
-
-        }
-
-
+STLFile::STLFile(const std::string& filepath){
+    mFilepath = filepath;
+    if(mMesh.Load(filepath)){
+        std::cout << "Loaded " << filepath << ": " << mMesh.GetTriangleCount() << " triangles, "
+                  << mMesh.GetVertexCount() << " vertices after welding" << std::endl;
     }
 }
 
 STLFile::~STLFile(){
     // Delete our OpenGL Objects
-    glDeleteBuffers(3, mVBO);
+    glDeleteBuffers(1, &mVBO);
+    glDeleteBuffers(1, &mIBO);
     glDeleteVertexArrays(1, &mVAO);
 
     // Delete our Graphics pipeline
@@ -111,25 +46,24 @@ void STLFile::Initialize(){
 		glBindVertexArray(mVAO);
 
 		// Vertex Buffer Object (VBO) creation
-		glGenBuffers(3, mVBO);
+		glGenBuffers(1, &mVBO);
 
-		// Populate our vertex buffer objects
-        // Position information (x,y,z)
-		glBindBuffer(GL_ARRAY_BUFFER, mVBO[0]);
-		glBufferData(GL_ARRAY_BUFFER,mVertices.size() * sizeof(float), mVertices.data(), GL_STATIC_DRAW);
+		// Populate our vertex buffer object
+        // Interleaved position (x,y,z) and normal (nx,ny,nz)
+		glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+		glBufferData(GL_ARRAY_BUFFER,mMesh.mVertices.size() * sizeof(float), mMesh.mVertices.data(), GL_STATIC_DRAW);
 		glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,0,(void*)0);
-
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,sizeof(float)*STLMesh::mStride,(void*)0);
         // Normals
-		glBindBuffer(GL_ARRAY_BUFFER, mVBO[1]);
-		glBufferData(GL_ARRAY_BUFFER,mNormals.size() * sizeof(float), mNormals.data(), GL_STATIC_DRAW);
         glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,0,(void*)0);
-        // Color information (r,g,b)
-		glBindBuffer(GL_ARRAY_BUFFER, mVBO[2]);
-		glBufferData(GL_ARRAY_BUFFER,mNormals.size() * sizeof(float), mNormals.data(), GL_STATIC_DRAW);
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE,0,(void*)0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,sizeof(float)*STLMesh::mStride,(void*)(sizeof(float)*3));
+        // There is no color information in an STL, attribute 2
+        // (vertexColors) keeps its default value.
+
+        // Index Buffer Object (IBO)
+		glGenBuffers(1, &mIBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER,mMesh.mIndices.size() * sizeof(unsigned int), mMesh.mIndices.data(), GL_STATIC_DRAW);
 
 		// Unbind our currently bound Vertex Array Object
 		glBindVertexArray(0);
@@ -137,7 +71,6 @@ void STLFile::Initialize(){
 		// as we do not want to leave them open. 
 		glDisableVertexAttribArray(0);
 		glDisableVertexAttribArray(1);
-		glDisableVertexAttribArray(2);
 }
 
 void STLFile::PreDraw(){
@@ -201,17 +134,9 @@ void STLFile::Draw(){
 
     //Render data
 	glBindVertexArray(mVAO);
-    glDrawArrays(GL_TRIANGLES,0,4404);
+    glDrawElements(GL_TRIANGLES,mMesh.mIndices.size(),GL_UNSIGNED_INT,(void*)0);
 }
 
-std::vector<float> STLFile::GetVertices() const{
-    std::cout << "mVertices:" << mVertices.size() << std::endl;
-    return mVertices;
+const STLMesh& STLFile::GetMesh() const{
+    return mMesh;
 }
-
-std::vector<float> STLFile::GetNormals() const{
-    std::cout << "mNormals :" << mNormals.size() << std::endl;
-    return mNormals;
-}
-
-
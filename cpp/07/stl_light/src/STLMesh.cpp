@@ -0,0 +1,209 @@
+#include "STLMesh.hpp"
+#include "mappedfile.hpp"
+
+#include <iostream>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+// ==================== Vertex welding ====================
+// An open addressing hash table from a position to the vertex it became.
+// Positions are compared bit for bit, which is what we want for STL:
+// exporters write a shared corner with exactly the same numbers every
+// time it appears.
+class Welder{
+public:
+	Welder(STLMesh& mesh, std::size_t expectedVertices) : mMesh(mesh){
+		std::size_t capacity = 16;
+		while(capacity < expectedVertices*2){
+			capacity <<= 1;
+		}
+		mSlots.assign(capacity, EMPTY);
+		mMesh.mVertices.reserve(expectedVertices*STLMesh::mStride);
+	}
+
+	// Adds a corner of a triangle, re-using the vertex if this
+	// position has been seen before
+	void AddCorner(const float position[3]){
+		uint32_t key[3];
+		for(int i=0; i < 3; ++i){
+			// -0.0 and 0.0 are the same place
+			float p = position[i] == 0.0f ? 0.0f : position[i];
+			std::memcpy(&key[i], &p, sizeof(float));
+		}
+		if((mCount+1)*2 > mSlots.size()){
+			Grow();
+		}
+		std::size_t mask = mSlots.size()-1;
+		std::size_t i = Hash(key) & mask;
+		while(mSlots[i] != EMPTY){
+			const float* v = &mMesh.mVertices[mSlots[i]*STLMesh::mStride];
+			if(std::memcmp(v, key, sizeof(key))==0){
+				mMesh.mIndices.push_back(mSlots[i]);
+				return;
+			}
+			i = (i+1) & mask;
+		}
+		mSlots[i] = mCount++;
+		mMesh.mIndices.push_back(mSlots[i]);
+		float vertex[STLMesh::mStride]{0.0f,0.0f,0.0f, 0.0f,0.0f,0.0f};
+		std::memcpy(vertex, key, sizeof(key));
+		mMesh.mVertices.insert(mMesh.mVertices.end(), vertex, vertex+STLMesh::mStride);
+	}
+
+private:
+	static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+
+	static std::size_t Hash(const uint32_t key[3]){
+		uint64_t h = key[0] * 0x9E3779B97F4A7C15ull;
+		h ^= (key[1] * 0xC2B2AE3D27D4EB4Full) + (h << 6);
+		h ^= (key[2] * 0x165667B19E3779F9ull) + (h >> 2);
+		h ^= h >> 29;
+		return (std::size_t)h;
+	}
+
+	void Grow(){
+		mSlots.assign(mSlots.size()*2, EMPTY);
+		std::size_t mask = mSlots.size()-1;
+		for(uint32_t vertex=0; vertex < mCount; ++vertex){
+			uint32_t key[3];
+			std::memcpy(key, &mMesh.mVertices[vertex*STLMesh::mStride], sizeof(key));
+			std::size_t i = Hash(key) & mask;
+			while(mSlots[i] != EMPTY){
+				i = (i+1) & mask;
+			}
+			mSlots[i] = vertex;
+		}
+	}
+
+	STLMesh& mMesh;
+	std::vector<uint32_t> mSlots;
+	uint32_t mCount{0};
+};
+
+// ==================== Parsing ====================
+// Binary STL:
+//      80 byte header
+//      uint32 triangle count
+//      50 bytes per triangle: normal (3 floats), 3 corners (9 floats), uint16 attribute
+static constexpr std::size_t BINARY_HEADER = 84;
+static constexpr std::size_t BINARY_RECORD = 50;
+
+static void ParseBinary(const char* data, uint32_t triangleCount, Welder& welder){
+	const char* record = data + BINARY_HEADER;
+	for(uint32_t t=0; t < triangleCount; ++t, record += BINARY_RECORD){
+		// The records are only 2 byte aligned, so copy the floats out
+		float corners[9];
+		std::memcpy(corners, record+12, sizeof(corners));
+		welder.AddCorner(corners+0);
+		welder.AddCorner(corners+3);
+		welder.AddCorner(corners+6);
+	}
+}
+
+// ASCII STL. Only the 'vertex x y z' lines matter, every three of them
+// make a triangle ('facet normal', 'outer loop', etc. are skipped).
+static void ParseASCII(const char* p, const char* end, Welder& welder){
+	float corner[3];
+	while(p < end){
+		const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end-p));
+		if(lineEnd == nullptr){
+			lineEnd = end;
+		}
+		while(p < lineEnd && (*p==' ' || *p=='\t')){
+			++p;
+		}
+		if(lineEnd-p > 6 && std::memcmp(p, "vertex", 6)==0){
+			p += 6;
+			int i = 0;
+			for(; i < 3; ++i){
+				while(p < lineEnd && (*p==' ' || *p=='\t' || *p=='+')){
+					++p;
+				}
+				auto [next, error] = std::from_chars(p, lineEnd, corner[i]);
+				if(error != std::errc()){
+					break;
+				}
+				p = next;
+			}
+			if(i == 3){
+				welder.AddCorner(corner);
+			}
+		}
+		p = lineEnd+1;
+	}
+}
+
+// Area weighted, smooth normals: each triangle adds its (unnormalized)
+// face normal to its three corners, then every vertex is normalized.
+static void ComputeSmoothNormals(STLMesh& mesh){
+	const unsigned int stride = STLMesh::mStride;
+	float* v = mesh.mVertices.data();
+	for(std::size_t i=0; i+2 < mesh.mIndices.size(); i+=3){
+		float* a = v + mesh.mIndices[i+0]*stride;
+		float* b = v + mesh.mIndices[i+1]*stride;
+		float* c = v + mesh.mIndices[i+2]*stride;
+		float e1[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+		float e2[3] = {c[0]-a[0], c[1]-a[1], c[2]-a[2]};
+		float n[3]  = {e1[1]*e2[2]-e1[2]*e2[1],
+		               e1[2]*e2[0]-e1[0]*e2[2],
+		               e1[0]*e2[1]-e1[1]*e2[0]};
+		for(float* corner : {a,b,c}){
+			corner[3] += n[0];
+			corner[4] += n[1];
+			corner[5] += n[2];
+		}
+	}
+	for(std::size_t i=0; i < mesh.mVertices.size(); i+=stride){
+		float* n = v + i + 3;
+		float length = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+		if(length > 0.0f){
+			n[0] /= length;
+			n[1] /= length;
+			n[2] /= length;
+		}
+	}
+}
+
+bool STLMesh::Load(const std::string& filepath){
+	mVertices.clear();
+	mIndices.clear();
+
+	MappedFile file;
+	if(!file.Open(filepath)){
+		std::cout << "STLMesh: unable to open " << filepath << std::endl;
+		return false;
+	}
+
+	// A binary file is exactly as big as its triangle count says.
+	// (Checking for 'solid' at the start is not enough, some binary
+	// exporters put 'solid' in the header too.)
+	uint32_t triangleCount = 0;
+	bool binary = false;
+	if(file.Size() >= BINARY_HEADER){
+		std::memcpy(&triangleCount, file.Data()+80, sizeof(triangleCount));
+		binary = BINARY_HEADER + (std::size_t)triangleCount*BINARY_RECORD == file.Size();
+	}
+
+	if(binary){
+		// Typical closed meshes have about half as many vertices as triangles
+		Welder welder(*this, triangleCount/2);
+		mIndices.reserve((std::size_t)triangleCount*3);
+		ParseBinary(file.Data(), triangleCount, welder);
+	}else if(file.Size() >= 5 && std::memcmp(file.Data(), "solid", 5)==0){
+		// About 250 bytes of text per triangle
+		std::size_t expectedTriangles = file.Size()/250;
+		Welder welder(*this, expectedTriangles/2);
+		mIndices.reserve(expectedTriangles*3);
+		ParseASCII(file.Data(), file.Data()+file.Size(), welder);
+	}else{
+		std::cout << "STLMesh: " << filepath << " is not an STL file" << std::endl;
+		return false;
+	}
+
+	// Drop a trailing partial triangle from a truncated ASCII file
+	mIndices.resize(mIndices.size()/3*3);
+	ComputeSmoothNormals(*this);
+	return true;
+}
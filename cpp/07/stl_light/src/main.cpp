@@ -91,7 +91,7 @@ void InitializeProgram(){
 		}
 
     // Setup Light(s)
-	g.gBunny = new STLFile;
+	g.gBunny = new STLFile("bunny_centered.stl");
 
     g.gLight.Initialize();
 	g.gBunny->Initialize();
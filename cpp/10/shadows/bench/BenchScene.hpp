@@ -0,0 +1,100 @@
+// The sample's scene, for the benchmarks that draw it scaled up.
+//
+// The things are the sample's kinds of things: textured quads (brick,
+// the terrain's color and detail maps, the height map), small terrains,
+// and a transparent quad. The shaders are the three the sample draws
+// them with (the terrain's with one and with two lights, and the shadow
+// mapping one). A benchmark picks from both at random for each object.
+//
+// Everything here runs on the fake driver (bench/FakeGL.hpp), and must
+// be run from the sample's folder, as the shaders are read from
+// ./shaders/ and the textures from ./../../common/textures/.
+#ifndef BENCHSCENE_HPP
+#define BENCHSCENE_HPP
+
+#include "Object.hpp"
+#include "Terrain.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "UniformBuffer.hpp"
+#include "FakeGL.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ShaderFiles{
+    const char* vertex;
+    const char* fragment;
+    ShaderDefines defines;
+};
+
+struct BenchScene{
+    std::vector<std::shared_ptr<Object>> things;
+    // A name for each thing (e.g. to save it by)
+    std::vector<std::string> thingNames;
+    std::vector<ShaderFiles> shaders;
+};
+
+// Installs the fake driver, with the uniforms and blocks the shaders have
+inline void BenchSceneInstallFakeGL(){
+    FakeGLInstall();
+    FakeGLSetUniforms({"model", "u_DiffuseMap", "u_DetailMap"},
+                      {{"FrameData", (GLint)sizeof(FrameData)}, {"LightData", (GLint)sizeof(LightData)},
+                       {"ObjectData", (GLint)sizeof(ObjectData)}});
+}
+
+// Keeps std::cout quiet until End() (or until it is destroyed). The
+// constructors print a line each, which is not what we measure.
+class BenchQuiet{
+public:
+    BenchQuiet() : m_console(std::cout.rdbuf(m_quiet.rdbuf())){}
+    ~BenchQuiet(){ End(); }
+    void End(){
+        if(m_console != nullptr){
+            std::cout.rdbuf(m_console);
+            m_console = nullptr;
+        }
+    }
+private:
+    std::ostringstream m_quiet;
+    std::streambuf* m_console;
+};
+
+// Makes the things, and lists the shaders
+inline BenchScene MakeBenchScene(){
+    BenchScene scene;
+    const char* textures[] = {"./../../common/textures/brick.ppm", "./../../common/textures/colormap.ppm",
+                              "./../../common/textures/detailmap.ppm", "./../../common/textures/terrain2.ppm"};
+    for(const char* texture : textures){
+        scene.things.push_back(std::make_shared<Object>());
+        scene.things.back()->MakeTexturedQuad(texture);
+        scene.thingNames.push_back(std::string("quad:") + texture);
+    }
+    for(int i=0; i < 2; ++i){
+        std::shared_ptr<Terrain> terrain = std::make_shared<Terrain>(32, 32, "./../../common/textures/terrain2.ppm");
+        terrain->LoadTextures(textures[1], textures[2]);
+        scene.things.push_back(terrain);
+        scene.thingNames.push_back("terrain" + std::to_string(i));
+    }
+    scene.things.push_back(std::make_shared<Object>());
+    scene.things.back()->MakeTexturedQuad(textures[0]);
+    scene.things.back()->SetTransparent(true);
+    scene.thingNames.push_back("window");
+
+    scene.shaders = {
+        {"./shaders/vert.glsl", "./shaders/frag.glsl", ShaderDefines().Set("LIGHT_COUNT", 1)},
+        {"./shaders/vert.glsl", "./shaders/frag.glsl", ShaderDefines().Set("LIGHT_COUNT", 2)},
+        {"./shaders/3.1.3.shadow_mapping.vs", "./shaders/3.1.3.shadow_mapping.fs", ShaderDefines().Set("PCF_RADIUS", 1)},
+    };
+    return scene;
+}
+
+// Milliseconds since 'start'
+inline double Since(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+#endif
@@ -0,0 +1,226 @@
+// A stand-in for the OpenGL driver, for benchmarks that count GL calls.
+//
+// glad calls OpenGL through function pointers, so pointing them at these
+// functions lets the engine's code run without a window or a GPU. Each
+// call is counted (draws on their own too). Programs 'link' successfully and report the uniforms
+// (and uniform blocks) they were given with FakeGLSetUniforms.
+//
+// Times measured with it are the CPU time of our own code only -- a real
+// driver does a lot more work per call, so fewer calls is worth more than
+// the numbers show.
+#ifndef FAKEGL_HPP
+#define FAKEGL_HPP
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstring>
+#include <cstdint>
+
+struct FakeGLCounters{
+    uint64_t calls{0};              // Every GL call
+    uint64_t uniformLocations{0};   // glGetUniformLocation
+    uint64_t uniformSets{0};        // glUniform*
+    uint64_t bufferUploads{0};      // glBufferData/glBufferSubData with data
+    uint64_t draws{0};              // glDrawArrays/glDrawElements(Instanced)
+};
+
+inline FakeGLCounters g_fakeGL;
+// Uniform names of every program (the fake has one set for all of them)
+inline std::vector<std::string> g_fakeGLUniforms;
+// Uniform block names and sizes (in bytes)
+inline std::vector<std::pair<std::string,GLint>> g_fakeGLUniformBlocks;
+
+inline void FakeGLSetUniforms(const std::vector<std::string>& names,
+                              const std::vector<std::pair<std::string,GLint>>& blocks = {}){
+    g_fakeGLUniforms = names;
+    g_fakeGLUniformBlocks = blocks;
+}
+
+namespace fakegl{
+    // Every object gets a different name, as GLState skips binding the
+    // same one again
+    inline GLuint NextName(){
+        static GLuint next = 1;
+        return next++;
+    }
+    inline void GenNames(GLsizei n, GLuint* names){
+        ++g_fakeGL.calls;
+        for(GLsizei i=0; i < n; ++i){
+            names[i] = NextName();
+        }
+    }
+    inline GLuint CreateProgram(){ ++g_fakeGL.calls; return NextName(); }
+    inline GLuint CreateShader(GLenum){ ++g_fakeGL.calls; return NextName(); }
+    inline void ShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*){ ++g_fakeGL.calls; }
+    inline void Program(GLuint){ ++g_fakeGL.calls; }
+    inline void ProgramShader(GLuint, GLuint){ ++g_fakeGL.calls; }
+    inline void GetShaderiv(GLuint, GLenum, GLint* value){ ++g_fakeGL.calls; *value = GL_TRUE; }
+    inline void GetProgramiv(GLuint, GLenum name, GLint* value){
+        ++g_fakeGL.calls;
+        if(name == GL_ACTIVE_UNIFORMS){
+            *value = (GLint)g_fakeGLUniforms.size();
+        }else if(name == GL_ACTIVE_UNIFORM_MAX_LENGTH){
+            std::size_t longest = 0;
+            for(const std::string& uniform : g_fakeGLUniforms){
+                longest = uniform.size()+1 > longest ? uniform.size()+1 : longest;
+            }
+            *value = (GLint)longest;
+        }else if(name == GL_ACTIVE_UNIFORM_BLOCKS){
+            *value = (GLint)g_fakeGLUniformBlocks.size();
+        }else{
+            *value = GL_TRUE;
+        }
+    }
+    inline void GetActiveUniform(GLuint, GLuint index, GLsizei bufferSize, GLsizei* length,
+                                 GLint* size, GLenum* type, GLchar* name){
+        ++g_fakeGL.calls;
+        const std::string& uniform = g_fakeGLUniforms[index];
+        std::size_t n = uniform.size() < (std::size_t)bufferSize ? uniform.size() : bufferSize-1;
+        std::memcpy(name, uniform.data(), n);
+        name[n] = '\0';
+        *length = (GLsizei)n;
+        *size = 1;
+        // Good enough for the type checks: matrices, vectors and samplers by name
+        *type = uniform == "model" || uniform == "view" || uniform == "projection" ||
+                uniform == "lightSpaceMatrix" ? GL_FLOAT_MAT4 :
+                uniform.find("Map") != std::string::npos ? GL_SAMPLER_2D :
+                uniform.find("Color") != std::string::npos || uniform.find("Pos") != std::string::npos ? GL_FLOAT_VEC3 :
+                GL_FLOAT;
+    }
+    // Drivers look names up in a table too, this is a simple version of that
+    inline GLint GetUniformLocation(GLuint, const GLchar* name){
+        ++g_fakeGL.calls;
+        ++g_fakeGL.uniformLocations;
+        for(std::size_t i=0; i < g_fakeGLUniforms.size(); ++i){
+            if(std::strcmp(g_fakeGLUniforms[i].c_str(), name) == 0){
+                return (GLint)i;
+            }
+        }
+        return -1;
+    }
+    inline void Uniform1i(GLint, GLint){ ++g_fakeGL.calls; ++g_fakeGL.uniformSets; }
+    inline void Uniform1f(GLint, GLfloat){ ++g_fakeGL.calls; ++g_fakeGL.uniformSets; }
+    inline void Uniform3f(GLint, GLfloat, GLfloat, GLfloat){ ++g_fakeGL.calls; ++g_fakeGL.uniformSets; }
+    inline void UniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*){ ++g_fakeGL.calls; ++g_fakeGL.uniformSets; }
+    inline void GetActiveUniformBlockName(GLuint, GLuint index, GLsizei bufferSize, GLsizei* length, GLchar* name){
+        ++g_fakeGL.calls;
+        const std::string& block = g_fakeGLUniformBlocks[index].first;
+        std::size_t n = block.size() < (std::size_t)bufferSize ? block.size() : bufferSize-1;
+        std::memcpy(name, block.data(), n);
+        name[n] = '\0';
+        *length = (GLsizei)n;
+    }
+    inline void GetActiveUniformBlockiv(GLuint, GLuint index, GLenum name, GLint* value){
+        ++g_fakeGL.calls;
+        if(name == GL_UNIFORM_BLOCK_NAME_LENGTH){
+            *value = (GLint)g_fakeGLUniformBlocks[index].first.size()+1;
+        }else{
+            *value = g_fakeGLUniformBlocks[index].second;
+        }
+    }
+    inline void UniformBlockBinding(GLuint, GLuint, GLuint){ ++g_fakeGL.calls; }
+    inline void DeleteBuffers(GLsizei, const GLuint*){ ++g_fakeGL.calls; }
+    inline void BindBuffer(GLenum, GLuint){ ++g_fakeGL.calls; }
+    inline void BindBufferBase(GLenum, GLuint, GLuint){ ++g_fakeGL.calls; }
+    inline void BufferData(GLenum, GLsizeiptr, const void* data, GLenum){
+        ++g_fakeGL.calls;
+        if(data != nullptr){
+            ++g_fakeGL.bufferUploads;
+        }
+    }
+    inline void BufferSubData(GLenum, GLintptr, GLsizeiptr, const void*){ ++g_fakeGL.calls; ++g_fakeGL.bufferUploads; }
+    inline void DrawElements(GLenum, GLsizei, GLenum, const void*){ ++g_fakeGL.calls; ++g_fakeGL.draws; }
+    inline void DrawArrays(GLenum, GLint, GLsizei){ ++g_fakeGL.calls; ++g_fakeGL.draws; }
+    inline void DrawElementsInstanced(GLenum, GLsizei, GLenum, const void*, GLsizei){ ++g_fakeGL.calls; ++g_fakeGL.draws; }
+
+    // Any other call, which is only counted
+    template<typename F> struct Counted;
+    template<typename R, typename... A> struct Counted<R(APIENTRY*)(A...)>{
+        static R APIENTRY Call(A...){
+            ++g_fakeGL.calls;
+            return R();
+        }
+    };
+    template<typename F> inline void Count(F& function){
+        function = &Counted<F>::Call;
+    }
+}
+
+// Point glad at the fake driver
+inline void FakeGLInstall(){
+    glad_glCreateProgram = fakegl::CreateProgram;
+    glad_glCreateShader = fakegl::CreateShader;
+    glad_glShaderSource = fakegl::ShaderSource;
+    glad_glCompileShader = fakegl::Program;
+    glad_glLinkProgram = fakegl::Program;
+    glad_glValidateProgram = fakegl::Program;
+    glad_glUseProgram = fakegl::Program;
+    glad_glDeleteProgram = fakegl::Program;
+    glad_glDeleteShader = fakegl::Program;
+    glad_glAttachShader = fakegl::ProgramShader;
+    glad_glDetachShader = fakegl::ProgramShader;
+    glad_glGetShaderiv = fakegl::GetShaderiv;
+    glad_glGetProgramiv = fakegl::GetProgramiv;
+    glad_glGetActiveUniform = fakegl::GetActiveUniform;
+    glad_glGetUniformLocation = fakegl::GetUniformLocation;
+    glad_glUniform1i = fakegl::Uniform1i;
+    glad_glUniform1f = fakegl::Uniform1f;
+    glad_glUniform3f = fakegl::Uniform3f;
+    glad_glUniformMatrix4fv = fakegl::UniformMatrix4fv;
+    glad_glGetActiveUniformBlockName = fakegl::GetActiveUniformBlockName;
+    glad_glGetActiveUniformBlockiv = fakegl::GetActiveUniformBlockiv;
+    glad_glUniformBlockBinding = fakegl::UniformBlockBinding;
+    glad_glGenBuffers = fakegl::GenNames;
+    glad_glGenTextures = fakegl::GenNames;
+    glad_glGenVertexArrays = fakegl::GenNames;
+    glad_glGenFramebuffers = fakegl::GenNames;
+    glad_glGenRenderbuffers = fakegl::GenNames;
+    glad_glDeleteBuffers = fakegl::DeleteBuffers;
+    glad_glBindBuffer = fakegl::BindBuffer;
+    glad_glBindBufferBase = fakegl::BindBufferBase;
+    glad_glBufferData = fakegl::BufferData;
+    glad_glBufferSubData = fakegl::BufferSubData;
+    glad_glDrawElements = fakegl::DrawElements;
+    glad_glDrawArrays = fakegl::DrawArrays;
+    glad_glDrawElementsInstanced = fakegl::DrawElementsInstanced;
+    // Setting up textures, meshes and framebuffers
+    fakegl::Count(glad_glTexImage2D);
+    fakegl::Count(glad_glTexParameteri);
+    fakegl::Count(glad_glTexParameterfv);
+    fakegl::Count(glad_glGenerateMipmap);
+    fakegl::Count(glad_glDeleteTextures);
+    fakegl::Count(glad_glDeleteVertexArrays);
+    fakegl::Count(glad_glDeleteFramebuffers);
+    fakegl::Count(glad_glEnableVertexAttribArray);
+    fakegl::Count(glad_glDisableVertexAttribArray);
+    fakegl::Count(glad_glVertexAttribPointer);
+    fakegl::Count(glad_glVertexAttribDivisor);
+    fakegl::Count(glad_glFramebufferTexture2D);
+    fakegl::Count(glad_glBindRenderbuffer);
+    fakegl::Count(glad_glRenderbufferStorage);
+    fakegl::Count(glad_glFramebufferRenderbuffer);
+    fakegl::Count(glad_glDrawBuffer);
+    fakegl::Count(glad_glReadBuffer);
+    // State, and clearing
+    fakegl::Count(glad_glGetIntegerv);
+    fakegl::Count(glad_glBindBufferRange);
+    fakegl::Count(glad_glBindVertexArray);
+    fakegl::Count(glad_glBindTexture);
+    fakegl::Count(glad_glActiveTexture);
+    fakegl::Count(glad_glBindFramebuffer);
+    fakegl::Count(glad_glViewport);
+    fakegl::Count(glad_glClearColor);
+    fakegl::Count(glad_glClear);
+    fakegl::Count(glad_glEnable);
+    fakegl::Count(glad_glDisable);
+    fakegl::Count(glad_glDepthMask);
+    fakegl::Count(glad_glDepthFunc);
+    fakegl::Count(glad_glBlendFunc);
+    fakegl::Count(glad_glPolygonMode);
+    fakegl::Count(glad_glCullFace);
+}
+
+#endif
@@ -0,0 +1,55 @@
+// An OpenGL context without a window, for benchmarks that need a real
+// driver (Linux only, with Mesa's EGL).
+//
+// Uses EGL's 'surfaceless' platform, so it works without a display, e.g.
+// over ssh. With LIBGL_ALWAYS_SOFTWARE=1 Mesa runs on the CPU (llvmpipe).
+// Build with -lEGL.
+#ifndef HEADLESSGL_HPP
+#define HEADLESSGL_HPP
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <iostream>
+
+// For gladLoadGLLoader (and anything else taking a GLADloadproc)
+inline void* HeadlessGLGetProcAddress(const char* name){
+    return (void*)eglGetProcAddress(name);
+}
+
+// Makes an OpenGL 3.3 core context current, and loads glad.
+// Returns false if there is no driver to make one with.
+inline bool HeadlessGLCreate(){
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if(getPlatformDisplay == nullptr){
+        std::cout << "HeadlessGL: EGL cannot make a display without a window" << std::endl;
+        return false;
+    }
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    EGLint major = 0, minor = 0;
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API)){
+        std::cout << "HeadlessGL: could not start EGL (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        return false;
+    }
+    const EGLint attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+    if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)){
+        std::cout << "HeadlessGL: could not create an OpenGL 3.3 context (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        return false;
+    }
+    if(!gladLoadGLLoader(HeadlessGLGetProcAddress)){
+        std::cout << "HeadlessGL: failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    std::cout << "OpenGL: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+    return true;
+}
+
+#endif
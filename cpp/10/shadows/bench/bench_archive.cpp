@@ -0,0 +1,168 @@
+// Times reading every file in an archive, against reading the same files
+// loose from the disk.
+//
+// Usage (from cpp/10/shadows, after packing the assets):
+//      ./bin/bench_archive ./assets/assets.pack ./../../
+//
+// 'cold' asks the operating system to drop the files from its cache first
+// (posix_fadvise), so the reads have to go to the disk. That is what the
+// first run of the program after a reboot sees. 'warm' reads them again
+// straight after, from the cache.
+#include "Archive.hpp"
+#include "VirtualFileSystem.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#if defined(LINUX) || defined(MAC)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// Evicts a file from the page cache. Returns false if that is not possible
+// here, in which case 'cold' numbers are really warm ones.
+static bool DropFromCache(const std::string& path){
+#if defined(LINUX)
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    fdatasync(fd);
+    bool dropped = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return dropped;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+// Every byte has to actually be read, or the zero-copy archive path would
+// only be timing a pointer assignment
+static uint64_t Checksum(const char* data, std::size_t size){
+    uint64_t sum = 0;
+    std::size_t i = 0;
+    for(; i+8 <= size; i+=8){
+        uint64_t word;
+        std::memcpy(&word, data+i, sizeof(word));
+        sum += word;
+    }
+    for(; i < size; ++i){
+        sum += (uint8_t)data[i];
+    }
+    return sum;
+}
+
+struct Result{
+    double ms{0.0};
+    uint64_t bytes{0};
+    uint64_t checksum{0};
+};
+
+static Result ReadLoose(const std::vector<std::string>& paths){
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    std::vector<char> storage;
+    for(const std::string& path : paths){
+        const char* data = nullptr;
+        std::size_t size = 0;
+        if(VirtualFileSystem::Instance().ReadFile(path, storage, data, size)){
+            result.bytes += size;
+            result.checksum ^= Checksum(data, size);
+        }
+    }
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+    return result;
+}
+
+static Result ReadArchive(const std::string& archivePath, const std::vector<std::string>& names){
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    Archive archive;
+    if(!archive.Open(archivePath)){
+        return result;
+    }
+    std::vector<char> storage;
+    for(const std::string& name : names){
+        const ArchiveEntry* entry = archive.Find(name);
+        const char* data = nullptr;
+        std::size_t size = 0;
+        if(entry != nullptr && archive.Read(*entry, storage, data, size)){
+            result.bytes += size;
+            result.checksum ^= Checksum(data, size);
+        }
+    }
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+    return result;
+}
+
+static void Print(const char* label, const Result& result){
+    std::cout << std::left << std::setw(16) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << result.ms << " ms"
+              << std::setw(10) << (result.bytes/(1024.0*1024.0))/(result.ms/1000.0) << " MB/s" << std::endl;
+}
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        std::cout << "usage: bench_archive <archive> <root the archive was packed from>" << std::endl;
+        return 1;
+    }
+    const std::string archivePath = argv[1];
+    const std::string root = argv[2];
+
+    Archive archive;
+    if(!archive.Open(archivePath)){
+        std::cout << "bench_archive: unable to open " << archivePath << std::endl;
+        return 1;
+    }
+    // The loose files are the ones in the archive
+    std::vector<std::string> names;
+    std::vector<std::string> paths;
+    uint64_t stored = 0;
+    unsigned int compressed = 0;
+    for(uint32_t i=0; i < archive.GetSlotCount(); ++i){
+        const ArchiveEntry& entry = archive.GetSlots()[i];
+        if(entry.hash == 0){
+            continue;
+        }
+        names.emplace_back(archive.GetName(entry));
+        paths.push_back(root + "/" + names.back());
+        stored += entry.storedSize;
+        compressed += (entry.flags & ARCHIVE_COMPRESSED) ? 1 : 0;
+    }
+    archive.Close();
+
+    Result loose = ReadLoose(paths);
+    std::cout << names.size() << " files, " << loose.bytes/1024 << " KB ("
+              << stored/1024 << " KB stored, " << compressed << " compressed)" << std::endl;
+
+    bool cold = true;
+    for(const std::string& path : paths){
+        cold &= DropFromCache(path);
+    }
+    Result looseCold = ReadLoose(paths);
+    Result looseWarm = ReadLoose(paths);
+
+    cold &= DropFromCache(archivePath);
+    Result archiveCold = ReadArchive(archivePath, names);
+    Result archiveWarm = ReadArchive(archivePath, names);
+
+    if(!cold){
+        std::cout << "(Could not drop the files from the cache, 'cold' is really 'warm')" << std::endl;
+    }
+    Print("loose cold", looseCold);
+    Print("archive cold", archiveCold);
+    Print("loose warm", looseWarm);
+    Print("archive warm", archiveWarm);
+
+    if(looseCold.checksum != archiveCold.checksum || looseCold.bytes != archiveCold.bytes){
+        std::cout << "The archive does not match the loose files!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Times recording the draws of a 100,000 node scene into command lists
+// on 1, 2, 4 and 8 threads, each thread recording its own part of the
+// scene, and replaying the lists on one thread. Against it, the
+// RenderQueue filling, sorting and submitting on one thread.
+//
+// The scene is bench_renderqueue's: the sample's kinds of things and
+// shaders, picked at random for each node, all children of one root and
+// placed at random around the camera. Every thread count must record the
+// same draws, with the same matrices, in the same order.
+//
+// The threads are started and joined every frame, which is part of the
+// record time (as it would be of any frame that waited for them). Of
+// course, more threads than the machine has cores only take turns.
+//
+// Runs on a fake driver (bench/FakeGL.hpp), so no window is needed.
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: ./bin/bench_commandlists [objects] [frames]
+#include "SceneNode.hpp"
+#include "Terrain.hpp"
+#include "CommandList.hpp"
+#include "RenderQueue.hpp"
+#include "TransformHierarchy.hpp"
+#include "GLState.hpp"
+#include "UniformBuffer.hpp"
+#include "FakeGL.hpp"
+#include "BenchScene.hpp"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+
+// Records 'root' into 'lists': the root on its own into the first, then
+// its children split evenly between 'threads' threads (as
+// Renderer::RecordParallel does on the JobSystem)
+static void Record(const SceneNode& root, std::vector<CommandList>& lists, unsigned int threads){
+    const std::vector<SceneNode*>& children = root.GetChildren();
+    lists.resize(threads+1);
+    lists[0].Reset();
+    root.Record(lists[0], false);
+    std::vector<std::thread> workers;
+    for(unsigned int part=0; part < threads; ++part){
+        uint32_t first = children.size()*part/threads;
+        uint32_t last = children.size()*(part+1)/threads;
+        CommandList* list = &lists[part+1];
+        workers.emplace_back([&children, list, first, last](){
+            list->Reset();
+            for(uint32_t i=first; i < last; ++i){
+                children[i]->Record(*list);
+            }
+        });
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+}
+
+// Every list's object data, one after the other (what the player uploads)
+static std::vector<ObjectData> AllObjectData(const std::vector<CommandList>& lists){
+    std::vector<ObjectData> all;
+    for(const CommandList& list : lists){
+        all.insert(all.end(), list.GetObjectData().begin(), list.GetObjectData().end());
+    }
+    return all;
+}
+
+int main(int argc, char** argv){
+    unsigned int objects = argc > 1 ? std::atoi(argv[1]) : 100000;
+    unsigned int frames = argc > 2 ? std::atoi(argv[2]) : 20;
+    BenchSceneInstallFakeGL();
+    BenchQuiet quiet;
+    BenchScene scene = MakeBenchScene();
+    std::vector<std::shared_ptr<Object>>& things = scene.things;
+    std::vector<ShaderFiles>& shaders = scene.shaders;
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> across(-200.0f, 200.0f);
+    TransformHierarchy& transforms = TransformHierarchy::Instance();
+    SceneNode root(things[0], shaders[0].vertex, shaders[0].fragment, shaders[0].defines);
+    for(unsigned int i=1; i < objects; ++i){
+        const ShaderFiles& shader = shaders[random()%shaders.size()];
+        SceneNode* node = new SceneNode(things[random()%things.size()], shader.vertex, shader.fragment, shader.defines);
+        transforms.SetPosition(node->GetTransform(), glm::vec3(across(random), across(random)*0.1f, across(random)));
+        root.AddChild(node);
+    }
+    quiet.End();
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 640.0f/480.0f, 0.1f, 200.0f);
+    transforms.Update();
+    unsigned int visible = transforms.Cull(Frustum(projection*view));
+    std::cout << objects << " objects (" << visible << " in view), " << things.size() << " meshes, "
+              << shaders.size() << " shaders, " << std::thread::hardware_concurrency() << " cores. Per frame:" << std::endl;
+
+    // One thread through the RenderQueue, to compare against
+    RenderQueue queue;
+    double fillMs = 0.0, submitMs = 0.0;
+    for(unsigned int frame=0; frame < frames; ++frame){
+        auto start = std::chrono::steady_clock::now();
+        queue.Begin(view);
+        root.Draw(queue);
+        queue.Sort();
+        auto filled = std::chrono::steady_clock::now();
+        queue.Submit();
+        auto submitted = std::chrono::steady_clock::now();
+        fillMs += std::chrono::duration<double,std::milli>(filled-start).count();
+        submitMs += std::chrono::duration<double,std::milli>(submitted-filled).count();
+    }
+    std::cout << std::left << std::setw(24) << "RenderQueue, 1 thread" << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << fillMs/frames << " ms fill and sort" << std::setw(8) << submitMs/frames << " ms submit"
+              << std::setw(8) << queue.GetDrawCount() << " draws" << std::endl;
+
+    CommandPlayer player;
+    std::vector<CommandList> lists;
+    std::vector<ObjectData> expected;
+    uint32_t expectedDraws = 0;
+    double oneThreadMs = 0.0;
+    for(unsigned int threads : {1u, 2u, 4u, 8u}){
+        double recordMs = 0.0, replayMs = 0.0;
+        for(unsigned int frame=0; frame < frames; ++frame){
+            auto start = std::chrono::steady_clock::now();
+            Record(root, lists, threads);
+            auto recorded = std::chrono::steady_clock::now();
+            player.Replay(lists);
+            auto replayed = std::chrono::steady_clock::now();
+            recordMs += std::chrono::duration<double,std::milli>(recorded-start).count();
+            replayMs += std::chrono::duration<double,std::milli>(replayed-recorded).count();
+        }
+        uint32_t commands = 0;
+        for(const CommandList& list : lists){
+            commands += list.GetCommands().size();
+        }
+        std::vector<ObjectData> all = AllObjectData(lists);
+        if(threads == 1){
+            expected = all;
+            expectedDraws = player.GetDrawCount();
+            oneThreadMs = recordMs;
+        }
+        bool same = all.size() == expected.size() && player.GetDrawCount() == expectedDraws &&
+                    std::memcmp(all.data(), expected.data(), all.size()*sizeof(ObjectData)) == 0;
+        std::ostringstream label;
+        label << "command lists, " << threads << (threads == 1 ? " thread" : " threads");
+        std::cout << std::left << std::setw(24) << label.str() << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(8) << recordMs/frames << " ms record" << std::setw(8) << replayMs/frames << " ms replay"
+                  << std::setw(8) << player.GetDrawCount() << " draws" << std::setw(8) << commands << " commands"
+                  << std::setw(7) << oneThreadMs/recordMs << "x" << (same ? "" : " (recorded different draws!)") << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Times going over a 100,000 thing scene made of SceneNodes against the
+// same scene made of entities in an EntityStore.
+//
+// The scene is bench_commandlists' (bench/BenchScene.hpp): the sample's
+// kinds of things and shaders, picked at random for each thing, placed
+// at random around the camera. As SceneNodes, everything is a child of one root; as entities,
+// everything is a row of the store, in the same order, at the same place
+// (each has a node of its own in the TransformHierarchy).
+//
+//   iterate - adds up the indices drawn by the things in view, a system
+//             that touches each thing once (through the children's
+//             pointers and each node's shared_ptr, or down the arrays)
+//   draw list - fills the RenderQueue (SceneNode::Draw against
+//             EntityStore::Draw), without sorting or submitting
+//   record - records one command list, as Renderer::RecordParallel does
+//             for each part
+//
+// Both ways must queue the same number of draws, make the same GL draws
+// once submitted, and record the same matrices in the same order.
+//
+// Runs on a fake driver (bench/FakeGL.hpp), so no window is needed.
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: ./bin/bench_entities [objects] [frames]
+#include "SceneNode.hpp"
+#include "EntityStore.hpp"
+#include "CommandList.hpp"
+#include "RenderQueue.hpp"
+#include "TransformHierarchy.hpp"
+#include "GLState.hpp"
+#include "BenchScene.hpp"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+// The indices drawn by the visible things, going down the scene graph
+static uint64_t CountIndices(const SceneNode& node){
+    uint64_t indices = 0;
+    std::shared_ptr<Object> object = node.GetObject();
+    if(object != nullptr){
+        if(TransformHierarchy::Instance().IsVisible(node.GetTransform())){
+            indices += object->GetIndexCount();
+        }
+        for(const SceneNode* child : node.GetChildren()){
+            indices += CountIndices(*child);
+        }
+    }
+    return indices;
+}
+
+// The same, down the store's arrays
+static uint64_t CountIndices(const EntityStore& entities){
+    const TransformHierarchy& transforms = TransformHierarchy::Instance();
+    const std::vector<TransformHandle>& transform = entities.GetTransforms();
+    const std::vector<MeshComponent>& mesh = entities.GetMeshes();
+    uint64_t indices = 0;
+    for(uint32_t row=0; row < entities.GetCount(); ++row){
+        if(transforms.IsVisible(transform[row])){
+            indices += mesh[row].indexCount;
+        }
+    }
+    return indices;
+}
+
+struct Times{
+    double iterateMs{0.0};
+    double drawListMs{0.0};
+    double recordMs{0.0};
+    uint64_t indices{0};
+    uint32_t queued{0};
+    uint32_t draws{0};
+    std::vector<ObjectData> recorded;
+};
+
+static void Print(const char* label, const Times& times, unsigned int frames){
+    std::cout << std::left << std::setw(12) << label << std::right << std::fixed << std::setprecision(3)
+              << std::setw(8) << times.iterateMs/frames << " ms iterate"
+              << std::setw(8) << times.drawListMs/frames << " ms draw list"
+              << std::setw(8) << times.recordMs/frames << " ms record"
+              << std::setw(8) << times.queued << " queued" << std::setw(8) << times.draws << " GL draws" << std::endl;
+}
+
+int main(int argc, char** argv){
+    unsigned int objects = argc > 1 ? std::atoi(argv[1]) : 100000;
+    unsigned int frames = argc > 2 ? std::atoi(argv[2]) : 20;
+    BenchSceneInstallFakeGL();
+    BenchQuiet quiet;
+    BenchScene scene = MakeBenchScene();
+    auto& things = scene.things;
+    auto& shaders = scene.shaders;
+    std::vector<MaterialComponent> materials;
+    for(const ShaderFiles& shader : shaders){
+        materials.push_back(MaterialComponent::Load(shader.vertex, shader.fragment, shader.defines));
+    }
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> across(-200.0f, 200.0f);
+    TransformHierarchy& transforms = TransformHierarchy::Instance();
+    EntityStore entities;
+    auto addEntity = [&](uint32_t thing, uint32_t shader, const glm::vec3& position){
+        Object& object = *things[thing];
+        MaterialComponent material = materials[shader];
+        material.texture = object.GetDiffuseTexture();
+        material.transparent = object.IsTransparent();
+        Entity entity = entities.Create(MeshComponent::FromObject(object), material, object.GetBounds());
+        transforms.SetPosition(entities.GetTransform(entity), position);
+    };
+    SceneNode root(things[0], shaders[0].vertex, shaders[0].fragment, shaders[0].defines);
+    addEntity(0, 0, glm::vec3(0.0f));
+    for(unsigned int i=1; i < objects; ++i){
+        uint32_t shader = random()%shaders.size();
+        uint32_t thing = random()%things.size();
+        glm::vec3 position(across(random), across(random)*0.1f, across(random));
+        SceneNode* node = new SceneNode(things[thing], shaders[shader].vertex, shaders[shader].fragment, shaders[shader].defines);
+        transforms.SetPosition(node->GetTransform(), position);
+        root.AddChild(node);
+        addEntity(thing, shader, position);
+    }
+    quiet.End();
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 640.0f/480.0f, 0.1f, 200.0f);
+    transforms.Update();
+    unsigned int visible = transforms.Cull(Frustum(projection*view));
+    std::cout << objects << " things each way (" << visible/2 << " in view), " << things.size() << " meshes, "
+              << shaders.size() << " shaders. Per frame:" << std::endl;
+
+    RenderQueue queue;
+    CommandList list;
+    Times times[2];
+    for(int way=0; way < 2; ++way){
+        Times& t = times[way];
+        for(unsigned int frame=0; frame < frames; ++frame){
+            auto start = std::chrono::steady_clock::now();
+            t.indices = way == 0 ? CountIndices(root) : CountIndices(entities);
+            t.iterateMs += Since(start);
+
+            start = std::chrono::steady_clock::now();
+            queue.Begin(view);
+            if(way == 0){
+                root.Draw(queue);
+            }else{
+                entities.Draw(queue);
+            }
+            t.drawListMs += Since(start);
+
+            start = std::chrono::steady_clock::now();
+            list.Reset();
+            if(way == 0){
+                root.Record(list);
+            }else{
+                entities.Record(list, 0, entities.GetCount());
+            }
+            t.recordMs += Since(start);
+        }
+        t.queued = queue.GetCount();
+        queue.Sort();
+        g_fakeGL = FakeGLCounters{};
+        queue.Submit();
+        t.draws = g_fakeGL.draws;
+        t.recorded = list.GetObjectData();
+    }
+    Print("SceneNode", times[0], frames);
+    Print("EntityStore", times[1], frames);
+    bool same = times[0].indices == times[1].indices && times[0].queued == times[1].queued &&
+                times[0].draws == times[1].draws && times[0].recorded.size() == times[1].recorded.size() &&
+                std::memcmp(times[0].recorded.data(), times[1].recorded.data(), times[0].recorded.size()*sizeof(ObjectData)) == 0;
+    std::cout << std::setprecision(1) << "speedup: " << times[0].iterateMs/times[1].iterateMs << "x iterate, "
+              << times[0].drawListMs/times[1].drawListMs << "x draw list, " << times[0].recordMs/times[1].recordMs
+              << "x record" << (same ? "" : " (the two ways drew differently!)") << std::endl;
+    return 0;
+}
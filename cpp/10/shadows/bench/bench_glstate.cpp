@@ -0,0 +1,150 @@
+// Counts the OpenGL calls of one frame of the sample, with GLState
+// skipping the binds and enables that change nothing, and with it making
+// every call it is asked for (GLState::SetFiltering(false)).
+//
+// The frame is the sample's: the shadow map pass and the lit pass over the
+// floor and cubes, the light, the terrain's SceneNode and the debug quad's
+// binds. (The .obj models are left out, they load in the background.)
+//
+// Runs on a fake driver (bench/FakeGL.hpp), so no window is needed.
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: ./bin/bench_glstate [frames]
+#include "GLState.hpp"
+#include "ShaderManager.hpp"
+#include "UniformBuffer.hpp"
+#include "MeshMaker.hpp"
+#include "Texture.hpp"
+#include "Terrain.hpp"
+#include "SceneNode.hpp"
+#include "FBO.hpp"
+#include "FakeGL.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <cstdlib>
+
+static const int WIDTH = 640;
+static const int HEIGHT = 480;
+
+struct Scene{
+    std::shared_ptr<MeshMaker> plane, cube, light;
+    std::shared_ptr<Texture> brick;
+    std::shared_ptr<FBO> depthFBO;
+    Shader* depthShader;
+    Shader* shadowShader;
+    Shader* debugShader;
+    std::shared_ptr<SceneNode> terrainNode;
+    std::shared_ptr<UniformBuffer> frameBuffer, lightBuffer;
+};
+
+// renderScene in SDLGraphicsProgram.cpp, without the models
+static void RenderScene(Scene& scene, Shader& shader){
+    UniformHandle model = shader.GetUniform(UniformHash("model"));
+    glm::mat4 matrix(1.0f);
+    shader.SetUniformMatrix4fv(model, &matrix[0][0]);
+    scene.plane->RenderMesh();
+    for(int i=0; i < 3; ++i){
+        matrix = glm::translate(glm::mat4(1.0f), glm::vec3(i, 0.0f, 0.0f));
+        shader.SetUniformMatrix4fv(model, &matrix[0][0]);
+        scene.cube->RenderMesh();
+    }
+}
+
+// The render part of the sample's main loop
+static void Frame(Scene& scene){
+    static FrameData frameData{};
+    static LightData lightData{};
+    GLState& state = GLState::Instance();
+    state.ClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    scene.frameBuffer->Update(frameData);
+    scene.lightBuffer->Update(lightData);
+
+    scene.depthShader->Bind();
+    scene.depthFBO->Bind();
+        glClear(GL_DEPTH_BUFFER_BIT);
+        scene.brick->Bind(0);
+        RenderScene(scene, *scene.depthShader);
+    scene.depthFBO->Unbind();
+
+    state.Viewport(0, 0, WIDTH, HEIGHT);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    state.Viewport(0, 0, WIDTH, HEIGHT);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    scene.shadowShader->Bind();
+    scene.brick->Bind(0);
+    scene.depthFBO->BindTexture(1);
+    RenderScene(scene, *scene.shadowShader);
+    glm::mat4 model(1.0f);
+    scene.shadowShader->SetUniformMatrix4fv(scene.shadowShader->GetUniform(UniformHash("model")), &model[0][0]);
+    scene.light->RenderMesh();
+
+    scene.terrainNode->Update();
+
+    scene.debugShader->Bind();
+    scene.depthFBO->BindTexture(0);
+}
+
+static void Run(const char* label, Scene& scene, unsigned int frames, bool filtering){
+    GLState::Instance().SetFiltering(filtering);
+    // Once first, so it starts from what the frame before left behind
+    Frame(scene);
+    GLState::Instance().ResetStats();
+    g_fakeGL = FakeGLCounters{};
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int i=0; i < frames; ++i){
+        Frame(scene);
+    }
+    double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+    const GLState::Stats& stats = GLState::Instance().GetStats();
+    std::cout << std::left << std::setw(22) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(7) << (double)stats.Issued()/frames << " of " << (double)stats.Requested()/frames
+              << " state calls made" << std::setw(8) << (double)g_fakeGL.calls/frames << " GL calls"
+              << std::setw(6) << (double)g_fakeGL.draws/frames << " draws"
+              << std::setprecision(0) << std::setw(8) << ms*1e6/frames << " ns/frame" << std::endl;
+}
+
+int main(int argc, char** argv){
+    unsigned int frames = argc > 1 ? std::atoi(argv[1]) : 10000;
+    FakeGLInstall();
+    FakeGLSetUniforms({"model", "u_DiffuseMap", "u_DetailMap", "diffuseTexture", "shadowMap", "depthMap"},
+                      {{"FrameData", (GLint)sizeof(FrameData)}, {"LightData", (GLint)sizeof(LightData)}});
+
+    Scene scene;
+    ShaderManager& shaders = ShaderManager::Instance();
+    scene.shadowShader = shaders.GetShader(shaders.CreateNewShader("shadowmapping",
+        "./shaders/3.1.3.shadow_mapping.vs", "./shaders/3.1.3.shadow_mapping.fs", ShaderDefines().Set("PCF_RADIUS", 1)));
+    scene.depthShader = shaders.GetShader(shaders.CreateNewShader("shadowmappingdepth",
+        "./shaders/3.1.3.shadow_mapping_depth.vs", "./shaders/3.1.3.shadow_mapping_depth.fs"));
+    scene.debugShader = shaders.GetShader(shaders.CreateNewShader("shadowmappingdepthdebug",
+        "./shaders/3.1.3.debug_quad.vs", "./shaders/3.1.3.debug_quad_depth.fs"));
+    scene.plane = std::make_shared<MeshMaker>(VERTEXLAYOUTS::VERTEX3TN);
+    scene.plane->CreateTexturedPlane(15.0f, 15.0f);
+    scene.cube = std::make_shared<MeshMaker>(VERTEXLAYOUTS::VERTEX3TN);
+    scene.cube->CreateCube(1.0f, 1.0f, 1.0f);
+    scene.light = std::make_shared<MeshMaker>(VERTEXLAYOUTS::VERTEX3TN);
+    scene.light->CreateCube(0.5f, 0.5f, 0.5f);
+    scene.brick = std::make_shared<Texture>("./../../common/textures/brick.ppm");
+    scene.depthFBO = std::make_shared<FBO>();
+    scene.depthFBO->CreateDepthMapFBO(WIDTH, HEIGHT);
+    scene.frameBuffer = std::make_shared<UniformBuffer>(FRAME_DATA_BINDING, sizeof(FrameData));
+    scene.lightBuffer = std::make_shared<UniformBuffer>(LIGHT_DATA_BINDING, sizeof(LightData));
+    std::shared_ptr<Terrain> terrain = std::make_shared<Terrain>(512, 512, "./../../common/textures/terrain2.ppm");
+    terrain->LoadTextures("./../../common/textures/colormap.ppm", "./../../common/textures/detailmap.ppm");
+    scene.terrainNode = std::make_shared<SceneNode>(terrain, "./shaders/vert.glsl", "./shaders/frag.glsl",
+                                                    ShaderDefines().Set("LIGHT_COUNT", 2));
+
+    std::cout << std::endl << "Per frame:" << std::endl;
+    Run("every call made", scene, frames, false);
+    Run("redundant ones skipped", scene, frames, true);
+    std::cout << std::endl << "One frame, by kind of state:" << std::endl;
+    GLState::Instance().ResetStats();
+    Frame(scene);
+    std::cout << GLState::Instance().StatsToString();
+    return 0;
+}
@@ -0,0 +1,221 @@
+// Times a frame of a large scene culled and drawn by the CPU (the
+// RenderQueue, with the repeated meshes instanced) against by the GPU
+// (GPUScene: a compute shader culls, and one glMultiDrawElementsIndirect
+// draws), on Mesa's software rasterizer (llvmpipe).
+//
+// 100,000 cubes (three meshes) are scattered over a 1km square, seen by
+// a camera in the middle that turns a little every frame, as in
+// bench_culling. Both ways must find the same number of cubes in view.
+//
+// Per frame, the time spent deciding what to draw in our own code (the
+// culling, filling and sorting the queue), in the GL calls that draw it,
+// and in all (after glFinish). llvmpipe runs the GPU's work on the CPU,
+// often inside the GL calls, so here the compute shader's culling counts
+// as CPU time. With a real GPU, the GPU culled frame is left with a
+// handful of GL calls on the CPU.
+//
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: LIBGL_ALWAYS_SOFTWARE=1 ./bin/bench_gpudriven [cubes] [frames]
+#include "GPUScene.hpp"
+#include "RenderQueue.hpp"
+#include "TransformHierarchy.hpp"
+#include "Frustum.hpp"
+#include "ShaderManager.hpp"
+#include "MeshMaker.hpp"
+#include "UniformBuffer.hpp"
+#include "GLState.hpp"
+#include "HeadlessGL.hpp"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+static const int SIZE = 512;
+
+// The camera for a frame: in the middle of the scene, turned a bit more
+// each frame
+static glm::mat4 CameraView(unsigned int frame){
+    float angle = frame*0.01f;
+    glm::vec3 eye(0.0f, 2.0f, 0.0f);
+    return glm::lookAt(eye, eye+glm::vec3(std::sin(angle), 0.0f, -std::cos(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+int main(int argc, char** argv){
+    unsigned int cubes = argc > 1 ? std::atoi(argv[1]) : 100000;
+    unsigned int frames = argc > 2 ? std::atoi(argv[2]) : 20;
+    if(!HeadlessGLCreate()){
+        return 1;
+    }
+    if(!GPUScene::Enable(HeadlessGLGetProcAddress)){
+        std::cout << "The driver does not have OpenGL 4.3" << std::endl;
+        return 1;
+    }
+
+    // Somewhere to draw, with a depth buffer
+    GLuint framebuffer, color, depth;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SIZE, SIZE);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SIZE, SIZE);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    glViewport(0, 0, SIZE, SIZE);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+
+    // A noisy texture, and a shadow map where nothing is in shadow
+    std::mt19937 random(42);
+    std::vector<uint8_t> pixels(64*64*4);
+    for(uint8_t& pixel : pixels){
+        pixel = (uint8_t)random();
+    }
+    GLuint textures[2];
+    glGenTextures(2, textures);
+    glBindTexture(GL_TEXTURE_2D, textures[0]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 64, 64, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    std::vector<float> depths(16*16, 1.0f);
+    glBindTexture(GL_TEXTURE_2D, textures[1]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, 16, 16, 0, GL_DEPTH_COMPONENT, GL_FLOAT, depths.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    GLState::Instance().Invalidate();
+    GLState::Instance().BindTexture(0, textures[0]);
+    GLState::Instance().BindTexture(1, textures[1]);
+
+    // The MeshMakers and the shaders print as they are made
+    std::ostringstream quiet;
+    std::streambuf* console = std::cout.rdbuf(quiet.rdbuf());
+    std::vector<std::shared_ptr<MeshMaker>> meshes;
+    GPUScene scene;
+    for(int i=0; i < 3; ++i){
+        meshes.push_back(std::make_shared<MeshMaker>(VERTEXLAYOUTS::VERTEX3TN));
+        MeshMaker& mesh = *meshes.back();
+        mesh.CreateCube(1.0f, 1.0f, 1.0f);
+        scene.AddMesh(mesh.GetBufferDataPtr(), mesh.GetVerticesCount(), mesh.GetIndicesDataPtr(), mesh.GetIndicesCount());
+    }
+    const char* vertex = "./shaders/3.1.3.shadow_mapping.vs";
+    const char* fragment = "./shaders/3.1.3.shadow_mapping.fs";
+    ShaderHandle shaderHandle = ShaderManager::Instance().GetShaderVariant(vertex, fragment, ShaderDefines().Set("PCF_RADIUS", 1));
+    ShaderHandle instancedHandle = ShaderManager::Instance().GetShaderVariant(vertex, fragment,
+                                       ShaderDefines().Set("PCF_RADIUS", 1).Set("INSTANCED", 1));
+    Shader* shader = ShaderManager::Instance().GetShader(shaderHandle);
+    Shader* instancedShader = ShaderManager::Instance().GetShader(instancedHandle);
+    for(Shader* s : {shader, instancedShader}){
+        s->Bind();
+        s->SetUniform1i("diffuseTexture", 0);
+        s->SetUniform1i("shadowMap", 1);
+    }
+    std::cout.rdbuf(console);
+
+    // The cubes, each a random mesh, size and turn
+    std::uniform_real_distribution<float> place(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    std::uniform_real_distribution<float> turn(0.0f, 6.28f);
+    TransformHierarchy hierarchy;
+    TransformHandle root = hierarchy.Create();
+    std::vector<TransformHandle> nodes(cubes);
+    std::vector<DrawItem> items(cubes);
+    for(uint32_t i=0; i < cubes; ++i){
+        TransformHandle node = nodes[i] = hierarchy.Create(root);
+        float scale = size(random);
+        hierarchy.SetPosition(node, glm::vec3(place(random), scale, place(random)));
+        hierarchy.SetRotation(node, glm::angleAxis(turn(random), glm::vec3(0.0f, 1.0f, 0.0f)));
+        hierarchy.SetScale(node, glm::vec3(scale));
+        uint32_t mesh = random()%meshes.size();
+        hierarchy.SetBounds(node, meshes[mesh]->GetBounds());
+        scene.AddObject(mesh, node);
+        DrawItem& item = items[i];
+        item.shader = shader;
+        item.shaderIndex = shaderHandle.index;
+        item.instancedShader = instancedShader;
+        item.modelUniform = shader->GetUniform("model");
+        item.vertexArray = meshes[mesh]->GetVertexArray();
+        item.indexCount = meshes[mesh]->GetIndicesCount();
+        item.texture = textures[0];
+    }
+    hierarchy.Update();
+    // (Adding nodes moves the matrices around, they stay put from here on)
+    for(uint32_t i=0; i < cubes; ++i){
+        items[i].model = &hierarchy.GetWorldMatrix(nodes[i]);
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 500.0f);
+    FrameData frameData{};
+    frameData.projection = projection;
+    frameData.lightSpaceMatrix = glm::mat4(0.0f);
+    frameData.viewPos = glm::vec4(0.0f, 2.0f, 0.0f, 1.0f);
+    frameData.lightPos = glm::vec4(0.0f, 100.0f, 0.0f, 1.0f);
+    frameData.shadowPCFRadius = 1;
+    UniformBuffer frameBuffer(FRAME_DATA_BINDING, sizeof(FrameData));
+    DepthState depthTest;
+    depthTest.test = true;
+    GLState::Instance().SetDepthState(depthTest);
+
+    RenderQueue queue;
+    uint64_t cpuVisible = 0, gpuVisible = 0;
+    auto run = [&](const char* label, bool onGPU){
+        double ownMs = 0.0, callsMs = 0.0, totalMs = 0.0;
+        for(unsigned int frame=0; frame < frames; ++frame){
+            glm::mat4 view = CameraView(frame);
+            frameData.view = view;
+            frameBuffer.Update(frameData);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glFinish();
+            auto start = std::chrono::steady_clock::now();
+            Frustum frustum(projection*view);
+            if(!onGPU){
+                hierarchy.Cull(frustum);
+                queue.Begin(view);
+                for(uint32_t i=0; i < cubes; ++i){
+                    if(hierarchy.IsVisible(nodes[i])){
+                        queue.Add(items[i], glm::vec3((*items[i].model)[3]));
+                    }
+                }
+                queue.Sort();
+            }
+            auto decided = std::chrono::steady_clock::now();
+            if(onGPU){
+                scene.Update(hierarchy);
+                scene.Cull(frustum);
+                scene.Draw(*instancedShader);
+            }else{
+                queue.Submit();
+            }
+            auto submitted = std::chrono::steady_clock::now();
+            glFinish();
+            auto drawn = std::chrono::steady_clock::now();
+            ownMs += std::chrono::duration<double,std::milli>(decided-start).count();
+            callsMs += std::chrono::duration<double,std::milli>(submitted-decided).count();
+            totalMs += std::chrono::duration<double,std::milli>(drawn-start).count();
+            if(onGPU){
+                gpuVisible += scene.ReadVisibleCount();
+            }else{
+                cpuVisible += queue.GetCount();
+            }
+        }
+        std::cout << std::left << std::setw(26) << label << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(8) << ownMs/frames << " ms our code" << std::setw(9) << callsMs/frames
+                  << " ms GL calls" << std::setw(9) << totalMs/frames << " ms in all" << std::endl;
+    };
+    std::cout << cubes << " cubes, " << meshes.size() << " meshes, " << SIZE << "x" << SIZE << " pixels. Per frame:" << std::endl;
+    run("CPU culled, RenderQueue", false);
+    if(!scene.Build()){
+        std::cout << "cull.comp did not build, so the cubes can only be culled on the CPU" << std::endl;
+        return 1;
+    }
+    run("GPU culled, multi draw", true);
+    std::cout << cpuVisible/frames << " cubes in view on the CPU, " << gpuVisible/frames << " on the GPU"
+              << (cpuVisible != gpuVisible ? " (they differ!)" : "") << std::endl;
+    return 0;
+}
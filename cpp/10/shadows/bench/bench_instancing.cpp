@@ -0,0 +1,178 @@
+// Draws 50,000 cubes through the RenderQueue, each drawn on its own
+// against repeated meshes drawn instanced, on Mesa's software rasterizer
+// (llvmpipe).
+//
+// The cubes are the sample's: shaders/3.1.3.shadow_mapping.* with a
+// MeshMaker cube, here made three times (three meshes, as if they were
+// different models) and with two textures, on a grid seen from above.
+// So there are six kinds of cube, and instanced they should take six
+// draws. Both ways must draw the same picture.
+//
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: LIBGL_ALWAYS_SOFTWARE=1 ./bin/bench_instancing [cubes] [frames]
+#include "RenderQueue.hpp"
+#include "ShaderManager.hpp"
+#include "MeshMaker.hpp"
+#include "UniformBuffer.hpp"
+#include "GLState.hpp"
+#include "HeadlessGL.hpp"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+static const int SIZE = 512;
+
+static GLuint MakeTexture(GLenum internalFormat, GLenum format, GLenum type, int size, const void* data){
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, size, size, 0, format, type, data);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return texture;
+}
+
+// What the last frame drew
+static std::vector<uint8_t> ReadImage(){
+    std::vector<uint8_t> image(SIZE*SIZE*4);
+    glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+    return image;
+}
+
+// Draws 'frames' frames, and prints what one took
+static std::vector<uint8_t> Run(const char* label, RenderQueue& queue, const std::vector<DrawItem>& items,
+                                const glm::mat4& view, unsigned int frames, bool instancing){
+    queue.SetInstancing(instancing);
+    double submitMs = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int frame=0; frame < frames; ++frame){
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        auto submitStart = std::chrono::steady_clock::now();
+        queue.Begin(view);
+        for(const DrawItem& item : items){
+            queue.Add(item, glm::vec3((*item.model)[3]));
+        }
+        queue.Sort();
+        queue.Submit();
+        submitMs += std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-submitStart).count();
+        // Waits for the driver to draw it all
+        glFinish();
+    }
+    double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+    std::cout << std::left << std::setw(14) << label << std::right << std::fixed << std::setprecision(0)
+              << std::setw(7) << queue.GetDrawCount() << " draws (" << queue.GetInstancedDrawCount() << " instanced)"
+              << std::setprecision(2) << std::setw(9) << submitMs/frames << " ms queue and submit"
+              << std::setw(9) << ms/frames << " ms/frame (with drawing)" << std::endl;
+    return ReadImage();
+}
+
+int main(int argc, char** argv){
+    unsigned int cubes = argc > 1 ? std::atoi(argv[1]) : 50000;
+    unsigned int frames = argc > 2 ? std::atoi(argv[2]) : 5;
+    if(!HeadlessGLCreate()){
+        return 1;
+    }
+
+    // Somewhere to draw, with a depth buffer
+    GLuint framebuffer, depth;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GLuint color = MakeTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, SIZE, nullptr);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SIZE, SIZE);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    glViewport(0, 0, SIZE, SIZE);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+
+    // Two noisy textures, and a shadow map where nothing is in shadow
+    std::mt19937 random(3);
+    std::vector<uint8_t> pixels(64*64*4);
+    GLuint textures[2];
+    for(GLuint& texture : textures){
+        for(uint8_t& pixel : pixels){
+            pixel = (uint8_t)random();
+        }
+        texture = MakeTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 64, pixels.data());
+    }
+    std::vector<float> depths(16*16, 1.0f);
+    GLuint shadowMap = MakeTexture(GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 16, depths.data());
+    GLState::Instance().Invalidate();
+    GLState::Instance().BindTexture(1, shadowMap);
+
+    // The MeshMakers and the shaders print as they are made
+    std::ostringstream quiet;
+    std::streambuf* console = std::cout.rdbuf(quiet.rdbuf());
+    std::vector<std::shared_ptr<MeshMaker>> meshes;
+    for(int i=0; i < 3; ++i){
+        meshes.push_back(std::make_shared<MeshMaker>(VERTEXLAYOUTS::VERTEX3TN));
+        meshes.back()->CreateCube(1.0f, 1.0f, 1.0f);
+    }
+    const char* vertex = "./shaders/3.1.3.shadow_mapping.vs";
+    const char* fragment = "./shaders/3.1.3.shadow_mapping.fs";
+    ShaderHandle shaderHandle = ShaderManager::Instance().GetShaderVariant(vertex, fragment, ShaderDefines().Set("PCF_RADIUS", 1));
+    ShaderHandle instancedHandle = ShaderManager::Instance().GetShaderVariant(vertex, fragment,
+                                       ShaderDefines().Set("PCF_RADIUS", 1).Set("INSTANCED", 1));
+    Shader* shader = ShaderManager::Instance().GetShader(shaderHandle);
+    Shader* instancedShader = ShaderManager::Instance().GetShader(instancedHandle);
+    for(Shader* s : {shader, instancedShader}){
+        s->Bind();
+        s->SetUniform1i("diffuseTexture", 0);
+        s->SetUniform1i("shadowMap", 1);
+    }
+    std::cout.rdbuf(console);
+
+    // A grid of cubes, a random kind each, turned a little
+    std::vector<glm::mat4> models(cubes);
+    std::vector<DrawItem> items(cubes);
+    unsigned int side = (unsigned int)std::ceil(std::sqrt((double)cubes));
+    std::uniform_real_distribution<float> turn(0.0f, 6.28f);
+    for(unsigned int i=0; i < cubes; ++i){
+        glm::vec3 position((float)(i%side) - side*0.5f, 0.0f, -(float)(i/side));
+        models[i] = glm::rotate(glm::translate(glm::mat4(1.0f), position*2.5f), turn(random), glm::vec3(0.0f, 1.0f, 0.0f));
+        models[i] = glm::scale(models[i], glm::vec3(0.5f));
+        MeshMaker& mesh = *meshes[random()%meshes.size()];
+        DrawItem& item = items[i];
+        item.shader = shader;
+        item.shaderIndex = shaderHandle.index;
+        item.instancedShader = instancedShader;
+        item.modelUniform = shader->GetUniform("model");
+        item.model = &models[i];
+        item.vertexArray = mesh.GetVertexArray();
+        item.indexCount = mesh.GetIndicesCount();
+        item.texture = textures[random()%2];
+    }
+
+    // From above the near edge of the grid, looking along it
+    glm::vec3 eye(0.0f, 60.0f, 40.0f);
+    glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, -2.5f*side), glm::vec3(0.0f, 1.0f, 0.0f));
+    FrameData frameData{};
+    frameData.projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 2000.0f);
+    frameData.view = view;
+    frameData.lightSpaceMatrix = glm::mat4(0.0f);
+    frameData.viewPos = glm::vec4(eye, 1.0f);
+    frameData.lightPos = glm::vec4(0.0f, 100.0f, 0.0f, 1.0f);
+    frameData.shadowPCFRadius = 1;
+    UniformBuffer frameBuffer(FRAME_DATA_BINDING, sizeof(FrameData));
+    frameBuffer.Update(frameData);
+
+    std::cout << cubes << " cubes, " << meshes.size() << " meshes, 2 textures, "
+              << SIZE << "x" << SIZE << " pixels. Per frame:" << std::endl;
+    RenderQueue queue;
+    std::vector<uint8_t> alone = Run("one by one", queue, items, view, frames, false);
+    std::vector<uint8_t> instanced = Run("instanced", queue, items, view, frames, true);
+    if(alone != instanced){
+        std::cout << "(instanced drew a different picture)" << std::endl;
+    }
+    return 0;
+}
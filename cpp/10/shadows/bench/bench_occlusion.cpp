@@ -0,0 +1,201 @@
+// Times occlusion culling a town of 100,000 objects seen from its
+// streets, and counts what it culls.
+//
+// The town is a grid of buildings (boxes of different heights, the
+// occluders) with streets between them, and small boxes scattered all
+// over it, inside the buildings too (as furniture would be). The camera
+// stands in a street and turns a little every frame, as in
+// bench_culling. The frustum culls first, then the OcclusionCuller culls
+// what the buildings hide; the time of drawing the buildings into its
+// depth buffer and of testing the boxes is per frame.
+//
+// As a check, the first frame's culled boxes are tested for a corner
+// that can be seen from the camera, by casting a ray to each corner
+// against the buildings. Such a box was culled wrongly, and there must
+// be none.
+//
+// Usage: ./bin/bench_occlusion [objects] [frames]
+#include "OcclusionCuller.hpp"
+#include "TransformHierarchy.hpp"
+#include "Frustum.hpp"
+#include "JobSystem.hpp"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Buildings are BLOCK metres square, with STREET metres between them
+static const float BLOCK = 30.0f;
+static const float STREET = 10.0f;
+static const int BLOCKS = 25;
+static const float TOWN = BLOCKS*(BLOCK+STREET);
+
+static const float CUBE[] = {
+    -0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f,  0.5f, -0.5f,  -0.5f,  0.5f, -0.5f,
+    -0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,   0.5f,  0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,
+};
+static const unsigned int CUBE_INDICES[] = {
+    0, 2, 1,  0, 3, 2,    4, 5, 6,  4, 6, 7,    0, 1, 5,  0, 5, 4,
+    3, 6, 2,  3, 7, 6,    0, 4, 7,  0, 7, 3,    1, 2, 6,  1, 6, 5,
+};
+
+struct Box{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Whether the segment from 'from' to 'to' passes through the box
+static bool Blocks(const Box& box, const glm::vec3& from, const glm::vec3& to){
+    glm::vec3 direction = to - from;
+    float enter = 0.0f, leave = 1.0f;
+    for(int axis=0; axis < 3; ++axis){
+        if(std::abs(direction[axis]) < 1e-9f){
+            if(from[axis] < box.min[axis] || from[axis] > box.max[axis]){
+                return false;
+            }
+            continue;
+        }
+        float t0 = (box.min[axis] - from[axis]) / direction[axis];
+        float t1 = (box.max[axis] - from[axis]) / direction[axis];
+        enter = std::max(enter, std::min(t0, t1));
+        leave = std::min(leave, std::max(t0, t1));
+    }
+    // Stopping just short of the corner, so that a box sitting against a
+    // wall is not blocked by it
+    return enter < leave && enter < 0.999f;
+}
+
+static glm::vec3 Eye(){
+    // In the middle of a street, at head height
+    return glm::vec3(-TOWN*0.5f + 10*(BLOCK+STREET) - STREET*0.5f, 1.7f, 0.0f);
+}
+
+static glm::mat4 CameraView(unsigned int frame){
+    float angle = frame*0.01f;
+    glm::vec3 eye = Eye();
+    return glm::lookAt(eye, eye+glm::vec3(std::sin(angle), 0.0f, -std::cos(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+int main(int argc, char** argv){
+    unsigned int objects = argc > 1 ? std::atoi(argv[1]) : 100000;
+    unsigned int frames = argc > 2 ? std::atoi(argv[2]) : 50;
+
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> height(8.0f, 30.0f);
+    std::uniform_real_distribution<float> place(-TOWN*0.5f, TOWN*0.5f);
+    std::uniform_real_distribution<float> size(0.3f, 2.0f);
+    Bounds cubeBounds = Bounds::FromPoints(CUBE, 8, 3);
+
+    TransformHierarchy hierarchy;
+    TransformHandle root = hierarchy.Create();
+    OcclusionCuller occlusion;
+    std::vector<Box> buildings;
+    for(int x=0; x < BLOCKS; ++x){
+        for(int z=0; z < BLOCKS; ++z){
+            glm::vec3 scale(BLOCK, height(random), BLOCK);
+            glm::vec3 center(-TOWN*0.5f + x*(BLOCK+STREET) + BLOCK*0.5f, scale.y*0.5f,
+                             -TOWN*0.5f + z*(BLOCK+STREET) + BLOCK*0.5f);
+            TransformHandle node = hierarchy.Create(root);
+            hierarchy.SetPosition(node, center);
+            hierarchy.SetScale(node, scale);
+            hierarchy.SetBounds(node, cubeBounds);
+            occlusion.AddOccluder(CUBE, 8, 3, CUBE_INDICES, 36, node);
+            buildings.push_back({center - scale*0.5f, center + scale*0.5f});
+        }
+    }
+    std::vector<TransformHandle> nodes;
+    for(unsigned int i=buildings.size(); i < objects; ++i){
+        float scale = size(random);
+        TransformHandle node = hierarchy.Create(root);
+        hierarchy.SetPosition(node, glm::vec3(place(random), scale*0.5f, place(random)));
+        hierarchy.SetScale(node, glm::vec3(scale));
+        hierarchy.SetBounds(node, cubeBounds);
+        nodes.push_back(node);
+    }
+    hierarchy.Update();
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)OcclusionCuller::WIDTH/OcclusionCuller::HEIGHT,
+                                            0.1f, 1000.0f);
+    std::cout << objects << " objects (" << buildings.size() << " of them buildings, " << buildings.size()*12
+              << " occluder triangles), a " << OcclusionCuller::WIDTH << "x" << OcclusionCuller::HEIGHT
+              << " depth buffer, " << JobSystem::Instance().GetWorkerCount() << " worker threads. Per frame:" << std::endl;
+
+    uint32_t wrongCulls = 0;
+    for(bool parallel : {false, true}){
+        occlusion.SetParallel(parallel);
+        uint64_t inFrustum = 0, notOccluded = 0, triangles = 0;
+        double rasterizeMs = 0.0, testMs = 0.0;
+        uint32_t wrong = 0, checked = 0;
+        for(unsigned int frame=0; frame < frames; ++frame){
+            glm::mat4 projectionView = projection*CameraView(frame);
+            uint32_t visible = hierarchy.Cull(Frustum(projectionView));
+            // The flags before occlusion culling, for the check
+            std::vector<uint8_t> beforeOcclusion;
+            if(frame == 0){
+                for(TransformHandle node : nodes){
+                    beforeOcclusion.push_back(hierarchy.IsVisible(node));
+                }
+            }
+            auto start = std::chrono::steady_clock::now();
+            occlusion.Rasterize(projectionView, hierarchy);
+            auto rasterized = std::chrono::steady_clock::now();
+            uint32_t left = occlusion.Cull(hierarchy);
+            auto tested = std::chrono::steady_clock::now();
+            rasterizeMs += std::chrono::duration<double,std::milli>(rasterized-start).count();
+            testMs += std::chrono::duration<double,std::milli>(tested-rasterized).count();
+            inFrustum += visible;
+            notOccluded += left;
+            triangles += occlusion.GetTriangleCount();
+
+            if(frame == 0){
+                Frustum frustum(projectionView);
+                glm::vec3 eye = Eye();
+                for(uint32_t i=0; i < nodes.size(); ++i){
+                    if(!beforeOcclusion[i] || hierarchy.IsVisible(nodes[i])){
+                        continue;
+                    }
+                    ++checked;
+                    glm::vec3 center, extent;
+                    hierarchy.GetWorldBounds(nodes[i], center, extent);
+                    for(int corner=0; corner < 8; ++corner){
+                        glm::vec3 point = center + glm::vec3((corner & 1) ? extent.x : -extent.x,
+                                                             (corner & 2) ? extent.y : -extent.y,
+                                                             (corner & 4) ? extent.z : -extent.z);
+                        if(!frustum.IsVisible(point, 0.0f)){
+                            continue;
+                        }
+                        bool blocked = std::any_of(buildings.begin(), buildings.end(),
+                                                   [&](const Box& box){ return Blocks(box, eye, point); });
+                        if(!blocked){
+                            ++wrong;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        double hidden = 100.0*(inFrustum-notOccluded)/std::max<uint64_t>(inFrustum, 1);
+        std::cout << std::left << std::setw(16) << (parallel ? "tiles as jobs" : "tiles in turn") << std::right
+                  << std::fixed << std::setprecision(0) << std::setw(7) << (double)inFrustum/frames << " in the frustum,"
+                  << std::setw(7) << (double)notOccluded/frames << " not hidden (" << std::setprecision(1) << hidden
+                  << "% culled)" << std::setprecision(0) << std::setw(6) << (double)triangles/frames << " triangles"
+                  << std::setprecision(3) << std::setw(8) << rasterizeMs/frames << " ms rasterize"
+                  << std::setw(8) << testMs/frames << " ms test" << std::endl;
+        if(!parallel){
+            std::cout << "  first frame: " << wrong << " of " << checked << " culled boxes have a corner in sight" << std::endl;
+        }
+        wrongCulls += wrong;
+    }
+    if(wrongCulls > 0){
+        std::cout << "Culled boxes that can be seen!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Times building the sample's shader programs at startup: with an empty
+// program cache (compile, and store), with a full one (load the stored
+// binaries), and compiling them again. See include/ProgramCache.hpp.
+//
+// Mesa keeps its own cache of compiled shaders on the disk (and needs it
+// for program binaries), so it is pointed at an empty folder here: the
+// first compile is from scratch, and the last one shows what Mesa's own
+// cache saves.
+//
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: LIBGL_ALWAYS_SOFTWARE=1 ./bin/bench_programcache [cache folder]
+#include "Shader.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "ProgramCache.hpp"
+#include "HeadlessGL.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+// The programs the sample builds when it starts
+static const char* PROGRAMS[][2] = {
+    {"./shaders/3.1.3.shadow_mapping.vs", "./shaders/3.1.3.shadow_mapping.fs"},
+    {"./shaders/3.1.3.shadow_mapping_depth.vs", "./shaders/3.1.3.shadow_mapping_depth.fs"},
+    {"./shaders/3.1.3.debug_quad.vs", "./shaders/3.1.3.debug_quad_depth.fs"},
+    {"./shaders/vert.glsl", "./shaders/frag.glsl"},
+};
+
+// Builds every program once, and returns how long it took
+static double BuildAll(const std::vector<std::pair<std::string,std::string>>& sources){
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<Shader>> shaders;
+    for(const std::pair<std::string,std::string>& source : sources){
+        shaders.push_back(std::make_unique<Shader>());
+        if(!shaders.back()->CreateShader(source.first, source.second)){
+            std::cout << "A program did not build" << std::endl;
+        }
+    }
+    // Wait for the driver, in case it finishes linking in the background
+    glFinish();
+    return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+static void Print(const char* label, double ms){
+    std::cout << std::left << std::setw(34) << label << std::right << std::fixed
+              << std::setprecision(2) << std::setw(10) << ms << " ms" << std::endl;
+}
+
+int main(int argc, char** argv){
+    std::string folder = argc > 1 ? argv[1] : "./cache/bench_programs";
+    std::filesystem::remove_all(folder);
+    std::filesystem::remove_all(folder+"_mesa");
+    // Mesa only makes the last folder of the path
+    std::filesystem::create_directories(folder+"_mesa");
+    setenv("MESA_SHADER_CACHE_DIR", (folder+"_mesa").c_str(), 1);
+    if(!HeadlessGLCreate()){
+        return 1;
+    }
+
+    std::vector<std::pair<std::string,std::string>> sources;
+    for(const auto& program : PROGRAMS){
+        sources.push_back({PreprocessShader(program[0], ShaderDefines()), PreprocessShader(program[1], ShaderDefines())});
+    }
+    std::cout << sources.size() << " programs" << std::endl;
+
+    if(!ProgramCache::Instance().Enable(folder, HeadlessGLGetProcAddress)){
+        return 1;
+    }
+    Print("cold cache (compile, and store)", BuildAll(sources));
+    Print("warm cache (load)", BuildAll(sources));
+    std::filesystem::remove_all(folder);
+    std::filesystem::create_directories(folder);
+    Print("compile again (driver's cache warm)", BuildAll(sources));
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Counts the state changes of drawing the sample's scene scaled up to
+// thousands of objects, in scene graph order against sorted by the
+// RenderQueue's keys, and sorted with the repeated meshes instanced.
+//
+// The scene is the sample's kinds of things, many times over: textured
+// quads (brick, the terrain's color and detail maps, the height map),
+// small terrains, and a transparent quad, drawn with three shaders (the
+// terrain's with one and with two lights, and the shadow mapping one).
+// Each node picks one of each at random, and is placed at random in
+// front of the camera.
+//
+// Runs on a fake driver (bench/FakeGL.hpp), so no window is needed.
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: ./bin/bench_renderqueue [objects] [frames]
+#include "SceneNode.hpp"
+#include "Terrain.hpp"
+#include "RenderQueue.hpp"
+#include "TransformHierarchy.hpp"
+#include "GLState.hpp"
+#include "UniformBuffer.hpp"
+#include "FakeGL.hpp"
+#include "BenchScene.hpp"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <vector>
+#include <cstdlib>
+
+static void Run(const char* label, SceneNode& root, RenderQueue& queue, const glm::mat4& view,
+                unsigned int frames, bool sorting, bool instancing){
+    queue.SetSorting(sorting);
+    queue.SetInstancing(instancing);
+    GLState::Instance().ResetStats();
+    g_fakeGL = FakeGLCounters{};
+    std::chrono::steady_clock::duration sortTime{0};
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int i=0; i < frames; ++i){
+        queue.Begin(view);
+        root.Draw(queue);
+        auto sortStart = std::chrono::steady_clock::now();
+        queue.Sort();
+        sortTime += std::chrono::steady_clock::now()-sortStart;
+        queue.Submit();
+    }
+    double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+    double sortMs = std::chrono::duration<double,std::milli>(sortTime).count();
+    const GLState::Stats& stats = GLState::Instance().GetStats();
+    std::cout << std::left << std::setw(20) << label << std::right << std::fixed << std::setprecision(0)
+              << std::setw(7) << (double)stats.issued[GLState::PROGRAM]/frames << " programs"
+              << std::setw(7) << (double)stats.issued[GLState::TEXTURE]/frames << " texture calls"
+              << std::setw(7) << (double)stats.issued[GLState::VERTEX_ARRAY]/frames << " vertex arrays"
+              << std::setw(7) << (double)(stats.issued[GLState::DEPTH]+stats.issued[GLState::BLEND])/frames << " depth/blend"
+              << std::setw(8) << (double)g_fakeGL.calls/frames << " GL calls"
+              << std::setw(7) << (double)g_fakeGL.draws/frames << " draws"
+              << std::setprecision(3) << std::setw(8) << sortMs/frames << " ms sorting"
+              << std::setw(8) << ms/frames << " ms/frame" << std::endl;
+}
+
+int main(int argc, char** argv){
+    unsigned int objects = argc > 1 ? std::atoi(argv[1]) : 4000;
+    unsigned int frames = argc > 2 ? std::atoi(argv[2]) : 100;
+    BenchSceneInstallFakeGL();
+    BenchQuiet quiet;
+    BenchScene scene = MakeBenchScene();
+    std::vector<std::shared_ptr<Object>>& things = scene.things;
+    std::vector<ShaderFiles>& shaders = scene.shaders;
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> across(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> away(-100.0f, -5.0f);
+    TransformHierarchy& transforms = TransformHierarchy::Instance();
+    SceneNode root(things[0], shaders[0].vertex, shaders[0].fragment, shaders[0].defines);
+    for(unsigned int i=1; i < objects; ++i){
+        const ShaderFiles& shader = shaders[random()%shaders.size()];
+        SceneNode* node = new SceneNode(things[random()%things.size()], shader.vertex, shader.fragment, shader.defines);
+        transforms.SetPosition(node->GetTransform(), glm::vec3(across(random), across(random)*0.25f, away(random)));
+        root.AddChild(node);
+    }
+    quiet.End();
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 640.0f/480.0f, 0.1f, 100.0f);
+    transforms.Update();
+    unsigned int visible = transforms.Cull(Frustum(projection*view));
+    std::cout << objects << " objects (" << visible << " in view), " << things.size() << " meshes, "
+              << shaders.size() << " shaders. Per frame:" << std::endl;
+
+    RenderQueue queue;
+    Run("scene graph order", root, queue, view, frames, false, false);
+    Run("sorted", root, queue, view, frames, true, false);
+    Run("sorted, instanced", root, queue, view, frames, true, true);
+    return 0;
+}
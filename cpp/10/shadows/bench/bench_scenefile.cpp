@@ -0,0 +1,196 @@
+// Times saving a 100,000 node scene to a SceneFile, and loading it back,
+// against building the same scene node by node.
+//
+// The scene is 1,000 groups of 100 entities: each group is an entity at
+// the top, with 99 below it, so it has a hierarchy to load as well as
+// entities. What they draw is bench/BenchScene.hpp's things and shaders,
+// picked at random, each with a name to be saved by.
+//
+//   build - Create() and SetPosition() etc. for every entity, as a scene
+//             made in code (or parsed from text) would be
+//   write - WriteSceneFile() of the built scene
+//   open - SceneFile::Open(), mapping and checking the file
+//   instantiate - SceneFile::Instantiate() into an empty hierarchy and
+//             store
+//   update - the first TransformHierarchy::Update() afterwards, which
+//             either way has every node to do
+//
+// The loaded scene must have the same world matrices, meshes, materials
+// and lights as the built one, row for row, and each mesh and texture
+// must have been asked for once.
+//
+// Runs on a fake driver (bench/FakeGL.hpp), so no window is needed.
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: ./bin/bench_scenefile [groups] [loads]
+#include "SceneFile.hpp"
+#include "EntityStore.hpp"
+#include "TransformHierarchy.hpp"
+#include "BenchScene.hpp"
+
+#include "glm/gtc/quaternion.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+// Whether two stores draw the same things at the same places, row for row
+static bool Same(const EntityStore& a, const EntityStore& b){
+    if(a.GetCount() != b.GetCount()){
+        return false;
+    }
+    for(uint32_t row=0; row < a.GetCount(); ++row){
+        const MeshComponent& meshA = a.GetMeshes()[row];
+        const MeshComponent& meshB = b.GetMeshes()[row];
+        const MaterialComponent& materialA = a.GetMaterials()[row];
+        const MaterialComponent& materialB = b.GetMaterials()[row];
+        const Bounds& boundsA = a.GetBoundsArray()[row];
+        const Bounds& boundsB = b.GetBoundsArray()[row];
+        if(meshA.vertexArray != meshB.vertexArray || meshA.indexCount != meshB.indexCount ||
+           materialA.shader != materialB.shader || materialA.shaderIndex != materialB.shaderIndex ||
+           materialA.instancedShader != materialB.instancedShader ||
+           materialA.objectDataShader != materialB.objectDataShader ||
+           materialA.texture != materialB.texture || materialA.transparent != materialB.transparent ||
+           std::memcmp(&boundsA, &boundsB, sizeof(Bounds)) != 0){
+            return false;
+        }
+        const glm::mat4& worldA = a.GetTransformHierarchy().GetWorldMatrix(a.GetTransforms()[row]);
+        const glm::mat4& worldB = b.GetTransformHierarchy().GetWorldMatrix(b.GetTransforms()[row]);
+        if(std::memcmp(&worldA, &worldB, sizeof(glm::mat4)) != 0){
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv){
+    unsigned int groups = argc > 1 ? std::atoi(argv[1]) : 1000;
+    unsigned int loads = argc > 2 ? std::atoi(argv[2]) : 10;
+    const unsigned int groupSize = 100;
+    const char* filename = "./bench_scene.scene";
+    BenchSceneInstallFakeGL();
+    BenchQuiet quiet;
+    BenchScene scene = MakeBenchScene();
+    auto& things = scene.things;
+    auto& thingNames = scene.thingNames;
+
+    SceneFileNames names;
+    std::unordered_map<std::string, MeshComponent> meshByName;
+    std::unordered_map<std::string, GLuint> textureByPath;
+    for(std::size_t i=0; i < things.size(); ++i){
+        MeshComponent mesh = MeshComponent::FromObject(*things[i]);
+        names.meshes[mesh.vertexArray] = thingNames[i];
+        meshByName[thingNames[i]] = mesh;
+        std::string path = "texture" + std::to_string(things[i]->GetDiffuseTexture());
+        names.textures[things[i]->GetDiffuseTexture()] = path;
+        textureByPath[path] = things[i]->GetDiffuseTexture();
+    }
+    unsigned int meshRequests = 0, textureRequests = 0;
+    SceneFileAssets assets;
+    assets.mesh = [&](const std::string& name){ ++meshRequests; return meshByName.at(name); };
+    assets.texture = [&](const std::string& path){ ++textureRequests; return textureByPath.at(path); };
+
+    std::vector<MaterialComponent> materials;
+    for(const ShaderFiles& shader : scene.shaders){
+        materials.push_back(MaterialComponent::Load(shader.vertex, shader.fragment, shader.defines));
+    }
+    quiet.End();
+
+    // (1) ======= Build the scene in code
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> across(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> near(-4.0f, 4.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+    TransformHierarchy builtTransforms;
+    EntityStore built(builtTransforms);
+    auto start = std::chrono::steady_clock::now();
+    auto addEntity = [&](TransformHandle parent, const glm::vec3& position){
+        Object& object = *things[random()%things.size()];
+        MaterialComponent material = materials[random()%materials.size()];
+        material.texture = object.GetDiffuseTexture();
+        material.transparent = object.IsTransparent();
+        Entity entity = built.Create(MeshComponent::FromObject(object), material, object.GetBounds(), parent);
+        TransformHandle transform = built.GetTransform(entity);
+        builtTransforms.SetPosition(transform, position);
+        builtTransforms.SetRotation(transform, glm::angleAxis(angle(random), glm::vec3(0.0f, 1.0f, 0.0f)));
+        return transform;
+    };
+    for(unsigned int group=0; group < groups; ++group){
+        TransformHandle top = addEntity(TransformHandle(), glm::vec3(across(random), 0.0f, across(random)));
+        builtTransforms.SetScale(top, glm::vec3(2.0f));
+        for(unsigned int i=1; i < groupSize; ++i){
+            addEntity(top, glm::vec3(near(random), near(random), near(random)));
+        }
+    }
+    double buildMs = Since(start);
+    start = std::chrono::steady_clock::now();
+    builtTransforms.Update();
+    double builtUpdateMs = Since(start);
+
+    LightData lights{};
+    lights.lightCount = 2;
+    for(int i=0; i < 2; ++i){
+        lights.pointLights[i].lightColor = glm::vec3(1.0f, 0.9f, 0.8f*i);
+        lights.pointLights[i].lightPos = glm::vec3(10.0f*i, 20.0f, 0.0f);
+        lights.pointLights[i].ambientIntensity = 0.1f;
+        lights.pointLights[i].specularStrength = 0.5f;
+        lights.pointLights[i].constant = 1.0f;
+        lights.pointLights[i].linear = 0.09f;
+        lights.pointLights[i].quadratic = 0.032f;
+    }
+
+    // (2) ======= Save it
+    start = std::chrono::steady_clock::now();
+    if(!WriteSceneFile(filename, built, lights, names)){
+        return 1;
+    }
+    double writeMs = Since(start);
+
+    // (3) ======= Load it back, into a new hierarchy and store each time
+    double openMs = 0.0, instantiateMs = 0.0, updateMs = 0.0;
+    bool same = true;
+    unsigned int fileBytes = 0;
+    for(unsigned int load=0; load < loads; ++load){
+        TransformHierarchy loadedTransforms;
+        EntityStore loaded(loadedTransforms);
+        LightData loadedLights{};
+        meshRequests = textureRequests = 0;
+
+        start = std::chrono::steady_clock::now();
+        SceneFile file;
+        if(!file.Open(filename)){
+            return 1;
+        }
+        openMs += Since(start);
+
+        start = std::chrono::steady_clock::now();
+        file.Instantiate(loaded, loadedLights, assets);
+        instantiateMs += Since(start);
+
+        start = std::chrono::steady_clock::now();
+        loadedTransforms.Update();
+        updateMs += Since(start);
+
+        fileBytes = file.GetHeader().fileSize;
+        same = same && Same(built, loaded) && std::memcmp(&lights, &loadedLights, sizeof(LightData)) == 0 &&
+               meshRequests == file.GetHeader().meshCount && textureRequests == file.GetHeader().textureCount;
+    }
+    std::remove(filename);
+
+    std::cout << groups*groupSize << " entities in " << groups << " groups, a " << fileBytes/1024 << " KiB file:" << std::endl;
+    std::cout << std::fixed << std::setprecision(2)
+              << "build    " << std::setw(9) << buildMs << " ms (then " << builtUpdateMs << " ms update)" << std::endl
+              << "write    " << std::setw(9) << writeMs << " ms" << std::endl
+              << "open     " << std::setw(9) << openMs/loads << " ms" << std::endl
+              << "instantiate " << std::setw(6) << instantiateMs/loads << " ms (then " << updateMs/loads << " ms update)" << std::endl
+              << std::setprecision(1) << "speedup: " << buildMs/(openMs/loads + instantiateMs/loads) << "x load against build"
+              << (same ? "" : " (the loaded scene is not the built one!)") << std::endl;
+    return same ? 0 : 1;
+}
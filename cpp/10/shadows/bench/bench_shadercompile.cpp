@@ -0,0 +1,131 @@
+// Times starting up with many shaders, building them one after the other
+// (Shader::CreateShader), and all at once in the background while
+// textures load (Shader::BeginCreateShader, waited for on first Bind).
+//
+// The sample's four programs are each built in several variants (a
+// different comment in each, so that none are the same to the driver),
+// and the sample's textures stand in for loading the other assets.
+//
+// Mesa's own shader cache is turned off (unless MESA_SHADER_CACHE_DISABLE
+// is already set), so every program is really compiled.
+//
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: LIBGL_ALWAYS_SOFTWARE=1 ./bin/bench_shadercompile [variants]
+#include "Shader.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "Image.hpp"
+#include "HeadlessGL.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+static const char* PROGRAMS[][2] = {
+    {"./shaders/3.1.3.shadow_mapping.vs", "./shaders/3.1.3.shadow_mapping.fs"},
+    {"./shaders/3.1.3.shadow_mapping_depth.vs", "./shaders/3.1.3.shadow_mapping_depth.fs"},
+    {"./shaders/3.1.3.debug_quad.vs", "./shaders/3.1.3.debug_quad_depth.fs"},
+    {"./shaders/vert.glsl", "./shaders/frag.glsl"},
+};
+
+static const char* TEXTURES[] = {
+    "./../../common/textures/terrain2.ppm",
+    "./../../common/textures/colormap.ppm",
+    "./../../common/textures/detailmap.ppm",
+    "./../../common/textures/brick.ppm",
+};
+
+static double Since(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+// Stands in for the rest of startup
+static void LoadTextures(){
+    for(const char* texture : TEXTURES){
+        Image image(texture);
+        image.LoadPPM(true);
+    }
+}
+
+// Makes 'variants' copies of every program, each different to the driver.
+// 'run' keeps the runs apart too.
+static std::vector<std::pair<std::string,std::string>> GetSources(unsigned int variants, int run){
+    std::vector<std::pair<std::string,std::string>> sources;
+    for(unsigned int variant=0; variant < variants; ++variant){
+        for(const auto& program : PROGRAMS){
+            std::string tag = "\n// run " + std::to_string(run) + " variant " + std::to_string(variant) + "\n";
+            sources.push_back({PreprocessShader(program[0], ShaderDefines()) + tag, PreprocessShader(program[1], ShaderDefines()) + tag});
+        }
+    }
+    return sources;
+}
+
+static void Print(const char* label, double totalMs, double waitMs){
+    std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << totalMs << " ms to the first frame"
+              << std::setw(8) << waitMs << " ms waiting for shaders" << std::endl;
+}
+
+int main(int argc, char** argv){
+    unsigned int variants = argc > 1 ? std::atoi(argv[1]) : 8;
+    setenv("MESA_SHADER_CACHE_DISABLE", "true", 0);
+    if(!HeadlessGLCreate()){
+        return 1;
+    }
+    bool parallel = Shader::EnableParallelCompile(HeadlessGLGetProcAddress);
+    std::cout << (parallel ? "KHR_parallel_shader_compile is supported" : "No KHR_parallel_shader_compile") << std::endl;
+
+    // Once without timing, so the first run does not pay for warming up
+    LoadTextures();
+    {
+        Shader warmUp;
+        auto sources = GetSources(1, -1);
+        warmUp.CreateShader(sources[0].first, sources[0].second);
+    }
+
+    std::cout << variants*4 << " programs, and " << sizeof(TEXTURES)/sizeof(TEXTURES[0]) << " textures" << std::endl;
+    {
+        auto sources = GetSources(variants, 0);
+        std::vector<std::unique_ptr<Shader>> shaders;
+        auto start = std::chrono::steady_clock::now();
+        for(const auto& source : sources){
+            shaders.push_back(std::make_unique<Shader>());
+            shaders.back()->CreateShader(source.first, source.second);
+        }
+        double waitMs = Since(start);
+        LoadTextures();
+        for(auto& shader : shaders){
+            shader->Bind();
+        }
+        glFinish();
+        Print("one after the other", Since(start), waitMs);
+    }
+    {
+        auto sources = GetSources(variants, 1);
+        std::vector<std::unique_ptr<Shader>> shaders;
+        auto start = std::chrono::steady_clock::now();
+        for(const auto& source : sources){
+            shaders.push_back(std::make_unique<Shader>());
+            shaders.back()->BeginCreateShader(source.first, source.second);
+        }
+        double submitMs = Since(start);
+        LoadTextures();
+        unsigned int ready = 0;
+        for(auto& shader : shaders){
+            ready += shader->IsReady() ? 1 : 0;
+        }
+        auto waitStart = std::chrono::steady_clock::now();
+        for(auto& shader : shaders){
+            shader->Bind();
+        }
+        glFinish();
+        double waitMs = Since(waitStart);
+        Print("in the background", Since(start), waitMs);
+        std::cout << "  (" << std::setprecision(1) << submitMs << " ms to start them, "
+                  << ready << " of " << shaders.size() << " ready once the textures loaded)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Counts the work of looking up shaders during a frame, three ways:
+//
+//   by name (before) - what ShaderManager used to do: GetShader("name")
+//                      and UseShader("name") hash the name twice (contains,
+//                      then operator[]) and copy a shared_ptr
+//   FindShader       - the name lookup that is left for tools: one hash,
+//                      and no std::string is made for a "literal"
+//   handle           - GetShader(handle)/UseShader(handle): an array index
+//
+// Each frame makes the dozen lookups the sample used to make (the shadow
+// mapping shader's, mostly), and binds three of the shaders. The counters
+// are hashes of a name (each ShaderManager name lookup is one), shared_ptr
+// copies (each one an atomic increment and decrement), and heap
+// allocations (counted by replacing operator new).
+//
+// Runs on a fake driver (bench/FakeGL.hpp), so no window is needed.
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: ./bin/bench_shaderhandles [frames]
+#include "ShaderManager.hpp"
+#include "FakeGL.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <unordered_map>
+#include <memory>
+#include <new>
+#include <string>
+#include <cstdlib>
+
+struct Counters{
+    uint64_t hashes{0};
+    uint64_t sharedPtrCopies{0};
+    uint64_t allocations{0};
+};
+static Counters g_counters;
+
+void* operator new(std::size_t size){
+    ++g_counters.allocations;
+    if(void* p = std::malloc(size ? size : 1)){
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept{ std::free(p); }
+void operator delete(void* p, std::size_t) noexcept{ std::free(p); }
+
+// What ShaderManager::GetShader and UseShader did before handles
+struct CountingHash{
+    std::size_t operator()(const std::string& name) const{
+        ++g_counters.hashes;
+        return std::hash<std::string>{}(name);
+    }
+};
+
+struct OldShaderManager{
+    std::unordered_map<std::string,std::shared_ptr<Shader>,CountingHash> m_shaders;
+
+    std::shared_ptr<Shader> GetShader(std::string name){
+        if(m_shaders.contains(name)){
+            ++g_counters.sharedPtrCopies;
+            return m_shaders[name];
+        }
+        return nullptr;
+    }
+    void UseShader(std::string name){
+        if(m_shaders.contains(name)){
+            m_shaders[name]->Bind();
+        }
+    }
+};
+
+static const char* NAMES[] = {"shadowmapping", "shadowmappingdepth", "shadowmappingdepthdebug"};
+
+// The lookups of one frame (indices into NAMES), and the shaders bound
+static const int LOOKUPS[] = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2};
+static const int BINDS[] = {1, 0, 2};
+
+template<typename F>
+static void Run(const char* label, unsigned int frames, F&& frame){
+    g_counters = Counters{};
+    uint64_t nameLookups = ShaderManager::Instance().GetNameLookups();
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int i=0; i < frames; ++i){
+        sum += frame();
+    }
+    double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+    Counters counted = g_counters;
+    counted.hashes += ShaderManager::Instance().GetNameLookups()-nameLookups;
+    std::cout << std::left << std::setw(18) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(7) << (double)counted.hashes/frames << " hashes"
+              << std::setw(7) << (double)counted.sharedPtrCopies/frames << " shared_ptr copies"
+              << std::setw(7) << (double)counted.allocations/frames << " allocations"
+              << std::setw(9) << ms*1e6/frames << " ns/frame" << (sum == 0 ? "!" : "") << std::endl;
+}
+
+int main(int argc, char** argv){
+    unsigned int frames = argc > 1 ? std::atoi(argv[1]) : 100000;
+    FakeGLInstall();
+    FakeGLSetUniforms({"model"});
+
+    ShaderManager& manager = ShaderManager::Instance();
+    ShaderHandle handles[3];
+    handles[0] = manager.CreateNewShader(NAMES[0], "./shaders/3.1.3.shadow_mapping.vs", "./shaders/3.1.3.shadow_mapping.fs");
+    handles[1] = manager.CreateNewShader(NAMES[1], "./shaders/3.1.3.shadow_mapping_depth.vs", "./shaders/3.1.3.shadow_mapping_depth.fs");
+    handles[2] = manager.CreateNewShader(NAMES[2], "./shaders/3.1.3.debug_quad.vs", "./shaders/3.1.3.debug_quad_depth.fs");
+    OldShaderManager old;
+    for(int i=0; i < 3; ++i){
+        old.m_shaders[NAMES[i]] = std::make_shared<Shader>();
+        old.m_shaders[NAMES[i]]->CreateShader("", "");
+        manager.GetShader(handles[i])->Bind();
+    }
+
+    std::cout << sizeof(LOOKUPS)/sizeof(LOOKUPS[0]) << " lookups and " << sizeof(BINDS)/sizeof(BINDS[0])
+              << " binds per frame, per frame:" << std::endl;
+    Run("by name (before)", frames, [&](){
+        uint64_t sum = 0;
+        for(int lookup : LOOKUPS){
+            sum += old.GetShader(NAMES[lookup])->GetID();
+        }
+        for(int bind : BINDS){
+            old.UseShader(NAMES[bind]);
+        }
+        return sum;
+    });
+    Run("FindShader", frames, [&](){
+        uint64_t sum = 0;
+        for(int lookup : LOOKUPS){
+            sum += manager.GetShader(manager.FindShader(NAMES[lookup]))->GetID();
+        }
+        for(int bind : BINDS){
+            manager.UseShader(manager.FindShader(NAMES[bind]));
+        }
+        return sum;
+    });
+    Run("handle", frames, [&](){
+        uint64_t sum = 0;
+        for(int lookup : LOOKUPS){
+            sum += manager.GetShader(handles[lookup])->GetID();
+        }
+        for(int bind : BINDS){
+            manager.UseShader(handles[bind]);
+        }
+        return sum;
+    });
+    return 0;
+}
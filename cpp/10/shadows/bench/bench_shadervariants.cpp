@@ -0,0 +1,221 @@
+// Times the fragment shaders built generic (loop lengths read from the
+// uniform buffers) against variants built for one setting (the lengths
+// are #defined constants, see ShaderPreprocessor.hpp), by drawing a
+// full screen quad with each on Mesa's software rasterizer (llvmpipe).
+//
+// Run from the sample's folder, as the shaders are read from ./shaders/.
+// Usage: LIBGL_ALWAYS_SOFTWARE=1 ./bin/bench_shadervariants [size]
+#include "Shader.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "UniformBuffer.hpp"
+#include "HeadlessGL.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+static const int DRAWS = 20;
+
+// A quad covering the screen, with every attribute either shader reads
+struct QuadVertex{
+    float position[3];
+    float normal[3];
+    float texCoord[2];
+    float tangent[3];
+    float bitangent[3];
+};
+
+static const QuadVertex QUAD[6] = {
+    {{-1,-1,0}, {0,0,1}, {0,0}, {1,0,0}, {0,1,0}},
+    {{ 1,-1,0}, {0,0,1}, {1,0}, {1,0,0}, {0,1,0}},
+    {{ 1, 1,0}, {0,0,1}, {1,1}, {1,0,0}, {0,1,0}},
+    {{-1,-1,0}, {0,0,1}, {0,0}, {1,0,0}, {0,1,0}},
+    {{ 1, 1,0}, {0,0,1}, {1,1}, {1,0,0}, {0,1,0}},
+    {{-1, 1,0}, {0,0,1}, {0,1}, {1,0,0}, {0,1,0}},
+};
+
+// Points attribute 'location' at one of QuadVertex's members
+static void Attribute(GLuint location, int size, std::size_t offset){
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, sizeof(QuadVertex), (const void*)offset);
+}
+
+static GLuint MakeTexture(GLenum internalFormat, GLenum format, GLenum type, int size, const void* data){
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, size, size, 0, format, type, data);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    return texture;
+}
+
+// Draws the quad DRAWS times, and returns the time per draw
+static double Time(Shader& shader, GLuint vao, const std::vector<std::pair<const char*,int>>& samplers){
+    shader.Bind();
+    for(const auto& sampler : samplers){
+        shader.SetUniform1i(sampler.first, sampler.second);
+    }
+    glm::mat4 model(1.0f);
+    shader.SetUniformMatrix4fv("model", &model[0][0]);
+    glBindVertexArray(vao);
+    // Once first, so the driver has finished setting up
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for(int i=0; i < DRAWS; ++i){
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+    glFinish();
+    return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count()/DRAWS;
+}
+
+// What the last draw made
+static std::vector<uint8_t> ReadImage(int size){
+    std::vector<uint8_t> image(size*size*4);
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+    return image;
+}
+
+static bool Build(Shader& shader, const char* vertex, const char* fragment, const ShaderDefines& defines){
+    return shader.CreateShader(PreprocessShader(vertex, defines), PreprocessShader(fragment, defines));
+}
+
+int main(int argc, char** argv){
+    int size = argc > 1 ? std::atoi(argv[1]) : 1024;
+    if(!HeadlessGLCreate()){
+        return 1;
+    }
+
+    // Somewhere to draw
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GLuint color = MakeTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, size, nullptr);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    glViewport(0, 0, size, size);
+
+    // A noisy diffuse texture and shadow map, so neither is a constant
+    std::vector<uint8_t> pixels(256*256*4);
+    std::vector<float> depths(1024*1024);
+    uint32_t random = 12345;
+    for(uint8_t& pixel : pixels){
+        random = random*1664525u + 1013904223u;
+        pixel = (uint8_t)(random >> 24);
+    }
+    for(float& depth : depths){
+        random = random*1664525u + 1013904223u;
+        depth = 0.3f + 0.4f*(random >> 8)/16777216.0f;
+    }
+    glActiveTexture(GL_TEXTURE0);
+    MakeTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 256, pixels.data());
+    glActiveTexture(GL_TEXTURE1);
+    MakeTexture(GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 1024, depths.data());
+
+    GLuint vertexBuffer;
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
+    // shaders/3.1.3.shadow_mapping.vs
+    GLuint shadowVAO;
+    glGenVertexArrays(1, &shadowVAO);
+    glBindVertexArray(shadowVAO);
+    Attribute(0, 3, offsetof(QuadVertex, position));
+    Attribute(1, 3, offsetof(QuadVertex, normal));
+    Attribute(2, 2, offsetof(QuadVertex, texCoord));
+    // shaders/vert.glsl
+    GLuint terrainVAO;
+    glGenVertexArrays(1, &terrainVAO);
+    glBindVertexArray(terrainVAO);
+    Attribute(0, 3, offsetof(QuadVertex, position));
+    Attribute(1, 2, offsetof(QuadVertex, texCoord));
+    Attribute(2, 3, offsetof(QuadVertex, normal));
+    Attribute(3, 3, offsetof(QuadVertex, tangent));
+    Attribute(4, 3, offsetof(QuadVertex, bitangent));
+
+    // The camera looks straight at the quad, and the lights are in front of it
+    FrameData frameData{};
+    frameData.projection = glm::mat4(1.0f);
+    frameData.view = glm::mat4(1.0f);
+    frameData.lightSpaceMatrix = glm::mat4(1.0f);
+    frameData.viewPos = glm::vec4(0.0f, 0.0f, 2.0f, 1.0f);
+    frameData.lightPos = glm::vec4(0.5f, 1.0f, 2.0f, 1.0f);
+    LightData lightData{};
+    for(int i=0; i < 2; ++i){
+        lightData.pointLights[i] = {glm::vec3(1.0f), 0.2f, glm::vec3(i ? 0.5f : -0.5f, 0.0f, 1.0f), 0.5f, 1.0f, 0.09f, 0.032f, 0.0f};
+    }
+    UniformBuffer frameBuffer(FRAME_DATA_BINDING, sizeof(FrameData));
+    UniformBuffer lightBuffer(LIGHT_DATA_BINDING, sizeof(LightData));
+
+    std::cout << size << "x" << size << " pixels per draw" << std::endl;
+    std::cout << std::left << std::setw(30) << "" << std::right << std::setw(14) << "generic"
+              << std::setw(14) << "variant" << std::endl;
+    // Both versions should draw the same picture
+    std::vector<uint8_t> genericImage;
+    auto timeGeneric = [&](Shader& shader, GLuint vao, const std::vector<std::pair<const char*,int>>& samplers){
+        double ms = Time(shader, vao, samplers);
+        genericImage = ReadImage(size);
+        return ms;
+    };
+    auto timeVariant = [&](Shader& shader, GLuint vao, const std::vector<std::pair<const char*,int>>& samplers){
+        double ms = Time(shader, vao, samplers);
+        if(ReadImage(size) != genericImage){
+            std::cout << "(the variant drew a different picture)" << std::endl;
+        }
+        return ms;
+    };
+    auto print = [&](const std::string& label, double generic, double variant){
+        double pixels = (double)size*size;
+        std::cout << std::left << std::setw(30) << label << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(9) << generic*1e6/pixels << " ns/px" << std::setw(9) << variant*1e6/pixels << " ns/px"
+                  << std::setw(8) << std::setprecision(0) << (generic/variant-1.0)*100.0 << "% faster" << std::endl;
+    };
+
+    const std::vector<std::pair<const char*,int>> shadowSamplers = {{"diffuseTexture", 0}, {"shadowMap", 1}};
+    for(int radius : {0, 1, 2}){
+        frameData.shadowPCFRadius = radius;
+        frameBuffer.Update(frameData);
+        Shader generic, variant;
+        if(!Build(generic, "./shaders/3.1.3.shadow_mapping.vs", "./shaders/3.1.3.shadow_mapping.fs", ShaderDefines()) ||
+           !Build(variant, "./shaders/3.1.3.shadow_mapping.vs", "./shaders/3.1.3.shadow_mapping.fs", ShaderDefines().Set("PCF_RADIUS", radius))){
+            return 1;
+        }
+        int kernel = 2*radius+1;
+        double genericMs = timeGeneric(generic, shadowVAO, shadowSamplers);
+        double variantMs = timeVariant(variant, shadowVAO, shadowSamplers);
+        print("shadow mapping, " + std::to_string(kernel) + "x" + std::to_string(kernel) + " PCF", genericMs, variantMs);
+    }
+
+    frameBuffer.Update(frameData);
+    const std::vector<std::pair<const char*,int>> terrainSamplers = {{"u_DiffuseMap", 0}, {"u_NormalMap", 0}};
+    for(int lights : {1, 2}){
+        lightData.lightCount = lights;
+        lightBuffer.Update(lightData);
+        Shader generic, variant;
+        if(!Build(generic, "./shaders/vert.glsl", "./shaders/frag.glsl", ShaderDefines()) ||
+           !Build(variant, "./shaders/vert.glsl", "./shaders/frag.glsl", ShaderDefines().Set("LIGHT_COUNT", lights))){
+            return 1;
+        }
+        double genericMs = timeGeneric(generic, terrainVAO, terrainSamplers);
+        double variantMs = timeVariant(variant, terrainVAO, terrainSamplers);
+        print("terrain, " + std::to_string(lights) + " point light" + (lights > 1 ? "s" : ""), genericMs, variantMs);
+    }
+
+    // Normal mapping is only built in, there is no generic version of it
+    Shader normalMapped;
+    if(!Build(normalMapped, "./shaders/vert.glsl", "./shaders/frag.glsl",
+              ShaderDefines().Set("LIGHT_COUNT", 2).Set("NORMAL_MAPPING", 1))){
+        return 1;
+    }
+    double ms = Time(normalMapped, terrainVAO, terrainSamplers);
+    std::cout << std::left << std::setw(30) << "terrain, 2 lights, normal map" << std::right << std::setw(23)
+              << std::setprecision(2) << ms*1e6/((double)size*size) << " ns/px" << std::endl;
+    return 0;
+}
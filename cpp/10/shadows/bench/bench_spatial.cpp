@@ -0,0 +1,285 @@
+// Times the LooseOctree and the HashGrid against testing every object,
+// with 10,000, 100,000 and 1,000,000 objects.
+//
+// The objects are boxes 0.5 to 4 metres wide, scattered over 2km square
+// and 40m high. For each way, it times inserting them all, moving them
+// all a little (as moving objects would each frame) with MoveMany() and
+// then one by one with Move(), and the queries: a camera's frustum (as
+// bench_culling), spheres 20m across and rays 200m long, at random
+// places. Then it removes every third object and inserts it again
+// ('remove' is both). Every query's results are checked against testing
+// every object, and again with those objects removed and once they are
+// back.
+//
+// Usage: ./bin/bench_spatial [objects...] [-q queries]
+#include "SpatialIndex.hpp"
+#include "Frustum.hpp"
+#include "JobSystem.hpp"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/geometric.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+
+static const float WORLD = 1000.0f;
+static const float HEIGHT = 40.0f;
+static const float SPHERE_RADIUS = 10.0f;
+static const float RAY_LENGTH = 200.0f;
+
+static Frustum CameraFrustum(unsigned int frame){
+    float angle = frame*0.1f;
+    glm::vec3 eye(0.0f, 2.0f, 0.0f);
+    glm::mat4 view = glm::lookAt(eye, eye+glm::vec3(std::sin(angle), 0.0f, -std::cos(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 640.0f/480.0f, 0.1f, 500.0f);
+    return Frustum(projection*view);
+}
+
+struct Query{
+    glm::vec3 origin;
+    glm::vec3 direction;
+};
+
+// What testing every object finds, as object indices
+static std::vector<uint32_t> Everything(const std::vector<glm::vec3>& centers, const std::vector<glm::vec3>& extents,
+                                        int kind, const Frustum& frustum, const Query& query){
+    std::vector<uint32_t> found;
+    for(uint32_t i=0; i < centers.size(); ++i){
+        bool touches = false;
+        if(kind == 0){
+            touches = frustum.IsVisible(centers[i], extents[i]);
+        }else if(kind == 1){
+            glm::vec3 outside = glm::max(glm::abs(query.origin - centers[i]) - extents[i], glm::vec3(0.0f));
+            touches = glm::dot(outside, outside) <= SPHERE_RADIUS*SPHERE_RADIUS;
+        }else{
+            float enter = 0.0f, leave = RAY_LENGTH;
+            for(int axis=0; axis < 3; ++axis){
+                float offset = centers[i][axis] - query.origin[axis];
+                float inverse = 1.0f/query.direction[axis];
+                float t0 = (offset - extents[i][axis])*inverse;
+                float t1 = (offset + extents[i][axis])*inverse;
+                enter = std::max(enter, std::min(t0, t1));
+                leave = std::min(leave, std::max(t0, t1));
+            }
+            touches = enter <= leave;
+        }
+        if(touches){
+            found.push_back(i);
+        }
+    }
+    return found;
+}
+
+static double Since(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+struct Scene{
+    std::vector<glm::vec3> centers;
+    std::vector<glm::vec3> extents;
+    std::vector<glm::vec3> velocities;
+    std::vector<Query> queries;
+    // Testing every object: its results and its times
+    std::vector<std::vector<uint32_t>> expected;
+    double milliseconds[3]{0.0, 0.0, 0.0};
+};
+
+static const unsigned int FRUSTA = 10;
+
+static Query QueryFor(const Scene& scene, uint32_t i){
+    return i < FRUSTA ? Query{} : scene.queries[(i-FRUSTA) % scene.queries.size()];
+}
+
+// Runs everything on one kind of index, and prints a row
+template<typename Index>
+static void Run(const char* name, Index& index, Scene& scene, unsigned int queryCount){
+    uint32_t count = scene.centers.size();
+    std::vector<SpatialHandle> handles(count);
+    std::vector<glm::vec3> placed = scene.centers;
+    auto start = std::chrono::steady_clock::now();
+    for(uint32_t i=0; i < count; ++i){
+        handles[i] = index.Insert(scene.centers[i], scene.extents[i]);
+    }
+    double insertMs = Since(start);
+
+    // A frame's worth of movement, all at once, then one by one
+    for(uint32_t i=0; i < count; ++i){
+        scene.centers[i] += scene.velocities[i];
+    }
+    start = std::chrono::steady_clock::now();
+    index.MoveMany(count, handles.data(), scene.centers.data(), scene.extents.data());
+    double moveManyMs = Since(start);
+    for(uint32_t i=0; i < count; ++i){
+        scene.centers[i] += scene.velocities[i];
+    }
+    start = std::chrono::steady_clock::now();
+    for(uint32_t i=0; i < count; ++i){
+        index.Move(handles[i], scene.centers[i], scene.extents[i]);
+    }
+    double moveMs = Since(start);
+
+    // The frusta, then spheres, then rays
+    std::vector<SpatialHandle> results;
+    double milliseconds[3]{0.0, 0.0, 0.0};
+    uint32_t wrong = 0;
+    bool checking = scene.expected.empty();
+    for(int kind=0; kind < 3; ++kind){
+        unsigned int queries = kind == 0 ? FRUSTA : queryCount;
+        for(unsigned int q=0; q < queries; ++q){
+            uint32_t i = kind == 0 ? q : FRUSTA + (kind-1)*queryCount + q;
+            Frustum frustum = CameraFrustum(q);
+            Query query = QueryFor(scene, i);
+            start = std::chrono::steady_clock::now();
+            if(kind == 0){
+                index.QueryFrustum(frustum, results);
+            }else if(kind == 1){
+                index.QuerySphere(query.origin, SPHERE_RADIUS, results);
+            }else{
+                index.QueryRay(query.origin, query.direction, RAY_LENGTH, results);
+            }
+            milliseconds[kind] += Since(start);
+
+            if(checking){
+                start = std::chrono::steady_clock::now();
+                scene.expected.push_back(Everything(scene.centers, scene.extents, kind, frustum, query));
+                scene.milliseconds[kind] += Since(start);
+            }
+            std::vector<uint32_t> indices;
+            for(SpatialHandle handle : results){
+                indices.push_back(handle.index);
+            }
+            std::sort(indices.begin(), indices.end());
+            if(indices != scene.expected[i]){
+                ++wrong;
+            }
+        }
+    }
+    // The objects were inserted in order, so their handles are 0, 1, ...
+    for(uint32_t i=0; i < count; ++i){
+        if(handles[i].index != i){
+            ++wrong;
+        }
+    }
+
+    // Every third object removed, then inserted again (into the handles
+    // that were freed, in whatever order). Each time, the queries must
+    // find what testing every object that is left finds.
+    std::vector<uint32_t> objectOf(count);
+    auto checkAll = [&](bool removed){
+        for(uint32_t i=0; i < count; ++i){
+            objectOf[handles[i].index] = i;
+        }
+        for(uint32_t i=0; i < scene.expected.size(); ++i){
+            if(i < FRUSTA){
+                index.QueryFrustum(CameraFrustum(i), results);
+            }else if(i < FRUSTA + queryCount){
+                index.QuerySphere(QueryFor(scene, i).origin, SPHERE_RADIUS, results);
+            }else{
+                index.QueryRay(QueryFor(scene, i).origin, QueryFor(scene, i).direction, RAY_LENGTH, results);
+            }
+            std::vector<uint32_t> indices, expected;
+            for(SpatialHandle handle : results){
+                indices.push_back(objectOf[handle.index]);
+            }
+            std::sort(indices.begin(), indices.end());
+            for(uint32_t object : scene.expected[i]){
+                if(!removed || object % 3 != 0){
+                    expected.push_back(object);
+                }
+            }
+            if(indices != expected){
+                ++wrong;
+            }
+        }
+    };
+    start = std::chrono::steady_clock::now();
+    for(uint32_t i=0; i < count; i+=3){
+        index.Remove(handles[i]);
+    }
+    double removeMs = Since(start);
+    if(index.GetCount() != count - (count+2)/3){
+        ++wrong;
+    }
+    checkAll(true);
+    start = std::chrono::steady_clock::now();
+    for(uint32_t i=0; i < count; i+=3){
+        handles[i] = index.Insert(scene.centers[i], scene.extents[i]);
+    }
+    removeMs += Since(start);
+    checkAll(false);
+
+    if(checking){
+        std::cout << "  " << std::left << std::setw(14) << "every object" << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(50) << "" << std::setw(10) << scene.milliseconds[0]/FRUSTA << " ms"
+                  << std::setw(10) << 1000.0*scene.milliseconds[1]/queryCount << " us"
+                  << std::setw(10) << 1000.0*scene.milliseconds[2]/queryCount << " us" << std::endl;
+    }
+    std::cout << "  " << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << insertMs << std::setw(10) << moveManyMs << std::setw(10) << moveMs
+              << std::setw(10) << removeMs
+              << std::setw(10) << index.GetCellCount()
+              << std::setw(10) << milliseconds[0]/FRUSTA << " ms"
+              << std::setw(10) << 1000.0*milliseconds[1]/queryCount << " us"
+              << std::setw(10) << 1000.0*milliseconds[2]/queryCount << " us"
+              << std::setw(8) << wrong << std::endl;
+
+    // Back to where the objects were, for the next index
+    scene.centers = placed;
+}
+
+int main(int argc, char** argv){
+    std::vector<uint32_t> sizes;
+    unsigned int queryCount = 200;
+    for(int i=1; i < argc; ++i){
+        if(std::string(argv[i]) == "-q" && i+1 < argc){
+            queryCount = std::atoi(argv[++i]);
+        }else{
+            sizes.push_back(std::atoi(argv[i]));
+        }
+    }
+    if(sizes.empty()){
+        sizes = {10000, 100000, 1000000};
+    }
+    std::cout << JobSystem::Instance().GetWorkerCount() << " worker threads. Times are the total for inserting and moving, "
+              << "and per query for querying; 'wrong' counts queries whose results differ from testing every object."
+              << std::endl;
+
+    for(uint32_t count : sizes){
+        std::mt19937 random(5);
+        std::uniform_real_distribution<float> place(-WORLD, WORLD);
+        std::uniform_real_distribution<float> height(0.0f, HEIGHT);
+        std::uniform_real_distribution<float> size(0.25f, 2.0f);
+        std::uniform_real_distribution<float> speed(-0.5f, 0.5f);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+        Scene scene;
+        for(uint32_t i=0; i < count; ++i){
+            scene.centers.push_back(glm::vec3(place(random), height(random), place(random)));
+            scene.extents.push_back(glm::vec3(size(random), size(random), size(random)));
+            scene.velocities.push_back(glm::vec3(speed(random), speed(random)*0.1f, speed(random)));
+        }
+        for(unsigned int q=0; q < queryCount; ++q){
+            glm::vec3 direction(unit(random), unit(random)*0.1f, unit(random));
+            scene.queries.push_back({glm::vec3(place(random), height(random), place(random)), glm::normalize(direction)});
+        }
+
+        std::cout << std::endl << count << " objects" << std::endl << "  " << std::left << std::setw(14) << "" << std::right
+                  << std::setw(10) << "insert" << std::setw(10) << "MoveMany" << std::setw(10) << "Move"
+                  << std::setw(10) << "remove"
+                  << std::setw(10) << "cells" << std::setw(13) << "frustum" << std::setw(13) << "sphere"
+                  << std::setw(13) << "ray" << std::setw(8) << "wrong" << std::endl;
+        // Cells of 16m at the bottom of the octree, and 8m in the grid
+        LooseOctree octree(glm::vec3(0.0f), 1024.0f, 7);
+        Run("loose octree", octree, scene, queryCount);
+        HashGrid grid(8.0f);
+        Run("hash grid", grid, scene, queryCount);
+    }
+    return 0;
+}
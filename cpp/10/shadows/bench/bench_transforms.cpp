@@ -0,0 +1,171 @@
+// Times working out the world matrices of 100,000 nodes, each frame:
+//
+//   pointer tree   - nodes allocated one by one, each holding its children,
+//                    walked recursively and all recomputed every frame
+//                    (what a SceneNode tree that composed its transforms
+//                    would do)
+//   hierarchy      - TransformHierarchy::Update, with 100% and with 1% of
+//                    the nodes moved since the last frame
+//   parallel       - TransformHierarchy::UpdateParallel, the same
+//
+// The scene is a root with 1,000 objects below it, each a tree of 99
+// nodes (like a skeleton). The nodes are made in a shuffled order, so the
+// hierarchy has to sort them into depth first order once.
+//
+// Usage: ./bin/bench_transforms [frames]
+#include "TransformHierarchy.hpp"
+#include "JobSystem.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+static const uint32_t OBJECTS = 1000;
+static const uint32_t NODES_PER_OBJECT = 99;
+
+struct PointerNode{
+    glm::vec3 position{0.0f};
+    glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+    glm::vec3 scale{1.0f};
+    glm::mat4 world{1.0f};
+    std::vector<PointerNode*> children;
+};
+
+static void UpdatePointerTree(PointerNode* node, const glm::mat4& parent){
+    glm::mat4 local = glm::mat4_cast(node->rotation);
+    local[0] *= node->scale.x;
+    local[1] *= node->scale.y;
+    local[2] *= node->scale.z;
+    local[3] = glm::vec4(node->position, 1.0f);
+    node->world = parent * local;
+    for(PointerNode* child : node->children){
+        UpdatePointerTree(child, node->world);
+    }
+}
+
+// Only the update is timed, not moving the nodes
+template<typename M, typename U>
+static void Run(const char* label, unsigned int frames, M&& move, U&& update){
+    uint64_t updated = 0;
+    std::chrono::steady_clock::duration time{0};
+    for(unsigned int i=0; i < frames; ++i){
+        move(i);
+        auto start = std::chrono::steady_clock::now();
+        updated += update();
+        time += std::chrono::steady_clock::now()-start;
+    }
+    double ms = std::chrono::duration<double,std::milli>(time).count();
+    std::cout << std::left << std::setw(24) << label << std::right << std::fixed << std::setprecision(3)
+              << std::setw(9) << ms/frames << " ms/frame" << std::setw(9) << updated/frames
+              << " matrices" << std::endl;
+}
+
+int main(int argc, char** argv){
+    unsigned int frames = argc > 1 ? std::atoi(argv[1]) : 100;
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+
+    // Who is whose parent: node 0 is the root, then each object's nodes.
+    // An object's first node hangs off the root, the others off an
+    // earlier node of the same object.
+    uint32_t count = 1 + OBJECTS*NODES_PER_OBJECT;
+    std::vector<uint32_t> parents(count, 0);
+    for(uint32_t object=0; object < OBJECTS; ++object){
+        uint32_t first = 1 + object*NODES_PER_OBJECT;
+        for(uint32_t i=1; i < NODES_PER_OBJECT; ++i){
+            parents[first+i] = first + random()%i;
+        }
+    }
+    // Made in a shuffled order, parents before their children
+    std::vector<uint32_t> order(count-1);
+    for(uint32_t i=0; i < count-1; ++i){
+        order[i] = i+1;
+    }
+    std::shuffle(order.begin(), order.end(), random);
+    std::stable_sort(order.begin(), order.end(), [](uint32_t a, uint32_t b){
+        return (a-1)%NODES_PER_OBJECT < (b-1)%NODES_PER_OBJECT;
+    });
+
+    std::vector<glm::vec3> positions(count);
+    std::vector<glm::quat> rotations(count);
+    for(uint32_t i=0; i < count; ++i){
+        positions[i] = glm::vec3(offset(random), offset(random), offset(random));
+        rotations[i] = glm::angleAxis(offset(random), glm::normalize(glm::vec3(offset(random), 1.0f, offset(random))));
+    }
+
+    std::vector<PointerNode*> pointerNodes(count);
+    pointerNodes[0] = new PointerNode();
+    TransformHierarchy hierarchy;
+    std::vector<TransformHandle> handles(count);
+    handles[0] = hierarchy.Create();
+    for(uint32_t i : order){
+        pointerNodes[i] = new PointerNode();
+        pointerNodes[i]->position = positions[i];
+        pointerNodes[i]->rotation = rotations[i];
+        pointerNodes[parents[i]]->children.push_back(pointerNodes[i]);
+        handles[i] = hierarchy.Create(handles[parents[i]]);
+        hierarchy.SetPosition(handles[i], positions[i]);
+        hierarchy.SetRotation(handles[i], rotations[i]);
+    }
+
+    auto sortStart = std::chrono::steady_clock::now();
+    hierarchy.Update();
+    double sortMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-sortStart).count();
+    UpdatePointerTree(pointerNodes[0], glm::mat4(1.0f));
+    float difference = 0.0f;
+    for(uint32_t i=0; i < count; ++i){
+        const glm::mat4& a = hierarchy.GetWorldMatrix(handles[i]);
+        const glm::mat4& b = pointerNodes[i]->world;
+        for(int column=0; column < 4; ++column){
+            for(int row=0; row < 4; ++row){
+                difference = std::max(difference, std::abs(a[column][row]-b[column][row]));
+            }
+        }
+    }
+    std::cout << count << " nodes, " << JobSystem::Instance().GetWorkerCount() << " worker threads" << std::endl;
+    std::cout << "first update (sorts the nodes): " << std::fixed << std::setprecision(3) << sortMs
+              << " ms, largest difference from the pointer tree " << difference << std::endl;
+
+    // The nodes moved each frame at 1%
+    std::vector<uint32_t> moved(count/100);
+    for(uint32_t& node : moved){
+        node = random()%count;
+    }
+    auto moveAll = [&](unsigned int frame){
+        float x = frame*0.001f;
+        for(uint32_t i=0; i < count; ++i){
+            hierarchy.SetPosition(handles[i], positions[i]+x);
+        }
+    };
+    auto moveSome = [&](unsigned int frame){
+        float x = frame*0.001f;
+        for(uint32_t i : moved){
+            hierarchy.SetPosition(handles[i], positions[i]+x);
+        }
+    };
+
+    std::cout << "Per frame:" << std::endl;
+    auto update = [&](){
+        hierarchy.Update();
+        return hierarchy.GetUpdatedCount();
+    };
+    auto updateParallel = [&](){
+        hierarchy.UpdateParallel();
+        return hierarchy.GetUpdatedCount();
+    };
+    Run("pointer tree", frames, [&](unsigned int frame){
+        pointerNodes[0]->position.x = frame*0.001f;
+    }, [&](){
+        UpdatePointerTree(pointerNodes[0], glm::mat4(1.0f));
+        return count;
+    });
+    Run("hierarchy, 100% moved", frames, moveAll, update);
+    Run("parallel, 100% moved", frames, moveAll, updateParallel);
+    Run("hierarchy, 1% moved", frames, moveSome, update);
+    Run("parallel, 1% moved", frames, moveSome, updateParallel);
+    return 0;
+}
@@ -0,0 +1,244 @@
+// Counts the OpenGL calls, and times the CPU side, of setting the
+// uniforms SceneNode::Update sets for every node, three ways:
+//
+//   glGetUniformLocation - what Shader used to do: ask the driver for the
+//                          location by name on every set
+//   by name              - Shader::SetUniform*("name"): the name is hashed
+//                          and found in the table built when linking
+//   handle               - Shader::SetUniform*(handle): an array index
+//
+// Then counts the uniform traffic of a whole frame of the sample, with
+// the camera and lights set on each shader, and with them in the
+// FrameData and LightData uniform buffers (UniformBuffer.hpp).
+//
+// Runs on a fake driver (bench/FakeGL.hpp), so no window is needed.
+//
+// Usage: ./bin/bench_uniforms [nodes]
+#include "Shader.hpp"
+#include "UniformBuffer.hpp"
+#include "FakeGL.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+
+// The uniforms of shaders/vert.glsl and shaders/frag.glsl
+static const std::vector<std::string> TERRAIN_UNIFORMS = {
+    "model", "view", "projection", "u_DiffuseMap",
+    "pointLights[0].lightColor", "pointLights[0].lightPos", "pointLights[0].ambientIntensity",
+    "pointLights[0].specularStrength", "pointLights[0].constant", "pointLights[0].linear",
+    "pointLights[0].quadratic",
+    "pointLights[1].lightColor", "pointLights[1].lightPos", "pointLights[1].ambientIntensity",
+    "pointLights[1].specularStrength", "pointLights[1].constant", "pointLights[1].linear",
+    "pointLights[1].quadratic",
+};
+
+static const float g_matrix[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+
+// What Shader::SetUniform* did before the reflection table
+struct OldShader{
+    GLuint id{1};
+    void SetUniformMatrix4fv(const GLchar* name, const GLfloat* value){
+        glUniformMatrix4fv(glGetUniformLocation(id, name), 1, GL_FALSE, value);
+    }
+    void SetUniform3f(const GLchar* name, float v0, float v1, float v2){
+        glUniform3f(glGetUniformLocation(id, name), v0, v1, v2);
+    }
+    void SetUniform1i(const GLchar* name, int value){
+        glUniform1i(glGetUniformLocation(id, name), value);
+    }
+    void SetUniform1f(const GLchar* name, float value){
+        glUniform1f(glGetUniformLocation(id, name), value);
+    }
+};
+
+// The sets SceneNode::Update makes, by name
+template<typename S>
+static void UpdateByName(S& shader){
+    shader.SetUniform1i("u_DiffuseMap", 0);
+    shader.SetUniform1i("u_DetailMap", 1);
+    shader.SetUniformMatrix4fv("model", g_matrix);
+    shader.SetUniformMatrix4fv("view", g_matrix);
+    shader.SetUniformMatrix4fv("projection", g_matrix);
+    shader.SetUniform3f("pointLights[0].lightColor", 1.0f, 1.0f, 1.0f);
+    shader.SetUniform3f("pointLights[0].lightPos", 1.0f, 2.0f, 3.0f);
+    shader.SetUniform1f("pointLights[0].ambientIntensity", 0.9f);
+    shader.SetUniform1f("pointLights[0].specularStrength", 0.5f);
+    shader.SetUniform1f("pointLights[0].constant", 1.0f);
+    shader.SetUniform1f("pointLights[0].linear", 0.003f);
+    shader.SetUniform1f("pointLights[0].quadratic", 0.0f);
+    shader.SetUniform3f("pointLights[1].lightColor", 1.0f, 0.0f, 0.0f);
+    shader.SetUniform3f("pointLights[1].lightPos", 1.0f, 2.0f, 3.0f);
+    shader.SetUniform1f("pointLights[1].ambientIntensity", 0.9f);
+    shader.SetUniform1f("pointLights[1].specularStrength", 0.5f);
+    shader.SetUniform1f("pointLights[1].constant", 1.0f);
+    shader.SetUniform1f("pointLights[1].linear", 0.09f);
+    shader.SetUniform1f("pointLights[1].quadratic", 0.032f);
+}
+
+// The same, with handles looked up once (as SceneNode does)
+struct Handles{
+    UniformHandle diffuseMap, detailMap, model, view, projection;
+    UniformHandle lights[2][7];
+};
+
+static Handles GetHandles(Shader& shader){
+    Handles h;
+    h.diffuseMap = shader.GetUniform("u_DiffuseMap");
+    h.detailMap = shader.GetUniform("u_DetailMap");
+    h.model = shader.GetUniform(UniformHash("model"));
+    h.view = shader.GetUniform(UniformHash("view"));
+    h.projection = shader.GetUniform(UniformHash("projection"));
+    const char* members[7] = {"lightColor","lightPos","ambientIntensity","specularStrength","constant","linear","quadratic"};
+    for(int i=0; i < 2; ++i){
+        for(int m=0; m < 7; ++m){
+            h.lights[i][m] = shader.GetUniform("pointLights[" + std::to_string(i) + "]." + members[m]);
+        }
+    }
+    return h;
+}
+
+static void UpdateByHandle(Shader& shader, const Handles& h){
+    static const float values[2][5] = {{0.9f,0.5f,1.0f,0.003f,0.0f},{0.9f,0.5f,1.0f,0.09f,0.032f}};
+    shader.SetUniform1i(h.diffuseMap, 0);
+    shader.SetUniform1i(h.detailMap, 1);
+    shader.SetUniformMatrix4fv(h.model, g_matrix);
+    shader.SetUniformMatrix4fv(h.view, g_matrix);
+    shader.SetUniformMatrix4fv(h.projection, g_matrix);
+    for(int i=0; i < 2; ++i){
+        shader.SetUniform3f(h.lights[i][0], 1.0f, i==0 ? 1.0f : 0.0f, i==0 ? 1.0f : 0.0f);
+        shader.SetUniform3f(h.lights[i][1], 1.0f, 2.0f, 3.0f);
+        for(int m=2; m < 7; ++m){
+            shader.SetUniform1f(h.lights[i][m], values[i][m-2]);
+        }
+    }
+}
+
+// The uniforms the shadow mapping shaders used to set every frame
+struct FrameHandles{
+    UniformHandle lightSpaceMatrix, viewPos, lightPos, nearPlane, farPlane;
+};
+
+// Objects drawn in each pass of the sample: the floor, three cubes and
+// four models
+static const int SCENE_OBJECTS = 8;
+
+// A frame with the camera and lights set on each shader
+static void FrameBefore(Shader& shader, const Handles& h, const FrameHandles& f){
+    // depth pass
+    shader.SetUniformMatrix4fv(f.lightSpaceMatrix, g_matrix);
+    for(int i=0; i < SCENE_OBJECTS; ++i){
+        shader.SetUniformMatrix4fv(h.model, g_matrix);
+    }
+    // main pass, and the light
+    shader.SetUniformMatrix4fv(h.projection, g_matrix);
+    shader.SetUniformMatrix4fv(h.view, g_matrix);
+    shader.SetUniform3f(f.viewPos, 0.0f, 0.5f, 5.0f);
+    shader.SetUniform3f(f.lightPos, -2.0f, 4.0f, -1.0f);
+    shader.SetUniformMatrix4fv(f.lightSpaceMatrix, g_matrix);
+    for(int i=0; i < SCENE_OBJECTS+1; ++i){
+        shader.SetUniformMatrix4fv(h.model, g_matrix);
+    }
+    // the terrain SceneNode
+    UpdateByHandle(shader, h);
+    // the debug quad
+    shader.SetUniform1f(f.nearPlane, 1.0f);
+    shader.SetUniform1f(f.farPlane, 7.5f);
+}
+
+// The same frame with the uniform buffers
+static void FrameAfter(Shader& shader, UniformHandle model,
+                       UniformBuffer& frameBuffer, UniformBuffer& lightBuffer){
+    static FrameData frameData{};
+    static LightData lightData{};
+    frameBuffer.Update(frameData);
+    lightBuffer.Update(lightData);
+    // depth pass
+    for(int i=0; i < SCENE_OBJECTS; ++i){
+        shader.SetUniformMatrix4fv(model, g_matrix);
+    }
+    // main pass, and the light
+    for(int i=0; i < SCENE_OBJECTS+1; ++i){
+        shader.SetUniformMatrix4fv(model, g_matrix);
+    }
+    // the terrain SceneNode
+    shader.SetUniformMatrix4fv(model, g_matrix);
+}
+
+template<typename F>
+static void RunFrame(const char* label, F&& frame){
+    const unsigned int frames = 100000;
+    g_fakeGL = FakeGLCounters{};
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int i=0; i < frames; ++i){
+        frame();
+    }
+    double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+    std::cout << std::left << std::setw(22) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << (double)g_fakeGL.uniformSets/frames << " uniform sets"
+              << std::setw(6) << (double)g_fakeGL.bufferUploads/frames << " buffer uploads"
+              << std::setw(8) << (double)g_fakeGL.calls/frames << " GL calls"
+              << std::setprecision(2) << std::setw(8) << ms*1e6/frames << " ns/frame" << std::endl;
+}
+
+template<typename F>
+static void Run(const char* label, unsigned int nodes, F&& update){
+    const unsigned int frames = 100;
+    g_fakeGL = FakeGLCounters{};
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int frame=0; frame < frames; ++frame){
+        for(unsigned int node=0; node < nodes; ++node){
+            update();
+        }
+    }
+    double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+    std::cout << std::left << std::setw(22) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << (double)g_fakeGL.calls/frames/nodes << " GL calls/node"
+              << std::setw(10) << (double)g_fakeGL.calls/frames << " GL calls/frame"
+              << std::setprecision(3) << std::setw(10) << ms/frames << " ms/frame"
+              << std::setprecision(1) << std::setw(8) << ms*1e6/frames/nodes << " ns/node" << std::endl;
+}
+
+int main(int argc, char** argv){
+    unsigned int nodes = argc > 1 ? std::atoi(argv[1]) : 1000;
+    FakeGLInstall();
+    FakeGLSetUniforms(TERRAIN_UNIFORMS);
+
+    Shader shader;
+    shader.CreateShader("", "");
+    Handles handles = GetHandles(shader);
+    OldShader oldShader;
+
+    std::cout << nodes << " nodes per frame, 19 uniform sets per node" << std::endl;
+    Run("glGetUniformLocation", nodes, [&](){ UpdateByName(oldShader); });
+    Run("by name", nodes, [&](){ UpdateByName(shader); });
+    Run("handle", nodes, [&](){ UpdateByHandle(shader, handles); });
+
+    // Every uniform any of the sample's shaders set (the fake driver has a
+    // single list for all programs)
+    std::vector<std::string> frameUniforms = TERRAIN_UNIFORMS;
+    frameUniforms.insert(frameUniforms.end(), {"lightSpaceMatrix", "viewPos", "lightPos", "near_plane", "far_plane"});
+    FakeGLSetUniforms(frameUniforms);
+    Shader before;
+    before.CreateShader("", "");
+    Handles beforeHandles = GetHandles(before);
+    FrameHandles frameHandles{before.GetUniform("lightSpaceMatrix"), before.GetUniform("viewPos"),
+                              before.GetUniform("lightPos"), before.GetUniform("near_plane"),
+                              before.GetUniform("far_plane")};
+
+    // With the blocks, only the model matrix (and the texture slots) are left
+    FakeGLSetUniforms({"model", "u_DiffuseMap", "u_DetailMap"},
+                      {{"FrameData", (GLint)sizeof(FrameData)}, {"LightData", (GLint)sizeof(LightData)}});
+    Shader after;
+    after.CreateShader("", "");
+    UniformHandle model = after.GetUniform("model");
+    UniformBuffer frameBuffer(FRAME_DATA_BINDING, sizeof(FrameData));
+    UniformBuffer lightBuffer(LIGHT_DATA_BINDING, sizeof(LightData));
+
+    std::cout << std::endl << "One frame of the sample, per frame:" << std::endl;
+    RunFrame("uniforms per shader", [&](){ FrameBefore(before, beforeHandles, frameHandles); });
+    RunFrame("uniform buffers", [&](){ FrameAfter(after, model, frameBuffer, lightBuffer); });
+    return 0;
+}
@@ -1,11 +1,14 @@
 # Run with: python3 build.py
 import os
+import sys
 import platform
 
 # (1)==================== COMMON CONFIGURATION OPTIONS ======================= #
 COMPILER="g++ -g -std=c++20"   # The compiler we want to use 
                                 #(You may try g++ if you have trouble)
 SOURCE="./src/*.cpp"    # Where the source code lives
+# The .obj/.mtl loader is shared with the mesh example in 06
+SOURCE+=" ./../../06/mesh/mesh.cpp ./../../06/mesh/material.cpp ./../../06/mesh/mappedfile.cpp"
 EXECUTABLE="./bin/prog"        # Name of the final executable
 # ======================= COMMON CONFIGURATION OPTIONS ======================= #
 
@@ -17,19 +20,85 @@ LIBRARIES=""            # What libraries do we want to include
 
 if platform.system()=="Linux":
     ARGUMENTS="-D LINUX" # -D is a #define sent to preprocessor
-    INCLUDE_DIR="-I ./include/ -I ./../../common/thirdparty/glm/"
-    LIBRARIES="-lSDL2 -ldl"
+    INCLUDE_DIR="-I ./include/ -I ./../../06/mesh/ -I ./../../common/thirdparty/glm/"
+    LIBRARIES="-lSDL2 -ldl -lpthread"
 elif platform.system()=="Darwin":
     ARGUMENTS="-D MAC" # -D is a #define sent to the preprocessor.
-    INCLUDE_DIR="-I ./include/ -I/Library/Frameworks/SDL2.framework/Headers -I./../../common/thirdparty/old/glm"
+    INCLUDE_DIR="-I ./include/ -I ./../../06/mesh/ -I/Library/Frameworks/SDL2.framework/Headers -I./../../common/thirdparty/old/glm"
     LIBRARIES="-F/Library/Frameworks -framework SDL2"
 elif platform.system()=="Windows":
     ARGUMENTS="-D MINGW -static-libgcc -static-libstdc++" 
-    INCLUDE_DIR="-I./include/ -I./../../common/thirdparty/old/glm/"
+    INCLUDE_DIR="-I./include/ -I./../../06/mesh/ -I./../../common/thirdparty/old/glm/"
     EXECUTABLE="lab.exe"
     LIBRARIES="-lmingw32 -lSDL2main -lSDL2 -mwindows"
 # (2)=================== Platform specific configuration ===================== #
 
+# 'python3 build.py tools' instead builds the command line tools into ./bin/
+#   packer        - packs assets into an archive (see tools/packer.cpp)
+#   bench_archive - times loading from an archive against loose files
+#   bench_uniforms - counts GL calls for setting uniforms (on a fake driver)
+#   bench_shaderhandles - counts the work of looking up shaders by name
+#                  against by handle (on a fake driver)
+#   bench_glstate - counts the GL calls of a frame, with and without
+#                  skipping redundant binds (on a fake driver)
+#   bench_transforms - times working out the world matrices of 100,000
+#                  nodes, all of them or only those that moved
+#   bench_culling - times frustum culling 100,000 boxes, one at a time
+#                  against with SIMD
+#   bench_renderqueue - counts the state changes of drawing thousands of
+#                  objects in scene graph order against sorted, and instanced
+#                  (on a fake driver)
+#   bench_occlusion - times occlusion culling 100,000 objects in a town
+#                  behind its buildings, and counts what it culls
+#   bench_spatial - times queries on a loose octree and a hash grid
+#                  against testing every object, with up to 1,000,000 objects
+#   bench_commandlists - times recording a 100,000 node scene into command
+#                  lists on 1 to 8 threads, and replaying them (on a fake
+#                  driver)
+#   bench_entities - times building a frame's draw list from 100,000
+#                  SceneNodes against from 100,000 entities (on a fake driver)
+#   bench_scenefile - times loading a 100,000 node scene from a binary
+#                  scene file against building it (on a fake driver)
+#   bench_programcache - times building the shaders with and without the
+#                  program cache (Linux only, needs Mesa's EGL)
+#   bench_shadercompile - times building shaders one by one against in the
+#                  background while textures load (Linux only, as above)
+#   bench_shadervariants - times generic shaders against variants built
+#                  for one setting, on Mesa's software rasterizer (Linux only)
+#   bench_instancing - draws 50,000 cubes one by one against instanced,
+#                  on Mesa's software rasterizer (Linux only)
+#   bench_gpudriven - times culling and drawing 100,000 cubes on the CPU
+#                  against on the GPU (compute culling, multi draw indirect),
+#                  on Mesa's software rasterizer (Linux only)
+if len(sys.argv) > 1 and sys.argv[1]=="tools":
+    ARCHIVE_SOURCE="./src/Archive.cpp ./src/LZ.cpp ./../../06/mesh/mappedfile.cpp"
+    SHADER_SOURCE="./src/Shader.cpp ./src/ShaderPreprocessor.cpp ./src/GLState.cpp ./src/UniformBuffer.cpp ./src/ProgramCache.cpp ./src/glad.cpp ./src/VirtualFileSystem.cpp "+ARCHIVE_SOURCE
+    TOOLS={"packer":"./tools/packer.cpp "+ARCHIVE_SOURCE,
+           "bench_archive":"./bench/bench_archive.cpp ./src/VirtualFileSystem.cpp "+ARCHIVE_SOURCE,
+           "bench_uniforms":"./bench/bench_uniforms.cpp "+SHADER_SOURCE+" "+LIBRARIES,
+           "bench_shaderhandles":"./bench/bench_shaderhandles.cpp ./src/FileWatcher.cpp "+SHADER_SOURCE+" "+LIBRARIES,
+           "bench_glstate":"./bench/bench_glstate.cpp ./src/FileWatcher.cpp ./src/Texture.cpp ./src/Image.cpp ./src/Terrain.cpp ./src/Object.cpp ./src/Geometry.cpp ./src/VertexBufferLayout.cpp ./src/SceneNode.cpp ./src/RenderQueue.cpp ./src/CommandList.cpp ./src/TransformHierarchy.cpp ./src/Frustum.cpp ./src/JobSystem.cpp "+SHADER_SOURCE+" "+LIBRARIES,
+           "bench_transforms":"./bench/bench_transforms.cpp ./src/TransformHierarchy.cpp ./src/Frustum.cpp ./src/JobSystem.cpp "+LIBRARIES,
+           "bench_culling":"./bench/bench_culling.cpp ./src/TransformHierarchy.cpp ./src/Frustum.cpp ./src/JobSystem.cpp "+LIBRARIES,
+           "bench_renderqueue":"./bench/bench_renderqueue.cpp ./src/FileWatcher.cpp ./src/Texture.cpp ./src/Image.cpp ./src/Terrain.cpp ./src/Object.cpp ./src/Geometry.cpp ./src/VertexBufferLayout.cpp ./src/SceneNode.cpp ./src/RenderQueue.cpp ./src/CommandList.cpp ./src/TransformHierarchy.cpp ./src/Frustum.cpp ./src/JobSystem.cpp "+SHADER_SOURCE+" "+LIBRARIES,
+           "bench_occlusion":"./bench/bench_occlusion.cpp ./src/OcclusionCuller.cpp ./src/TransformHierarchy.cpp ./src/Frustum.cpp ./src/JobSystem.cpp "+LIBRARIES,
+           "bench_spatial":"./bench/bench_spatial.cpp ./src/SpatialIndex.cpp ./src/Frustum.cpp ./src/JobSystem.cpp "+LIBRARIES,
+           "bench_commandlists":"./bench/bench_commandlists.cpp ./src/FileWatcher.cpp ./src/Texture.cpp ./src/Image.cpp ./src/Terrain.cpp ./src/Object.cpp ./src/Geometry.cpp ./src/VertexBufferLayout.cpp ./src/SceneNode.cpp ./src/RenderQueue.cpp ./src/CommandList.cpp ./src/TransformHierarchy.cpp ./src/Frustum.cpp ./src/JobSystem.cpp "+SHADER_SOURCE+" "+LIBRARIES,
+           "bench_entities":"./bench/bench_entities.cpp ./src/EntityStore.cpp ./src/FileWatcher.cpp ./src/Texture.cpp ./src/Image.cpp ./src/Terrain.cpp ./src/Object.cpp ./src/Geometry.cpp ./src/VertexBufferLayout.cpp ./src/SceneNode.cpp ./src/RenderQueue.cpp ./src/CommandList.cpp ./src/TransformHierarchy.cpp ./src/Frustum.cpp ./src/JobSystem.cpp "+SHADER_SOURCE+" "+LIBRARIES,
+           "bench_scenefile":"./bench/bench_scenefile.cpp ./src/SceneFile.cpp ./src/EntityStore.cpp ./src/FileWatcher.cpp ./src/Texture.cpp ./src/Image.cpp ./src/Terrain.cpp ./src/Object.cpp ./src/Geometry.cpp ./src/VertexBufferLayout.cpp ./src/SceneNode.cpp ./src/RenderQueue.cpp ./src/CommandList.cpp ./src/TransformHierarchy.cpp ./src/Frustum.cpp ./src/JobSystem.cpp "+SHADER_SOURCE+" "+LIBRARIES}
+    if platform.system()=="Linux":
+        TOOLS["bench_programcache"]="./bench/bench_programcache.cpp "+SHADER_SOURCE+" -lEGL "+LIBRARIES
+        TOOLS["bench_shadercompile"]="./bench/bench_shadercompile.cpp ./src/Image.cpp "+SHADER_SOURCE+" -lEGL "+LIBRARIES
+        TOOLS["bench_shadervariants"]="./bench/bench_shadervariants.cpp "+SHADER_SOURCE+" -lEGL "+LIBRARIES
+        TOOLS["bench_instancing"]="./bench/bench_instancing.cpp ./src/FileWatcher.cpp ./src/RenderQueue.cpp "+SHADER_SOURCE+" -lEGL "+LIBRARIES
+        TOOLS["bench_gpudriven"]="./bench/bench_gpudriven.cpp ./src/FileWatcher.cpp ./src/RenderQueue.cpp ./src/GPUScene.cpp ./src/TransformHierarchy.cpp ./src/Frustum.cpp ./src/JobSystem.cpp "+SHADER_SOURCE+" -lEGL "+LIBRARIES
+    for name, source in TOOLS.items():
+        toolString="g++ -O2 -std=c++20 "+ARGUMENTS+" "+source+" -o ./bin/"+name+" "+INCLUDE_DIR
+        print(toolString)
+        if os.system(toolString)!=0:
+            exit(1)
+    exit(0)
+
 # (3)====================== Building the Executable ========================== #
 # Build a string of our compile commands that we run in the terminal
 compileString=COMPILER+" "+ARGUMENTS+" "+SOURCE+" -o "+EXECUTABLE+" "+" "+INCLUDE_DIR+" "+LIBRARIES
@@ -0,0 +1,131 @@
+/** @file Archive.hpp
+ *  @brief A single file holding many assets (a '.pack').
+ *
+ *  Layout of a .pack file:
+ *
+ *      ArchiveHeader
+ *      entry data      every entry starts on a 64 byte boundary
+ *      directory       ArchiveEntry[slotCount], a hash table
+ *      names           the path of every entry, one after another
+ *
+ *  Entries are found by hashing their path (FNV-1a, 64 bit) into the
+ *  directory, which is an open addressing table -- so a lookup touches one
+ *  or two entries instead of searching a list of names. The archive is
+ *  memory mapped, so an entry that was stored uncompressed is read without
+ *  any copy at all. Compressed entries (see LZ.hpp) are unpacked into a
+ *  buffer the caller provides.
+ *
+ *  Paths are stored with '/' separators, relative to the folder the
+ *  archive was packed from (e.g. 'common/textures/brick.ppm').
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef ARCHIVE_HPP
+#define ARCHIVE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+
+#include "mappedfile.hpp"
+
+// Bump when the layout changes, old archives are then refused
+static constexpr uint32_t ARCHIVE_VERSION = 1;
+// Entry data alignment
+static constexpr uint64_t ARCHIVE_ALIGNMENT = 64;
+// ArchiveEntry::flags
+static constexpr uint32_t ARCHIVE_COMPRESSED = 1;
+// The most a compressed entry may unpack to. Bigger ones are taken to be
+// damage, rather than allocated.
+static constexpr uint64_t ARCHIVE_MAX_ENTRY_SIZE = 1ull << 30;
+
+struct ArchiveHeader{
+    char     magic[4];          // 'PACK'
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t slotCount;         // Directory size, a power of two
+    uint64_t directoryOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+    uint64_t fileSize;          // Catches archives that were cut short
+};
+
+struct ArchiveEntry{
+    uint64_t hash;              // 0 marks an empty slot
+    uint64_t offset;            // Where the data starts in the file
+    uint64_t storedSize;        // Bytes in the file
+    uint64_t size;              // Bytes once decompressed
+    uint32_t nameOffset;        // Into the names block
+    uint32_t nameLength;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ArchiveHeader) == 48, "ArchiveHeader is written to disk as is");
+static_assert(sizeof(ArchiveEntry) == 48, "ArchiveEntry is written to disk as is");
+
+// Hash of an archive path. Never 0, which marks an empty slot.
+uint64_t ArchiveHash(std::string_view path);
+
+// Reads a .pack file
+class Archive{
+public:
+    // Maps an archive. Returns false if it is missing or not a valid archive.
+    bool Open(const std::string& filename);
+    void Close();
+    bool IsOpen() const { return m_directory != nullptr; }
+
+    // Returns the entry for a path, or nullptr if it is not in the archive
+    const ArchiveEntry* Find(std::string_view path) const;
+    // The path an entry was stored under
+    std::string_view GetName(const ArchiveEntry& entry) const;
+
+    // Gets the contents of an entry. Stored entries point straight into the
+    // mapping (no copy); compressed entries are unpacked into 'storage'.
+    // Returns false if the data is corrupt.
+    bool Read(const ArchiveEntry& entry, std::vector<char>& storage,
+              const char*& data, std::size_t& size) const;
+
+    uint32_t GetEntryCount() const { return m_header.entryCount; }
+    uint32_t GetSlotCount() const { return m_header.slotCount; }
+    const ArchiveEntry* GetSlots() const { return m_directory; }
+    std::size_t GetFileSize() const { return m_file.Size(); }
+
+private:
+    MappedFile m_file;
+    ArchiveHeader m_header{};
+    const ArchiveEntry* m_directory{nullptr};
+};
+
+// Writes a .pack file one entry at a time, so only one file needs to be
+// in memory while packing.
+class ArchiveWriter{
+public:
+    // Starts a new archive. Returns false if the file cannot be created.
+    bool Begin(const std::string& filename);
+    // Adds an entry. With 'compress' the entry is compressed, but only kept
+    // that way if it saves a useful amount of space.
+    // Returns false if the path is already in the archive.
+    bool AddFile(const std::string& path, const char* data, std::size_t size, bool compress);
+    // Writes the directory and names. Returns false if writing failed.
+    bool Finish();
+
+    uint64_t GetTotalSize() const { return m_totalSize; }
+    uint64_t GetStoredSize() const { return m_storedSize; }
+
+private:
+    void Pad();
+
+    std::ofstream m_out;
+    uint64_t m_offset{0};
+    std::vector<ArchiveEntry> m_entries;
+    std::string m_names;
+    uint64_t m_totalSize{0};
+    uint64_t m_storedSize{0};
+};
+
+#endif
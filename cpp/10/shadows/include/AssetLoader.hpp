@@ -0,0 +1,64 @@
+/** @file AssetLoader.hpp
+ *  @brief Loads assets in the background while the program keeps rendering.
+ *
+ *  Asking for a model returns right away with an empty Model. Behind the
+ *  scenes the request becomes a small graph of jobs:
+ *
+ *      parse .obj + .mtl ----> load diffuse map 1 ---> upload texture 1 --\
+ *                         \--> load diffuse map 2 ---> upload texture 2 ---+--> upload mesh
+ *                          \-> ...                                        /
+ *
+ *  Parsing and image decoding run on the JobSystem's worker threads. The
+ *  OpenGL work goes on the UploadQueue, which the render thread drains a
+ *  few milliseconds at a time in Update(). The model draws as soon as it
+ *  IsReady(). Textures are shared through the TextureManager, so two
+ *  models using the same file only load it once.
+ *
+ *  When an .obj file is saved, its model goes through the same steps
+ *  again and the new buffers replace the old ones between two frames.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef ASSETLOADER_HPP
+#define ASSETLOADER_HPP
+
+#include <memory>
+#include <string>
+#include <atomic>
+#include <chrono>
+
+#include "Model.hpp"
+
+class AssetLoader{
+public:
+    static AssetLoader& Instance(){
+        static AssetLoader* instance = new AssetLoader();
+        return *instance;
+    }
+
+    // Start loading a model from an .obj file. Returns immediately,
+    // the model draws nothing until it IsReady().
+    std::shared_ptr<Model> LoadModelAsync(const std::string& filename);
+    // Call once per frame from the render thread. Runs queued uploads
+    // for at most 'budgetMilliseconds'.
+    void Update(double budgetMilliseconds);
+    // True while anything is still being loaded or uploaded
+    bool IsBusy() const;
+
+private:
+    // Builds the job graph that (re)loads 'model' from 'filename'.
+    // 'requested' is when the load was asked for, to log how long it took.
+    void StartLoad(std::shared_ptr<Model> model, const std::string& filename,
+                   std::chrono::steady_clock::time_point requested, bool reload);
+
+    // AssetLoader Constructor
+    AssetLoader() {}
+    // AssetLoader Destructor
+    ~AssetLoader() {}
+
+    // Models requested but not uploaded yet
+    std::atomic<unsigned int> m_loading{0};
+};
+
+#endif
@@ -0,0 +1,55 @@
+/** @file Bounds.hpp
+ *  @brief The box and the sphere around a mesh's vertices.
+ *
+ *  Worked out once, when a mesh is generated (see Geometry::Gen and
+ *  MeshMaker::Generate), in the mesh's own space. The TransformHierarchy
+ *  moves them into world space, where they are tested against the
+ *  camera's Frustum.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include "glm/vec3.hpp"
+#include "glm/geometric.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+struct Bounds{
+    // The axis aligned box. Empty (min > max) until a point is added.
+    glm::vec3 min{FLT_MAX};
+    glm::vec3 max{-FLT_MAX};
+    // The sphere is around the box's center, just big enough for every
+    // point (which is often smaller than the box's corners)
+    float radius{0.0f};
+
+    bool IsEmpty() const { return min.x > max.x; }
+    glm::vec3 Center() const { return (min+max)*0.5f; }
+    // Half the size of the box
+    glm::vec3 Extent() const { return (max-min)*0.5f; }
+
+    // The bounds of 'count' points, 'stride' floats apart (the first three
+    // being x, y and z)
+    static Bounds FromPoints(const float* points, unsigned int count, unsigned int stride){
+        Bounds bounds;
+        for(unsigned int i=0; i < count; ++i){
+            glm::vec3 point(points[i*stride+0], points[i*stride+1], points[i*stride+2]);
+            bounds.min = glm::min(bounds.min, point);
+            bounds.max = glm::max(bounds.max, point);
+        }
+        glm::vec3 center = bounds.Center();
+        float radius2 = 0.0f;
+        for(unsigned int i=0; i < count; ++i){
+            glm::vec3 offset = glm::vec3(points[i*stride+0], points[i*stride+1], points[i*stride+2])-center;
+            radius2 = std::max(radius2, glm::dot(offset, offset));
+        }
+        bounds.radius = std::sqrt(radius2);
+        return bounds;
+    }
+};
+
+#endif
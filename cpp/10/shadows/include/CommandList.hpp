@@ -0,0 +1,117 @@
+/** @file CommandList.hpp
+ *  @brief Draws recorded on any thread, and made later on the render
+ *         thread.
+ *
+ *  Walking the scene and deciding what to draw does not need OpenGL,
+ *  only making the draws does. A CommandList is a plain array of small
+ *  commands (bind a shader, a vertex array, a texture, an object's
+ *  uniform block range, then draw), so several threads can each record
+ *  their own part of the scene into their own list at once. The render
+ *  thread then replays the lists in order with a CommandPlayer, which is
+ *  the only one to call OpenGL.
+ *
+ *  The model matrix of each draw goes into the list's object data
+ *  instead of a uniform, as setting a uniform needs the GL context. The
+ *  player uploads every list's object data into one uniform buffer, and
+ *  binds each draw's part of it to the ObjectData block (see
+ *  shaders/common/instancing.glsl), so the shaders recorded must be built
+ *  with OBJECT_DATA.
+ *
+ *  A list only records a binding when it changes from the one before it.
+ *  The lists are not sorted, so objects draw in the order recorded
+ *  (transparent ones too). The RenderQueue sorts and instances, but is
+ *  filled by one thread.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef COMMANDLIST_HPP
+#define COMMANDLIST_HPP
+
+#include <glad/glad.h>
+
+#include "Shader.hpp"
+#include "UniformBuffer.hpp"
+
+#include "glm/mat4x4.hpp"
+
+#include <vector>
+#include <cstdint>
+
+// One command of a list (16 bytes)
+struct Command{
+    enum Type : uint32_t{
+        BIND_SHADER,        // shader
+        BIND_VERTEX_ARRAY,  // value: the vertex array
+        BIND_TEXTURE,       // value: the texture, on unit 0
+        SET_TRANSPARENT,    // value: 1 to blend and not write depth, 0 not to
+        BIND_OBJECT_DATA,   // value: the object's index in the list's object data
+        DRAW                // value: the index count of glDrawElements
+    };
+    Type type;
+    GLuint value;
+    Shader* shader;
+};
+
+class CommandList{
+public:
+    // Empties the list, for a new frame
+    void Reset();
+
+    void BindShader(Shader* shader);
+    void BindVertexArray(GLuint vertexArray);
+    void BindTexture(GLuint texture);
+    void SetTransparent(bool transparent);
+    // Adds an object's data, and binds its range for the draws after
+    void BindObjectData(const glm::mat4& model);
+    void DrawElements(GLsizei indexCount);
+
+    const std::vector<Command>& GetCommands() const { return m_commands; }
+    const std::vector<ObjectData>& GetObjectData() const { return m_objects; }
+    uint32_t GetDrawCount() const { return m_drawCount; }
+
+private:
+    std::vector<Command> m_commands;
+    std::vector<ObjectData> m_objects;
+    // What the commands so far leave bound. A list starts not knowing
+    // (the one replayed before it may have left anything bound).
+    static constexpr GLuint UNKNOWN = 0xFFFFFFFF;
+    Shader* m_shader{nullptr};
+    GLuint m_vertexArray{UNKNOWN};
+    GLuint m_texture{UNKNOWN};
+    bool m_transparent{false};
+    uint32_t m_drawCount{0};
+};
+
+class CommandPlayer{
+public:
+    CommandPlayer();
+    ~CommandPlayer();
+
+    // Uploads the lists' object data, and makes their commands, the lists
+    // in order. Must be called on the render thread, once the lists are
+    // recorded.
+    void Replay(const CommandList* lists, uint32_t count);
+    void Replay(const std::vector<CommandList>& lists){ Replay(lists.data(), lists.size()); }
+
+    // The draw calls the last Replay() made
+    uint32_t GetDrawCount() const { return m_drawCount; }
+
+private:
+    // Copies the lists' object data into the uniform buffer
+    void Upload(const CommandList* lists, uint32_t count);
+
+    GLuint m_buffer{0};
+    // The buffer's size, in objects
+    uint32_t m_capacity{0};
+    // Bytes from one object's range to the next: the object data, padded
+    // to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    GLsizeiptr m_stride{0};
+    // Where each list's object data starts in the buffer, in objects
+    std::vector<uint32_t> m_firstObject;
+    // The object data spaced out by m_stride, when that is not its size
+    std::vector<uint8_t> m_staging;
+    uint32_t m_drawCount{0};
+};
+
+#endif
@@ -0,0 +1,145 @@
+/** @file EntityStore.hpp
+ *  @brief Drawable things as entities: rows of flat component arrays,
+ *         drawn by looping over the arrays.
+ *
+ *  A SceneNode holds a shared_ptr to an Object, and is reached through
+ *  its parent's vector of pointers, so collecting a frame's draws hops
+ *  from node to node and object to object around the heap, and touches
+ *  the reference counts on the way. Here each component is one array:
+ *
+ *  - transform: the entity's node in the TransformHierarchy (its arrays
+ *    hold the matrices, and the world boxes that are culled)
+ *  - mesh: the vertex array and index count to draw
+ *  - material: the shaders (as a SceneNode builds them), the texture,
+ *    and whether it is transparent
+ *  - bounds: the mesh's, in its own space (also given to the hierarchy)
+ *
+ *  Index i of every array is the same entity, and the arrays have no
+ *  gaps: Destroy() moves the last entity into the hole. So Draw() and
+ *  Record() are one loop from the front to the back of the arrays, with
+ *  no virtual calls and no pointers followed but the shaders.
+ *
+ *  Entities are named by an Entity, which stays the same when others
+ *  are destroyed. The store only keeps the GL names of an Object's mesh
+ *  and texture, so the Object must outlive its entities.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef ENTITYSTORE_HPP
+#define ENTITYSTORE_HPP
+
+#include <glad/glad.h>
+
+#include "Object.hpp"
+#include "Bounds.hpp"
+#include "Shader.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "TransformHierarchy.hpp"
+#include "RenderQueue.hpp"
+#include "CommandList.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Names an entity in an EntityStore
+struct Entity{
+    uint32_t index{0xFFFFFFFF};
+    bool IsValid() const { return index != 0xFFFFFFFF; }
+    bool operator==(const Entity& other) const { return index == other.index; }
+};
+
+// What is drawn
+struct MeshComponent{
+    GLuint vertexArray{0};
+    GLsizei indexCount{0};
+
+    static MeshComponent FromObject(Object& object){
+        return MeshComponent{object.GetVertexArray(), object.GetIndexCount()};
+    }
+};
+
+// How it is drawn
+struct MaterialComponent{
+    Shader* shader{nullptr};
+    // The shader's index in the ShaderManager (for the RenderQueue's key)
+    uint32_t shaderIndex{0};
+    UniformHandle modelUniform;
+    // Built with INSTANCED (see RenderQueue.hpp) and OBJECT_DATA (see
+    // CommandList.hpp)
+    Shader* instancedShader{nullptr};
+    Shader* objectDataShader{nullptr};
+    // Bound to texture unit 0
+    GLuint texture{0};
+    bool transparent{false};
+
+    // The shaders built from 'vertShader' and 'fragShader' with 'defines',
+    // as a SceneNode gets them. The texture is left for the caller.
+    static MaterialComponent Load(const std::string& vertShader, const std::string& fragShader,
+                                  const ShaderDefines& defines = ShaderDefines());
+};
+
+class EntityStore{
+public:
+    explicit EntityStore(TransformHierarchy& transforms = TransformHierarchy::Instance());
+
+    // Adds an entity, with a new node in the hierarchy below 'parent' (or
+    // a root node)
+    Entity Create(const MeshComponent& mesh, const MaterialComponent& material, const Bounds& bounds,
+                  TransformHandle parent = TransformHandle());
+    // Adds many entities at once (e.g. loaded from a SceneFile), copying
+    // the arrays. Their nodes must exist, and already have the bounds.
+    // The new entities are consecutive: returns the first.
+    Entity Append(uint32_t count, const TransformHandle* transforms, const MeshComponent* meshes,
+                  const MaterialComponent* materials, const Bounds* bounds);
+    // Removes an entity. Its node is hidden (see TransformHierarchy::Hide),
+    // and is the next Create()'s, unless nodes are below it: those stay
+    // where they are relative to it, so it stays too.
+    void Destroy(Entity entity);
+    bool IsAlive(Entity entity) const { return entity.index < m_row.size() && m_row[entity.index] != NONE; }
+
+    // Its node, to move it with
+    TransformHandle GetTransform(Entity entity) const { return m_transform[m_row[entity.index]]; }
+    MeshComponent& GetMesh(Entity entity){ return m_mesh[m_row[entity.index]]; }
+    MaterialComponent& GetMaterial(Entity entity){ return m_material[m_row[entity.index]]; }
+    const Bounds& GetBounds(Entity entity) const { return m_bounds[m_row[entity.index]]; }
+    void SetBounds(Entity entity, const Bounds& bounds);
+
+    // Where the entities' nodes are
+    TransformHierarchy& GetTransformHierarchy() const { return m_transforms; }
+
+    // The component arrays, one row per entity (for systems to loop over)
+    uint32_t GetCount() const { return m_entity.size(); }
+    const std::vector<Entity>& GetEntities() const { return m_entity; }
+    const std::vector<TransformHandle>& GetTransforms() const { return m_transform; }
+    const std::vector<MeshComponent>& GetMeshes() const { return m_mesh; }
+    const std::vector<MaterialComponent>& GetMaterials() const { return m_material; }
+    const std::vector<Bounds>& GetBoundsArray() const { return m_bounds; }
+
+    // Adds the entities the last TransformHierarchy::Cull found in view to
+    // the queue, as SceneNode::Draw does. Returns how many.
+    uint32_t Draw(RenderQueue& queue) const;
+    // Records the rows [first, last) that are in view, as SceneNode::Record
+    // does. This only reads, so different ranges may be recorded on
+    // different threads at once.
+    void Record(CommandList& list, uint32_t first, uint32_t last) const;
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    TransformHierarchy& m_transforms;
+    // The components, one row per entity
+    std::vector<Entity> m_entity;
+    std::vector<TransformHandle> m_transform;
+    std::vector<MeshComponent> m_mesh;
+    std::vector<MaterialComponent> m_material;
+    std::vector<Bounds> m_bounds;
+    // Each entity's row (NONE once destroyed), and the entities and nodes
+    // to reuse
+    std::vector<uint32_t> m_row;
+    std::vector<uint32_t> m_free;
+    std::vector<TransformHandle> m_freeTransforms;
+};
+
+#endif
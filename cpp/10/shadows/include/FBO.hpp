@@ -1,6 +1,8 @@
 #ifndef FRAMEBUFFER_HPP
 #define FRAMEBUFFER_HPP
 
+#include "GLState.hpp"
+
 class FBO{
     public:
 
@@ -19,7 +21,7 @@ class FBO{
 
             // create depth texture
             glGenTextures(1, &m_textureID);
-            glBindTexture(GL_TEXTURE_2D, m_textureID);
+            GLState::Instance().BindTexture(0, m_textureID);
             glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -29,26 +31,25 @@ class FBO{
             float borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
             glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
             // attach depth texture as FBO's depth buffer
-            glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+            GLState::Instance().BindFramebuffer(m_fbo);
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_textureID, 0);
             glDrawBuffer(GL_NONE);
             glReadBuffer(GL_NONE);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            GLState::Instance().BindFramebuffer(0);
         }
 
         void BindTexture(int slot){
-            glActiveTexture(GL_TEXTURE0+slot);
-            glBindTexture(GL_TEXTURE_2D, m_textureID);
+            GLState::Instance().BindTexture(slot, m_textureID);
         }
 
         void Bind(){
 
-            glViewport(0, 0, m_width, m_height);
-            glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+            GLState::Instance().Viewport(0, 0, m_width, m_height);
+            GLState::Instance().BindFramebuffer(m_fbo);
         }
 
         void Unbind(){
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            GLState::Instance().BindFramebuffer(0);
         }
 
     private:
@@ -0,0 +1,73 @@
+/** @file FileWatcher.hpp
+ *  @brief Notices when files on disk change, so they can be reloaded.
+ *
+ *  On Linux the kernel tells us about changes (inotify), so checking costs
+ *  nothing until something actually changes. Elsewhere the modification
+ *  time of every watched file is checked twice a second.
+ *
+ *  Callbacks only ever run from Update(), which the render thread calls
+ *  between frames -- so a reload can swap OpenGL objects without a frame
+ *  ever seeing half of the old and half of the new.
+ *
+ *  Only loose files are watched. A file read from a mounted archive (see
+ *  VirtualFileSystem) keeps coming from the archive.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef FILEWATCHER_HPP
+#define FILEWATCHER_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <utility>
+#include <filesystem>
+#include <mutex>
+
+class FileWatcher{
+public:
+	static FileWatcher& Instance(){
+		static FileWatcher* instance = new FileWatcher();
+		return *instance;
+	}
+
+	// Run 'callback' whenever 'path' is written to (or replaced).
+	// Each owner has one callback per file: watching the same file again
+	// with the same owner replaces its callback, so it is safe to Watch
+	// again whenever the files something depends on may have changed.
+	// Safe to call from any thread.
+	void Watch(const std::string& path, const void* owner, std::function<void()> callback);
+	// Runs the callbacks of every file that changed since the last call.
+	// Call once per frame, from the render thread.
+	void Update();
+
+private:
+	// FileWatcher Constructor
+	FileWatcher();
+	// FileWatcher Destructor
+	~FileWatcher();
+
+	struct WatchedFile{
+		// With the owner each belongs to
+		std::vector<std::pair<const void*,std::function<void()>>> callbacks;
+		// Only used when polling
+		std::filesystem::file_time_type lastWrite;
+	};
+
+	// Files being watched, by absolute path
+	std::unordered_map<std::string,WatchedFile> m_files;
+	// inotify watches whole folders (editors often save by writing a new
+	// file and renaming it over the old one), so these map each folder
+	// to its watch and back
+	int m_inotify{-1};
+	std::unordered_map<std::string,int> m_folderWatches;
+	std::unordered_map<int,std::string> m_watchedFolders;
+	// When the modification times were last checked, if polling
+	double m_lastPoll{0.0};
+	// Watch may be called from worker threads
+	std::mutex m_mutex;
+};
+
+#endif
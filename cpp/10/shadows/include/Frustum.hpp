@@ -0,0 +1,63 @@
+/** @file Frustum.hpp
+ *  @brief The six planes of what a camera can see, to skip drawing what
+ *         is outside of them.
+ *
+ *  The planes come straight out of the projection times view matrix, so
+ *  they are in world space. A box is outside when it is fully behind any
+ *  one plane. (A box near a corner of the frustum can be behind none of
+ *  the planes and still not be seen. It is drawn, which is only a little
+ *  wasted work.)
+ *
+ *  Cull() tests many boxes at once, given as one array per component
+ *  (see TransformHierarchy). It tests 8 boxes per step with AVX, 4 with
+ *  SSE or NEON, and one at a time otherwise.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <cstdint>
+
+class Frustum{
+public:
+    // Sees everything
+    Frustum();
+    // The frustum of a camera, from projection * view
+    explicit Frustum(const glm::mat4& projectionView);
+
+    // A box, given by its center and half its size
+    bool IsVisible(const glm::vec3& center, const glm::vec3& extent) const;
+    // A sphere
+    bool IsVisible(const glm::vec3& center, float radius) const;
+
+    // Tests 'count' boxes, and sets visible[i] to 1 or 0 for each.
+    // Returns how many are visible.
+    uint32_t Cull(uint32_t count, const float* centerX, const float* centerY, const float* centerZ,
+                  const float* extentX, const float* extentY, const float* extentZ,
+                  uint8_t* visible) const;
+    // The same, one box at a time (to compare against)
+    uint32_t CullScalar(uint32_t count, const float* centerX, const float* centerY, const float* centerZ,
+                        const float* extentX, const float* extentY, const float* extentZ,
+                        uint8_t* visible) const;
+
+    // The box around the frustum's eight corners. Returns false if the
+    // planes do not close (e.g. the frustum that sees everything, or an
+    // infinite far plane).
+    bool GetBounds(glm::vec3& min, glm::vec3& max) const;
+
+    // The six planes (see below), e.g. to cull on the GPU
+    const glm::vec4* GetPlanes() const { return m_planes; }
+
+private:
+    // Left, right, bottom, top, near, far. (x,y,z) points inside, and is
+    // normalized, so w is the distance from the origin.
+    glm::vec4 m_planes[6];
+};
+
+#endif
@@ -0,0 +1,269 @@
+/** @file GLState.hpp
+ *  @brief Remembers what is bound and enabled in OpenGL, to skip calls
+ *         that would not change anything.
+ *
+ *  Every bind (program, vertex array, buffers, textures, framebuffer) and
+ *  every enable (the depth, blend and raster states) goes through here.
+ *  A call that asks for what is already set never reaches the driver,
+ *  which saves the driver's own checking and validation. So objects can
+ *  bind what they need before drawing without knowing what was drawn
+ *  before them.
+ *
+ *  Things to keep in mind:
+ *  - Anything that calls OpenGL itself must call Invalidate() after, or
+ *    the state here is out of date.
+ *  - Deleted objects must be forgotten (ForgetTexture etc.), as OpenGL
+ *    unbinds them and may hand their name out again.
+ *  - The element array buffer belongs to the vertex array, so it is
+ *    forgotten whenever a different vertex array is bound.
+ *
+ *  GetStats() counts the calls asked for and the calls made, for each kind
+ *  of state. SetFiltering(false) makes every call, to rule this class out
+ *  when something draws wrong.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef GLSTATE_HPP
+#define GLSTATE_HPP
+
+#include <glad/glad.h>
+
+#include <string>
+#include <cstdint>
+
+// glEnable/glDisable(GL_DEPTH_TEST), glDepthMask, glDepthFunc
+struct DepthState{
+    bool test{false};
+    bool write{true};
+    GLenum func{GL_LESS};
+};
+
+// glEnable/glDisable(GL_BLEND), glBlendFunc
+struct BlendState{
+    bool enabled{false};
+    GLenum source{GL_ONE};
+    GLenum destination{GL_ZERO};
+};
+
+// glPolygonMode, glEnable/glDisable(GL_CULL_FACE), glCullFace
+struct RasterState{
+    GLenum polygonMode{GL_FILL};
+    bool cull{false};
+    GLenum cullFace{GL_BACK};
+};
+
+class GLState{
+public:
+    static GLState& Instance(){
+        static GLState* instance = new GLState();
+        return *instance;
+    }
+
+    // The kinds of state, for the statistics
+    enum Kind{
+        PROGRAM, VERTEX_ARRAY, BUFFER, TEXTURE, FRAMEBUFFER,
+        VIEWPORT, CLEAR_COLOR, DEPTH, BLEND, RASTER, KIND_COUNT
+    };
+    struct Stats{
+        // GL calls that were asked for (what would have been made without
+        // this class), and those that were actually made
+        uint64_t requested[KIND_COUNT]{};
+        uint64_t issued[KIND_COUNT]{};
+        uint64_t Requested() const;
+        uint64_t Issued() const;
+    };
+
+    // glUseProgram
+    void UseProgram(GLuint program){
+        Count(PROGRAM, 1);
+        if(m_program != program || !m_filtering){
+            m_program = program;
+            Issue(PROGRAM, 1);
+            glUseProgram(program);
+        }
+    }
+
+    // glBindVertexArray
+    void BindVertexArray(GLuint vertexArray){
+        Count(VERTEX_ARRAY, 1);
+        if(m_vertexArray != vertexArray || !m_filtering){
+            m_vertexArray = vertexArray;
+            // Each vertex array has its own element buffer
+            m_buffers[ELEMENT_ARRAY] = UNKNOWN;
+            Issue(VERTEX_ARRAY, 1);
+            glBindVertexArray(vertexArray);
+        }
+    }
+
+    // glBindBuffer. GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER and
+    // GL_UNIFORM_BUFFER are remembered, other targets are always bound.
+    void BindBuffer(GLenum target, GLuint buffer){
+        Count(BUFFER, 1);
+        int slot = BufferSlot(target);
+        if(slot < 0 || m_buffers[slot] != buffer || !m_filtering){
+            if(slot >= 0){
+                m_buffers[slot] = buffer;
+            }
+            Issue(BUFFER, 1);
+            glBindBuffer(target, buffer);
+        }
+    }
+
+    // glBindBufferBase, which also binds 'buffer' to 'target' itself.
+    // The indexed binding points are not remembered (they are only set up
+    // once).
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer){
+        Count(BUFFER, 1);
+        Issue(BUFFER, 1);
+        int slot = BufferSlot(target);
+        if(slot >= 0){
+            m_buffers[slot] = buffer;
+        }
+        glBindBufferBase(target, index, buffer);
+    }
+
+    // glBindBufferRange, which like glBindBufferBase also binds 'buffer'
+    // to 'target'. Not remembered either, as it is used to move a binding
+    // point along a buffer, a different range each time.
+    void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size){
+        Count(BUFFER, 1);
+        Issue(BUFFER, 1);
+        int slot = BufferSlot(target);
+        if(slot >= 0){
+            m_buffers[slot] = buffer;
+        }
+        glBindBufferRange(target, index, buffer, offset, size);
+    }
+
+    // glActiveTexture and glBindTexture(GL_TEXTURE_2D). The active unit
+    // only changes when a texture actually has to be bound.
+    void BindTexture(GLuint unit, GLuint texture){
+        Count(TEXTURE, 2);
+        if(unit >= TEXTURE_UNITS){
+            Issue(TEXTURE, 2);
+            m_activeUnit = unit;
+            glActiveTexture(GL_TEXTURE0+unit);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            return;
+        }
+        if(m_textures[unit] != texture || !m_filtering){
+            if(m_activeUnit != unit || !m_filtering){
+                m_activeUnit = unit;
+                Issue(TEXTURE, 1);
+                glActiveTexture(GL_TEXTURE0+unit);
+            }
+            m_textures[unit] = texture;
+            Issue(TEXTURE, 1);
+            glBindTexture(GL_TEXTURE_2D, texture);
+        }
+    }
+
+    // glBindFramebuffer(GL_FRAMEBUFFER)
+    void BindFramebuffer(GLuint framebuffer){
+        Count(FRAMEBUFFER, 1);
+        if(m_framebuffer != framebuffer || !m_filtering){
+            m_framebuffer = framebuffer;
+            Issue(FRAMEBUFFER, 1);
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        }
+    }
+
+    // glViewport
+    void Viewport(GLint x, GLint y, GLsizei width, GLsizei height){
+        Count(VIEWPORT, 1);
+        if(!m_viewportKnown || m_viewport[0] != x || m_viewport[1] != y ||
+           m_viewport[2] != width || m_viewport[3] != height || !m_filtering){
+            m_viewportKnown = true;
+            m_viewport[0] = x;
+            m_viewport[1] = y;
+            m_viewport[2] = width;
+            m_viewport[3] = height;
+            Issue(VIEWPORT, 1);
+            glViewport(x, y, width, height);
+        }
+    }
+
+    // glClearColor
+    void ClearColor(float r, float g, float b, float a){
+        Count(CLEAR_COLOR, 1);
+        if(!m_clearColorKnown || m_clearColor[0] != r || m_clearColor[1] != g ||
+           m_clearColor[2] != b || m_clearColor[3] != a || !m_filtering){
+            m_clearColorKnown = true;
+            m_clearColor[0] = r;
+            m_clearColor[1] = g;
+            m_clearColor[2] = b;
+            m_clearColor[3] = a;
+            Issue(CLEAR_COLOR, 1);
+            glClearColor(r, g, b, a);
+        }
+    }
+
+    // Only the parts of a state that differ from the last one are set
+    void SetDepthState(const DepthState& state);
+    void SetBlendState(const BlendState& state);
+    void SetRasterState(const RasterState& state);
+
+    // Call when an object is deleted
+    void ForgetProgram(GLuint program);
+    void ForgetVertexArray(GLuint vertexArray);
+    void ForgetBuffer(GLuint buffer);
+    void ForgetTexture(GLuint texture);
+    void ForgetFramebuffer(GLuint framebuffer);
+    // Forgets everything, so the next call of each kind is made. Call after
+    // OpenGL was used without going through this class.
+    void Invalidate();
+
+    // When false, every call is made (but still counted)
+    void SetFiltering(bool filtering){ m_filtering = filtering; }
+    bool IsFiltering() const { return m_filtering; }
+
+    const Stats& GetStats() const { return m_stats; }
+    void ResetStats(){ m_stats = Stats(); }
+    // One line per kind of state: asked for, made, and skipped
+    std::string StatsToString() const;
+
+private:
+    GLState(){ Invalidate(); }
+    ~GLState() {}
+
+    // Nothing is known about it
+    static constexpr GLuint UNKNOWN = 0xFFFFFFFF;
+    static constexpr GLuint TEXTURE_UNITS = 32;
+    enum BufferSlots{ ARRAY, ELEMENT_ARRAY, UNIFORM, BUFFER_SLOTS };
+
+    static int BufferSlot(GLenum target){
+        switch(target){
+            case GL_ARRAY_BUFFER:         return ARRAY;
+            case GL_ELEMENT_ARRAY_BUFFER: return ELEMENT_ARRAY;
+            case GL_UNIFORM_BUFFER:       return UNIFORM;
+            default:                      return -1;
+        }
+    }
+    void Count(Kind kind, uint32_t calls){ m_stats.requested[kind] += calls; }
+    void Issue(Kind kind, uint32_t calls){ m_stats.issued[kind] += calls; }
+    // glEnable or glDisable
+    void SetCapability(Kind kind, GLenum capability, bool enabled);
+
+    bool m_filtering{true};
+    Stats m_stats;
+
+    GLuint m_program;
+    GLuint m_vertexArray;
+    GLuint m_buffers[BUFFER_SLOTS];
+    GLuint m_activeUnit;
+    GLuint m_textures[TEXTURE_UNITS];
+    GLuint m_framebuffer;
+    bool m_viewportKnown;
+    GLint m_viewport[4];
+    bool m_clearColorKnown;
+    float m_clearColor[4];
+    bool m_depthKnown;
+    DepthState m_depth;
+    bool m_blendKnown;
+    BlendState m_blend;
+    bool m_rasterKnown;
+    RasterState m_raster;
+};
+
+#endif
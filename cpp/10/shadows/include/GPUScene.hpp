@@ -0,0 +1,142 @@
+/** @file GPUScene.hpp
+ *  @brief Draws many objects with the culling done on the GPU, and the
+ *         draws made by the GPU too.
+ *
+ *  Each object is a mesh and a node of the TransformHierarchy. The
+ *  objects live in a shader storage buffer: their world matrix, and the
+ *  box around their mesh. Every frame a compute shader (shaders/cull.comp)
+ *  tests each object's box against the frustum. An object in view is
+ *  counted into its mesh's draw command, and its matrix is written out
+ *  to that mesh's part of the instance buffer. One
+ *  glMultiDrawElementsIndirect then draws every mesh, instanced. The CPU
+ *  never looks at the objects, whatever their number.
+ *
+ *  The draw commands are per mesh, so their number is known without
+ *  reading anything back. Each mesh has room for all of its objects in
+ *  the instance buffer, and its command's baseInstance points there. The
+ *  instanced shaders of the RenderQueue read the matrices (see
+ *  shaders/common/instancing.glsl).
+ *
+ *  Every mesh has the VERTEX3TN layout (as MeshMaker makes), and is
+ *  packed into one vertex and index buffer, so one vertex array draws
+ *  them all. Every object is drawn with the same shader and textures.
+ *
+ *  This needs OpenGL 4.3 (compute shaders and multi draw indirect), which
+ *  glad is not generated for: Enable() loads the functions, and says if
+ *  the driver has them. (macOS stops at 4.1, so there the objects must go
+ *  through the RenderQueue.)
+ *
+ *  The sample does not use it: its scene is a terrain with a shader of
+ *  its own, which the RenderQueue draws as well. bench_gpudriven uses it
+ *  on a scene large enough for it to pay.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef GPUSCENE_HPP
+#define GPUSCENE_HPP
+
+#include <glad/glad.h>
+
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+#include "Shader.hpp"
+#include "TransformHierarchy.hpp"
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
+
+#include <vector>
+#include <cstdint>
+
+class GPUScene{
+public:
+    // Loads the OpenGL 4.3 functions, with 'load' (as for
+    // gladLoadGLLoader). Returns false if the driver does not have them,
+    // in which case nothing else here may be used.
+    static bool Enable(GLADloadproc load);
+    static bool IsSupported();
+
+    GPUScene();
+    ~GPUScene();
+
+    // Adds a mesh, given as MeshMaker gives it: 8 floats per vertex
+    // (position, normal, texture coordinates), and triangles' indices.
+    // Returns its index.
+    uint32_t AddMesh(const float* vertices, uint32_t floatCount, const unsigned int* indices, uint32_t indexCount);
+    // Adds an object: 'mesh', placed by 'transform'
+    void AddObject(uint32_t mesh, TransformHandle transform);
+
+    // Makes the culling shader, and the buffers for the meshes and objects
+    // added so far (Update does this too, when something was added).
+    // Returns false if the culling shader did not build: then nothing is
+    // culled or drawn here, and the objects have to be culled on the CPU
+    // (e.g. drawn through the RenderQueue).
+    bool Build();
+    // Uploads the objects' world matrices, unless no node moved since the
+    // last upload. Call after TransformHierarchy::Update.
+    // Returns false if the scene could not be built (see Build).
+    bool Update(const TransformHierarchy& transforms);
+    // Starts the compute shader that culls the objects, and fills in the
+    // draw commands
+    void Cull(const Frustum& frustum);
+    // Draws the objects that are in view, with 'instancedShader' (built
+    // with INSTANCED)
+    void Draw(Shader& instancedShader);
+
+    // How many objects the last Cull found in view. This reads back from
+    // the GPU, so it waits for the culling to finish (for checking only).
+    uint32_t ReadVisibleCount();
+    uint32_t GetObjectCount() const { return m_objects.size(); }
+    uint32_t GetMeshCount() const { return m_meshes.size(); }
+
+private:
+    // One object, as cull.comp reads it (std430)
+    struct ObjectData{
+        glm::mat4 model;
+        // xyz: the center of the mesh's box, w: the mesh's index (its bits)
+        glm::vec4 center;
+        // xyz: half the size of the mesh's box
+        glm::vec4 extent;
+    };
+    // As glMultiDrawElementsIndirect reads it
+    struct DrawCommand{
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+    struct Mesh{
+        Bounds bounds;
+        GLuint firstIndex;
+        GLuint indexCount;
+        GLint baseVertex;
+        uint32_t objectCount;
+    };
+    std::vector<Mesh> m_meshes;
+    std::vector<float> m_vertices;
+    std::vector<unsigned int> m_indices;
+    std::vector<TransformHandle> m_transforms;
+    std::vector<ObjectData> m_objects;
+    // With instanceCount 0, copied over the commands before each Cull
+    std::vector<DrawCommand> m_commands;
+
+    GLuint m_vertexArray{0};
+    GLuint m_vertexBuffer{0};
+    GLuint m_indexBuffer{0};
+    GLuint m_objectBuffer{0};
+    GLuint m_commandBuffer{0};
+    GLuint m_instanceBuffer{0};
+    GLuint m_cullProgram{0};
+    GLint m_planesLocation{-1};
+    GLint m_objectCountLocation{-1};
+    // False when meshes or objects were added since Build()
+    bool m_built{false};
+    // True if cull.comp did not build (it is not tried again)
+    bool m_failed{false};
+    // False until the matrices have been uploaded once
+    bool m_uploaded{false};
+};
+
+#endif
@@ -12,11 +12,16 @@
 
 #include <vector>
 
+#include "Bounds.hpp"
+
 
 
 // Purpose of this class is to store vertice and triangle information
 class Geometry{
 public:
+	// Floats per vertex in the buffer data: position, normal, texture
+	// coordinates, tangent, bi-tangent
+	static constexpr unsigned int FLOATS_PER_VERTEX = 14;
 	// Constructor
 	Geometry();
 	// Destructor
@@ -34,7 +39,10 @@ public:
 	// you know which vertices are needed to make a triangle.
 	void AddIndex(unsigned int i);
     // Gen pushes all attributes into a single vector
+    // (and works out the bounds)
 	void Gen();
+	// The box and sphere around the vertices, as of Gen()
+	const Bounds& GetBounds() const;
 	// Functions for working with Indices
 	// Creates a triangle from 3 indices
 	// When a triangle is made, the tangents and bi-tangents are also
@@ -59,6 +67,8 @@ private:
 
 	// The indices for a indexed-triangle mesh
 	std::vector<unsigned int> m_indices;
+	// The box and sphere around the vertices
+	Bounds m_bounds;
 };
 
 
@@ -0,0 +1,85 @@
+/** @file JobSystem.hpp
+ *  @brief A pool of worker threads that run small jobs, with dependencies.
+ *
+ *  A job is a function plus the jobs it has to wait for. When the last of
+ *  its dependencies finishes, the job is handed to a worker thread. This
+ *  lets a piece of work (e.g. loading a model) be described as a small
+ *  graph of jobs that run on as many cores as there are.
+ *
+ *  Jobs must not use OpenGL -- the context belongs to the render thread.
+ *  Push that work to the UploadQueue instead.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef JOBSYSTEM_HPP
+#define JOBSYSTEM_HPP
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class Job;
+// Jobs are shared between whoever submitted them and the jobs waiting on them
+using JobHandle = std::shared_ptr<Job>;
+
+class Job{
+public:
+    // True once the function has finished running
+    bool IsDone() const { return m_done.load(std::memory_order_acquire); }
+private:
+    friend class JobSystem;
+    std::function<void()> m_function;
+    // Dependencies that have not finished yet (plus one while submitting)
+    std::atomic<int> m_waitingOn{1};
+    std::atomic<bool> m_done{false};
+    // Jobs that depend on this one. Guarded by JobSystem::m_mutex.
+    std::vector<JobHandle> m_dependents;
+};
+
+class JobSystem{
+public:
+    static JobSystem& Instance(){
+        static JobSystem* instance = new JobSystem();
+        return *instance;
+    }
+
+    // Run 'function' on a worker thread once every job in 'dependencies'
+    // has finished. Safe to call from any thread, including from a job.
+    JobHandle Submit(std::function<void()> function, const std::vector<JobHandle>& dependencies = {});
+    // Blocks until a job has finished. The calling thread helps run jobs
+    // while it waits, so this is safe to call from inside a job too.
+    void Wait(const JobHandle& job);
+    // Number of jobs submitted but not finished
+    unsigned int GetPendingCount() const { return m_pending.load(); }
+    // Number of worker threads
+    unsigned int GetWorkerCount() const { return m_workers.size(); }
+    // Finish the queued jobs and stop the worker threads
+    void Shutdown();
+
+private:
+    // JobSystem Constructor, starts one worker per core (less the render thread)
+    JobSystem();
+    // JobSystem Destructor
+    ~JobSystem();
+    // Body of each worker thread
+    void WorkerLoop();
+    // Runs a job, then releases the jobs that were waiting for it
+    void Execute(const JobHandle& job);
+    // Drops one dependency of a job, queueing it when none are left
+    void Release(const JobHandle& job);
+
+    std::vector<std::thread> m_workers;
+    std::deque<JobHandle> m_ready;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::atomic<unsigned int> m_pending{0};
+    bool m_quit{false};
+};
+
+#endif
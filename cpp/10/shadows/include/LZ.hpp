@@ -0,0 +1,35 @@
+/** @file LZ.hpp
+ *  @brief A small, fast LZ77 compressor (the LZ4 block format).
+ *
+ *  The compressed data is a list of sequences, each made of some literal
+ *  bytes followed by a match -- a copy of earlier output:
+ *
+ *      token (1 byte)       high 4 bits: literal count, low 4 bits: match length-4
+ *      [more literal count] if the count was 15, add bytes until one is not 255
+ *      literals
+ *      offset (2 bytes)     how far back the match starts (little endian)
+ *      [more match length]  if the length was 15, add bytes until one is not 255
+ *
+ *  The last sequence is literals only. Decompression is little more than
+ *  memcpy, which is why it is worth doing when loading assets: reading
+ *  fewer bytes from disk costs more than unpacking them.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef LZ_HPP
+#define LZ_HPP
+
+#include <vector>
+#include <cstddef>
+
+// Compress 'size' bytes of 'data'. Incompressible data comes out
+// slightly bigger than it went in.
+std::vector<char> LZCompress(const char* data, std::size_t size);
+
+// Decompress into 'out', which must be exactly 'decompressedSize' bytes.
+// Returns false (instead of reading or writing out of bounds) if the
+// data is corrupt.
+bool LZDecompress(const char* data, std::size_t size, char* out, std::size_t decompressedSize);
+
+#endif
@@ -7,6 +7,8 @@
 #include <memory>
 
 #include "Vertex.hpp"
+#include "GLState.hpp"
+#include "Bounds.hpp"
 
 #include <iostream>
 // The purpose of this class is to make it easy to
@@ -26,9 +28,12 @@ class MeshMaker{
         }
         ~MeshMaker(){
 			//de-allocate all resources once they've outlived their purpose:
+			GLState::Instance().ForgetVertexArray(m_VAOId);
+			GLState::Instance().ForgetBuffer(m_vertexPositionBuffer);
+			GLState::Instance().ForgetBuffer(m_indexBufferObject);
 			glDeleteVertexArrays(1, &m_VAOId);
 			glDeleteBuffers(1, &m_vertexPositionBuffer);
-			glDeleteBuffers(1, &m_vertexPositionBuffer);
+			glDeleteBuffers(1, &m_indexBufferObject);
         }
 
         // Create specific primitives
@@ -94,11 +99,9 @@ class MeshMaker{
             Generate();
         }
     
-        // Add a vertex to the mesh
-        //  Returns 1 if new vertex added
-        //  Returns index if the vertex has already been
-        //  added
-        int AddTriangle(std::shared_ptr<Vertex3TN> v1, std::shared_ptr<Vertex3TN> v2, std::shared_ptr<Vertex3TN> v3){
+        // Add a triangle to the mesh. Vertices that were
+        // already added are shared (by their index).
+        void AddTriangle(std::shared_ptr<Vertex3TN> v1, std::shared_ptr<Vertex3TN> v2, std::shared_ptr<Vertex3TN> v3){
             // Indices that will make up the triangle
             // We check if they already exist first,
             // Then we will add them.
@@ -242,13 +245,15 @@ class MeshMaker{
         // normals:  x,y,z
         void Generate(){
             m_stride = 8;          // TODO: Update based on layout 
+            // The box and sphere around the mesh, for culling
+            m_bounds = Bounds::FromPoints(m_vertices.data(), m_vertices.size()/m_stride, m_stride);
             // VertexArrays
             glGenVertexArrays(1, &m_VAOId);
-            glBindVertexArray(m_VAOId);
+            GLState::Instance().BindVertexArray(m_VAOId);
 
             // Vertex Buffer Object (VBO)
             glGenBuffers(1, &m_vertexPositionBuffer); // selecting the buffer is
-            glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+            GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
             glBufferData(GL_ARRAY_BUFFER, m_vertices.size()*sizeof(Vertex3TN), m_vertices.data(), GL_STATIC_DRAW);
 
             // Setup Vertex Buffer attributes
@@ -264,16 +269,20 @@ class MeshMaker{
             
             // Setup an index buffer (IBO)
             glGenBuffers(1, &m_indexBufferObject);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+            GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size()*sizeof(unsigned int), m_indices.data(),GL_STATIC_DRAW);
         }
 
+        // The bounds of the mesh, as of Generate()
+        const Bounds& GetBounds() const { return m_bounds; }
+        // The vertex array, for drawing through a RenderQueue
+        GLuint GetVertexArray() const { return m_VAOId; }
+
 		// Draw the mesh
 		void RenderMesh(){
-		//	glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);
-			glBindVertexArray(m_VAOId);
+			// (The polygon mode is part of the RasterState, see GLState)
+			GLState::Instance().BindVertexArray(m_VAOId);
 			glDrawElements(GL_TRIANGLES, m_indices.size(),GL_UNSIGNED_INT,(void*)0); 
-			glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
 		}
         
     private:
@@ -297,6 +306,8 @@ class MeshMaker{
         std::vector<float> m_vertices;
         // The indices for a indexed-triangle mesh
         std::vector<unsigned int> m_indices;
+        // The box and sphere around the vertices
+        Bounds m_bounds;
 };
 
 #endif
@@ -0,0 +1,66 @@
+/** @file Model.hpp
+ *  @brief Loads a Wavefront .obj (and its .mtl materials) onto the GPU.
+ *
+ *  The whole model lives in one vertex buffer and one index buffer.
+ *  The mesh loader sorts triangles by material, so drawing the model
+ *  is one glDrawElements per material, and a texture is only bound
+ *  when it differs from the previous material's.
+ *
+ *  A Model can also be filled in later (see AssetLoader), in which case
+ *  it draws nothing until IsReady().
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef MODEL_HPP
+#define MODEL_HPP
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "mesh.hpp"
+#include "Texture.hpp"
+
+class Model{
+public:
+    // An empty model, to be filled in by Upload
+    Model();
+    // Load a model from an .obj file
+    Model(std::string filename);
+    // Release the buffers on the GPU
+    ~Model();
+    // Create the buffers on the GPU from a mesh that has already been
+    // loaded, with the diffuse map of each of its materials.
+    // Uploading again replaces the buffers (used for reloading).
+    void Upload(const Mesh& mesh, const std::vector<std::shared_ptr<Texture>>& materialDiffuseMaps);
+    // True once the buffers and all of the textures are on the GPU
+    bool IsReady() const;
+    // Draw every material of the model.
+    // Diffuse maps are bound to texture slot 0.
+    void RenderMesh();
+    // Number of glDrawElements calls RenderMesh makes
+    unsigned int GetDrawCount() const { return m_subsets.size(); }
+    // Axis-aligned bounding box in model space
+    const float* GetBoundsMin() const { return m_boundsMin; }
+    const float* GetBoundsMax() const { return m_boundsMax; }
+
+private:
+    // Vertex Array Object
+    GLuint m_VAOId{0};
+    // Vertex Buffer
+    GLuint m_vertexBuffer{0};
+    // Index Buffer Object
+    GLuint m_indexBufferObject{0};
+    // One draw per material
+    std::vector<MeshSubset> m_subsets;
+    // The diffuse map of each subset (nullptr if it has none)
+    std::vector<std::shared_ptr<Texture>> m_diffuseMaps;
+    // Bounds of the model
+    float m_boundsMin[3]{0.0f,0.0f,0.0f};
+    float m_boundsMax[3]{0.0f,0.0f,0.0f};
+};
+
+#endif
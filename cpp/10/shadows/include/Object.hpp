@@ -42,6 +42,17 @@ public:
     virtual void Render();
 	// Helper method for when we are ready to draw or update our object
 	void Bind();
+	// The bounds of the object's geometry, in its own space
+	const Bounds& GetBounds() const;
+	// What the RenderQueue needs to draw the object like Render() does
+	GLuint GetVertexArray() const { return m_vertexBufferLayout.GetVertexArray(); }
+	GLuint GetDiffuseTexture() const { return m_textureDiffuse.GetID(); }
+	GLsizei GetIndexCount() { return m_geometry.GetIndicesSize(); }
+	// The vertices and triangles (e.g. to use as an occluder)
+	Geometry& GetGeometry() { return m_geometry; }
+	// Transparent objects are blended, and drawn after the opaque ones
+	void SetTransparent(bool transparent){ m_transparent = transparent; }
+	bool IsTransparent() const { return m_transparent; }
 protected: // Classes that inherit from Object are intended to be overridden.
 
     // For now we have one buffer per object.
@@ -52,6 +63,8 @@ protected: // Classes that inherit from Object are intended to be overridden.
     Texture m_detailMap; // NOTE: Note yet supported
     // Store the objects Geometry
 	Geometry m_geometry;
+	// Drawn with blending (see RenderQueue)
+	bool m_transparent{false};
 };
 
 #endif
@@ -0,0 +1,138 @@
+/** @file OcclusionCuller.hpp
+ *  @brief Skips drawing what is hidden behind walls, found by drawing the
+ *         walls on the CPU.
+ *
+ *  The frustum only says what is in front of the camera. Inside a house,
+ *  most of that is behind a wall. A few big meshes are picked as
+ *  occluders (walls, floors, buildings), and every frame Rasterize()
+ *  draws their triangles into a small depth buffer (WIDTH x HEIGHT) on
+ *  the CPU, keeping the nearest depth at each pixel. Then each box the
+ *  frustum let through is projected onto the screen: if every pixel under
+ *  it has an occluder nearer than the box's nearest corner, the box is
+ *  hidden.
+ *
+ *  Rasterizing: the screen is split into tiles, and each triangle is
+ *  binned into the tiles it overlaps. The tiles are drawn as jobs on the
+ *  JobSystem, with no locks, as no two of them write the same pixels.
+ *  Within a tile, a triangle's three edge functions and its depth are
+ *  worked out for 4 pixels of a row per step (with SSE or NEON; one at a
+ *  time otherwise). Triangles are clipped against the near plane, and
+ *  drawn whichever way they face.
+ *
+ *  Testing: next to the depth buffer are its mips, each pixel holding the
+ *  farthest depth of the four below it. A box is tested at the level
+ *  where it covers at most 2x2 pixels, so each test reads 4 values
+ *  whatever its size.
+ *
+ *  Depths are z/w of the clip space position, which is linear across a
+ *  triangle on the screen. Occluders are drawn conservatively: a pixel is
+ *  only written when the triangle covers all of it, with the triangle's
+ *  farthest depth in it. So an object is never hidden by an occluder it
+ *  can be seen past, though occluders (and their shared edges) hide a
+ *  little less than they would at full size.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef OCCLUSIONCULLER_HPP
+#define OCCLUSIONCULLER_HPP
+
+#include "TransformHierarchy.hpp"
+
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <vector>
+#include <cstdint>
+
+class OcclusionCuller{
+public:
+    // The size of the depth buffer, and of its tiles
+    static constexpr uint32_t WIDTH = 256;
+    static constexpr uint32_t HEIGHT = 128;
+    static constexpr uint32_t TILE_WIDTH = 64;
+    static constexpr uint32_t TILE_HEIGHT = 32;
+
+    OcclusionCuller();
+
+    // Adds an occluder: the triangles of a mesh, whose vertex positions
+    // are 'stride' floats apart, placed by 'transform'. The positions are
+    // copied. Returns its index.
+    uint32_t AddOccluder(const float* vertices, uint32_t vertexCount, uint32_t stride,
+                         const unsigned int* indices, uint32_t indexCount, TransformHandle transform);
+    void ClearOccluders();
+    uint32_t GetOccluderCount() const { return m_occluders.size(); }
+
+    // Draws the occluders, as seen through 'projectionView', into the
+    // depth buffer, and builds its mips. Occluders the last
+    // TransformHierarchy::Cull found out of view are skipped.
+    void Rasterize(const glm::mat4& projectionView, const TransformHierarchy& transforms);
+
+    // Whether a box (its center, and half its size) may be seen, as of
+    // the last Rasterize()
+    bool IsVisible(const glm::vec3& center, const glm::vec3& extent) const;
+    // Tests the boxes whose visible[i] is 1, and sets it to 0 for those
+    // that are hidden. Returns how many are still visible.
+    uint32_t Cull(uint32_t count, const float* centerX, const float* centerY, const float* centerZ,
+                  const float* extentX, const float* extentY, const float* extentZ,
+                  uint8_t* visible) const;
+    // The same, for the nodes TransformHierarchy::Cull found in view
+    uint32_t Cull(TransformHierarchy& transforms) const;
+
+    // When false, Rasterize() draws the tiles one after the other on the
+    // calling thread (to compare against)
+    void SetParallel(bool parallel){ m_parallel = parallel; }
+    // Triangles the last Rasterize() drew (after clipping)
+    uint32_t GetTriangleCount() const { return m_triangles.size(); }
+    // The depth buffer, WIDTH x HEIGHT, bottom row first (e.g. to look at)
+    const float* GetDepth() const { return m_mips[0].data(); }
+
+private:
+    // Clips a triangle against the near plane, and adds what is left
+    void AddTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+    // Sets up a triangle that is in front of the near plane, and bins it
+    void SetupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+    // Draws the triangles binned into one tile
+    void RasterizeTile(uint32_t tile);
+    // Works out the mips from the depth buffer
+    void BuildMips();
+
+    struct Occluder{
+        uint32_t firstVertex;
+        uint32_t vertexCount;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        TransformHandle transform;
+    };
+    std::vector<Occluder> m_occluders;
+    std::vector<glm::vec3> m_vertices;
+    std::vector<uint32_t> m_indices;
+    // An occluder's vertices in clip space, while it is being drawn
+    std::vector<glm::vec4> m_clip;
+
+    // A triangle on the screen. A pixel (x,y) is inside when every edge's
+    // a*x + b*y + c is at least 0, and its depth there is
+    // depth.x*x + depth.y*y + depth.z.
+    struct Triangle{
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        glm::vec3 depth;
+        // The pixels it may cover, inclusive
+        int minX, minY, maxX, maxY;
+    };
+    std::vector<Triangle> m_triangles;
+    // The triangles overlapping each tile
+    std::vector<std::vector<uint32_t>> m_bins;
+
+    // Level 0 is the depth buffer, each level after it half the size
+    std::vector<std::vector<float>> m_mips;
+    std::vector<uint32_t> m_mipWidth;
+    std::vector<uint32_t> m_mipHeight;
+
+    glm::mat4 m_projectionView{1.0f};
+    bool m_parallel{true};
+};
+
+#endif
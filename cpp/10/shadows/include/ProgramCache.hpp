@@ -0,0 +1,75 @@
+/** @file ProgramCache.hpp
+ *  @brief Saves linked shader programs to the disk, to skip compiling
+ *         them the next time the program starts.
+ *
+ *  Compiling and linking GLSL is one of the slowest parts of starting up.
+ *  After a program links, the driver can give us the finished program as
+ *  a blob (glGetProgramBinary), which we store in a file named after a
+ *  hash of the shader sources and of the driver's name and version. On
+ *  the next launch the same sources load the blob back (glProgramBinary)
+ *  instead of being compiled.
+ *
+ *  A blob only works on the driver that made it. If the driver was
+ *  updated, or rejects the blob for any other reason, the file is removed
+ *  and the shaders are compiled as usual (and stored again).
+ *
+ *  Program binaries are part of OpenGL 4.1 (or ARB_get_program_binary),
+ *  so the functions are loaded separately from glad's 3.3 ones. Without
+ *  them the cache stays off.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef PROGRAMCACHE_HPP
+#define PROGRAMCACHE_HPP
+
+#include <glad/glad.h>
+
+#include <string>
+#include <cstdint>
+
+class ProgramCache{
+public:
+    static ProgramCache& Instance(){
+        static ProgramCache* instance = new ProgramCache();
+        return *instance;
+    }
+
+    // Turns the cache on, keeping the programs in 'directory' (created if
+    // needed). Needs a current OpenGL context; 'load' finds the OpenGL
+    // functions, as for gladLoadGLLoader.
+    // Returns false if the driver cannot save programs.
+    bool Enable(const std::string& directory, GLADloadproc load);
+    bool IsEnabled() const;
+    // Returns the linked program built from these sources before, or 0
+    // if it is not in the cache (then build it, and Store it).
+    GLuint Load(const std::string& vertexSource, const std::string& fragmentSource);
+    // Call on a new program before linking it, so that it can be stored
+    void PrepareToLink(GLuint program);
+    // Saves a program that linked
+    void Store(const std::string& vertexSource, const std::string& fragmentSource, GLuint program);
+
+private:
+    ProgramCache() {}
+    ~ProgramCache() {}
+
+    // The file a program with these sources is stored in
+    std::string GetPath(const std::string& vertexSource, const std::string& fragmentSource) const;
+
+    bool m_enabled{false};
+    std::string m_directory;
+    // Hash of the driver's vendor, renderer and version
+    uint64_t m_driverHash{0};
+
+    // From OpenGL 4.1
+    typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length,
+                                                  GLenum* binaryFormat, void* binary);
+    typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat,
+                                               const void* binary, GLsizei length);
+    typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+    GetProgramBinaryProc m_getProgramBinary{nullptr};
+    ProgramBinaryProc m_programBinary{nullptr};
+    ProgramParameteriProc m_programParameteri{nullptr};
+};
+
+#endif
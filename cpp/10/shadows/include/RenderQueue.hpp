@@ -0,0 +1,132 @@
+/** @file RenderQueue.hpp
+ *  @brief Collects a frame's draws, and makes them in an order that
+ *         changes as little OpenGL state as possible.
+ *
+ *  The scene graph adds one DrawItem per visible object. Each item gets a
+ *  64 bit sort key, and Sort() radix sorts the keys, so that Submit()
+ *  draws:
+ *  - the opaque items first, grouped by shader, then texture, then vertex
+ *    array, and front to back within a group (so the depth test throws
+ *    away more of the hidden pixels)
+ *  - then the transparent items, back to front (so they blend over what
+ *    is behind them), whatever state that costs.
+ *
+ *  The key, from the most significant bit down:
+ *
+ *    opaque:      pass:2 | shader:10 | texture:16 | vertex array:12 | depth:24
+ *    transparent: pass:2 | far to near:24 | shader:10 | texture:16 | vertex array:12
+ *
+ *  The ids are cut down to fit their bits. Two ids that end up the same
+ *  are only grouped less well; the items still draw with their own.
+ *
+ *  Opaque items that end up next to each other with the same mesh (vertex
+ *  array and index count), texture and shader are drawn together, with
+ *  one glDrawElementsInstanced, if the item has an instanced version of
+ *  its shader. Their model matrices are packed into an instance buffer,
+ *  uploaded once per frame, which the instanced shader reads as a mat4
+ *  attribute (see shaders/common/instancing.glsl).
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef RENDERQUEUE_HPP
+#define RENDERQUEUE_HPP
+
+#include <glad/glad.h>
+
+#include "Shader.hpp"
+
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <vector>
+#include <cstdint>
+
+// Everything needed to draw one object
+struct DrawItem{
+    Shader* shader{nullptr};
+    // The index of the shader in the ShaderManager (small, so it fits in
+    // the key)
+    uint32_t shaderIndex{0};
+    // Where the model matrix goes, and the matrix. The matrix must stay
+    // where it is until Submit() (the TransformHierarchy's do).
+    UniformHandle modelUniform;
+    const glm::mat4* model{nullptr};
+    GLuint vertexArray{0};
+    // Bound to texture unit 0
+    GLuint texture{0};
+    GLsizei indexCount{0};
+    bool transparent{false};
+    // The shader built with INSTANCED, which reads the model matrix from
+    // the instance buffer. Without one, the item is always drawn alone.
+    Shader* instancedShader{nullptr};
+};
+
+// Where instanced shaders read the model matrix from (a mat4 takes this
+// location and the three after it). Must match common/instancing.glsl.
+static constexpr GLuint INSTANCE_MODEL_LOCATION = 8;
+
+class RenderQueue{
+public:
+    enum Pass{ OPAQUE_PASS = 0, TRANSPARENT_PASS = 1 };
+
+    RenderQueue();
+    ~RenderQueue();
+
+    // Empties the queue for a new frame, seen through 'view'
+    void Begin(const glm::mat4& view);
+    // Adds an item, whose center (for sorting by depth) is at 'center'
+    void Add(const DrawItem& item, const glm::vec3& center);
+    // Orders the items by their keys
+    void Sort();
+    // Draws the items, in order
+    void Submit();
+
+    // The key of an item 'depth' in front of the camera
+    static uint64_t MakeKey(const DrawItem& item, float depth);
+
+    // When false, Sort() does nothing, so Submit() draws in the order the
+    // items were added (to compare against)
+    void SetSorting(bool sorting){ m_sorting = sorting; }
+    // When false, every item is drawn on its own (to compare against)
+    void SetInstancing(bool instancing){ m_instancing = instancing; }
+    uint32_t GetCount() const { return m_items.size(); }
+    // The draw calls the last Submit() made, and how many of those were
+    // instanced
+    uint32_t GetDrawCount() const { return m_drawCount; }
+    uint32_t GetInstancedDrawCount() const { return m_batches.size(); }
+
+private:
+    std::vector<DrawItem> m_items;
+    // The key of each item, with the item's index
+    struct Entry{
+        uint64_t key;
+        uint32_t item;
+    };
+    std::vector<Entry> m_entries;
+    // Where the radix sort puts each pass's result
+    std::vector<Entry> m_scratch;
+    // The row of the view matrix that gives the depth
+    glm::vec4 m_depthRow;
+    bool m_sorting{true};
+
+    // Finds the items that can be drawn instanced, and uploads their
+    // matrices
+    void BuildBatches();
+    // Items drawn with one instanced draw: the entries from 'first' on,
+    // whose matrices start at 'firstInstance' in the instance buffer
+    struct Batch{
+        uint32_t first;
+        uint32_t count;
+        uint32_t firstInstance;
+    };
+    std::vector<Batch> m_batches;
+    std::vector<glm::mat4> m_instances;
+    GLuint m_instanceBuffer{0};
+    // The instance buffer's size, in matrices
+    uint32_t m_instanceCapacity{0};
+    bool m_instancing{true};
+    uint32_t m_drawCount{0};
+};
+
+#endif
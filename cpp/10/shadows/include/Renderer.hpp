@@ -26,6 +26,10 @@
 #include "SceneNode.hpp"
 #include "Camera.hpp"
 #include "Framebuffer.hpp"
+#include "RenderQueue.hpp"
+#include "CommandList.hpp"
+#include "OcclusionCuller.hpp"
+#include "EntityStore.hpp"
 
 
 class Renderer{
@@ -35,7 +39,8 @@ public:
     Renderer(unsigned int w, unsigned int h);
     // Destructor
     ~Renderer();
-    // Update the scene
+    // Update the scene: works out where every node is, and which of them
+    // the camera sees
     void Update();
     // Render the scene
     void Render();
@@ -50,21 +55,64 @@ public:
         return m_cameras[index];
     }
 
+    // The camera's projection, for culling. (The shaders get theirs from
+    // the FrameData uniform buffer, so the two should match.)
+    void SetProjection(const glm::mat4& projection){ m_projection = projection; }
+    // How many nodes the last Update() found out of view, and how long
+    // finding them took
+    unsigned int GetCulledCount() const { return m_culled; }
+    double GetCullMilliseconds() const { return m_cullMs; }
+    // Makes a node's object an occluder: what it hides is not drawn.
+    // (The sample adds none: its only object is the terrain, which hides
+    //  nothing but itself, and is too many triangles to draw on the CPU
+    //  every frame. Scenes with walls and buildings should add those.)
+    void AddOccluder(SceneNode& node);
+    // How many nodes in view the last Update() found hidden behind the
+    // occluders, and how long drawing them and testing took
+    unsigned int GetOccludedCount() const { return m_occluded; }
+    double GetOcclusionMilliseconds() const { return m_occlusionMs; }
+    // When true, Render() records the scene into command lists, the root's
+    // children split between the JobSystem's threads, and replays them.
+    // Otherwise the scene goes through the RenderQueue (sorted and
+    // instanced, but on this thread alone).
+    void SetParallelRecording(bool parallel){ m_parallelRecording = parallel; }
+    // How long the last Render() took to record the command lists
+    double GetRecordMilliseconds() const { return m_recordMs; }
+    // Entities are drawn along with the scene graph, in the same passes
+    EntityStore& GetEntities(){ return m_entities; }
+
 // TODO: maybe write getter/setter methods
 protected:
     // Root scene node
     std::shared_ptr<SceneNode> m_root;
     // One or more cameras camera per Renderer
     std::vector<Camera*> m_cameras;
-    // Store the projection matrix for our camera.
-    glm::mat4 m_projectionMatrix;
     // A renderer can have any number of framebuffers
     std::vector<Framebuffer*> m_framebuffers;
+    // The scene's draws, collected each frame
+    RenderQueue m_queue;
+    // Or, recorded in parallel: the root, then one list per part of the
+    // scene
+    std::vector<CommandList> m_commandLists;
+    CommandPlayer m_commandPlayer;
+    // Drawn after the scene graph
+    EntityStore m_entities;
 
 private:
     // Screen dimension constants
     int m_screenWidth;
     int m_screenHeight;
+    glm::mat4 m_projection;
+    unsigned int m_culled{0};
+    double m_cullMs{0.0};
+    // Culls what the occluders hide (when there are any)
+    OcclusionCuller m_occlusion;
+    unsigned int m_occluded{0};
+    double m_occlusionMs{0.0};
+    bool m_parallelRecording{false};
+    double m_recordMs{0.0};
+    // Records the scene into m_commandLists
+    void RecordParallel();
 };
 
 #endif
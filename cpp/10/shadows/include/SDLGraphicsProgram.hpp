@@ -55,6 +55,8 @@ private:
     // Window width and height
     unsigned int m_width;
     unsigned int m_height;
+    // When the program started (SDL performance counter)
+    Uint64 m_startTime;
 
 };
 
@@ -0,0 +1,146 @@
+/** @file SceneFile.hpp
+ *  @brief Saves a whole scene to one binary file, and loads it back with
+ *         a few array copies.
+ *
+ *  A scene is the entities of an EntityStore, the nodes of its
+ *  TransformHierarchy that place them, and the lights. The file holds them as the
+ *  hierarchy and the store keep them in memory: one array per field,
+ *  the nodes in depth first order. Loading maps the file (see
+ *  MappedFile), and copies each array onto the back of the hierarchy's
+ *  and the store's. Nothing is parsed, and nothing is allocated per node.
+ *
+ *  What the entities draw is named, not stored: a mesh by a name, a
+ *  texture by its path, a material by its shader files and defines, and
+ *  the texture it uses. The file has a table of each, which the entities
+ *  refer to by index. When loading, each mesh and texture is made (or
+ *  found) once, by functions the caller gives, and each material's
+ *  shaders are built (or found) by MaterialComponent::Load.
+ *
+ *  Layout on disk (as in memory, so little endian on the machines we
+ *  build for; every section 16 byte aligned):
+ *
+ *      SceneFileHeader
+ *      node parents        uint32 [nodeCount], a place in the nodes or NO_PARENT
+ *      node positions      vec3 [nodeCount]
+ *      node rotations      quat [nodeCount]
+ *      node scales         vec3 [nodeCount]
+ *      node bounds         vec3 centers [nodeCount], vec3 extents [nodeCount]
+ *      entity nodes        uint32 [entityCount]
+ *      entity meshes       uint32 [entityCount], into the mesh table
+ *      entity materials    uint32 [entityCount], into the material table
+ *      entity bounds       Bounds [entityCount]
+ *      mesh table          uint32 [meshCount], names in the strings
+ *      texture table       uint32 [textureCount], paths in the strings
+ *      material table      SceneFileMaterial [materialCount]
+ *      strings             0 terminated, one after the other
+ *      lights              LightData
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef SCENEFILE_HPP
+#define SCENEFILE_HPP
+
+#include <glad/glad.h>
+
+#include "EntityStore.hpp"
+#include "TransformHierarchy.hpp"
+#include "UniformBuffer.hpp"
+#include "mappedfile.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+
+constexpr char     SCENEFILE_MAGIC[4] = {'S','C','N','E'};
+constexpr uint32_t SCENEFILE_VERSION  = 1;
+// A material without a texture
+constexpr uint32_t SCENEFILE_NO_TEXTURE = 0xFFFFFFFF;
+
+struct SceneFileMaterial{
+    uint32_t vertexShader;      // Offsets into the strings
+    uint32_t fragmentShader;
+    uint32_t defines;           // As ShaderDefines::GetKey gives them
+    uint32_t texture;           // Into the texture table
+    uint32_t transparent;
+    uint32_t reserved[3];
+};
+
+struct SceneFileHeader{
+    char     magic[4];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t entityCount;
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint32_t materialCount;
+    uint32_t stringBytes;
+    uint64_t parentOffset;      // All offsets are in bytes from the start of the file
+    uint64_t positionOffset;
+    uint64_t rotationOffset;
+    uint64_t scaleOffset;
+    uint64_t boundsCenterOffset;
+    uint64_t boundsExtentOffset;
+    uint64_t entityNodeOffset;
+    uint64_t entityMeshOffset;
+    uint64_t entityMaterialOffset;
+    uint64_t entityBoundsOffset;
+    uint64_t meshOffset;
+    uint64_t textureOffset;
+    uint64_t materialOffset;
+    uint64_t stringOffset;
+    uint64_t lightOffset;
+    uint64_t fileSize;
+};
+
+// The names of what the entities draw, which the EntityStore only knows
+// by their GL names: each mesh by its vertex array, and each texture
+struct SceneFileNames{
+    std::unordered_map<GLuint, std::string> meshes;
+    std::unordered_map<GLuint, std::string> textures;
+};
+
+// Makes (or finds) a mesh or texture by the name it was saved with.
+// Called once for each in the file, not for each entity.
+struct SceneFileAssets{
+    std::function<MeshComponent(const std::string& name)> mesh;
+    std::function<GLuint(const std::string& path)> texture;
+};
+
+// Writes every entity of 'entities', the nodes of its hierarchy that
+// place them (theirs and their ancestors, but not e.g. a SceneNode's),
+// and 'lights'. Returns false if an entity's mesh or texture has no name,
+// or the file could not be written.
+bool WriteSceneFile(const std::string& filename, const EntityStore& entities, const LightData& lights,
+                    const SceneFileNames& names);
+
+// Read-only access to a scene file. The pointers point straight into the
+// mapped file, and stay valid for the lifetime of the SceneFile.
+class SceneFile{
+public:
+    SceneFile();
+    // Maps and checks a scene file. Returns false on failure.
+    bool Open(const std::string& filename);
+
+    const SceneFileHeader& GetHeader() const { return *m_header; }
+    // The nodes, as TransformHierarchy::Append takes them
+    TransformHierarchy::NodeArrays GetNodes() const;
+    const LightData& GetLights() const { return *At<LightData>(m_header->lightOffset); }
+
+    // Adds the nodes to the hierarchy of 'entities' (the roots as roots),
+    // and the entities to it, with their meshes, textures and materials
+    // made by 'assets', and copies the lights into 'lights'. Returns the
+    // first new entity.
+    Entity Instantiate(EntityStore& entities, LightData& lights, const SceneFileAssets& assets) const;
+
+private:
+    template<typename T>
+    const T* At(uint64_t offset) const { return reinterpret_cast<const T*>(m_file.Data() + offset); }
+    const char* String(uint32_t offset) const { return At<char>(m_header->stringOffset) + offset; }
+
+    MappedFile m_file;
+    const SceneFileHeader* m_header{nullptr};
+};
+
+#endif
@@ -15,9 +15,13 @@
 #include <memory>
 
 #include "Object.hpp"
-#include "Transform.hpp"
+#include "TransformHierarchy.hpp"
 #include "Camera.hpp"
 #include "Shader.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "ShaderManager.hpp"
+#include "RenderQueue.hpp"
+#include "CommandList.hpp"
 
 #include "glm/vec3.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -28,7 +32,9 @@ public:
     // a pointer to an object.
     // For now, we also specify the shader paths as well (TODO: Implement a shader manager here
     //                                                          instead for a cleaner code..
-    SceneNode(std::shared_ptr<Object> ob, std::string vertShader, std::string fragShader);
+    // The shader is built with 'defines' (see ShaderPreprocessor.hpp)
+    SceneNode(std::shared_ptr<Object> ob, std::string vertShader, std::string fragShader,
+              const ShaderDefines& defines = ShaderDefines());
     // Our destructor takes care of destroying
     // all of the children within the node.
     // Now we do not have to manage deleting
@@ -36,17 +42,32 @@ public:
     ~SceneNode();
     // Adds a child node to our current node.
     void AddChild(SceneNode* n);
-    // Draws the current SceneNode
-    void Draw();
-    // Updates the current SceneNode
-    void Update(glm::mat4 projectionMatrix, Camera* camera);
-    // Returns the local transformation transform
-    // Remember that local is local to an object, where it's center is the origin.
-    Transform& GetLocalTransform();
-    // Returns a SceneNode's world transform
-    Transform& GetWorldTransform();
-    // For now we have one shader per Node.
-    std::shared_ptr<Shader> m_shader; 
+    // Adds the current SceneNode (if it is in view) and its children to
+    // the queue, which draws them (see Renderer::Render)
+    void Draw(RenderQueue& queue);
+    // Records the current SceneNode (if it is in view), and its children
+    // unless 'children' is false, into a command list. This only reads,
+    // so different parts of the scene may be recorded on different
+    // threads at once (see Renderer::Render).
+    void Record(CommandList& list, bool children = true) const;
+    // The object drawn at this node (may be null)
+    std::shared_ptr<Object> GetObject() const { return m_object; }
+    // The nodes below this one
+    const std::vector<SceneNode*>& GetChildren() const { return m_children; }
+    // Updates the current SceneNode.
+    void Update();
+    // Returns the node's transform in the TransformHierarchy. Its position,
+    // rotation and scale are local (relative to the parent node), and
+    // its world matrix is worked out by TransformHierarchy::Update.
+    TransformHandle GetTransform() const;
+    // For now we have one shader per Node. The handle identifies it in the
+    // ShaderManager, and the pointer is kept to save looking it up.
+    ShaderHandle m_shaderHandle;
+    Shader* m_shader{nullptr};
+    // The same shader built with INSTANCED (see RenderQueue.hpp)
+    Shader* m_instancedShader{nullptr};
+    // And built with OBJECT_DATA (see CommandList.hpp)
+    Shader* m_objectDataShader{nullptr};
     
     // NOTE: Protected members are accessible by anything
     // that we inherit from, as well as ?
@@ -60,10 +81,11 @@ private:
     std::vector<SceneNode*> m_children;
     // The object stored in the scene graph
     std::shared_ptr<Object> m_object;
-    // Each SceneNode nodes locals transform.
-    Transform m_localTransform;
-    // We additionally can store the world transform
-    Transform m_worldTransform;
+    // Each SceneNode's transform, kept with every other node's in the
+    // TransformHierarchy
+    TransformHandle m_transform;
+    // The uniform set for each draw, looked up once when the shader is created
+    UniformHandle m_model;
 };
 
 #endif
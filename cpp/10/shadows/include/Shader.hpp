@@ -10,6 +10,10 @@
 #define SHADER_HPP
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstdint>
 
 #if defined(LINUX) || defined(MINGW)
     #include <SDL2/SDL.h>
@@ -23,6 +27,25 @@
 // TODO: This is a free function for now, as well as a member function
 std::string LoadShaderAsString(const std::string& fname);
 
+// FNV-1a hash of a uniform's name. It is constexpr, so a name written in
+// the code (e.g. UniformHash("model")) is hashed by the compiler.
+constexpr uint64_t UniformHash(std::string_view name){
+    uint64_t hash = 14695981039346656037ull;
+    for(char c : name){
+        hash ^= (uint8_t)c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Refers to one uniform of one Shader (see Shader::GetUniform).
+// Setting a uniform through a handle is an array lookup and one GL call.
+// Handles stay valid when the shader is rebuilt (e.g. hot reloaded).
+struct UniformHandle{
+    uint32_t index{0xFFFFFFFF};
+    bool IsValid() const { return index != 0xFFFFFFFF; }
+};
+
 class Shader{
 public:
     // Shader constructor
@@ -30,24 +53,65 @@ public:
     // Shader Destructor
     ~Shader();
     // Use this shader in our pipeline.
-    void Bind() const;
+    // If the program is still being built, this waits for it.
+    void Bind();
     // Remove shader from our pipeline
     void Unbind() const;
     // Load a shader
     std::string LoadShaderAsString(const std::string& fname);
-    // Create a Shader from a loaded vertex and fragment shader
-    void CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+    // Create a Shader from a loaded vertex and fragment shader.
+    // If this shader already has a working program (i.e. it is being
+    // reloaded), the new program only replaces it if it linked, so a typo
+    // in a shader being edited does not break the running program.
+    // Returns false if the shaders did not compile or link.
+    bool CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+    // Starts building a program like CreateShader, without waiting for the
+    // driver to compile and link it. The shader can be used straight away
+    // (handles, SetUniform1i): the first Bind waits for the program if it is
+    // not built yet, so start early and bind late.
+    void BeginCreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+    // Waits for the program BeginCreateShader started, and starts using it.
+    // Returns false if the shaders did not compile or link.
+    bool FinishCreateShader();
+    // True if binding the shader will not wait for the driver.
+    // Without KHR_parallel_shader_compile the driver cannot tell us, so
+    // this is always true.
+    bool IsReady();
+    // Lets the driver compile and link on its own threads, if it supports
+    // KHR_parallel_shader_compile. Needs a current OpenGL context; 'load'
+    // finds the OpenGL functions, as for gladLoadGLLoader.
+    static bool EnableParallelCompile(GLADloadproc load);
     // return the shader id
     GLuint GetID() const;
+    // Get a handle to a uniform, to set it without looking it up by name.
+    // Get handles once (e.g. when setting up) and keep them.
+    // A uniform that is not in the shader (or that the compiler removed as
+    // unused) still gets a handle, setting it just does nothing.
+    UniformHandle GetUniform(std::string_view name);
+    UniformHandle GetUniform(uint64_t nameHash);
     // Set our uniforms for our shader.
+    void SetUniformMatrix4fv(UniformHandle uniform, const GLfloat* value);
+	void SetUniform3f(UniformHandle uniform, float v0, float v1, float v2);
+    void SetUniform1i(UniformHandle uniform, int value);
+    void SetUniform1f(UniformHandle uniform, float value);
+    // Set our uniforms by name. Slower than using a handle, as the name is
+    // hashed and searched for each time (but no OpenGL call is needed).
     void SetUniformMatrix4fv(const GLchar* name, const GLfloat* value);
 	void SetUniform3f(const GLchar* name, float v0, float v1, float v2);
     void SetUniform1i(const GLchar* name, int value);
     void SetUniform1f(const GLchar* name, float value);
+    // Sets the texture slot a sampler reads. This needs no Bind: if the
+    // program is still being built it only remembers the slot, and sets
+    // it once the program is, so setting up does not wait for the driver.
+    void SetSampler(const GLchar* name, int slot);
+    // Location of a uniform by name, -1 if the shader does not have it
+    GLint GetUniformLocation(std::string_view name) const;
 
 private:
-    // Compiles loaded shaders
+    // Compiles loaded shaders (without waiting for the result)
     unsigned int CompileShader(unsigned int type, const std::string& source);
+    // Makes sure a shader compiled, logging the errors if it did not
+    bool CheckCompileStatus(GLuint shaderID, GLenum type);
     // Makes sure shaders 'linked' successfully
     bool CheckLinkStatus(GLuint programID);
     // Shader loading utility programs
@@ -55,8 +119,46 @@ private:
     void PrintShaderLog( GLuint shader );
     // Logs an error message 
     void Log(const char* system, const char* message);
+    // Finds every active uniform of the linked program
+    void Reflect();
+    // Checks a uniform is in the shader, and (in debug builds) that it is
+    // being set with the type the shader declares
+    bool CheckType(UniformHandle uniform, GLenum type);
+    // Keeps a value given to SetUniform1i, to set again on a rebuilt program
+    void RememberInt(UniformHandle uniform, int value);
     // The unique shaderID
-    GLuint m_shaderID;
+    GLuint m_shaderID{0};
+
+    // A program BeginCreateShader started, which is not finished yet
+    GLuint m_pendingProgram{0};
+    GLuint m_pendingVertexShader{0};
+    GLuint m_pendingFragmentShader{0};
+    // True if it came from the ProgramCache (so it is already linked)
+    bool m_pendingCached{false};
+    // Its sources, to store it in the ProgramCache once it links
+    std::string m_pendingVertexSource;
+    std::string m_pendingFragmentSource;
+    // Whether the driver builds programs on its own threads
+    static bool s_parallelCompile;
+
+    // Every active uniform, sorted by the hash of its name.
+    // Array elements have their own entries ("lights[1]"), and the first
+    // element can also be found without the index ("lights").
+    struct UniformInfo{
+        uint64_t hash;
+        GLint location;
+        GLenum type;
+        std::string name;
+    };
+    std::vector<UniformInfo> m_uniforms;
+    // What each handle refers to. The locations are kept in their own
+    // array, as that is all setting a uniform needs.
+    std::vector<GLint> m_handleLocations;
+    std::vector<uint64_t> m_handleHashes;
+    std::vector<GLenum> m_handleTypes;
+    // Values given to SetUniform1i (by handle index), set again on a
+    // rebuilt program
+    std::vector<std::pair<uint32_t,int>> m_intValues;
 };
 
 #endif
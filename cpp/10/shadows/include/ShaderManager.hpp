@@ -2,8 +2,19 @@
  *  @brief This Singleton class manages all of the shaders that have been created
  *
  *  The shader manager handles all of the shaders that have been loaded.
- *  
+ *  New shaders are built in the background where the driver allows it
+ *  (see Shader::BeginCreateShader), so create them early and use them
+ *  late. Shaders are rebuilt when their files (or the files they #include)
+ *  are saved (see FileWatcher).
  *
+ *  A shader can be built in variants, with different #defines (see
+ *  ShaderPreprocessor.hpp). Each variant is built once, and variants that
+ *  come out the same share one program.
+ *
+ *  Creating a shader gives back a ShaderHandle, an index into an array of
+ *  the shaders, which is what the per frame code should use: looking a
+ *  shader up by it costs no string hashing, or shared_ptr copies. Looking
+ *  up by name (FindShader) is still there for tools and debugging.
  *
  *  @author Mike
  *  @bug No known bugs.
@@ -14,8 +25,25 @@
 #include <unordered_map>
 #include <memory>
 #include <iostream> // remove this later on
+#include <chrono>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
 
 #include "Shader.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "FileWatcher.hpp"
+
+// Identifies a shader in the ShaderManager. Stays the same for as long as
+// the program runs (also when the shader is reloaded).
+struct ShaderHandle{
+	uint32_t index{0xFFFFFFFF};
+	bool IsValid() const { return index != 0xFFFFFFFF; }
+	bool operator==(const ShaderHandle& other) const { return index == other.index; }
+};
 
 class ShaderManager{
 public:
@@ -24,49 +52,150 @@ public:
 		return *instance;
 	}
 
-	// Create a new shader using a vertex Shader and a Fragment shader
-	void CreateNewShader(std::string name, 
-						std::string vertexShaderFilePath, 
-						std::string fragmentShaderFilePath){
-		// create a new shader to add to our shader manager
-		std::shared_ptr<Shader> s = std::make_shared<Shader>();
-		std::string vertexShaderProgramString 	= s->LoadShaderAsString(vertexShaderFilePath);
-		std::string fragmentShaderProgramString = s->LoadShaderAsString(fragmentShaderFilePath);
-		// Create the shader from the vertex and fragment shader
-		// strings that have been loaded
-		s->CreateShader( vertexShaderProgramString,
-						fragmentShaderProgramString);
-
-		// Now add our shader to a 'map' structure so that we can later look 
-		// up the shader program by its name.
-		m_shaders[name] = s;
-	}
-
-	// Retrieve an existing shader object
-	std::shared_ptr<Shader> GetShader(std::string name){
-			if(m_shaders.contains(name)){
-				return m_shaders[name];
-			}else{
-				std::cout << "Error, unable to GetShader: " << name << std::endl;
-				// TODO: Either throw an exception, or perhaps we can
-				// 		 be friendly in a debug build and print out all of the
-				// 		 shaders that exist.
-				return nullptr;
+	// Create a new shader using a vertex Shader and a Fragment shader,
+	// built with 'defines' (see ShaderPreprocessor.hpp).
+	// This does not wait for it to compile: the shader is returned straight
+	// away, and waits for the driver the first time it is bound.
+	ShaderHandle CreateNewShader(const std::string& name,
+						const std::string& vertexShaderFilePath,
+						const std::string& fragmentShaderFilePath,
+						const ShaderDefines& defines = ShaderDefines()){
+		ShaderFiles files{name, vertexShaderFilePath, fragmentShaderFilePath, defines};
+		Preprocess(files);
+		return AddShader(std::move(files));
+	}
+
+	// Returns the shader built from these two files, creating it the first
+	// time. Everything drawn with the same files shares one program.
+	ShaderHandle GetShaderFromFiles(const std::string& vertexShaderFilePath,
+									const std::string& fragmentShaderFilePath){
+		return GetShaderVariant(vertexShaderFilePath, fragmentShaderFilePath, ShaderDefines());
+	}
+
+	// Returns the variant of a shader built with 'defines', creating it the
+	// first time it is asked for. If it comes out the same as a shader that
+	// was already built from the same files, that one is shared.
+	ShaderHandle GetShaderVariant(const std::string& vertexShaderFilePath,
+								  const std::string& fragmentShaderFilePath,
+								  const ShaderDefines& defines){
+		std::string name = vertexShaderFilePath + "+" + fragmentShaderFilePath;
+		if(!defines.values.empty()){
+			name += "?" + defines.GetKey();
+		}
+		auto found = m_handles.find(name);
+		if(found != m_handles.end()){
+			return found->second;
+		}
+		ShaderFiles files{name, vertexShaderFilePath, fragmentShaderFilePath, defines};
+		Preprocess(files);
+		ShaderHandle sameSource = FindSameSource(files);
+		if(sameSource.IsValid()){
+			m_handles[name] = sameSource;
+			return sameSource;
+		}
+		return AddShader(std::move(files));
+	}
+
+	// True while any shader is still being built by the driver
+	bool IsBusy(){
+		for(const std::shared_ptr<Shader>& s : m_shaders){
+			if(!s->IsReady()){
+				return true;
 			}
+		}
+		return false;
 	}
 
-	// Looks up a previously created shader to use.
-	void UseShader(std::string name){
-			if(m_shaders.contains(name)){
-					m_shaders[name]->Bind();
-			}else{
-				std::cout << "Error, unable to Use Shader: " << name << std::endl;
-				// TODO: Either throw an exception, or perhaps we can
-				// 		 be friendly in a debug build and print out all of the
-				// 		 shaders that exist.
+	// Compile and link a shader again from its files. The shader keeps its
+	// old program if the new one does not build.
+	void ReloadShader(ShaderHandle handle){
+		if(!IsValid(handle)){
+			std::cout << "Error, unable to ReloadShader: " << handle.index << std::endl;
+			return;
+		}
+		auto start = std::chrono::steady_clock::now();
+		ShaderFiles& files = m_files[handle.index];
+		ShaderFiles reloaded{files.name, files.vertex, files.fragment, files.defines};
+		Preprocess(reloaded);
+		// Files it #includes now may not have been watched yet (even if
+		// it did not build, as the fix may go in one of them)
+		WatchFiles(handle, reloaded.read);
+		bool linked = m_shaders[handle.index]->CreateShader(reloaded.vertexSource, reloaded.fragmentSource);
+		if(linked){
+			// File it under its new source
+			auto [first, last] = m_shadersBySource.equal_range(files.hash);
+			for(auto it = first; it != last; ++it){
+				if(it->second == handle){
+					m_shadersBySource.erase(it);
+					break;
+				}
 			}
+			files = std::move(reloaded);
+			m_shadersBySource.emplace(files.hash, handle);
+		}
+		double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+		if(linked){
+			std::cout << "ShaderManager: reloaded " << files.name << " in " << ms << " ms" << std::endl;
+		}else{
+			std::cout << "ShaderManager: " << files.name << " did not build, still using the old version" << std::endl;
+		}
+	}
+	void ReloadShader(std::string_view name){
+		ReloadShader(FindShader(name));
 	}
 
+	// Retrieve an existing shader object. No hashing, or reference
+	// counting: this is an array index. The shader lives as long as the
+	// ShaderManager, so the pointer may be kept.
+	Shader* GetShader(ShaderHandle handle){
+		return IsValid(handle) ? m_shaders[handle.index].get() : nullptr;
+	}
+
+	// Binds a previously created shader to use.
+	void UseShader(ShaderHandle handle){
+		if(IsValid(handle)){
+			m_shaders[handle.index]->Bind();
+		}else{
+			std::cout << "Error, unable to Use Shader: " << handle.index << std::endl;
+		}
+	}
+
+	// Finds a shader by the name it was created with, for tools and
+	// debugging. Returns an invalid handle if there is none.
+	ShaderHandle FindShader(std::string_view name){
+		++m_nameLookups;
+		auto found = m_handles.find(name);
+		if(found == m_handles.end()){
+			std::cout << "Error, unable to FindShader: " << name << std::endl;
+			// TODO: Either throw an exception, or perhaps we can
+			// 		 be friendly in a debug build and print out all of the
+			// 		 shaders that exist.
+			return ShaderHandle();
+		}
+		return found->second;
+	}
+
+	// The name a shader was created with
+	const std::string& GetShaderName(ShaderHandle handle){
+		static const std::string none = "";
+		return IsValid(handle) ? m_files[handle.index].name : none;
+	}
+
+	// The files and defines a shader was built from (e.g. to save what a
+	// material uses, and build it again later)
+	void GetShaderFiles(ShaderHandle handle, std::string& vertex, std::string& fragment, ShaderDefines& defines) const{
+		const ShaderFiles& files = m_files[handle.index];
+		vertex = files.vertex;
+		fragment = files.fragment;
+		defines = files.defines;
+	}
+
+	// How many shaders were built (variants that are shared count once)
+	uint32_t GetShaderCount() const { return (uint32_t)m_shaders.size(); }
+
+	// How many times a shader was looked up by name, to catch name lookups
+	// that have crept back into the per frame code
+	uint64_t GetNameLookups() const { return m_nameLookups; }
 
       
 private:
@@ -75,8 +204,92 @@ private:
     // ShaderManager Destructor
     ~ShaderManager() {}
 
-	// Holds all of the shader programs
-	std::unordered_map<std::string,std::shared_ptr<Shader>> m_shaders;
+	bool IsValid(ShaderHandle handle) const { return handle.index < m_shaders.size(); }
+
+	// Holds all of the shader programs, indexed by ShaderHandle
+	std::vector<std::shared_ptr<Shader>> m_shaders;
+	// The name, vertex and fragment shader files of each shader (in the
+	// same order), for reloading, and what they were last built from
+	struct ShaderFiles{
+		std::string name;
+		std::string vertex;
+		std::string fragment;
+		ShaderDefines defines;
+		// The preprocessed sources, and every file read for them
+		std::string vertexSource;
+		std::string fragmentSource;
+		std::vector<std::string> read;
+		uint64_t hash{0};
+	};
+	std::vector<ShaderFiles> m_files;
+	// Shaders by name. More than one name can share a shader. The hash
+	// takes a string_view, so looking up a "literal" makes no std::string.
+	struct NameHash{
+		using is_transparent = void;
+		std::size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+	};
+	std::unordered_map<std::string,ShaderHandle,NameHash,std::equal_to<>> m_handles;
+	uint64_t m_nameLookups{0};
+	// Shaders by the hash of their (preprocessed) sources, to share them
+	// between variants that come out the same
+	std::unordered_multimap<uint64_t,ShaderHandle> m_shadersBySource;
+
+	// Reads and preprocesses a shader's files, filling in its sources
+	static void Preprocess(ShaderFiles& files){
+		std::vector<std::string> fragmentFiles;
+		files.vertexSource = PreprocessShader(files.vertex, files.defines, &files.read);
+		files.fragmentSource = PreprocessShader(files.fragment, files.defines, &fragmentFiles);
+		for(const std::string& file : fragmentFiles){
+			if(std::find(files.read.begin(), files.read.end(), file) == files.read.end()){
+				files.read.push_back(file);
+			}
+		}
+		files.hash = UniformHash(files.vertexSource) ^ (UniformHash(files.fragmentSource) * 1099511628211ull);
+	}
+
+	// A shader built from the same sources, read from the same files, or an
+	// invalid handle. (As the defines are part of the source, the two were
+	// built with the same defines too, so reloading either one's files
+	// gives the same program.)
+	ShaderHandle FindSameSource(const ShaderFiles& files) const{
+		auto [first, last] = m_shadersBySource.equal_range(files.hash);
+		for(auto it = first; it != last; ++it){
+			const ShaderFiles& other = m_files[it->second.index];
+			if(other.vertexSource == files.vertexSource && other.fragmentSource == files.fragmentSource &&
+			   other.read == files.read){
+				return it->second;
+			}
+		}
+		return ShaderHandle();
+	}
+
+	// Starts building a shader from its preprocessed sources, and adds it
+	ShaderHandle AddShader(ShaderFiles files){
+		// This does not wait for the driver: the shader waits for its
+		// program the first time it is bound
+		std::shared_ptr<Shader> s = std::make_shared<Shader>();
+		s->BeginCreateShader(files.vertexSource, files.fragmentSource);
+
+		// Now add our shader to the array, and remember its name so that
+		// we can later look it up by name too.
+		ShaderHandle handle{(uint32_t)m_shaders.size()};
+		m_shaders.push_back(s);
+		m_handles[files.name] = handle;
+		m_shadersBySource.emplace(files.hash, handle);
+
+		m_files.push_back(std::move(files));
+		WatchFiles(handle, m_files.back().read);
+		return handle;
+	}
+
+	// Rebuild the shader whenever any of its files is saved. Each shader
+	// watches a file once, however often this is called.
+	void WatchFiles(ShaderHandle handle, const std::vector<std::string>& files){
+		for(const std::string& file : files){
+			FileWatcher::Instance().Watch(file, m_shaders[handle.index].get(), [this,handle](){ ReloadShader(handle); });
+		}
+	}
+
 	// Convenience variable to store the active shader.
 	static std::string s_activeShaderName;
 };
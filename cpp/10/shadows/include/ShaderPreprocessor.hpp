@@ -0,0 +1,50 @@
+/** @file ShaderPreprocessor.hpp
+ *  @brief Puts a shader's source together before it is compiled.
+ *
+ *  GLSL has no #include, and the only way to give a shader a compile time
+ *  constant is to write it in the source. So before a shader is compiled:
+ *
+ *  - '#include "file"' lines are replaced with that file (found relative
+ *    to the file including it). Each file is only pasted in once.
+ *  - '#define NAME VALUE' lines for the variant being built are put right
+ *    after '#version'.
+ *
+ *  A shader can then be built in variants, e.g. for a number of lights,
+ *  where each variant's loops have a constant length the compiler can
+ *  unroll (see ShaderManager::GetShaderVariant).
+ *
+ *  '#line' directives are added, so the compiler's errors give the line
+ *  in the original file. The number before the line is the index of the
+ *  file in the list PreprocessShader returns (0 is the shader itself).
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef SHADERPREPROCESSOR_HPP
+#define SHADERPREPROCESSOR_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+
+// The #defines one variant of a shader is built with
+struct ShaderDefines{
+    // Sets NAME to VALUE, replacing a value it already had
+    ShaderDefines& Set(const std::string& name, const std::string& value);
+    ShaderDefines& Set(const std::string& name, int value);
+    // Identifies the set: "NAME=VALUE;..." in order of name, so the same
+    // defines give the same key whatever order they were set in
+    std::string GetKey() const;
+
+    // Sorted by name
+    std::vector<std::pair<std::string,std::string>> values;
+};
+
+// Reads a shader (from the disk, or a mounted archive), and pastes in its
+// #includes and the defines. Returns "" if the shader is missing.
+// 'files' (if given) is filled with every file that was read, starting
+// with the shader itself, e.g. to watch them for changes.
+std::string PreprocessShader(const std::string& path, const ShaderDefines& defines,
+                             std::vector<std::string>* files = nullptr);
+
+#endif
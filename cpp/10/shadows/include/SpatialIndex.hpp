@@ -0,0 +1,192 @@
+/** @file SpatialIndex.hpp
+ *  @brief Finds the objects near a point, along a ray or in a frustum
+ *         without looking at every object.
+ *
+ *  Two ways of doing it, with the same functions:
+ *
+ *  LooseOctree - a cube split into eight, each of those into eight, and
+ *  so on. Each cell is 'loose': it holds objects whose center is in it,
+ *  and reaches half a cell further than its children on every side, so
+ *  an object that is at most half a cell wide is always inside its cell.
+ *  The level an object goes to only depends on its size, and the cell on
+ *  its center, so inserting and moving go straight to the cell, without
+ *  searching. Good when objects have very different sizes.
+ *
+ *  HashGrid - cells all of one size, found by their coordinates in a
+ *  hash table, each holding the objects whose center is in it (and
+ *  their boxes, so a query reads a cell's objects in a row). Only the
+ *  cells that hold something exist, so the world has no bounds. Objects
+ *  may reach out of their cell, so the queries look that much further
+ *  (by the largest object so far). A frustum query looks up the cells
+ *  in the box around the frustum, unless fewer cells exist than that.
+ *  Good when the objects are about the cell's size.
+ *
+ *  Objects are boxes (a center, and half the size). Inserting, moving
+ *  and removing one take the same time however many there are, except
+ *  when a cell has to be made: a moved object that stays in its cell is
+ *  only written. MoveMany() moves many at once: it works out their new
+ *  cells as jobs on the JobSystem, then moves those that changed cell.
+ *
+ *  The queries fill a vector with the objects whose box the frustum,
+ *  sphere or ray touches, in no particular order. A HashGrid's queries
+ *  mark the cells they visit, so only one of them may run at a time.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef SPATIALINDEX_HPP
+#define SPATIALINDEX_HPP
+
+#include "Frustum.hpp"
+
+#include "glm/vec3.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <limits>
+#include <cstdint>
+
+// Names an object in a LooseOctree or HashGrid
+struct SpatialHandle{
+    uint32_t index{0xFFFFFFFF};
+    bool IsValid() const { return index != 0xFFFFFFFF; }
+    bool operator==(const SpatialHandle& other) const { return index == other.index; }
+};
+
+class LooseOctree{
+public:
+    // Covers the cube 'halfSize' to each side of 'center', split 'depth'
+    // times at most. Objects whose center is outside of it are kept at
+    // the top, and tested by every query.
+    LooseOctree(const glm::vec3& center, float halfSize, uint32_t depth = 8);
+
+    SpatialHandle Insert(const glm::vec3& center, const glm::vec3& extent);
+    void Move(SpatialHandle object, const glm::vec3& center, const glm::vec3& extent);
+    void Remove(SpatialHandle object);
+    // Moves 'count' objects (each at most once)
+    void MoveMany(uint32_t count, const SpatialHandle* objects, const glm::vec3* centers, const glm::vec3* extents);
+
+    void QueryFrustum(const Frustum& frustum, std::vector<SpatialHandle>& results) const;
+    void QuerySphere(const glm::vec3& center, float radius, std::vector<SpatialHandle>& results) const;
+    // The objects the ray from 'origin' along 'direction' (normalized)
+    // touches within 'length'
+    void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float length,
+                  std::vector<SpatialHandle>& results) const;
+
+    uint32_t GetCount() const { return m_count; }
+    // Cells that hold objects, or have cells below them that do
+    uint32_t GetCellCount() const { return m_nodes.size() - m_freeNodes.size(); }
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    // A cell: its level, and its coordinates at that level, packed
+    uint64_t CellOf(const glm::vec3& center, const glm::vec3& extent) const;
+    // Adds an object to its cell, making the cells down to it
+    void Link(uint32_t object);
+    // Takes an object out of its cell, freeing the cells left empty
+    void Unlink(uint32_t object);
+    // Visits the objects in the cells whose loose box 'test' accepts,
+    // adding those whose own box it accepts
+    template<typename Test>
+    void Query(const Test& test, std::vector<SpatialHandle>& results) const;
+
+    struct Node{
+        uint32_t children[8];
+        uint32_t parent;
+        // Objects here and below
+        uint32_t count;
+        glm::vec3 center;
+        // Half the size of the loose cell (twice the cell's)
+        float looseHalfSize;
+        std::vector<uint32_t> objects;
+    };
+    struct Entry{
+        glm::vec3 center;
+        glm::vec3 extent;
+        uint64_t cell;
+        // NONE when the entry is free
+        uint32_t node;
+        // Where it is in the node's objects
+        uint32_t slot;
+    };
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_freeNodes;
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_freeEntries;
+    // MoveMany's new cells
+    std::vector<uint64_t> m_newCells;
+    glm::vec3 m_min;
+    float m_size;
+    uint32_t m_depth;
+    uint32_t m_count{0};
+};
+
+class HashGrid{
+public:
+    explicit HashGrid(float cellSize);
+
+    SpatialHandle Insert(const glm::vec3& center, const glm::vec3& extent);
+    void Move(SpatialHandle object, const glm::vec3& center, const glm::vec3& extent);
+    void Remove(SpatialHandle object);
+    void MoveMany(uint32_t count, const SpatialHandle* objects, const glm::vec3* centers, const glm::vec3* extents);
+
+    void QueryFrustum(const Frustum& frustum, std::vector<SpatialHandle>& results) const;
+    void QuerySphere(const glm::vec3& center, float radius, std::vector<SpatialHandle>& results) const;
+    void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float length,
+                  std::vector<SpatialHandle>& results) const;
+
+    uint32_t GetCount() const { return m_count; }
+    uint32_t GetCellCount() const { return m_cells.size(); }
+
+private:
+    // The cell a point is in, its coordinates packed into one key
+    uint64_t CellOf(const glm::vec3& point) const;
+    // An object in a cell, with its box kept there so that a query reads
+    // the cell's objects in a row
+    struct CellObject{
+        glm::vec3 center;
+        glm::vec3 extent;
+        uint32_t object;
+    };
+    struct Cell{
+        uint64_t key;
+        std::vector<CellObject> objects;
+        // The last query that visited the cell
+        mutable uint32_t query;
+    };
+    struct Entry{
+        uint64_t cell;
+        // Where its cell is in m_cells, and it in the cell
+        uint32_t cellIndex;
+        uint32_t slot;
+        bool used;
+    };
+
+    void Link(const CellObject& object);
+    void Unlink(uint32_t object);
+    // Adds the objects of the cell that 'test' accepts
+    template<typename Test>
+    void TestCell(const Cell& cell, const Test& test, std::vector<SpatialHandle>& results) const;
+    // The same for the cell at 'key' (if there is one), unless the cell was
+    // visited by this query already
+    template<typename Test>
+    void QueryCell(uint64_t key, const Test& test, std::vector<SpatialHandle>& results) const;
+    // The cells that hold objects, and where each key's cell is
+    std::vector<Cell> m_cells;
+    std::unordered_map<uint64_t, uint32_t> m_cellIndex;
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_freeEntries;
+    std::vector<uint64_t> m_newCells;
+    float m_cellSize;
+    // The most any object reaches out of its cell (it only ever grows)
+    glm::vec3 m_maxExtent{0.0f};
+    // The lowest and highest cell coordinates that have held objects (they
+    // only ever grow)
+    glm::ivec3 m_cellLow{std::numeric_limits<int32_t>::max()};
+    glm::ivec3 m_cellHigh{std::numeric_limits<int32_t>::min()};
+    mutable uint32_t m_query{0};
+    uint32_t m_count{0};
+};
+
+#endif
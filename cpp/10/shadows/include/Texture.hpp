@@ -24,19 +24,27 @@ public:
     ~Texture();
 	// Loads and sets up an actual texture
     void LoadTexture(const std::string filepath);
+    // Creates the OpenGL texture from an image that has already been
+    // loaded (e.g. on a worker thread). The image is not kept.
+    // Uploading again replaces the texture (used for reloading).
+    void Upload(Image& image);
+    // True once the texture exists on the GPU
+    bool IsReady() const { return m_textureID != 0; }
 	// slot tells us which slot we want to bind to.
     // We can have multiple slots. By default, we
     // will set our slot to 0 if it is not specified.
     void Bind(unsigned int slot=0) const;
-    // Be done with our texture
-    void Unbind();
+    // Be done with our texture (unbinds whatever is in the slot)
+    void Unbind(unsigned int slot=0);
+    // The OpenGL texture (0 until uploaded)
+    GLuint GetID() const { return m_textureID; }
 private:
     // Store a unique ID for the texture
-    GLuint m_textureID;
+    GLuint m_textureID{0};
 	// Filepath to the image loaded
     std::string m_filepath;
     // Store whatever image data inside of our texture class.
-    Image* m_image;
+    Image* m_image{nullptr};
 };
 
 
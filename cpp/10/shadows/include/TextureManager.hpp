@@ -0,0 +1,72 @@
+/** @file TextureManager.hpp
+ *  @brief This Singleton class manages all of the textures that have been loaded
+ *
+ *  Textures are looked up by their file path, so a texture that is used by
+ *  several materials (or several models) is only loaded and uploaded once.
+ *  GetTextureAsync loads the image on a worker thread and queues the
+ *  upload for the render thread. When a file is saved, its texture is
+ *  loaded again the same way and replaced in place.
+ *
+ *  @author Mike
+ *  @bug Only .ppm images can be loaded by Texture.
+ */
+#ifndef TEXTUREMANAGER_HPP
+#define TEXTUREMANAGER_HPP
+
+#include <unordered_map>
+#include <memory>
+#include <string>
+#include <iostream>
+#include <mutex>
+
+#include "Texture.hpp"
+#include "JobSystem.hpp"
+
+class TextureManager{
+public:
+	static TextureManager& Instance(){
+		static TextureManager* instance = new TextureManager();
+		return *instance;
+	}
+
+	// Retrieve the texture for a file, loading it the first time it is asked for.
+	// Returns nullptr if the file cannot be loaded.
+	// Render thread only, as the texture is created right away.
+	std::shared_ptr<Texture> GetTexture(const std::string& filepath){
+		JobHandle job;
+		std::shared_ptr<Texture> texture = GetTextureAsync(filepath, job);
+		if(texture != nullptr && !texture->IsReady()){
+			// Someone already asked for it asynchronously, so finish that
+			JobSystem::Instance().Wait(job);
+			ExecuteUploads(texture);
+		}
+		return texture;
+	}
+
+	// Retrieve the texture for a file. The first time a file is asked for,
+	// a job is started that loads the image, and then queues the upload on
+	// the UploadQueue. 'job' is set to that job, so other jobs can depend
+	// on the image being loaded. The texture is usable once IsReady().
+	// Safe to call from any thread.
+	std::shared_ptr<Texture> GetTextureAsync(const std::string& filepath, JobHandle& job);
+
+private:
+    // TextureManager Constructor
+    TextureManager() {}
+    // TextureManager Destructor
+    ~TextureManager() {}
+
+	// Loads a texture's image again, then swaps it in on the render thread
+	void ReloadTexture(const std::string& filepath);
+	// Runs queued uploads until 'texture' is on the GPU
+	void ExecuteUploads(const std::shared_ptr<Texture>& texture);
+
+	// Holds all of the textures, by file path
+	std::unordered_map<std::string,std::shared_ptr<Texture>> m_textures;
+	// The job loading each texture's image
+	std::unordered_map<std::string,JobHandle> m_jobs;
+	// Textures may be asked for from worker threads
+	std::mutex m_mutex;
+};
+
+#endif
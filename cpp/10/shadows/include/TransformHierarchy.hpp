@@ -0,0 +1,192 @@
+/** @file TransformHierarchy.hpp
+ *  @brief Every node's transform in flat arrays, with the world matrices
+ *         worked out only for the nodes that moved.
+ *
+ *  Each node has a parent, a local position/rotation/scale, and a world
+ *  matrix (its parent's world matrix times its local one). These are kept
+ *  as one array per field, in depth first order: a parent always comes
+ *  before its children, and each subtree is one contiguous range. So
+ *  Update() is one pass from the front to the back of the arrays, which
+ *  only reads the fields it needs.
+ *
+ *  Setting a node's position, rotation or scale marks it dirty. Update()
+ *  recomputes the dirty nodes and everything below them, and nothing
+ *  else. UpdateParallel() splits the arrays into subtrees, which do not
+ *  depend on each other, and updates them as jobs (see JobSystem.hpp).
+ *
+ *  A node may also have Bounds (its mesh's). The box around them in world
+ *  space is worked out along with the world matrix, and Cull() tests
+ *  these boxes against the camera's Frustum.
+ *
+ *  Nodes are named by a TransformHandle, which stays the same when the
+ *  arrays are put back in order (after a node is added or moved to
+ *  another parent). Nodes are not removed.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef TRANSFORMHIERARCHY_HPP
+#define TRANSFORMHIERARCHY_HPP
+
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+
+#include <vector>
+#include <cstdint>
+
+// Names a node in the TransformHierarchy
+struct TransformHandle{
+    uint32_t index{0xFFFFFFFF};
+    bool IsValid() const { return index != 0xFFFFFFFF; }
+    bool operator==(const TransformHandle& other) const { return index == other.index; }
+};
+
+class TransformHierarchy{
+public:
+    // The hierarchy the SceneNodes use
+    static TransformHierarchy& Instance(){
+        static TransformHierarchy* instance = new TransformHierarchy();
+        return *instance;
+    }
+
+    TransformHierarchy();
+    ~TransformHierarchy();
+
+    // Adds a node below 'parent' (or a root node, with no parent). It
+    // starts at the origin, unrotated and unscaled.
+    TransformHandle Create(TransformHandle parent = TransformHandle());
+    // Moves a node (and what is below it) to another parent. The parent
+    // must not be the node itself or below it.
+    void SetParent(TransformHandle node, TransformHandle parent);
+    TransformHandle GetParent(TransformHandle node) const;
+
+    // The local transform: scaled, then rotated, then moved
+    void SetPosition(TransformHandle node, const glm::vec3& position);
+    void SetRotation(TransformHandle node, const glm::quat& rotation);
+    void SetScale(TransformHandle node, const glm::vec3& scale);
+    const glm::vec3& GetPosition(TransformHandle node) const;
+    const glm::quat& GetRotation(TransformHandle node) const;
+    const glm::vec3& GetScale(TransformHandle node) const;
+
+    // As of the last Update()
+    const glm::mat4& GetWorldMatrix(TransformHandle node) const;
+
+    // The bounds of what is drawn at the node, in its own space. A node
+    // without bounds (or with empty ones) is never culled.
+    void SetBounds(TransformHandle node, const Bounds& bounds);
+    // Gives the node bounds that are never in view, for a node nothing is
+    // drawn at any more (SetBounds() gives it bounds again)
+    void Hide(TransformHandle node);
+    // Whether any nodes are below it (puts the nodes in order first)
+    bool HasChildren(TransformHandle node);
+    // The box around the node's bounds in world space, as of the last
+    // Update(): its center and half its size
+    void GetWorldBounds(TransformHandle node, glm::vec3& center, glm::vec3& extent) const;
+    // Finds the nodes whose world bounds are (at least partly) in the
+    // frustum. Returns how many are.
+    uint32_t Cull(const Frustum& frustum);
+    // As of the last Cull()
+    bool IsVisible(TransformHandle node) const { return m_visible[Slot(node)]; }
+    // The world boxes, one array per component, and Cull()'s results, in
+    // the arrays' order (not by handle): for culling further, e.g. by an
+    // OcclusionCuller
+    const float* GetWorldCenters(int axis) const { return m_worldCenter[axis].data(); }
+    const float* GetWorldExtents(int axis) const { return m_worldExtent[axis].data(); }
+    uint8_t* GetVisibleFlags(){ return m_visible.data(); }
+
+    // Works out the world matrices of the nodes that changed (and those
+    // below them) since the last update
+    void Update();
+    // The same, with the subtrees updated as jobs on the JobSystem
+    void UpdateParallel();
+
+    // For saving and loading whole scenes (see SceneFile.hpp): every
+    // node's local transform and bounds, in depth first order, with its
+    // parent given as its place in that order (or NO_PARENT)
+    static constexpr uint32_t NO_PARENT = 0xFFFFFFFF;
+    struct NodeArrays{
+        uint32_t count;
+        const uint32_t* parent;
+        const glm::vec3* position;
+        const glm::quat* rotation;
+        const glm::vec3* scale;
+        // As SetBounds keeps them: a box around a center (with huge extents
+        // for a node without bounds)
+        const glm::vec3* boundsCenter;
+        const glm::vec3* boundsExtent;
+    };
+    // Puts the nodes in order first. The arrays are valid until a node is
+    // added or moved.
+    NodeArrays GetNodeArrays();
+    // A node's place in that order
+    uint32_t GetOrder(TransformHandle node) const { return Slot(node); }
+    // Adds many nodes at once, copying the arrays, with parents given as
+    // places among the new nodes (each before its children). The new
+    // nodes' handles are consecutive, in the order given: returns the
+    // first. If they are not in depth first order, the next update puts
+    // them in order.
+    TransformHandle Append(const NodeArrays& nodes);
+    // Whether 'parent' lists nodes in depth first order: each node's
+    // parent is the node before it or one of that node's ancestors
+    static bool IsDepthFirst(uint32_t count, const uint32_t* parent);
+
+    // Number of nodes
+    uint32_t GetCount() const { return m_parent.size(); }
+    // Number of world matrices the last update worked out
+    uint32_t GetUpdatedCount() const { return m_updated; }
+    // A subtree with at most this many nodes is updated by one job
+    void SetJobSize(uint32_t nodes){ m_jobSize = nodes; m_rangesValid = false; }
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    // Puts the arrays back in depth first order, if nodes were added or
+    // moved since the last update
+    void Sort();
+    // Splits the arrays into the nodes updated before the jobs start, and
+    // subtrees of at most m_jobSize nodes
+    void BuildRanges();
+    // Updates the nodes in [begin, end), whose parents (if outside the
+    // range) are already up to date. Returns how many were dirty.
+    uint32_t UpdateRange(uint32_t begin, uint32_t end);
+    // Clears the dirty flags of [begin, end)
+    void ClearRange(uint32_t begin, uint32_t end);
+    uint32_t Slot(TransformHandle node) const { return m_slot[node.index]; }
+
+    // One entry per node, in depth first order. m_parent holds the slot
+    // of the parent (always before the node), or NONE.
+    std::vector<uint32_t> m_parent;
+    std::vector<uint32_t> m_subtreeSize;
+    std::vector<glm::vec3> m_position;
+    std::vector<glm::quat> m_rotation;
+    std::vector<glm::vec3> m_scale;
+    std::vector<glm::mat4> m_world;
+    // The bounds, as a box around a center
+    std::vector<glm::vec3> m_boundsCenter;
+    std::vector<glm::vec3> m_boundsExtent;
+    // The world space boxes, one array per component for Frustum::Cull
+    std::vector<float> m_worldCenter[3];
+    std::vector<float> m_worldExtent[3];
+    std::vector<uint8_t> m_visible;
+    // Not bool, so that jobs may write neighbouring flags
+    std::vector<uint8_t> m_dirty;
+    // Handle to slot, and slot to handle
+    std::vector<uint32_t> m_slot;
+    std::vector<uint32_t> m_handle;
+
+    // False when nodes were added or moved since the last Sort()
+    bool m_sorted{true};
+    // What UpdateParallel() does: the slots updated first, in order, then
+    // one job per subtree range
+    bool m_rangesValid{false};
+    std::vector<uint32_t> m_serial;
+    std::vector<std::pair<uint32_t,uint32_t>> m_ranges;
+    uint32_t m_jobSize{4096};
+    uint32_t m_updated{0};
+};
+
+#endif
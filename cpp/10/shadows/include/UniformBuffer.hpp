@@ -0,0 +1,97 @@
+/** @file UniformBuffer.hpp
+ *  @brief Uniforms shared by every shader, stored in a buffer on the GPU.
+ *
+ *  Data that is the same for every draw in a frame (the camera, the
+ *  lights) is uploaded once per frame into a uniform buffer object,
+ *  instead of being set on each shader. A shader that declares one of the
+ *  blocks below reads it from its binding point; Shader connects the two
+ *  when the program is linked.
+ *
+ *  The GLSL blocks are in shaders/common/, for shaders to #include.
+ *  The structs mirror the GLSL blocks using the std140 layout rules, so
+ *  they can be copied into the buffer as they are: a vec3 takes 16 bytes
+ *  unless a float follows it, and a struct is padded to 16 bytes.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef UNIFORMBUFFER_HPP
+#define UNIFORMBUFFER_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+
+// Binding points, one per block
+static constexpr GLuint FRAME_DATA_BINDING = 0;
+static constexpr GLuint LIGHT_DATA_BINDING = 1;
+static constexpr GLuint OBJECT_DATA_BINDING = 2;
+
+// layout(std140) uniform FrameData
+struct FrameData{
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::mat4 lightSpaceMatrix;
+    glm::vec4 viewPos;          // xyz
+    glm::vec4 lightPos;         // xyz, the light that casts shadows
+    float shadowNearPlane;
+    float shadowFarPlane;
+    int shadowPCFRadius;        // Used by shaders built without PCF_RADIUS
+    float padding;
+};
+
+// struct PointLight
+struct PointLightData{
+    glm::vec3 lightColor;
+    float ambientIntensity;
+    glm::vec3 lightPos;
+    float specularStrength;
+    float constant;
+    float linear;
+    float quadratic;
+    float padding;
+};
+
+// layout(std140) uniform LightData
+struct LightData{
+    PointLightData pointLights[2];
+    int lightCount;             // Used by shaders built without LIGHT_COUNT
+    int padding[3];
+};
+
+// layout(std140) uniform ObjectData. Unlike the others, there is one per
+// object drawn, bound a range at a time (see CommandList.hpp).
+struct ObjectData{
+    glm::mat4 model;
+};
+
+static_assert(sizeof(FrameData) == 240, "FrameData must match the std140 layout");
+static_assert(sizeof(PointLightData) == 48, "PointLightData must match the std140 layout");
+static_assert(sizeof(LightData) == 112, "LightData must match the std140 layout");
+static_assert(sizeof(ObjectData) == 64, "ObjectData must match the std140 layout");
+
+// Finds the binding point and size (in bytes) of a block by its name in
+// the shaders. Returns false if it is not one of ours.
+bool GetUniformBlock(const std::string& name, GLuint& binding, GLint& size);
+
+class UniformBuffer{
+public:
+    // Creates a buffer of 'size' bytes attached to a binding point
+    UniformBuffer(GLuint binding, GLsizeiptr size);
+    // Releases the buffer
+    ~UniformBuffer();
+    // Replaces the contents of the buffer ('size' must be the buffer's size)
+    void Update(const void* data, GLsizeiptr size);
+    template<typename T>
+    void Update(const T& data){
+        Update(&data, sizeof(T));
+    }
+
+private:
+    GLuint m_bufferID{0};
+    GLuint m_binding{0};
+    GLsizeiptr m_size{0};
+};
+
+#endif
@@ -0,0 +1,47 @@
+/** @file UploadQueue.hpp
+ *  @brief Work that has to run on the render thread (i.e. OpenGL calls).
+ *
+ *  Worker threads load and decode assets, then push a small function that
+ *  creates the buffers or textures. Once per frame the render thread runs
+ *  as many of them as fit in a time budget, so a big load is spread over
+ *  several frames instead of causing one long hitch.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef UPLOADQUEUE_HPP
+#define UPLOADQUEUE_HPP
+
+#include <functional>
+#include <deque>
+#include <mutex>
+
+class UploadQueue{
+public:
+    static UploadQueue& Instance(){
+        static UploadQueue* instance = new UploadQueue();
+        return *instance;
+    }
+
+    // Queue some OpenGL work. Safe to call from any thread.
+    void Push(std::function<void()> upload);
+    // Run queued work, in order, until 'budgetMilliseconds' have passed.
+    // At least one item is run per call so progress is always made.
+    // Returns how many were run. Call this from the render thread only.
+    unsigned int Execute(double budgetMilliseconds);
+    // Run everything that is queued, however long it takes
+    unsigned int ExecuteAll();
+    // Number of items waiting
+    unsigned int GetPendingCount() const;
+
+private:
+    // UploadQueue Constructor
+    UploadQueue() {}
+    // UploadQueue Destructor
+    ~UploadQueue() {}
+
+    std::deque<std::function<void()>> m_uploads;
+    mutable std::mutex m_mutex;
+};
+
+#endif
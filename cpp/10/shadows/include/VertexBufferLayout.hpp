@@ -25,6 +25,8 @@ public:
     void Bind();
     // Unbind our buffers
     void Unbind();
+    // The vertex array, to bind it through GLState
+    GLuint GetVertexArray() const { return m_VAOId; }
 
     // Creates a vertex and index buffer object
     // Format is: x,y,z
@@ -0,0 +1,63 @@
+/** @file VirtualFileSystem.hpp
+ *  @brief This Singleton class lets loaders read files out of an archive
+ *
+ *  Once an archive is mounted, every file under the archive's root folder
+ *  is read from the archive if it is in there, and from the disk if it is
+ *  not. Loaders do not need to know which -- Image, Shader, and everything
+ *  that goes through MappedFile (the .obj and .mtl loaders) ask here.
+ *
+ *  With nothing mounted files simply come from the disk, so the program
+ *  runs the same way from loose files during development.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef VIRTUALFILESYSTEM_HPP
+#define VIRTUALFILESYSTEM_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include "Archive.hpp"
+
+class VirtualFileSystem{
+public:
+	static VirtualFileSystem& Instance(){
+		static VirtualFileSystem* instance = new VirtualFileSystem();
+		return *instance;
+	}
+
+	// Mounts an archive that was packed from the folder 'root'
+	// (e.g. Mount("./assets/assets.pack", "./../../")).
+	// Returns false if the archive cannot be opened.
+	bool Mount(const std::string& archivePath, const std::string& root);
+	// Back to reading loose files only
+	void Unmount();
+	bool IsMounted() const { return m_archive != nullptr; }
+
+	// Reads a whole file. 'data' either points into the archive (valid for
+	// as long as it stays mounted) or into 'storage'.
+	// Returns false if the file does not exist.
+	bool ReadFile(const std::string& path, std::vector<char>& storage,
+	              const char*& data, std::size_t& size) const;
+	// Reads a whole file into a string. Returns false if it does not exist.
+	bool ReadFile(const std::string& path, std::string& contents) const;
+
+	// The name a file would have in the archive, or "" if the file is
+	// not under the root folder
+	std::string ArchivePath(const std::string& path) const;
+
+private:
+	VirtualFileSystem();
+	~VirtualFileSystem();
+
+	bool ReadFromArchive(const std::string& path, std::vector<char>& storage,
+	                     const char*& data, std::size_t& size) const;
+
+	std::unique_ptr<Archive> m_archive;
+	std::string m_root;
+};
+
+#endif
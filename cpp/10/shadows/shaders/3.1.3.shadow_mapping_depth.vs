@@ -1,10 +1,12 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 lightSpaceMatrix;
-uniform mat4 model;
+#include "common/frame_data.glsl"
+
+#include "common/instancing.glsl"
 
 void main()
 {
+    mat4 model = ModelMatrix();
     gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,12 @@
+// Camera and shadow data, set once per frame for every shader
+// (must match FrameData in include/UniformBuffer.hpp)
+layout(std140) uniform FrameData{
+    mat4 projection;
+    mat4 view;
+    mat4 lightSpaceMatrix;
+    vec4 viewPos;           // xyz
+    vec4 lightPos;          // xyz, the light that casts shadows
+    float shadowNearPlane;
+    float shadowFarPlane;
+    int shadowPCFRadius;    // Used by shaders built without PCF_RADIUS
+};
@@ -0,0 +1,27 @@
+// The model matrix of the object being drawn. Shaders built with
+// INSTANCED draw many copies of an object at once, and read each copy's
+// matrix from the RenderQueue's instance buffer (a mat4 attribute takes
+// locations 8 to 11, see INSTANCE_MODEL_LOCATION in include/RenderQueue.hpp).
+// Shaders built with OBJECT_DATA read it from the ObjectData block, whose
+// range is bound for each draw by a CommandList (must match ObjectData in
+// include/UniformBuffer.hpp).
+// Otherwise it is the 'model' uniform, set for each draw.
+#ifdef INSTANCED
+layout(location = 8) in mat4 instanceModel;
+#elif defined(OBJECT_DATA)
+layout(std140) uniform ObjectData{
+    mat4 objectModel;
+};
+#else
+uniform mat4 model;
+#endif
+
+mat4 ModelMatrix(){
+#ifdef INSTANCED
+    return instanceModel;
+#elif defined(OBJECT_DATA)
+    return objectModel;
+#else
+    return model;
+#endif
+}
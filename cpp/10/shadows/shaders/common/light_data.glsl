@@ -0,0 +1,19 @@
+// Our light source data structure
+// (must match PointLightData in include/UniformBuffer.hpp)
+struct PointLight{
+    vec3 lightColor;
+    float ambientIntensity;
+    vec3 lightPos;
+    float specularStrength;
+
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+// Set once per frame for every shader
+// (must match LightData in include/UniformBuffer.hpp)
+layout(std140) uniform LightData{
+    PointLight pointLights[2];
+    int lightCount;         // Used by shaders built without LIGHT_COUNT
+};
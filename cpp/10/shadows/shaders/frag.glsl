@@ -4,28 +4,21 @@
 // The final output color of each 'fragment' from our fragment shader.
 out vec4 FragColor;
 
-// Our light source data structure
-struct PointLight{
-    vec3 lightColor;
-    vec3 lightPos;
-    float ambientIntensity;
-
-    float specularStrength;
-
-    float constant;
-    float linear;
-    float quadratic;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-uniform PointLight pointLights[2];
-
-// Used for our specular highlights
-uniform mat4 view;
-
+#include "common/light_data.glsl"
+
+// LIGHT_COUNT: how many of the point lights to use. A shader built with
+// it has a loop of a known length (that the compiler can unroll); without
+// it, the count is read from LightData.
+#ifdef LIGHT_COUNT
+const int pointLightCount = LIGHT_COUNT;
+#else
+#define pointLightCount lightCount
+#endif
+
+// NORMAL_MAPPING: 1 to take the normals from u_NormalMap
+#ifndef NORMAL_MAPPING
+#define NORMAL_MAPPING 0
+#endif
 
 // Import our normal data
 in vec3 myNormal;
@@ -33,6 +26,11 @@ in vec3 myNormal;
 in vec2 v_texCoord;
 // Import the fragment position
 in vec3 FragPos;
+#if NORMAL_MAPPING
+// Turns normals from the normal map into world space
+in mat3 v_TBN;
+uniform sampler2D u_NormalMap;
+#endif
 
 // If we have texture coordinates, they are stored in this sampler.
 uniform sampler2D u_DiffuseMap; 
@@ -42,7 +40,11 @@ uniform sampler2D u_DiffuseMap;
 void main()
 {
     // Compute the normal direction
+#if NORMAL_MAPPING
+    vec3 norm = normalize(v_TBN * (texture(u_NormalMap, v_texCoord).rgb * 2.0 - 1.0));
+#else
     vec3 norm = normalize(myNormal);
+#endif
     
     // Store our final texture color
     vec3 diffuseColor   = texture(u_DiffuseMap, v_texCoord).rgb;
@@ -52,7 +54,7 @@ void main()
 	vec3 Lighting = vec3(0.0,0.0,0.0);
 
 	// TODO: (Optional) You should refactor this into a separate function :)
-	for(int i=0; i < 1; i++){
+	for(int i=0; i < pointLightCount; i++){
 		// (1) Compute ambient light
 		vec3 ambient = pointLights[i].ambientIntensity * pointLights[i].lightColor;
 
@@ -11,12 +11,22 @@ layout(location=4)in vec3 bitangents; // Our third attribute - texture coordinat
 
 // If we are applying our camera, then we need to add some uniforms.
 // Note that the syntax nicely matches glm's mat4!
-uniform mat4 model; // Object space
-uniform mat4 view; // Object space
-uniform mat4 projection; // Object space
+// The model matrix (object space), from a uniform or per instance
+#include "common/instancing.glsl"
+
+#include "common/frame_data.glsl"
+
+// NORMAL_MAPPING: 1 to take the normals from a normal map (see frag.glsl)
+#ifndef NORMAL_MAPPING
+#define NORMAL_MAPPING 0
+#endif
 
 // Export our normal data, and read it into our frag shader
 out vec3 myNormal;
+#if NORMAL_MAPPING
+// Turns the normal map's normals (in tangent space) into world space
+out mat3 v_TBN;
+#endif
 // Export our Fragment Position computed in world space
 out vec3 FragPos;
 // If we have texture coordinates we can now use this as well
@@ -24,10 +34,17 @@ out vec2 v_texCoord;
 
 void main()
 {
+    mat4 model = ModelMatrix();
 
     gl_Position = projection * view * model * vec4(position, 1.0f);
 
     myNormal = normals;
+#if NORMAL_MAPPING
+    mat3 normalMatrix = mat3(model);
+    v_TBN = mat3(normalize(normalMatrix * tangents),
+                 normalize(normalMatrix * bitangents),
+                 normalize(normalMatrix * normals));
+#endif
     // Transform normal into world space
     FragPos = vec3(model* vec4(position,1.0f));
 
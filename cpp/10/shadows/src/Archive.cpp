@@ -0,0 +1,223 @@
+#include "Archive.hpp"
+#include "LZ.hpp"
+
+#include <iostream>
+#include <cstring>
+
+uint64_t ArchiveHash(std::string_view path){
+    uint64_t hash = 14695981039346656037ull;
+    for(char c : path){
+        hash ^= (uint8_t)c;
+        hash *= 1099511628211ull;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+// ==================== Reading ====================
+bool Archive::Open(const std::string& filename){
+    Close();
+    if(!m_file.Open(filename)){
+        return false;
+    }
+    const char* data = m_file.Data();
+    const std::size_t size = m_file.Size();
+    if(size < sizeof(ArchiveHeader)){
+        std::cout << "Archive: " << filename << " is too small to be an archive" << std::endl;
+        return false;
+    }
+    std::memcpy(&m_header, data, sizeof(ArchiveHeader));
+    if(std::memcmp(m_header.magic, "PACK", 4) != 0 || m_header.version != ARCHIVE_VERSION){
+        std::cout << "Archive: " << filename << " is not a version " << ARCHIVE_VERSION << " archive" << std::endl;
+        return false;
+    }
+    // Everything the directory points at has to be inside the file. (Each
+    // end is checked as 'offset <= size - bytes', which cannot overflow.)
+    auto inside = [size](uint64_t offset, uint64_t bytes){
+        return bytes <= size && offset <= size - bytes;
+    };
+    const bool powerOfTwo = m_header.slotCount != 0 && (m_header.slotCount & (m_header.slotCount-1)) == 0;
+    if(m_header.fileSize != size || !powerOfTwo || m_header.directoryOffset % alignof(ArchiveEntry) != 0 ||
+       !inside(m_header.directoryOffset, (uint64_t)m_header.slotCount*sizeof(ArchiveEntry)) ||
+       !inside(m_header.namesOffset, m_header.namesSize)){
+        std::cout << "Archive: " << filename << " is damaged" << std::endl;
+        m_file.Close();
+        return false;
+    }
+    const ArchiveEntry* slots = reinterpret_cast<const ArchiveEntry*>(data + m_header.directoryOffset);
+    uint32_t used = 0;
+    for(uint32_t i=0; i < m_header.slotCount; ++i){
+        const ArchiveEntry& entry = slots[i];
+        if(entry.hash == 0){
+            continue;
+        }
+        ++used;
+        const bool compressed = (entry.flags & ARCHIVE_COMPRESSED) != 0;
+        // Stored entries are read in place, so they are as big as they are
+        // stored. Compressed ones can grow at most 255 times (see LZ.hpp).
+        const bool sizeOk = compressed ? entry.size <= ARCHIVE_MAX_ENTRY_SIZE && entry.size/255 <= entry.storedSize
+                                       : entry.size == entry.storedSize;
+        if(!inside(entry.offset, entry.storedSize) || !sizeOk ||
+           (uint64_t)entry.nameOffset + entry.nameLength > m_header.namesSize){
+            std::cout << "Archive: " << filename << " is damaged" << std::endl;
+            m_file.Close();
+            return false;
+        }
+    }
+    // Find() stops at an empty slot, so there has to be one
+    if(used != m_header.entryCount || used >= m_header.slotCount){
+        std::cout << "Archive: " << filename << " is damaged" << std::endl;
+        m_file.Close();
+        return false;
+    }
+    m_directory = slots;
+    return true;
+}
+
+void Archive::Close(){
+    m_file.Close();
+    m_directory = nullptr;
+    m_header = ArchiveHeader{};
+}
+
+const ArchiveEntry* Archive::Find(std::string_view path) const{
+    if(m_directory == nullptr){
+        return nullptr;
+    }
+    const uint64_t hash = ArchiveHash(path);
+    const uint32_t mask = m_header.slotCount-1;
+    // The table is never full, so this always reaches an empty slot
+    for(uint32_t i = (uint32_t)hash & mask; m_directory[i].hash != 0; i = (i+1) & mask){
+        // Two paths can share a hash, so check the name as well
+        if(m_directory[i].hash == hash && GetName(m_directory[i]) == path){
+            return &m_directory[i];
+        }
+    }
+    return nullptr;
+}
+
+std::string_view Archive::GetName(const ArchiveEntry& entry) const{
+    return std::string_view(m_file.Data() + m_header.namesOffset + entry.nameOffset, entry.nameLength);
+}
+
+bool Archive::Read(const ArchiveEntry& entry, std::vector<char>& storage,
+                   const char*& data, std::size_t& size) const{
+    const char* stored = m_file.Data() + entry.offset;
+    if((entry.flags & ARCHIVE_COMPRESSED) == 0){
+        data = stored;
+        size = entry.size;
+        return true;
+    }
+    storage.resize(entry.size);
+    if(!LZDecompress(stored, entry.storedSize, storage.data(), entry.size)){
+        std::cout << "Archive: " << GetName(entry) << " is corrupt" << std::endl;
+        storage.clear();
+        return false;
+    }
+    data = storage.data();
+    size = entry.size;
+    return true;
+}
+
+// ==================== Writing ====================
+bool ArchiveWriter::Begin(const std::string& filename){
+    m_out.open(filename.c_str(), std::ios::binary | std::ios::trunc);
+    if(!m_out.is_open()){
+        std::cout << "ArchiveWriter: unable to create " << filename << std::endl;
+        return false;
+    }
+    // The header is written for real by Finish, once we know where things are
+    ArchiveHeader header{};
+    m_out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_offset = sizeof(header);
+    m_entries.clear();
+    m_names.clear();
+    m_totalSize = 0;
+    m_storedSize = 0;
+    return true;
+}
+
+void ArchiveWriter::Pad(){
+    static const char zeros[ARCHIVE_ALIGNMENT]{};
+    uint64_t padding = (ARCHIVE_ALIGNMENT - m_offset % ARCHIVE_ALIGNMENT) % ARCHIVE_ALIGNMENT;
+    m_out.write(zeros, padding);
+    m_offset += padding;
+}
+
+bool ArchiveWriter::AddFile(const std::string& path, const char* data, std::size_t size, bool compress){
+    const uint64_t hash = ArchiveHash(path);
+    for(const ArchiveEntry& other : m_entries){
+        if(other.hash == hash && m_names.compare(other.nameOffset, other.nameLength, path) == 0){
+            std::cout << "ArchiveWriter: " << path << " was already added" << std::endl;
+            return false;
+        }
+    }
+
+    ArchiveEntry entry{};
+    entry.hash = hash;
+    entry.size = size;
+    entry.nameOffset = (uint32_t)m_names.size();
+    entry.nameLength = (uint32_t)path.size();
+    m_names += path;
+
+    std::vector<char> compressed;
+    // (Anything too big to unpack is stored as it is)
+    if(compress && size > 0 && size <= ARCHIVE_MAX_ENTRY_SIZE){
+        compressed = LZCompress(data, size);
+        // Not worth unpacking on every load unless it saves at least 1/8th
+        if(compressed.size() <= size - size/8){
+            data = compressed.data();
+            size = compressed.size();
+            entry.flags |= ARCHIVE_COMPRESSED;
+        }
+    }
+
+    Pad();
+    entry.offset = m_offset;
+    entry.storedSize = size;
+    m_out.write(data, size);
+    m_offset += size;
+    m_entries.push_back(entry);
+    m_totalSize += entry.size;
+    m_storedSize += entry.storedSize;
+    return true;
+}
+
+bool ArchiveWriter::Finish(){
+    // Keep the table at most half full so lookups stay short
+    uint32_t slotCount = 16;
+    while(slotCount < m_entries.size()*2){
+        slotCount <<= 1;
+    }
+    std::vector<ArchiveEntry> slots(slotCount, ArchiveEntry{});
+    for(const ArchiveEntry& entry : m_entries){
+        uint32_t i = (uint32_t)entry.hash & (slotCount-1);
+        while(slots[i].hash != 0){
+            i = (i+1) & (slotCount-1);
+        }
+        slots[i] = entry;
+    }
+
+    ArchiveHeader header{};
+    std::memcpy(header.magic, "PACK", 4);
+    header.version = ARCHIVE_VERSION;
+    header.entryCount = (uint32_t)m_entries.size();
+    header.slotCount = slotCount;
+    Pad();
+    header.directoryOffset = m_offset;
+    m_out.write(reinterpret_cast<const char*>(slots.data()), slots.size()*sizeof(ArchiveEntry));
+    m_offset += slots.size()*sizeof(ArchiveEntry);
+    header.namesOffset = m_offset;
+    header.namesSize = m_names.size();
+    m_out.write(m_names.data(), m_names.size());
+    m_offset += m_names.size();
+    header.fileSize = m_offset;
+
+    m_out.seekp(0);
+    m_out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_out.close();
+    if(m_out.fail()){
+        std::cout << "ArchiveWriter: unable to write the archive" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+#include "AssetLoader.hpp"
+#include "JobSystem.hpp"
+#include "UploadQueue.hpp"
+#include "TextureManager.hpp"
+#include "FileWatcher.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+std::shared_ptr<Model> AssetLoader::LoadModelAsync(const std::string& filename){
+    std::shared_ptr<Model> model = std::make_shared<Model>();
+    StartLoad(model, filename, std::chrono::steady_clock::now(), false);
+
+    // Reload the model when its file is saved (as long as it is still used)
+    std::weak_ptr<Model> watched = model;
+    FileWatcher::Instance().Watch(filename, model.get(), [this, watched, filename](){
+        if(std::shared_ptr<Model> model = watched.lock()){
+            StartLoad(model, filename, std::chrono::steady_clock::now(), true);
+        }
+    });
+    return model;
+}
+
+void AssetLoader::StartLoad(std::shared_ptr<Model> model, const std::string& filename,
+                            std::chrono::steady_clock::time_point requested, bool reload){
+    m_loading++;
+
+    JobSystem::Instance().Submit([this, model, filename, requested, reload](){
+        // (1) Parse the .obj and its .mtl. We are already on a worker,
+        //     other workers are busy with other assets, so one thread.
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(filename, 1);
+
+        // (2) Start (or join) the loading of every diffuse map
+        std::vector<std::shared_ptr<Texture>> diffuseMaps;
+        std::vector<JobHandle> textureJobs;
+        for(const Material& material : mesh->materials){
+            if(material.diffuseMap.empty()){
+                diffuseMaps.push_back(nullptr);
+                continue;
+            }
+            JobHandle job;
+            diffuseMaps.push_back(TextureManager::Instance().GetTextureAsync(material.diffuseMap, job));
+            textureJobs.push_back(job);
+        }
+
+        // (3) Once every image is decoded (so their uploads are already
+        //     queued ahead of ours), queue the mesh upload
+        JobSystem::Instance().Submit([this, model, mesh, diffuseMaps, filename, requested, reload](){
+            UploadQueue::Instance().Push([this, model, mesh, diffuseMaps, filename, requested, reload](){
+                if(mesh->GetTriangleCount() > 0){
+                    model->Upload(*mesh, diffuseMaps);
+                }else{
+                    std::cout << "AssetLoader: no triangles in " << filename << std::endl;
+                }
+                m_loading--;
+                double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-requested).count();
+                std::cout << "AssetLoader: " << filename << (reload ? " reloaded in " : " ready after ") << ms << " ms" << std::endl;
+            });
+        }, textureJobs);
+    });
+}
+
+void AssetLoader::Update(double budgetMilliseconds){
+    UploadQueue::Instance().Execute(budgetMilliseconds);
+}
+
+bool AssetLoader::IsBusy() const{
+    return m_loading.load() > 0 || UploadQueue::Instance().GetPendingCount() > 0;
+}
@@ -0,0 +1,168 @@
+#include "CommandList.hpp"
+#include "GLState.hpp"
+
+#include <cstring>
+
+void CommandList::Reset(){
+    m_commands.clear();
+    m_objects.clear();
+    m_shader = nullptr;
+    m_vertexArray = UNKNOWN;
+    m_texture = UNKNOWN;
+    m_transparent = false;
+    m_drawCount = 0;
+}
+
+void CommandList::BindShader(Shader* shader){
+    if(shader != m_shader){
+        m_shader = shader;
+        m_commands.push_back({Command::BIND_SHADER, 0, shader});
+    }
+}
+
+void CommandList::BindVertexArray(GLuint vertexArray){
+    if(vertexArray != m_vertexArray){
+        m_vertexArray = vertexArray;
+        m_commands.push_back({Command::BIND_VERTEX_ARRAY, vertexArray, nullptr});
+    }
+}
+
+void CommandList::BindTexture(GLuint texture){
+    if(texture != m_texture){
+        m_texture = texture;
+        m_commands.push_back({Command::BIND_TEXTURE, texture, nullptr});
+    }
+}
+
+void CommandList::SetTransparent(bool transparent){
+    if(transparent != m_transparent){
+        m_transparent = transparent;
+        m_commands.push_back({Command::SET_TRANSPARENT, transparent ? 1u : 0u, nullptr});
+    }
+}
+
+void CommandList::BindObjectData(const glm::mat4& model){
+    m_commands.push_back({Command::BIND_OBJECT_DATA, (GLuint)m_objects.size(), nullptr});
+    m_objects.push_back({model});
+}
+
+void CommandList::DrawElements(GLsizei indexCount){
+    m_commands.push_back({Command::DRAW, (GLuint)indexCount, nullptr});
+    ++m_drawCount;
+}
+
+CommandPlayer::CommandPlayer(){
+}
+
+CommandPlayer::~CommandPlayer(){
+    if(m_buffer != 0){
+        GLState::Instance().ForgetBuffer(m_buffer);
+        glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+void CommandPlayer::Upload(const CommandList* lists, uint32_t count){
+    GLState& state = GLState::Instance();
+    if(m_buffer == 0){
+        glGenBuffers(1, &m_buffer);
+        // Each range has to start on the driver's alignment
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_stride = sizeof(ObjectData);
+        if(alignment > 0){
+            m_stride = (m_stride + alignment-1)/alignment*alignment;
+        }
+    }
+    m_firstObject.resize(count);
+    uint32_t objects = 0;
+    for(uint32_t i=0; i < count; ++i){
+        m_firstObject[i] = objects;
+        objects += lists[i].GetObjectData().size();
+    }
+    if(objects == 0){
+        return;
+    }
+    state.BindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    if(objects > m_capacity){
+        m_capacity = objects + objects/2;
+    }
+    // New storage each frame, as in RenderQueue::BuildBatches, so the
+    // driver need not wait for last frame's draws
+    glBufferData(GL_UNIFORM_BUFFER, m_capacity*m_stride, nullptr, GL_STREAM_DRAW);
+    if(m_stride == (GLsizeiptr)sizeof(ObjectData)){
+        for(uint32_t i=0; i < count; ++i){
+            const std::vector<ObjectData>& data = lists[i].GetObjectData();
+            if(!data.empty()){
+                glBufferSubData(GL_UNIFORM_BUFFER, m_firstObject[i]*sizeof(ObjectData),
+                                data.size()*sizeof(ObjectData), data.data());
+            }
+        }
+        return;
+    }
+    // Spread out to the alignment, then all at once
+    m_staging.resize(objects*m_stride);
+    for(uint32_t i=0; i < count; ++i){
+        const std::vector<ObjectData>& data = lists[i].GetObjectData();
+        uint8_t* destination = m_staging.data() + m_firstObject[i]*m_stride;
+        for(const ObjectData& object : data){
+            std::memcpy(destination, &object, sizeof(ObjectData));
+            destination += m_stride;
+        }
+    }
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, m_staging.size(), m_staging.data());
+}
+
+void CommandPlayer::Replay(const CommandList* lists, uint32_t count){
+    GLState& state = GLState::Instance();
+    DepthState opaqueDepth;
+    opaqueDepth.test = true;
+    DepthState transparentDepth = opaqueDepth;
+    transparentDepth.write = false;
+    BlendState blend;
+    blend.enabled = true;
+    blend.source = GL_SRC_ALPHA;
+    blend.destination = GL_ONE_MINUS_SRC_ALPHA;
+
+    Upload(lists, count);
+    m_drawCount = 0;
+    state.SetDepthState(opaqueDepth);
+    state.SetBlendState(BlendState());
+    bool transparent = false;
+    for(uint32_t i=0; i < count; ++i){
+        // (Each list binds what it needs from its start, and GLState skips
+        //  what the list before it left bound.)
+        GLintptr firstObject = m_firstObject[i];
+        for(const Command& command : lists[i].GetCommands()){
+            switch(command.type){
+                case Command::BIND_SHADER:
+                    command.shader->Bind();
+                    break;
+                case Command::BIND_VERTEX_ARRAY:
+                    state.BindVertexArray(command.value);
+                    break;
+                case Command::BIND_TEXTURE:
+                    state.BindTexture(0, command.value);
+                    break;
+                case Command::SET_TRANSPARENT:
+                    transparent = command.value != 0;
+                    state.SetDepthState(transparent ? transparentDepth : opaqueDepth);
+                    state.SetBlendState(transparent ? blend : BlendState());
+                    break;
+                case Command::BIND_OBJECT_DATA:
+                    state.BindBufferRange(GL_UNIFORM_BUFFER, OBJECT_DATA_BINDING, m_buffer,
+                                          (firstObject+command.value)*m_stride, sizeof(ObjectData));
+                    break;
+                case Command::DRAW:
+                    glDrawElements(GL_TRIANGLES, command.value, GL_UNSIGNED_INT, nullptr);
+                    ++m_drawCount;
+                    break;
+            }
+        }
+        // The next list was recorded as if it started opaque
+        if(transparent){
+            transparent = false;
+            state.SetDepthState(opaqueDepth);
+            state.SetBlendState(BlendState());
+        }
+    }
+}
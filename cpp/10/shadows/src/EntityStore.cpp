@@ -0,0 +1,158 @@
+#include "EntityStore.hpp"
+#include "ShaderManager.hpp"
+
+// The same shaders a SceneNode gets, with the texture slots set once
+MaterialComponent MaterialComponent::Load(const std::string& vertShader, const std::string& fragShader,
+                                          const ShaderDefines& defines){
+    ShaderManager& shaders = ShaderManager::Instance();
+    MaterialComponent material;
+    ShaderHandle handle = shaders.GetShaderVariant(vertShader, fragShader, defines);
+    material.shader = shaders.GetShader(handle);
+    material.shaderIndex = handle.index;
+    ShaderDefines instancedDefines = defines;
+    instancedDefines.Set("INSTANCED", 1);
+    material.instancedShader = shaders.GetShader(shaders.GetShaderVariant(vertShader, fragShader, instancedDefines));
+    ShaderDefines objectDataDefines = defines;
+    objectDataDefines.Set("OBJECT_DATA", 1);
+    material.objectDataShader = shaders.GetShader(shaders.GetShaderVariant(vertShader, fragShader, objectDataDefines));
+    // Without binding, so this does not wait for the shaders to be built
+    for(Shader* shader : {material.shader, material.instancedShader, material.objectDataShader}){
+        shader->SetSampler("u_DiffuseMap",0);
+        shader->SetSampler("u_DetailMap",1);
+    }
+    material.modelUniform = material.shader->GetUniform("model");
+    return material;
+}
+
+EntityStore::EntityStore(TransformHierarchy& transforms) : m_transforms(transforms){
+}
+
+Entity EntityStore::Create(const MeshComponent& mesh, const MaterialComponent& material, const Bounds& bounds,
+                           TransformHandle parent){
+    Entity entity;
+    if(m_free.empty()){
+        entity.index = m_row.size();
+        m_row.push_back(NONE);
+    }else{
+        entity.index = m_free.back();
+        m_free.pop_back();
+    }
+    TransformHandle transform;
+    if(m_freeTransforms.empty()){
+        transform = m_transforms.Create(parent);
+    }else{
+        // A destroyed entity's node, put back as a new one would be
+        transform = m_freeTransforms.back();
+        m_freeTransforms.pop_back();
+        if(!(m_transforms.GetParent(transform) == parent)){
+            m_transforms.SetParent(transform, parent);
+        }
+        m_transforms.SetPosition(transform, glm::vec3(0.0f));
+        m_transforms.SetRotation(transform, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+        m_transforms.SetScale(transform, glm::vec3(1.0f));
+    }
+    m_transforms.SetBounds(transform, bounds);
+
+    m_row[entity.index] = m_entity.size();
+    m_entity.push_back(entity);
+    m_transform.push_back(transform);
+    m_mesh.push_back(mesh);
+    m_material.push_back(material);
+    m_bounds.push_back(bounds);
+    return entity;
+}
+
+Entity EntityStore::Append(uint32_t count, const TransformHandle* transforms, const MeshComponent* meshes,
+                           const MaterialComponent* materials, const Bounds* bounds){
+    // New ids after the last one, rather than the free ones, so that they
+    // are consecutive
+    Entity first;
+    first.index = m_row.size();
+    uint32_t firstRow = m_entity.size();
+    m_row.reserve(m_row.size() + count);
+    m_entity.reserve(firstRow + count);
+    for(uint32_t i=0; i < count; ++i){
+        m_row.push_back(firstRow + i);
+        m_entity.push_back(Entity{first.index + i});
+    }
+    m_transform.insert(m_transform.end(), transforms, transforms + count);
+    m_mesh.insert(m_mesh.end(), meshes, meshes + count);
+    m_material.insert(m_material.end(), materials, materials + count);
+    m_bounds.insert(m_bounds.end(), bounds, bounds + count);
+    return first;
+}
+
+void EntityStore::Destroy(Entity entity){
+    uint32_t row = m_row[entity.index];
+    m_transforms.Hide(m_transform[row]);
+    if(!m_transforms.HasChildren(m_transform[row])){
+        m_freeTransforms.push_back(m_transform[row]);
+    }
+    // The last row takes its place
+    uint32_t last = m_entity.size()-1;
+    if(row != last){
+        m_entity[row] = m_entity[last];
+        m_transform[row] = m_transform[last];
+        m_mesh[row] = m_mesh[last];
+        m_material[row] = m_material[last];
+        m_bounds[row] = m_bounds[last];
+        m_row[m_entity[row].index] = row;
+    }
+    m_entity.pop_back();
+    m_transform.pop_back();
+    m_mesh.pop_back();
+    m_material.pop_back();
+    m_bounds.pop_back();
+    m_row[entity.index] = NONE;
+    m_free.push_back(entity.index);
+}
+
+void EntityStore::SetBounds(Entity entity, const Bounds& bounds){
+    uint32_t row = m_row[entity.index];
+    m_bounds[row] = bounds;
+    m_transforms.SetBounds(m_transform[row], bounds);
+}
+
+uint32_t EntityStore::Draw(RenderQueue& queue) const{
+    uint32_t added = 0;
+    for(uint32_t row=0; row < m_transform.size(); ++row){
+        TransformHandle transform = m_transform[row];
+        if(!m_transforms.IsVisible(transform)){
+            continue;
+        }
+        const MeshComponent& mesh = m_mesh[row];
+        const MaterialComponent& material = m_material[row];
+        DrawItem item;
+        item.shader = material.shader;
+        item.shaderIndex = material.shaderIndex;
+        item.modelUniform = material.modelUniform;
+        item.model = &m_transforms.GetWorldMatrix(transform);
+        item.vertexArray = mesh.vertexArray;
+        item.texture = material.texture;
+        item.indexCount = mesh.indexCount;
+        item.transparent = material.transparent;
+        item.instancedShader = material.instancedShader;
+        glm::vec3 center, extent;
+        m_transforms.GetWorldBounds(transform, center, extent);
+        queue.Add(item, center);
+        ++added;
+    }
+    return added;
+}
+
+void EntityStore::Record(CommandList& list, uint32_t first, uint32_t last) const{
+    for(uint32_t row=first; row < last; ++row){
+        TransformHandle transform = m_transform[row];
+        if(!m_transforms.IsVisible(transform)){
+            continue;
+        }
+        const MeshComponent& mesh = m_mesh[row];
+        const MaterialComponent& material = m_material[row];
+        list.SetTransparent(material.transparent);
+        list.BindShader(material.objectDataShader);
+        list.BindTexture(material.texture);
+        list.BindVertexArray(mesh.vertexArray);
+        list.BindObjectData(m_transforms.GetWorldMatrix(transform));
+        list.DrawElements(mesh.indexCount);
+    }
+}
@@ -0,0 +1,127 @@
+#include "FileWatcher.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+#if defined(LINUX)
+	#include <sys/inotify.h>
+	#include <unistd.h>
+	#include <limits.h>
+#endif
+
+// How often modification times are checked when polling
+static constexpr double POLL_INTERVAL_MS = 500.0;
+
+static std::string AbsolutePath(const std::string& path){
+	return std::filesystem::absolute(path).lexically_normal().string();
+}
+
+static double NowMilliseconds(){
+	return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FileWatcher::FileWatcher(){
+#if defined(LINUX)
+	m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(m_inotify < 0){
+		std::cout << "FileWatcher: inotify is not available, checking files for changes instead" << std::endl;
+	}
+#endif
+}
+
+FileWatcher::~FileWatcher(){
+#if defined(LINUX)
+	if(m_inotify >= 0){
+		close(m_inotify);
+	}
+#endif
+}
+
+void FileWatcher::Watch(const std::string& path, const void* owner, std::function<void()> callback){
+	const std::string absolute = AbsolutePath(path);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	WatchedFile& file = m_files[absolute];
+	for(auto& [watcher, existing] : file.callbacks){
+		if(watcher == owner){
+			existing = std::move(callback);
+			return;
+		}
+	}
+	file.callbacks.push_back({owner, std::move(callback)});
+	if(file.callbacks.size() > 1){
+		return;
+	}
+	std::error_code error;
+	file.lastWrite = std::filesystem::last_write_time(absolute, error);
+#if defined(LINUX)
+	const std::string folder = std::filesystem::path(absolute).parent_path().string();
+	if(m_inotify >= 0 && !m_folderWatches.contains(folder)){
+		// Written and closed, or renamed into place
+		int watch = inotify_add_watch(m_inotify, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if(watch >= 0){
+			m_folderWatches[folder] = watch;
+			m_watchedFolders[watch] = folder;
+		}else{
+			std::cout << "FileWatcher: unable to watch " << folder << std::endl;
+		}
+	}
+#endif
+}
+
+void FileWatcher::Update(){
+	std::vector<std::string> changed;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+#if defined(LINUX)
+		if(m_inotify >= 0){
+			alignas(struct inotify_event) char buffer[16*(sizeof(struct inotify_event)+NAME_MAX+1)];
+			while(true){
+				ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+				if(length <= 0){
+					break; // Nothing more to read (EAGAIN)
+				}
+				for(char* p = buffer; p < buffer+length; ){
+					const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+					p += sizeof(struct inotify_event) + event->len;
+					auto folder = m_watchedFolders.find(event->wd);
+					if(event->len == 0 || folder == m_watchedFolders.end()){
+						continue;
+					}
+					std::string path = (std::filesystem::path(folder->second) / event->name).string();
+					if(m_files.contains(path)){
+						changed.push_back(path);
+					}
+				}
+			}
+		}
+#endif
+		if(m_inotify < 0 && NowMilliseconds()-m_lastPoll >= POLL_INTERVAL_MS){
+			m_lastPoll = NowMilliseconds();
+			for(auto& [path, file] : m_files){
+				std::error_code error;
+				std::filesystem::file_time_type lastWrite = std::filesystem::last_write_time(path, error);
+				if(!error && lastWrite != file.lastWrite){
+					file.lastWrite = lastWrite;
+					changed.push_back(path);
+				}
+			}
+		}
+	}
+	// Saving a file can produce several events, reload it once
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+	for(const std::string& path : changed){
+		std::vector<std::pair<const void*,std::function<void()>>> callbacks;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			callbacks = m_files[path].callbacks;
+		}
+		// Run without the lock, callbacks may Watch new files
+		std::cout << "FileWatcher: " << path << " changed" << std::endl;
+		for(const auto& [owner, callback] : callbacks){
+			callback();
+		}
+	}
+}
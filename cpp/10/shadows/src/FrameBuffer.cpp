@@ -7,6 +7,7 @@
 
 #include "Framebuffer.hpp"
 #include "Shader.hpp"
+#include "GLState.hpp"
 
 #include <glad/glad.h>
 
@@ -28,6 +29,9 @@ Framebuffer::Framebuffer(){
 
 // Destructor
 Framebuffer::~Framebuffer(){
+    GLState::Instance().ForgetFramebuffer(m_fbo_id);
+    GLState::Instance().ForgetVertexArray(m_quadVAO);
+    GLState::Instance().ForgetBuffer(m_quadVBO);
     glDeleteFramebuffers(1,&m_fbo_id); 
     glDeleteVertexArrays(1,&m_quadVAO);
     glDeleteBuffers(1,&m_quadVBO);
@@ -47,7 +51,7 @@ void Framebuffer::Create(int width, int height){
     Bind();
     // Create a color attachment texture
     glGenTextures(1, &m_colorBuffer_id);
-    glBindTexture(GL_TEXTURE_2D, m_colorBuffer_id);
+    GLState::Instance().BindTexture(0, m_colorBuffer_id);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL); 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -62,7 +66,7 @@ void Framebuffer::Create(int width, int height){
 }
 // Select our framebuffer
 void Framebuffer::Bind(){
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo_id);
+    GLState::Instance().BindFramebuffer(m_fbo_id);
 }
 
 // Update our framebuffer once per frame for any
@@ -80,15 +84,15 @@ void Framebuffer::Update(){
 
 // Done with our framebuffer
 void Framebuffer::Unbind(){
-    glBindFramebuffer(GL_FRAMEBUFFER,0);
+    GLState::Instance().BindFramebuffer(0);
 }
 
 // Draws the screen quad
 // This is the actual rendering of our FBO to the screen.
 // Typically this would be called after 'update'
 void Framebuffer::DrawFBO(){
-    glBindVertexArray(m_quadVAO);
-    glBindTexture(GL_TEXTURE_2D, m_colorBuffer_id);   // use the color attachment texture as the texture of the quad plane
+    GLState::Instance().BindVertexArray(m_quadVAO);
+    GLState::Instance().BindTexture(0, m_colorBuffer_id);   // use the color attachment texture as the texture of the quad plane
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
@@ -117,9 +121,9 @@ void Framebuffer::SetupScreenQuad(float x,float y, float w, float h){
 // screen quad VAO
     glGenVertexArrays(1, &m_quadVAO);
     glGenBuffers(1, &m_quadVBO);
-    glBindVertexArray(m_quadVAO);
+    GLState::Instance().BindVertexArray(m_quadVAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quad), &quad, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
@@ -0,0 +1,170 @@
+#include "Frustum.hpp"
+
+#include "glm/geometric.hpp"
+#include "glm/common.hpp"
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64)
+    #include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+#include <cmath>
+
+Frustum::Frustum(){
+    // Planes that everything is in front of
+    for(glm::vec4& plane : m_planes){
+        plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+// Gribb and Hartmann's method: a point p is inside when
+// -w <= x,y,z <= w for (x,y,z,w) = projectionView * p, and each of those six
+// tests is a plane made from the matrix's rows.
+Frustum::Frustum(const glm::mat4& projectionView){
+    glm::vec4 rows[4];
+    for(int row=0; row < 4; ++row){
+        rows[row] = glm::vec4(projectionView[0][row], projectionView[1][row],
+                              projectionView[2][row], projectionView[3][row]);
+    }
+    for(int axis=0; axis < 3; ++axis){
+        m_planes[axis*2+0] = rows[3] + rows[axis];
+        m_planes[axis*2+1] = rows[3] - rows[axis];
+    }
+    for(glm::vec4& plane : m_planes){
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool Frustum::IsVisible(const glm::vec3& center, const glm::vec3& extent) const{
+    for(const glm::vec4& plane : m_planes){
+        // How far the box reaches towards the plane
+        glm::vec3 normal(plane);
+        float reach = glm::dot(glm::abs(normal), extent);
+        if(glm::dot(normal, center) + plane.w + reach < 0.0f){
+            return false;
+        }
+    }
+    return true;
+}
+
+// Each corner is where a side plane, a bottom or top plane, and the near
+// or far plane meet
+bool Frustum::GetBounds(glm::vec3& min, glm::vec3& max) const{
+    min = glm::vec3(INFINITY);
+    max = glm::vec3(-INFINITY);
+    for(int corner=0; corner < 8; ++corner){
+        const glm::vec4& a = m_planes[0 + (corner & 1)];
+        const glm::vec4& b = m_planes[2 + ((corner >> 1) & 1)];
+        const glm::vec4& c = m_planes[4 + ((corner >> 2) & 1)];
+        glm::vec3 bc = glm::cross(glm::vec3(b), glm::vec3(c));
+        float determinant = glm::dot(glm::vec3(a), bc);
+        if(!(std::abs(determinant) > 1e-6f)){
+            return false;
+        }
+        glm::vec3 point = -(a.w*bc + b.w*glm::cross(glm::vec3(c), glm::vec3(a)) +
+                            c.w*glm::cross(glm::vec3(a), glm::vec3(b))) / determinant;
+        if(!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)){
+            return false;
+        }
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    return true;
+}
+
+bool Frustum::IsVisible(const glm::vec3& center, float radius) const{
+    for(const glm::vec4& plane : m_planes){
+        if(glm::dot(glm::vec3(plane), center) + plane.w + radius < 0.0f){
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t Frustum::CullScalar(uint32_t count, const float* centerX, const float* centerY, const float* centerZ,
+                             const float* extentX, const float* extentY, const float* extentZ,
+                             uint8_t* visible) const{
+    uint32_t visibleCount = 0;
+    for(uint32_t i=0; i < count; ++i){
+        visible[i] = IsVisible(glm::vec3(centerX[i], centerY[i], centerZ[i]),
+                               glm::vec3(extentX[i], extentY[i], extentZ[i]));
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
+
+uint32_t Frustum::Cull(uint32_t count, const float* centerX, const float* centerY, const float* centerZ,
+                       const float* extentX, const float* extentY, const float* extentZ,
+                       uint8_t* visible) const{
+    uint32_t visibleCount = 0;
+    uint32_t i = 0;
+    // Each step tests a few boxes against one plane at a time, with the
+    // plane's components in every lane. A lane's mask is set once its box
+    // is behind a plane.
+#if defined(__AVX__)
+    for(; i+8 <= count; i+=8){
+        __m256 cx = _mm256_loadu_ps(centerX+i), cy = _mm256_loadu_ps(centerY+i), cz = _mm256_loadu_ps(centerZ+i);
+        __m256 ex = _mm256_loadu_ps(extentX+i), ey = _mm256_loadu_ps(extentY+i), ez = _mm256_loadu_ps(extentZ+i);
+        __m256 outside = _mm256_setzero_ps();
+        for(const glm::vec4& plane : m_planes){
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)),
+                                                          _mm256_mul_ps(cy, _mm256_set1_ps(plane.y))),
+                                            _mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(plane.z)),
+                                                          _mm256_set1_ps(plane.w)));
+            __m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(std::abs(plane.x))),
+                                                       _mm256_mul_ps(ey, _mm256_set1_ps(std::abs(plane.y)))),
+                                         _mm256_mul_ps(ez, _mm256_set1_ps(std::abs(plane.z))));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+        int mask = _mm256_movemask_ps(outside);
+        for(int lane=0; lane < 8; ++lane){
+            visible[i+lane] = !((mask >> lane) & 1);
+            visibleCount += visible[i+lane];
+        }
+    }
+#elif defined(__SSE__) || defined(_M_X64)
+    for(; i+4 <= count; i+=4){
+        __m128 cx = _mm_loadu_ps(centerX+i), cy = _mm_loadu_ps(centerY+i), cz = _mm_loadu_ps(centerZ+i);
+        __m128 ex = _mm_loadu_ps(extentX+i), ey = _mm_loadu_ps(extentY+i), ez = _mm_loadu_ps(extentZ+i);
+        __m128 outside = _mm_setzero_ps();
+        for(const glm::vec4& plane : m_planes){
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)),
+                                                    _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+                                         _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)),
+                                                    _mm_set1_ps(plane.w)));
+            __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::abs(plane.x))),
+                                                 _mm_mul_ps(ey, _mm_set1_ps(std::abs(plane.y)))),
+                                      _mm_mul_ps(ez, _mm_set1_ps(std::abs(plane.z))));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+        }
+        int mask = _mm_movemask_ps(outside);
+        for(int lane=0; lane < 4; ++lane){
+            visible[i+lane] = !((mask >> lane) & 1);
+            visibleCount += visible[i+lane];
+        }
+    }
+#elif defined(__ARM_NEON)
+    for(; i+4 <= count; i+=4){
+        float32x4_t cx = vld1q_f32(centerX+i), cy = vld1q_f32(centerY+i), cz = vld1q_f32(centerZ+i);
+        float32x4_t ex = vld1q_f32(extentX+i), ey = vld1q_f32(extentY+i), ez = vld1q_f32(extentZ+i);
+        uint32x4_t outside = vdupq_n_u32(0);
+        for(const glm::vec4& plane : m_planes){
+            float32x4_t distance = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(plane.w), cx, plane.x), cy, plane.y), cz, plane.z);
+            float32x4_t reach = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(ex, std::abs(plane.x)), ey, std::abs(plane.y)), ez, std::abs(plane.z));
+            outside = vorrq_u32(outside, vcltq_f32(vaddq_f32(distance, reach), vdupq_n_f32(0.0f)));
+        }
+        uint32_t lanes[4];
+        vst1q_u32(lanes, outside);
+        for(int lane=0; lane < 4; ++lane){
+            visible[i+lane] = lanes[lane] == 0;
+            visibleCount += visible[i+lane];
+        }
+    }
+#endif
+    // What is left over
+    return visibleCount + CullScalar(count-i, centerX+i, centerY+i, centerZ+i,
+                                     extentX+i, extentY+i, extentZ+i, visible+i);
+}
@@ -0,0 +1,155 @@
+#include "GLState.hpp"
+
+#include <sstream>
+#include <iomanip>
+
+uint64_t GLState::Stats::Requested() const{
+    uint64_t total = 0;
+    for(uint64_t calls : requested){
+        total += calls;
+    }
+    return total;
+}
+
+uint64_t GLState::Stats::Issued() const{
+    uint64_t total = 0;
+    for(uint64_t calls : issued){
+        total += calls;
+    }
+    return total;
+}
+
+void GLState::SetCapability(Kind kind, GLenum capability, bool enabled){
+    Issue(kind, 1);
+    if(enabled){
+        glEnable(capability);
+    }else{
+        glDisable(capability);
+    }
+}
+
+void GLState::SetDepthState(const DepthState& state){
+    Count(DEPTH, 3);
+    bool all = !m_depthKnown || !m_filtering;
+    if(all || m_depth.test != state.test){
+        SetCapability(DEPTH, GL_DEPTH_TEST, state.test);
+    }
+    if(all || m_depth.write != state.write){
+        Issue(DEPTH, 1);
+        glDepthMask(state.write ? GL_TRUE : GL_FALSE);
+    }
+    if(all || m_depth.func != state.func){
+        Issue(DEPTH, 1);
+        glDepthFunc(state.func);
+    }
+    m_depthKnown = true;
+    m_depth = state;
+}
+
+void GLState::SetBlendState(const BlendState& state){
+    Count(BLEND, 2);
+    bool all = !m_blendKnown || !m_filtering;
+    if(all || m_blend.enabled != state.enabled){
+        SetCapability(BLEND, GL_BLEND, state.enabled);
+    }
+    if(all || m_blend.source != state.source || m_blend.destination != state.destination){
+        Issue(BLEND, 1);
+        glBlendFunc(state.source, state.destination);
+    }
+    m_blendKnown = true;
+    m_blend = state;
+}
+
+void GLState::SetRasterState(const RasterState& state){
+    Count(RASTER, 3);
+    bool all = !m_rasterKnown || !m_filtering;
+    if(all || m_raster.polygonMode != state.polygonMode){
+        Issue(RASTER, 1);
+        glPolygonMode(GL_FRONT_AND_BACK, state.polygonMode);
+    }
+    if(all || m_raster.cull != state.cull){
+        SetCapability(RASTER, GL_CULL_FACE, state.cull);
+    }
+    if(all || m_raster.cullFace != state.cullFace){
+        Issue(RASTER, 1);
+        glCullFace(state.cullFace);
+    }
+    m_rasterKnown = true;
+    m_raster = state;
+}
+
+// OpenGL binds 0 in place of a deleted object
+void GLState::ForgetProgram(GLuint program){
+    if(m_program == program){
+        m_program = UNKNOWN;
+    }
+}
+
+void GLState::ForgetVertexArray(GLuint vertexArray){
+    if(m_vertexArray == vertexArray){
+        m_vertexArray = UNKNOWN;
+        m_buffers[ELEMENT_ARRAY] = UNKNOWN;
+    }
+}
+
+void GLState::ForgetBuffer(GLuint buffer){
+    for(GLuint& bound : m_buffers){
+        if(bound == buffer){
+            bound = UNKNOWN;
+        }
+    }
+}
+
+void GLState::ForgetTexture(GLuint texture){
+    for(GLuint& bound : m_textures){
+        if(bound == texture){
+            bound = UNKNOWN;
+        }
+    }
+}
+
+void GLState::ForgetFramebuffer(GLuint framebuffer){
+    if(m_framebuffer == framebuffer){
+        m_framebuffer = UNKNOWN;
+    }
+}
+
+void GLState::Invalidate(){
+    m_program = UNKNOWN;
+    m_vertexArray = UNKNOWN;
+    for(GLuint& bound : m_buffers){
+        bound = UNKNOWN;
+    }
+    m_activeUnit = UNKNOWN;
+    for(GLuint& bound : m_textures){
+        bound = UNKNOWN;
+    }
+    m_framebuffer = UNKNOWN;
+    m_viewportKnown = false;
+    m_clearColorKnown = false;
+    m_depthKnown = false;
+    m_blendKnown = false;
+    m_rasterKnown = false;
+}
+
+std::string GLState::StatsToString() const{
+    static const char* names[KIND_COUNT] = {
+        "program", "vertex array", "buffer", "texture", "framebuffer",
+        "viewport", "clear color", "depth", "blend", "raster"
+    };
+    std::ostringstream out;
+    for(int kind=0; kind < KIND_COUNT; ++kind){
+        if(m_stats.requested[kind] == 0){
+            continue;
+        }
+        out << std::left << std::setw(14) << names[kind] << std::right
+            << std::setw(8) << m_stats.requested[kind] << " asked for"
+            << std::setw(8) << m_stats.issued[kind] << " made"
+            << std::setw(8) << m_stats.requested[kind]-m_stats.issued[kind] << " skipped\n";
+    }
+    out << std::left << std::setw(14) << "total" << std::right
+        << std::setw(8) << m_stats.Requested() << " asked for"
+        << std::setw(8) << m_stats.Issued() << " made"
+        << std::setw(8) << m_stats.Requested()-m_stats.Issued() << " skipped\n";
+    return out.str();
+}
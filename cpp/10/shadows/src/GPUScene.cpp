@@ -0,0 +1,236 @@
+#include "GPUScene.hpp"
+#include "GLState.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "RenderQueue.hpp"
+
+#include <iostream>
+#include <cstring>
+
+// From OpenGL 4.3, which glad's 3.3 header does not have
+#define COMPUTE_SHADER                  0x91B9
+#define SHADER_STORAGE_BUFFER           0x90D2
+#define DRAW_INDIRECT_BUFFER            0x8F3F
+#define VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define COMMAND_BARRIER_BIT             0x00000040
+typedef void (APIENTRYP DispatchComputeProc)(GLuint x, GLuint y, GLuint z);
+typedef void (APIENTRYP MemoryBarrierProc)(GLbitfield barriers);
+typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void* indirect,
+                                                       GLsizei drawCount, GLsizei stride);
+static DispatchComputeProc s_dispatchCompute = nullptr;
+static MemoryBarrierProc s_memoryBarrier = nullptr;
+static MultiDrawElementsIndirectProc s_multiDrawElementsIndirect = nullptr;
+
+// Objects culled by one work group of cull.comp
+static const GLuint WORK_GROUP_SIZE = 64;
+
+bool GPUScene::Enable(GLADloadproc load){
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if(major < 4 || (major == 4 && minor < 3)){
+        return false;
+    }
+    s_dispatchCompute = (DispatchComputeProc)load("glDispatchCompute");
+    s_memoryBarrier = (MemoryBarrierProc)load("glMemoryBarrier");
+    s_multiDrawElementsIndirect = (MultiDrawElementsIndirectProc)load("glMultiDrawElementsIndirect");
+    return IsSupported();
+}
+
+bool GPUScene::IsSupported(){
+    return s_dispatchCompute != nullptr && s_memoryBarrier != nullptr && s_multiDrawElementsIndirect != nullptr;
+}
+
+GPUScene::GPUScene(){
+}
+
+GPUScene::~GPUScene(){
+    GLState& state = GLState::Instance();
+    if(m_vertexArray != 0){
+        GLuint buffers[] = {m_vertexBuffer, m_indexBuffer, m_objectBuffer, m_commandBuffer, m_instanceBuffer};
+        state.ForgetVertexArray(m_vertexArray);
+        for(GLuint buffer : buffers){
+            state.ForgetBuffer(buffer);
+        }
+        glDeleteVertexArrays(1, &m_vertexArray);
+        glDeleteBuffers(5, buffers);
+    }
+    if(m_cullProgram != 0){
+        state.ForgetProgram(m_cullProgram);
+        glDeleteProgram(m_cullProgram);
+    }
+}
+
+uint32_t GPUScene::AddMesh(const float* vertices, uint32_t floatCount, const unsigned int* indices, uint32_t indexCount){
+    Mesh mesh;
+    mesh.bounds = Bounds::FromPoints(vertices, floatCount/8, 8);
+    mesh.firstIndex = m_indices.size();
+    mesh.indexCount = indexCount;
+    mesh.baseVertex = m_vertices.size()/8;
+    mesh.objectCount = 0;
+    m_vertices.insert(m_vertices.end(), vertices, vertices+floatCount);
+    m_indices.insert(m_indices.end(), indices, indices+indexCount);
+    m_meshes.push_back(mesh);
+    m_built = false;
+    return m_meshes.size()-1;
+}
+
+void GPUScene::AddObject(uint32_t mesh, TransformHandle transform){
+    const Bounds& bounds = m_meshes[mesh].bounds;
+    ObjectData object;
+    object.model = glm::mat4(1.0f);
+    float meshBits;
+    std::memcpy(&meshBits, &mesh, sizeof(mesh));
+    object.center = glm::vec4(bounds.Center(), meshBits);
+    object.extent = glm::vec4(bounds.Extent(), 0.0f);
+    m_objects.push_back(object);
+    m_transforms.push_back(transform);
+    m_meshes[mesh].objectCount++;
+    m_built = false;
+}
+
+bool GPUScene::Build(){
+    if(m_failed){
+        return false;
+    }
+    GLState& state = GLState::Instance();
+    if(m_cullProgram == 0){
+        std::string source = PreprocessShader("./shaders/cull.comp", ShaderDefines());
+        const char* text = source.c_str();
+        GLuint shader = glCreateShader(COMPUTE_SHADER);
+        glShaderSource(shader, 1, &text, nullptr);
+        glCompileShader(shader);
+        char log[1024];
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if(compiled != GL_TRUE){
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            std::cout << "[GPUScene] cull.comp did not compile:\n" << log << std::endl;
+            glDeleteShader(shader);
+            m_failed = true;
+            return false;
+        }
+        GLuint program = glCreateProgram();
+        glAttachShader(program, shader);
+        glLinkProgram(program);
+        glDeleteShader(shader);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(linked != GL_TRUE){
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            std::cout << "[GPUScene] cull.comp did not link:\n" << log << std::endl;
+            glDeleteProgram(program);
+            m_failed = true;
+            return false;
+        }
+        m_cullProgram = program;
+        m_planesLocation = glGetUniformLocation(m_cullProgram, "u_planes");
+        m_objectCountLocation = glGetUniformLocation(m_cullProgram, "u_objectCount");
+    }
+    if(m_vertexArray == 0){
+        glGenVertexArrays(1, &m_vertexArray);
+        glGenBuffers(1, &m_vertexBuffer);
+        glGenBuffers(1, &m_indexBuffer);
+        glGenBuffers(1, &m_objectBuffer);
+        glGenBuffers(1, &m_commandBuffer);
+        glGenBuffers(1, &m_instanceBuffer);
+    }
+
+    // Every mesh in one vertex array, laid out as MeshMaker::Generate's
+    state.BindVertexArray(m_vertexArray);
+    state.BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size()*sizeof(float), m_vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float)*8, 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float)*8, (char*)(sizeof(float)*3));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float)*8, (char*)(sizeof(float)*6));
+    state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size()*sizeof(unsigned int), m_indices.data(), GL_STATIC_DRAW);
+    // A matrix per instance. Each draw's baseInstance starts it at its
+    // mesh's part of the buffer.
+    state.BindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_objects.size()*sizeof(glm::mat4), nullptr, GL_DYNAMIC_COPY);
+    for(GLuint column=0; column < 4; ++column){
+        GLuint location = INSTANCE_MODEL_LOCATION + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column*sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+
+    // One draw per mesh, each with room for all of its objects
+    m_commands.clear();
+    GLuint instances = 0;
+    for(const Mesh& mesh : m_meshes){
+        m_commands.push_back({mesh.indexCount, 0, mesh.firstIndex, mesh.baseVertex, instances});
+        instances += mesh.objectCount;
+    }
+    state.BindBuffer(DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glBufferData(DRAW_INDIRECT_BUFFER, m_commands.size()*sizeof(DrawCommand), m_commands.data(), GL_DYNAMIC_COPY);
+    state.BindBuffer(SHADER_STORAGE_BUFFER, m_objectBuffer);
+    glBufferData(SHADER_STORAGE_BUFFER, m_objects.size()*sizeof(ObjectData), nullptr, GL_DYNAMIC_DRAW);
+    m_built = true;
+    m_uploaded = false;
+    return true;
+}
+
+bool GPUScene::Update(const TransformHierarchy& transforms){
+    if(!m_built && !Build()){
+        return false;
+    }
+    if(m_uploaded && transforms.GetUpdatedCount() == 0){
+        return true;
+    }
+    for(uint32_t i=0; i < m_objects.size(); ++i){
+        m_objects[i].model = transforms.GetWorldMatrix(m_transforms[i]);
+    }
+    GLState::Instance().BindBuffer(SHADER_STORAGE_BUFFER, m_objectBuffer);
+    glBufferSubData(SHADER_STORAGE_BUFFER, 0, m_objects.size()*sizeof(ObjectData), m_objects.data());
+    m_uploaded = true;
+    return true;
+}
+
+void GPUScene::Cull(const Frustum& frustum){
+    if(!m_built || m_objects.empty()){
+        return;
+    }
+    GLState& state = GLState::Instance();
+    // Start every count at 0
+    state.BindBuffer(DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glBufferSubData(DRAW_INDIRECT_BUFFER, 0, m_commands.size()*sizeof(DrawCommand), m_commands.data());
+
+    state.UseProgram(m_cullProgram);
+    glUniform4fv(m_planesLocation, 6, &frustum.GetPlanes()[0][0]);
+    glUniform1ui(m_objectCountLocation, m_objects.size());
+    state.BindBufferBase(SHADER_STORAGE_BUFFER, 0, m_objectBuffer);
+    state.BindBufferBase(SHADER_STORAGE_BUFFER, 1, m_commandBuffer);
+    state.BindBufferBase(SHADER_STORAGE_BUFFER, 2, m_instanceBuffer);
+    s_dispatchCompute((m_objects.size()+WORK_GROUP_SIZE-1)/WORK_GROUP_SIZE, 1, 1);
+    // The draws read what the compute shader wrote
+    s_memoryBarrier(COMMAND_BARRIER_BIT | VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void GPUScene::Draw(Shader& instancedShader){
+    if(!m_built || m_objects.empty()){
+        return;
+    }
+    GLState& state = GLState::Instance();
+    instancedShader.Bind();
+    state.BindVertexArray(m_vertexArray);
+    state.BindBuffer(DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    s_multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, m_commands.size(), 0);
+}
+
+uint32_t GPUScene::ReadVisibleCount(){
+    if(!m_built || m_objects.empty()){
+        return 0;
+    }
+    std::vector<DrawCommand> commands(m_commands.size());
+    GLState::Instance().BindBuffer(DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glGetBufferSubData(DRAW_INDIRECT_BUFFER, 0, commands.size()*sizeof(DrawCommand), commands.data());
+    uint32_t visible = 0;
+    for(const DrawCommand& command : commands){
+        visible += command.instanceCount;
+    }
+    return visible;
+}
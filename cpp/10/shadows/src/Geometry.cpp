@@ -72,6 +72,8 @@ unsigned int Geometry::GetBufferSizeInBytes(){
 // with the corresponding vertices
 void Geometry::Gen(){
 	assert((m_vertexPositions.size()/3) == (m_textureCoords.size()/2));
+	// The bounds, for culling
+	m_bounds = Bounds::FromPoints(m_vertexPositions.data(), m_vertexPositions.size()/3, 3);
 
 	int coordsPos =0;
 	for(int i =0; i < m_vertexPositions.size()/3; ++i){
@@ -102,6 +104,11 @@ void Geometry::Gen(){
 	}
 }
 
+// Retrieves the bounds worked out by Gen
+const Bounds& Geometry::GetBounds() const{
+	return m_bounds;
+}
+
 // The big trick here, is that when we make a triangle
 // We also need to update our m_normals, tangents, and bi-tangents.
 void Geometry::MakeTriangle(unsigned int vert0, unsigned int vert1, unsigned int vert2){
@@ -1,9 +1,13 @@
 #include "Image.hpp"
+#include "VirtualFileSystem.hpp"
 #include <fstream>
 #include <iostream>
 #include <string.h>
 #include <stdio.h>
 #include <memory>
+#include <vector>
+#include <charconv>
+#include <cctype>
 
 // Constructor
 Image::Image(std::string filepath) : m_filepath(filepath){
@@ -22,57 +26,78 @@ Image::~Image (){
 
 // Little function for loading the pixel data
 // from a PPM image.
-// TODO: Expects a very specific version of PPM!
+// TODO: Only ASCII (P3) PPMs are supported!
 //
 // flip - Will flip the pixels upside down in the data
 //        If you use this be consistent.
 void Image::LoadPPM(bool flip){
 
-  // Open an input file stream for reading a file
-  std::ifstream ppmFile(m_filepath.c_str());
-  // If our file successfully opens, begin to process it.
-  if (ppmFile.is_open()){
-      // line will store one line of input
-      std::string line;
-      // Our loop invariant is to continue reading input until
-      // we reach the end of the file and it reads in a NULL character
+  // Read the whole file (from the disk, or a mounted archive)
+  std::vector<char> storage;
+  const char* p = nullptr;
+  std::size_t size = 0;
+  if(VirtualFileSystem::Instance().ReadFile(m_filepath, storage, p, size)){
+      const char* end = p + size;
       std::cout << "Reading in ppm file: " << m_filepath << std::endl;
+      // The header is the magic number, width, height and max color range,
+      // then one number per color component follows. Numbers are separated
+      // by any whitespace, and comments (# to the end of the line) may
+      // appear anywhere in the header.
+      int header[3] = {0,0,0}; // width, height, max color range
       unsigned int iteration = 0;
       unsigned int pos = 0;
-      while ( getline (ppmFile,line) ){
+      while(p < end){
+         if(isspace((unsigned char)*p)){
+            ++p;
+            continue;
+         }
          // Ignore comments in the file
-         if (line[0]=='#'){
+         if(*p=='#'){
+            while(p < end && *p!='\n'){
+               ++p;
+            }
+            continue;
+         }
+         if(iteration==0){
+            // The magic number, 'P3'
+            const char* start = p;
+            while(p < end && !isspace((unsigned char)*p)){
+               ++p;
+            }
+            magicNumber.assign(start, p-start);
+            ++iteration;
             continue;
          }
-         if(line[0]=='P'){
-            magicNumber = line;
-         }else if(iteration==1){
-            // Returns first token 
-            char *token = strtok((char*)line.c_str(), " "); 
-            m_width = atoi(token);
-            token = strtok(NULL, " ");
-            m_height = atoi(token);
-            std::cout << "PPM width,height=" << m_width << "," << m_height << "\n";	
-            if(m_width > 0 && m_height > 0){
-                m_pixelData = new uint8_t[m_width*m_height*3];
-                if(m_pixelData==NULL){
-                    std::cout << "Unable to allocate memory for ppm" << std::endl;
+         int value = 0;
+         auto [next, error] = std::from_chars(p, end, value);
+         if(error != std::errc()){
+            std::cout << "PPM not parsed correctly, unexpected '" << *p << "' in " << m_filepath << std::endl;
+            break;
+         }
+         p = next;
+         if(iteration < 4){
+            header[iteration-1] = value;
+            ++iteration;
+            if(iteration==3){
+                // Width and height
+                m_width = header[0];
+                m_height = header[1];
+                std::cout << "PPM width,height=" << m_width << "," << m_height << "\n";	
+                if(m_width > 0 && m_height > 0){
+                    m_pixelData = new uint8_t[m_width*m_height*3]();
+                 }else{
+                    std::cout << "PPM not parsed correctly, width and/or height dimensions are 0" << std::endl;
                     exit(1);
                  }
-             }else{
-                std::cout << "PPM not parsed correctly, width and/or height dimensions are 0" << std::endl;
-                exit(1);
-             }
-         }else if(iteration==2){
-            // max color range is stored here
-            // TODO: Can be stored optionally
-         }else{
-            m_pixelData[pos] = (uint8_t)atoi(line.c_str());
+            }
+            // (The max color range is assumed to be 255)
+            continue;
+         }
+         if(pos < (unsigned int)m_width*m_height*3){
+            m_pixelData[pos] = (uint8_t)value;
             ++pos;
          }
-          iteration++;
-    }             
-    ppmFile.close();
+      }
   }
   else{
       std::cout << "Unable to open ppm file:" << m_filepath << std::endl;
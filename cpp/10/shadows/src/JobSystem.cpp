@@ -0,0 +1,112 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+JobSystem::JobSystem(){
+    // The render thread is busy drawing, so leave a core for it
+    unsigned int count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    count = std::max(1u, count);
+    for(unsigned int i=0; i < count; ++i){
+        m_workers.emplace_back(&JobSystem::WorkerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem(){
+    Shutdown();
+}
+
+void JobSystem::Shutdown(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for(std::thread& worker : m_workers){
+        if(worker.joinable()){
+            worker.join();
+        }
+    }
+    m_workers.clear();
+}
+
+JobHandle JobSystem::Submit(std::function<void()> function, const std::vector<JobHandle>& dependencies){
+    JobHandle job = std::make_shared<Job>();
+    job->m_function = std::move(function);
+    m_pending++;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(const JobHandle& dependency : dependencies){
+            // Dependencies that already finished do not need to be waited on
+            if(dependency != nullptr && !dependency->m_done.load(std::memory_order_acquire)){
+                job->m_waitingOn++;
+                dependency->m_dependents.push_back(job);
+            }
+        }
+    }
+    // Drop the extra count that kept the job from running while
+    // we were still adding its dependencies
+    Release(job);
+    return job;
+}
+
+void JobSystem::Release(const JobHandle& job){
+    if(job->m_waitingOn.fetch_sub(1) == 1){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ready.push_back(job);
+        }
+        m_wake.notify_one();
+    }
+}
+
+void JobSystem::Execute(const JobHandle& job){
+    job->m_function();
+    job->m_function = nullptr;
+
+    std::vector<JobHandle> dependents;
+    {
+        // Marking the job done under the lock means Submit either sees it
+        // done, or adds itself to m_dependents before we take them here
+        std::lock_guard<std::mutex> lock(m_mutex);
+        job->m_done.store(true, std::memory_order_release);
+        dependents.swap(job->m_dependents);
+    }
+    m_wake.notify_all();
+    for(const JobHandle& dependent : dependents){
+        Release(dependent);
+    }
+    m_pending--;
+}
+
+void JobSystem::WorkerLoop(){
+    while(true){
+        JobHandle job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this](){ return m_quit || !m_ready.empty(); });
+            if(m_ready.empty()){
+                return; // Quitting, and nothing is left to do
+            }
+            job = std::move(m_ready.front());
+            m_ready.pop_front();
+        }
+        Execute(job);
+    }
+}
+
+void JobSystem::Wait(const JobHandle& job){
+    while(job != nullptr && !job->IsDone()){
+        JobHandle other;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if(m_ready.empty()){
+                // Nothing to help with, sleep until some job finishes
+                m_wake.wait(lock, [&](){ return job->m_done.load() || !m_ready.empty(); });
+                continue;
+            }
+            other = std::move(m_ready.front());
+            m_ready.pop_front();
+        }
+        Execute(other);
+    }
+}
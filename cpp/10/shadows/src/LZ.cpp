@@ -0,0 +1,182 @@
+#include "LZ.hpp"
+
+#include <cstring>
+#include <cstdint>
+
+// Shortest match worth encoding
+static constexpr std::size_t MIN_MATCH = 4;
+// The format requires the last 5 bytes to be literals, and the last
+// match to start at least 12 bytes before the end
+static constexpr std::size_t LAST_LITERALS = 5;
+static constexpr std::size_t MATCH_FIND_LIMIT = 12;
+// Matches can reach back at most this far (offsets are 16 bit)
+static constexpr std::size_t MAX_OFFSET = 65535;
+static constexpr int HASH_BITS = 16;
+
+static inline uint32_t Read32(const char* p){
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t Hash(uint32_t sequence){
+    return (sequence * 2654435761u) >> (32-HASH_BITS);
+}
+
+// Writes a length that did not fit in the token (15 or more)
+static inline void WriteLength(std::vector<char>& out, std::size_t length){
+    while(length >= 255){
+        out.push_back((char)255);
+        length -= 255;
+    }
+    out.push_back((char)length);
+}
+
+static void WriteSequence(std::vector<char>& out, const char* literals, std::size_t literalCount,
+                          std::size_t offset, std::size_t matchLength){
+    std::size_t matchCode = matchLength >= MIN_MATCH ? matchLength-MIN_MATCH : 0;
+    uint8_t token = (uint8_t)((literalCount < 15 ? literalCount : 15) << 4);
+    token |= (uint8_t)(matchCode < 15 ? matchCode : 15);
+    out.push_back((char)token);
+    if(literalCount >= 15){
+        WriteLength(out, literalCount-15);
+    }
+    out.insert(out.end(), literals, literals+literalCount);
+    if(matchLength == 0){
+        return; // The final, literals only, sequence
+    }
+    out.push_back((char)(offset & 0xFF));
+    out.push_back((char)(offset >> 8));
+    if(matchCode >= 15){
+        WriteLength(out, matchCode-15);
+    }
+}
+
+std::vector<char> LZCompress(const char* data, std::size_t size){
+    std::vector<char> out;
+    out.reserve(size/2 + 16);
+
+    std::size_t anchor = 0; // Start of the literals not written yet
+    if(size > MATCH_FIND_LIMIT){
+        // Last position seen for each hashed 4 byte sequence (+1, so 0 is empty)
+        std::vector<uint32_t> table(1u << HASH_BITS, 0);
+        const std::size_t findLimit = size - MATCH_FIND_LIMIT;
+        const std::size_t matchLimit = size - LAST_LITERALS;
+        std::size_t ip = 0;
+        while(ip < findLimit){
+            uint32_t sequence = Read32(data+ip);
+            uint32_t h = Hash(sequence);
+            std::size_t candidate = table[h];
+            table[h] = (uint32_t)(ip+1);
+            if(candidate == 0 || ip-(candidate-1) > MAX_OFFSET || Read32(data+candidate-1) != sequence){
+                // No match. Skip faster through data that is not compressing.
+                ip += 1 + ((ip-anchor) >> 6);
+                continue;
+            }
+            std::size_t match = candidate-1;
+            std::size_t length = MIN_MATCH;
+            while(ip+length < matchLimit && data[match+length] == data[ip+length]){
+                ++length;
+            }
+            WriteSequence(out, data+anchor, ip-anchor, ip-match, length);
+            ip += length;
+            anchor = ip;
+            // Remember a position inside the match, helps the next search
+            if(ip-2 < findLimit){
+                table[Hash(Read32(data+ip-2))] = (uint32_t)(ip-2+1);
+            }
+        }
+    }
+    WriteSequence(out, data+anchor, size-anchor, 0, 0);
+    return out;
+}
+
+// Reads a length that did not fit in the token
+static inline bool ReadLength(const uint8_t*& ip, const uint8_t* end, std::size_t& length){
+    uint8_t byte;
+    do{
+        if(ip >= end){
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    }while(byte == 255);
+    return true;
+}
+
+// Copies in 8 byte steps, so it may write up to 7 bytes past 'end'.
+// Only used when there is that much room left in the output.
+static inline void WildCopy(char* op, const char* ip, char* end){
+    do{
+        std::memcpy(op, ip, 8);
+        op += 8;
+        ip += 8;
+    }while(op < end);
+}
+
+bool LZDecompress(const char* data, std::size_t size, char* out, std::size_t decompressedSize){
+    const uint8_t* ip = (const uint8_t*)data;
+    const uint8_t* end = ip + size;
+    char* op = out;
+    char* outEnd = out + decompressedSize;
+
+    while(ip < end){
+        uint8_t token = *ip++;
+        // Literals
+        std::size_t literalCount = token >> 4;
+        if(literalCount == 15 && !ReadLength(ip, end, literalCount)){
+            return false;
+        }
+        if(literalCount > (std::size_t)(end-ip) || literalCount > (std::size_t)(outEnd-op)){
+            return false;
+        }
+        if((std::size_t)(end-ip) >= literalCount+8 && (std::size_t)(outEnd-op) >= literalCount+8){
+            WildCopy(op, (const char*)ip, op+literalCount);
+        }else{
+            std::memcpy(op, ip, literalCount);
+        }
+        ip += literalCount;
+        op += literalCount;
+        if(ip == end){
+            break; // The last sequence has no match
+        }
+
+        // Match
+        if(end-ip < 2){
+            return false;
+        }
+        std::size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        std::size_t length = token & 15;
+        if(length == 15 && !ReadLength(ip, end, length)){
+            return false;
+        }
+        length += MIN_MATCH;
+        if(offset == 0 || offset > (std::size_t)(op-out) || length > (std::size_t)(outEnd-op)){
+            return false;
+        }
+        const char* match = op - offset;
+        if(offset >= 8 && (std::size_t)(outEnd-op) >= length+8){
+            // Each 8 byte step only reads bytes that are already written
+            WildCopy(op, match, op+length);
+        }else if(length > 16 && (std::size_t)(outEnd-op) >= length+8){
+            // A short repeating pattern ('255\n255\n...' in a .ppm). It also
+            // repeats every 'period' bytes, a multiple of offset that is at
+            // least 8, so once that much is written the rest can be copied
+            // 8 bytes at a time.
+            std::size_t period = offset * ((8+offset-1)/offset);
+            for(std::size_t i=0; i < period; ++i){
+                op[i] = match[i];
+            }
+            WildCopy(op+period, op, op+length);
+        }else{
+            // The match overlaps what it is producing (e.g. a run of
+            // one repeated byte), so it has to go one byte at a time
+            for(std::size_t i=0; i < length; ++i){
+                op[i] = match[i];
+            }
+        }
+        op += length;
+    }
+    return op == outEnd;
+}
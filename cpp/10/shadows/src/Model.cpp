@@ -0,0 +1,123 @@
+#include "Model.hpp"
+#include "TextureManager.hpp"
+#include "GLState.hpp"
+
+#include <iostream>
+#include <cstring>
+
+Model::Model(){
+}
+
+Model::Model(std::string filename){
+    // Parse the .obj, using every core we have
+    Mesh mesh(filename, 0);
+    if(mesh.GetTriangleCount() == 0){
+        std::cout << "Model: no triangles in " << filename << std::endl;
+        return;
+    }
+    // Feed each material's diffuse map to the texture manager, which
+    // makes sure each file is only loaded once
+    std::vector<std::shared_ptr<Texture>> diffuseMaps;
+    for(const Material& material : mesh.materials){
+        if(material.diffuseMap.empty()){
+            diffuseMaps.push_back(nullptr);
+        }else{
+            diffuseMaps.push_back(TextureManager::Instance().GetTexture(material.diffuseMap));
+        }
+    }
+    Upload(mesh, diffuseMaps);
+}
+
+void Model::Upload(const Mesh& mesh, const std::vector<std::shared_ptr<Texture>>& materialDiffuseMaps){
+    std::memcpy(m_boundsMin, mesh.boundsMin, sizeof(m_boundsMin));
+    std::memcpy(m_boundsMax, mesh.boundsMax, sizeof(m_boundsMax));
+
+    m_subsets = mesh.subsets;
+    m_diffuseMaps.clear();
+    for(const MeshSubset& subset : m_subsets){
+        m_diffuseMaps.push_back(materialDiffuseMaps[subset.material]);
+    }
+
+    // When reloading, the old buffers are released once the new ones exist
+    GLuint oldVAO = m_VAOId;
+    GLuint oldBuffers[2] = {m_vertexBuffer, m_indexBufferObject};
+
+    // VertexArrays
+    glGenVertexArrays(1, &m_VAOId);
+    GLState::Instance().BindVertexArray(m_VAOId);
+
+    // Vertex Buffer Object (VBO)
+    glGenBuffers(1, &m_vertexBuffer);
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size()*sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+
+    // Same layout as VERTEX3TN in MeshMaker
+    // Add three floats for x,y,z position
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float)*Mesh::stride, 0);
+    // Add three floats for normal coordinates
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float)*Mesh::stride, (char*)(sizeof(float)*3));
+    // Add two floats for texture coordinates
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float)*Mesh::stride, (char*)(sizeof(float)*6));
+
+    // Setup an index buffer (IBO)
+    glGenBuffers(1, &m_indexBufferObject);
+    GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size()*sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+
+    GLState::Instance().BindVertexArray(0);
+
+    if(oldVAO != 0){
+        GLState::Instance().ForgetVertexArray(oldVAO);
+        GLState::Instance().ForgetBuffer(oldBuffers[0]);
+        GLState::Instance().ForgetBuffer(oldBuffers[1]);
+        glDeleteVertexArrays(1, &oldVAO);
+        glDeleteBuffers(2, oldBuffers);
+    }
+}
+
+Model::~Model(){
+    GLState::Instance().ForgetVertexArray(m_VAOId);
+    GLState::Instance().ForgetBuffer(m_vertexBuffer);
+    GLState::Instance().ForgetBuffer(m_indexBufferObject);
+    glDeleteVertexArrays(1, &m_VAOId);
+    glDeleteBuffers(1, &m_vertexBuffer);
+    glDeleteBuffers(1, &m_indexBufferObject);
+}
+
+bool Model::IsReady() const{
+    if(m_VAOId == 0){
+        return false;
+    }
+    for(const std::shared_ptr<Texture>& texture : m_diffuseMaps){
+        if(texture != nullptr && !texture->IsReady()){
+            return false;
+        }
+    }
+    return true;
+}
+
+void Model::RenderMesh(){
+    if(m_VAOId == 0){
+        // Still loading
+        return;
+    }
+    GLState::Instance().BindVertexArray(m_VAOId);
+    const Texture* bound = nullptr;
+    for(std::size_t i=0; i < m_subsets.size(); ++i){
+        // Materials sharing a texture are next to each other,
+        // so only bind when it actually changes. (A material
+        // without a diffuse map keeps whatever was bound.)
+        const Texture* texture = m_diffuseMaps[i].get();
+        if(texture != nullptr && texture->IsReady() && texture != bound){
+            texture->Bind(0);
+            bound = texture;
+        }
+        glDrawElements(GL_TRIANGLES,
+                       m_subsets[i].indexCount,
+                       GL_UNSIGNED_INT,
+                       (void*)(sizeof(unsigned int)*m_subsets[i].indexOffset));
+    }
+}
@@ -11,6 +11,11 @@ Object::~Object(){
     
 }
 
+// The bounds of our geometry
+const Bounds& Object::GetBounds() const{
+    return m_geometry.GetBounds();
+}
+
 // TODO: In the future it may be good to 
 // think about loading a 'default' texture
 // if the user forgets to do this action!
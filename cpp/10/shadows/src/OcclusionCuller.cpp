@@ -0,0 +1,379 @@
+#include "OcclusionCuller.hpp"
+#include "JobSystem.hpp"
+
+#if defined(__SSE__) || defined(_M_X64)
+    #include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr uint32_t TILES_X = OcclusionCuller::WIDTH/OcclusionCuller::TILE_WIDTH;
+static constexpr uint32_t TILES_Y = OcclusionCuller::HEIGHT/OcclusionCuller::TILE_HEIGHT;
+static_assert(TILES_X*OcclusionCuller::TILE_WIDTH == OcclusionCuller::WIDTH &&
+              TILES_Y*OcclusionCuller::TILE_HEIGHT == OcclusionCuller::HEIGHT, "The tiles must fill the depth buffer");
+static_assert(OcclusionCuller::TILE_WIDTH % 4 == 0, "A tile's rows are drawn 4 pixels at a time");
+
+// Triangles are clipped against the near plane, and against these planes
+// a little outside the screen, which keeps the screen positions small
+// enough for float edge functions. (Past the screen, they are only for
+// the bounding boxes.) Each is a plane in clip space, kept where
+// dot(plane, position) >= 0.
+static const float GUARD_BAND = 2.0f;
+static const glm::vec4 CLIP_PLANES[] = {
+    glm::vec4( 0.0f,  0.0f, 1.0f, 1.0f),           // near: z >= -w
+    glm::vec4( 1.0f,  0.0f, 0.0f, GUARD_BAND),     // x >= -2w
+    glm::vec4(-1.0f,  0.0f, 0.0f, GUARD_BAND),     // x <= 2w
+    glm::vec4( 0.0f,  1.0f, 0.0f, GUARD_BAND),     // y >= -2w
+    glm::vec4( 0.0f, -1.0f, 0.0f, GUARD_BAND),     // y <= 2w
+};
+// A triangle clipped by every plane has at most this many corners
+static const int MAX_CLIPPED = 3 + sizeof(CLIP_PLANES)/sizeof(CLIP_PLANES[0]);
+// A node without bounds has extents about this big (see TransformHierarchy)
+static const float UNBOUNDED = 1e29f;
+
+OcclusionCuller::OcclusionCuller(){
+    m_bins.resize(TILES_X*TILES_Y);
+    uint32_t width = WIDTH, height = HEIGHT;
+    while(true){
+        m_mips.push_back(std::vector<float>(width*height, 1.0f));
+        m_mipWidth.push_back(width);
+        m_mipHeight.push_back(height);
+        if(width == 1 && height == 1){
+            break;
+        }
+        width = std::max(1u, width/2);
+        height = std::max(1u, height/2);
+    }
+}
+
+uint32_t OcclusionCuller::AddOccluder(const float* vertices, uint32_t vertexCount, uint32_t stride,
+                                      const unsigned int* indices, uint32_t indexCount, TransformHandle transform){
+    Occluder occluder;
+    occluder.firstVertex = m_vertices.size();
+    occluder.vertexCount = vertexCount;
+    occluder.firstIndex = m_indices.size();
+    occluder.indexCount = indexCount;
+    occluder.transform = transform;
+    for(uint32_t i=0; i < vertexCount; ++i){
+        m_vertices.push_back(glm::vec3(vertices[i*stride+0], vertices[i*stride+1], vertices[i*stride+2]));
+    }
+    m_indices.insert(m_indices.end(), indices, indices+indexCount);
+    m_occluders.push_back(occluder);
+    return m_occluders.size()-1;
+}
+
+void OcclusionCuller::ClearOccluders(){
+    m_occluders.clear();
+    m_vertices.clear();
+    m_indices.clear();
+}
+
+void OcclusionCuller::Rasterize(const glm::mat4& projectionView, const TransformHierarchy& transforms){
+    m_projectionView = projectionView;
+    m_triangles.clear();
+    for(std::vector<uint32_t>& bin : m_bins){
+        bin.clear();
+    }
+    for(const Occluder& occluder : m_occluders){
+        if(!transforms.IsVisible(occluder.transform)){
+            continue;
+        }
+        glm::mat4 toClip = projectionView * transforms.GetWorldMatrix(occluder.transform);
+        m_clip.resize(occluder.vertexCount);
+        for(uint32_t i=0; i < occluder.vertexCount; ++i){
+            m_clip[i] = toClip * glm::vec4(m_vertices[occluder.firstVertex+i], 1.0f);
+        }
+        const uint32_t* indices = m_indices.data() + occluder.firstIndex;
+        for(uint32_t i=0; i+2 < occluder.indexCount; i+=3){
+            AddTriangle(m_clip[indices[i]], m_clip[indices[i+1]], m_clip[indices[i+2]]);
+        }
+    }
+
+    if(m_parallel){
+        std::vector<JobHandle> jobs;
+        jobs.reserve(m_bins.size());
+        for(uint32_t tile=0; tile < m_bins.size(); ++tile){
+            jobs.push_back(JobSystem::Instance().Submit([this, tile](){
+                RasterizeTile(tile);
+            }));
+        }
+        for(const JobHandle& job : jobs){
+            JobSystem::Instance().Wait(job);
+        }
+    }else{
+        for(uint32_t tile=0; tile < m_bins.size(); ++tile){
+            RasterizeTile(tile);
+        }
+    }
+    BuildMips();
+}
+
+// Sutherland-Hodgman, one plane at a time, skipping the planes every
+// corner is inside of
+void OcclusionCuller::AddTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c){
+    glm::vec4 polygon[MAX_CLIPPED] = {a, b, c};
+    int count = 3;
+    for(const glm::vec4& plane : CLIP_PLANES){
+        float distance[MAX_CLIPPED];
+        bool anyOutside = false, anyInside = false;
+        for(int i=0; i < count; ++i){
+            distance[i] = glm::dot(plane, polygon[i]);
+            anyOutside = anyOutside || distance[i] < 0.0f;
+            anyInside = anyInside || distance[i] >= 0.0f;
+        }
+        if(!anyInside){
+            return;
+        }
+        if(!anyOutside){
+            continue;
+        }
+        glm::vec4 clipped[MAX_CLIPPED];
+        int clippedCount = 0;
+        for(int i=0; i < count; ++i){
+            int next = (i+1) % count;
+            if(distance[i] >= 0.0f){
+                clipped[clippedCount++] = polygon[i];
+            }
+            // The edge crosses the plane
+            if((distance[i] >= 0.0f) != (distance[next] >= 0.0f)){
+                float t = distance[i] / (distance[i] - distance[next]);
+                clipped[clippedCount++] = polygon[i] + (polygon[next]-polygon[i])*t;
+            }
+        }
+        count = clippedCount;
+        std::copy(clipped, clipped+count, polygon);
+    }
+    for(int i=1; i+1 < count; ++i){
+        SetupTriangle(polygon[0], polygon[i], polygon[i+1]);
+    }
+}
+
+void OcclusionCuller::SetupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c){
+    // To pixels, with depth
+    glm::vec3 screen[3];
+    const glm::vec4* corners[3] = {&a, &b, &c};
+    for(int i=0; i < 3; ++i){
+        const glm::vec4& clip = *corners[i];
+        screen[i] = glm::vec3((clip.x/clip.w*0.5f + 0.5f)*WIDTH, (clip.y/clip.w*0.5f + 0.5f)*HEIGHT, clip.z/clip.w);
+    }
+    float minX = std::min({screen[0].x, screen[1].x, screen[2].x});
+    float maxX = std::max({screen[0].x, screen[1].x, screen[2].x});
+    float minY = std::min({screen[0].y, screen[1].y, screen[2].y});
+    float maxY = std::max({screen[0].y, screen[1].y, screen[2].y});
+    if(maxX < 0.0f || maxY < 0.0f || minX >= (float)WIDTH || minY >= (float)HEIGHT){
+        return;
+    }
+    glm::vec3 u = screen[1]-screen[0];
+    glm::vec3 v = screen[2]-screen[0];
+    // Twice the area, negative when the triangle faces away
+    float area = u.x*v.y - u.y*v.x;
+    if(std::abs(area) < 1e-6f){
+        return;
+    }
+    Triangle triangle;
+    // Edge i runs from corner i to the next. Flipping the back facing
+    // triangles' edges makes the inside positive either way.
+    // The edges are tested at pixel centers, and moved in by half a pixel
+    // (along their normal, measured in a and b), so that only pixels the
+    // triangle covers all of pass: a pixel it only partly covers may show
+    // what is behind it.
+    float facing = area > 0.0f ? 1.0f : -1.0f;
+    for(int i=0; i < 3; ++i){
+        const glm::vec3& from = screen[i];
+        const glm::vec3& to = screen[(i+1)%3];
+        triangle.edgeA[i] = (from.y - to.y)*facing;
+        triangle.edgeB[i] = (to.x - from.x)*facing;
+        triangle.edgeC[i] = ((to.y - from.y)*from.x - (to.x - from.x)*from.y)*facing -
+                            (std::abs(triangle.edgeA[i]) + std::abs(triangle.edgeB[i]))*0.5f;
+    }
+    // The plane through the three corners, solved for depth, and moved
+    // back to its farthest within a pixel (for the same reason)
+    glm::vec3 normal = glm::cross(u, v);
+    triangle.depth.x = -normal.x/normal.z;
+    triangle.depth.y = -normal.y/normal.z;
+    triangle.depth.z = screen[0].z - triangle.depth.x*screen[0].x - triangle.depth.y*screen[0].y +
+                       (std::abs(triangle.depth.x) + std::abs(triangle.depth.y))*0.5f;
+    triangle.minX = std::max(0, (int)std::floor(minX));
+    triangle.minY = std::max(0, (int)std::floor(minY));
+    triangle.maxX = std::min((int)WIDTH-1, (int)std::ceil(maxX));
+    triangle.maxY = std::min((int)HEIGHT-1, (int)std::ceil(maxY));
+
+    uint32_t index = m_triangles.size();
+    m_triangles.push_back(triangle);
+    for(int tileY = triangle.minY/TILE_HEIGHT; tileY <= triangle.maxY/(int)TILE_HEIGHT; ++tileY){
+        for(int tileX = triangle.minX/TILE_WIDTH; tileX <= triangle.maxX/(int)TILE_WIDTH; ++tileX){
+            m_bins[tileY*TILES_X + tileX].push_back(index);
+        }
+    }
+}
+
+void OcclusionCuller::RasterizeTile(uint32_t tile){
+    int tileX0 = (tile % TILES_X)*TILE_WIDTH;
+    int tileY0 = (tile / TILES_X)*TILE_HEIGHT;
+    int tileX1 = tileX0 + TILE_WIDTH - 1;
+    int tileY1 = tileY0 + TILE_HEIGHT - 1;
+    float* depth = m_mips[0].data();
+    for(int y=tileY0; y <= tileY1; ++y){
+        std::fill(depth + y*WIDTH + tileX0, depth + y*WIDTH + tileX1 + 1, 1.0f);
+    }
+
+    for(uint32_t index : m_bins[tile]){
+        const Triangle& t = m_triangles[index];
+        // From a multiple of 4, so the steps stay inside the tile's rows
+        int x0 = std::max(t.minX, tileX0) & ~3;
+        int x1 = std::min(t.maxX, tileX1);
+        int y0 = std::max(t.minY, tileY0);
+        int y1 = std::min(t.maxY, tileY1);
+#if defined(__SSE__) || defined(_M_X64)
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 centers = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        __m128 a0 = _mm_set1_ps(t.edgeA[0]), a1 = _mm_set1_ps(t.edgeA[1]), a2 = _mm_set1_ps(t.edgeA[2]);
+        __m128 depthX = _mm_set1_ps(t.depth.x);
+        for(int y=y0; y <= y1; ++y){
+            float py = y + 0.5f;
+            __m128 row0 = _mm_set1_ps(t.edgeB[0]*py + t.edgeC[0]);
+            __m128 row1 = _mm_set1_ps(t.edgeB[1]*py + t.edgeC[1]);
+            __m128 row2 = _mm_set1_ps(t.edgeB[2]*py + t.edgeC[2]);
+            __m128 rowDepth = _mm_set1_ps(t.depth.y*py + t.depth.z);
+            float* row = depth + y*WIDTH;
+            for(int x=x0; x <= x1; x+=4){
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x), centers);
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), row0), zero),
+                                                      _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), row1), zero)),
+                                           _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), row2), zero));
+                __m128 old = _mm_loadu_ps(row+x);
+                __m128 nearer = _mm_min_ps(old, _mm_add_ps(_mm_mul_ps(depthX, px), rowDepth));
+                _mm_storeu_ps(row+x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            }
+        }
+#elif defined(__ARM_NEON)
+        const float centerValues[4] = {0.5f, 1.5f, 2.5f, 3.5f};
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t centers = vld1q_f32(centerValues);
+        for(int y=y0; y <= y1; ++y){
+            float py = y + 0.5f;
+            float32x4_t row0 = vdupq_n_f32(t.edgeB[0]*py + t.edgeC[0]);
+            float32x4_t row1 = vdupq_n_f32(t.edgeB[1]*py + t.edgeC[1]);
+            float32x4_t row2 = vdupq_n_f32(t.edgeB[2]*py + t.edgeC[2]);
+            float32x4_t rowDepth = vdupq_n_f32(t.depth.y*py + t.depth.z);
+            float* row = depth + y*WIDTH;
+            for(int x=x0; x <= x1; x+=4){
+                float32x4_t px = vaddq_f32(vdupq_n_f32((float)x), centers);
+                uint32x4_t inside = vandq_u32(vandq_u32(vcgeq_f32(vmlaq_n_f32(row0, px, t.edgeA[0]), zero),
+                                                        vcgeq_f32(vmlaq_n_f32(row1, px, t.edgeA[1]), zero)),
+                                              vcgeq_f32(vmlaq_n_f32(row2, px, t.edgeA[2]), zero));
+                float32x4_t old = vld1q_f32(row+x);
+                float32x4_t nearer = vminq_f32(old, vmlaq_n_f32(rowDepth, px, t.depth.x));
+                vst1q_f32(row+x, vbslq_f32(inside, nearer, old));
+            }
+        }
+#else
+        for(int y=y0; y <= y1; ++y){
+            float py = y + 0.5f;
+            float* row = depth + y*WIDTH;
+            for(int x=x0; x <= x1; ++x){
+                float px = x + 0.5f;
+                if(t.edgeA[0]*px + t.edgeB[0]*py + t.edgeC[0] >= 0.0f &&
+                   t.edgeA[1]*px + t.edgeB[1]*py + t.edgeC[1] >= 0.0f &&
+                   t.edgeA[2]*px + t.edgeB[2]*py + t.edgeC[2] >= 0.0f){
+                    row[x] = std::min(row[x], t.depth.x*px + t.depth.y*py + t.depth.z);
+                }
+            }
+        }
+#endif
+    }
+}
+
+void OcclusionCuller::BuildMips(){
+    for(uint32_t level=1; level < m_mips.size(); ++level){
+        const std::vector<float>& below = m_mips[level-1];
+        uint32_t belowWidth = m_mipWidth[level-1];
+        uint32_t belowHeight = m_mipHeight[level-1];
+        std::vector<float>& mip = m_mips[level];
+        for(uint32_t y=0; y < m_mipHeight[level]; ++y){
+            // (A level that is one pixel tall halves its width only)
+            uint32_t y0 = std::min(y*2, belowHeight-1), y1 = std::min(y*2+1, belowHeight-1);
+            for(uint32_t x=0; x < m_mipWidth[level]; ++x){
+                uint32_t x0 = std::min(x*2, belowWidth-1), x1 = std::min(x*2+1, belowWidth-1);
+                mip[y*m_mipWidth[level] + x] = std::max(std::max(below[y0*belowWidth + x0], below[y0*belowWidth + x1]),
+                                                        std::max(below[y1*belowWidth + x0], below[y1*belowWidth + x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible(const glm::vec3& center, const glm::vec3& extent) const{
+    if(extent.x >= UNBOUNDED || extent.y >= UNBOUNDED || extent.z >= UNBOUNDED){
+        return true;
+    }
+    // The box's corners on the screen, and the nearest of their depths
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    float nearest = INFINITY;
+    // The corners are the center plus or minus each axis, all in clip space
+    glm::vec4 middle = m_projectionView * glm::vec4(center, 1.0f);
+    glm::vec4 axisX = m_projectionView[0]*extent.x;
+    glm::vec4 axisY = m_projectionView[1]*extent.y;
+    glm::vec4 axisZ = m_projectionView[2]*extent.z;
+    for(int corner=0; corner < 8; ++corner){
+        glm::vec4 clip = middle + ((corner & 1) ? axisX : -axisX) + ((corner & 2) ? axisY : -axisY) +
+                         ((corner & 4) ? axisZ : -axisZ);
+        // Reaching past the near plane, so it may cover the whole screen
+        if(clip.z < -clip.w || clip.w <= 0.0f){
+            return true;
+        }
+        float x = (clip.x/clip.w*0.5f + 0.5f)*WIDTH;
+        float y = (clip.y/clip.w*0.5f + 0.5f)*HEIGHT;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, clip.z/clip.w);
+    }
+    if(maxX < 0.0f || maxY < 0.0f || minX >= (float)WIDTH || minY >= (float)HEIGHT){
+        return false;
+    }
+    // Every pixel it touches
+    int x0 = std::max(0, (int)std::floor(minX));
+    int y0 = std::max(0, (int)std::floor(minY));
+    int x1 = std::min((int)WIDTH-1, (int)std::floor(maxX));
+    int y1 = std::min((int)HEIGHT-1, (int)std::floor(maxY));
+    // The level where those are at most 2x2 pixels
+    uint32_t level = 0;
+    while(level+1 < m_mips.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)){
+        ++level;
+    }
+    const std::vector<float>& mip = m_mips[level];
+    uint32_t width = m_mipWidth[level];
+    for(int y = y0 >> level; y <= (y1 >> level); ++y){
+        for(int x = x0 >> level; x <= (x1 >> level); ++x){
+            // Nearer than the farthest occluder there
+            if(nearest <= mip[y*width + x]){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+uint32_t OcclusionCuller::Cull(uint32_t count, const float* centerX, const float* centerY, const float* centerZ,
+                               const float* extentX, const float* extentY, const float* extentZ,
+                               uint8_t* visible) const{
+    uint32_t visibleCount = 0;
+    for(uint32_t i=0; i < count; ++i){
+        if(visible[i]){
+            visible[i] = IsVisible(glm::vec3(centerX[i], centerY[i], centerZ[i]),
+                                   glm::vec3(extentX[i], extentY[i], extentZ[i]));
+            visibleCount += visible[i];
+        }
+    }
+    return visibleCount;
+}
+
+uint32_t OcclusionCuller::Cull(TransformHierarchy& transforms) const{
+    return Cull(transforms.GetCount(), transforms.GetWorldCenters(0), transforms.GetWorldCenters(1),
+                transforms.GetWorldCenters(2), transforms.GetWorldExtents(0), transforms.GetWorldExtents(1),
+                transforms.GetWorldExtents(2), transforms.GetVisibleFlags());
+}
@@ -0,0 +1,176 @@
+#include "ProgramCache.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <cstdio>
+
+// From OpenGL 4.1, which glad's 3.3 header does not have
+#define PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define PROGRAM_BINARY_LENGTH           0x8741
+#define NUM_PROGRAM_BINARY_FORMATS      0x87FE
+
+// Start of each file. The key is checked as well as the file name, so a
+// file copied or renamed by hand is not loaded for the wrong shaders.
+struct ProgramCacheHeader{
+    char magic[4];              // "PRGB"
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t binarySize;
+};
+
+static const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+// FNV-1a, continuing from 'hash'
+static uint64_t HashBytes(uint64_t hash, const char* data, std::size_t size){
+    for(std::size_t i=0; i < size; ++i){
+        hash ^= (uint8_t)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t HashString(uint64_t hash, const std::string& text){
+    // The terminator keeps "ab"+"c" and "a"+"bc" apart
+    return HashBytes(hash, text.c_str(), text.size()+1);
+}
+
+static uint64_t GetKey(uint64_t driverHash, const std::string& vertexSource, const std::string& fragmentSource){
+    return HashString(HashString(driverHash, vertexSource), fragmentSource);
+}
+
+bool ProgramCache::Enable(const std::string& directory, GLADloadproc load){
+    m_getProgramBinary = (GetProgramBinaryProc)load("glGetProgramBinary");
+    m_programBinary = (ProgramBinaryProc)load("glProgramBinary");
+    m_programParameteri = (ProgramParameteriProc)load("glProgramParameteri");
+    GLint formats = 0;
+    glGetIntegerv(NUM_PROGRAM_BINARY_FORMATS, &formats);
+    // glGetIntegerv does not know the name on an older driver
+    while(glGetError() != GL_NO_ERROR){}
+    if(m_getProgramBinary == nullptr || m_programBinary == nullptr ||
+       m_programParameteri == nullptr || formats <= 0){
+        std::cout << "ProgramCache: the driver cannot save programs, shaders will be compiled" << std::endl;
+        m_enabled = false;
+        return false;
+    }
+
+    // A different driver (or version) cannot load our programs
+    uint64_t hash = 14695981039346656037ull;
+    const GLenum names[4] = {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION};
+    for(GLenum name : names){
+        const GLubyte* text = glGetString(name);
+        hash = HashString(hash, text != nullptr ? (const char*)text : "");
+    }
+    hash = HashBytes(hash, (const char*)&PROGRAM_CACHE_VERSION, sizeof(PROGRAM_CACHE_VERSION));
+    m_driverHash = hash;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    m_directory = directory;
+    if(!m_directory.empty() && m_directory.back() != '/'){
+        m_directory += '/';
+    }
+    m_enabled = true;
+    return true;
+}
+
+bool ProgramCache::IsEnabled() const{
+    return m_enabled;
+}
+
+std::string ProgramCache::GetPath(const std::string& vertexSource, const std::string& fragmentSource) const{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin",
+                  (unsigned long long)GetKey(m_driverHash, vertexSource, fragmentSource));
+    return m_directory + name;
+}
+
+GLuint ProgramCache::Load(const std::string& vertexSource, const std::string& fragmentSource){
+    if(!m_enabled){
+        return 0;
+    }
+    std::string path = GetPath(vertexSource, fragmentSource);
+    std::ifstream file(path, std::ios::binary);
+    if(!file){
+        return 0;
+    }
+    // The binary is all that follows the header, so a size that says
+    // otherwise is a broken file (and is not allocated)
+    std::error_code error;
+    uintmax_t fileSize = std::filesystem::file_size(path, error);
+    ProgramCacheHeader header;
+    std::vector<char> binary;
+    bool valid = !error && file.read((char*)&header, sizeof(header)) &&
+                 std::string(header.magic, 4) == "PRGB" &&
+                 header.version == PROGRAM_CACHE_VERSION &&
+                 header.key == GetKey(m_driverHash, vertexSource, fragmentSource) &&
+                 header.binarySize > 0 && header.binarySize == fileSize - sizeof(header);
+    if(valid){
+        binary.resize(header.binarySize);
+        valid = (bool)file.read(binary.data(), binary.size());
+    }
+    file.close();
+
+    GLuint program = 0;
+    if(valid){
+        program = glCreateProgram();
+        m_programBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(linked == GL_FALSE){
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    if(program == 0){
+        // Stale or broken, it will be replaced once the shaders are compiled
+        std::cout << "ProgramCache: could not load " << path << ", compiling the shaders" << std::endl;
+        std::remove(path.c_str());
+    }
+    return program;
+}
+
+void ProgramCache::PrepareToLink(GLuint program){
+    if(m_enabled){
+        m_programParameteri(program, PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void ProgramCache::Store(const std::string& vertexSource, const std::string& fragmentSource, GLuint program){
+    if(!m_enabled){
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0){
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    m_getProgramBinary(program, length, &written, &format, binary.data());
+    if(written <= 0){
+        return;
+    }
+
+    ProgramCacheHeader header{{'P','R','G','B'}, PROGRAM_CACHE_VERSION,
+                              GetKey(m_driverHash, vertexSource, fragmentSource),
+                              format, (uint32_t)written};
+    // Written next to the file and then renamed, so a file is never read
+    // half written (e.g. if we are stopped while saving)
+    std::string path = GetPath(vertexSource, fragmentSource);
+    std::string temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::binary);
+    file.write((const char*)&header, sizeof(header));
+    file.write(binary.data(), written);
+    file.close();
+    if(!file){
+        std::cout << "ProgramCache: could not write " << temporary << std::endl;
+        std::remove(temporary.c_str());
+        return;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+}
@@ -0,0 +1,197 @@
+#include "RenderQueue.hpp"
+#include "GLState.hpp"
+
+#include "glm/geometric.hpp"
+
+#include <cstring>
+
+RenderQueue::RenderQueue(){
+}
+
+RenderQueue::~RenderQueue(){
+    if(m_instanceBuffer != 0){
+        GLState::Instance().ForgetBuffer(m_instanceBuffer);
+        glDeleteBuffers(1, &m_instanceBuffer);
+    }
+}
+
+void RenderQueue::Begin(const glm::mat4& view){
+    m_items.clear();
+    m_entries.clear();
+    // The camera looks down -z, so the depth is -z in view space
+    m_depthRow = -glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]);
+}
+
+void RenderQueue::Add(const DrawItem& item, const glm::vec3& center){
+    float depth = glm::dot(m_depthRow, glm::vec4(center, 1.0f));
+    m_entries.push_back({MakeKey(item, depth), (uint32_t)m_items.size()});
+    m_items.push_back(item);
+}
+
+uint64_t RenderQueue::MakeKey(const DrawItem& item, float depth){
+    // A positive float's bits sort the same way as the float, so the top
+    // 24 of them (below the sign) keep the order. Behind the camera is 0.
+    uint32_t depthBits = 0;
+    if(depth > 0.0f){
+        std::memcpy(&depthBits, &depth, sizeof(depth));
+        depthBits >>= 7;
+    }
+    uint64_t shader = item.shaderIndex & 0x3FF;
+    uint64_t texture = item.texture & 0xFFFF;
+    uint64_t vertexArray = item.vertexArray & 0xFFF;
+    if(item.transparent){
+        uint64_t farToNear = 0xFFFFFF - depthBits;
+        return (uint64_t)TRANSPARENT_PASS << 62 | farToNear << 38 | shader << 28 | texture << 12 | vertexArray;
+    }
+    return (uint64_t)OPAQUE_PASS << 62 | shader << 52 | texture << 36 | vertexArray << 24 | depthBits;
+}
+
+// Least significant digit first, 8 bits at a time. Each pass is stable,
+// so the earlier passes' order is kept among equal digits. Passes where
+// every key has the same digit are skipped (e.g. the pass bits, when
+// nothing is transparent).
+void RenderQueue::Sort(){
+    if(!m_sorting){
+        return;
+    }
+    uint32_t count = m_entries.size();
+    uint32_t histograms[8][256] = {};
+    for(const Entry& entry : m_entries){
+        for(int digit=0; digit < 8; ++digit){
+            histograms[digit][(entry.key >> (digit*8)) & 0xFF]++;
+        }
+    }
+    m_scratch.resize(count);
+    for(int digit=0; digit < 8; ++digit){
+        uint32_t* histogram = histograms[digit];
+        if(count == 0 || histogram[(m_entries[0].key >> (digit*8)) & 0xFF] == count){
+            continue;
+        }
+        // Where each digit's entries start
+        uint32_t offset = 0;
+        for(int bucket=0; bucket < 256; ++bucket){
+            uint32_t size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += size;
+        }
+        for(const Entry& entry : m_entries){
+            m_scratch[histogram[(entry.key >> (digit*8)) & 0xFF]++] = entry;
+        }
+        m_entries.swap(m_scratch);
+    }
+}
+
+// Two items can share an instanced draw if they only differ in their
+// model matrix
+static bool CanInstance(const DrawItem& a, const DrawItem& b){
+    return a.instancedShader != nullptr && !a.transparent && !b.transparent &&
+           a.shader == b.shader && a.instancedShader == b.instancedShader &&
+           a.vertexArray == b.vertexArray && a.texture == b.texture && a.indexCount == b.indexCount;
+}
+
+void RenderQueue::BuildBatches(){
+    m_batches.clear();
+    m_instances.clear();
+    if(!m_instancing){
+        return;
+    }
+    uint32_t count = m_entries.size();
+    uint32_t i = 0;
+    while(i < count){
+        const DrawItem& item = m_items[m_entries[i].item];
+        uint32_t end = i+1;
+        while(end < count && CanInstance(item, m_items[m_entries[end].item])){
+            ++end;
+        }
+        // One item on its own is drawn the usual way
+        if(end-i > 1){
+            m_batches.push_back({i, end-i, (uint32_t)m_instances.size()});
+            for(uint32_t j=i; j < end; ++j){
+                m_instances.push_back(*m_items[m_entries[j].item].model);
+            }
+        }
+        i = end;
+    }
+    if(m_instances.empty()){
+        return;
+    }
+    // All of the frame's matrices go up at once. Giving the buffer new
+    // storage each frame lets the driver keep the old one for draws that
+    // still read it.
+    GLState& state = GLState::Instance();
+    if(m_instanceBuffer == 0){
+        glGenBuffers(1, &m_instanceBuffer);
+    }
+    state.BindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    if(m_instances.size() > m_instanceCapacity){
+        m_instanceCapacity = m_instances.size() + m_instances.size()/2;
+    }
+    glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity*sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_instances.size()*sizeof(glm::mat4), m_instances.data());
+}
+
+void RenderQueue::Submit(){
+    GLState& state = GLState::Instance();
+    DepthState opaqueDepth;
+    opaqueDepth.test = true;
+    // Transparent items are tested against what is drawn, but do not hide
+    // each other
+    DepthState transparentDepth = opaqueDepth;
+    transparentDepth.write = false;
+    BlendState blend;
+    blend.enabled = true;
+    blend.source = GL_SRC_ALPHA;
+    blend.destination = GL_ONE_MINUS_SRC_ALPHA;
+
+    BuildBatches();
+    m_drawCount = 0;
+    bool transparent = false;
+    state.SetDepthState(opaqueDepth);
+    state.SetBlendState(BlendState());
+    uint32_t count = m_entries.size();
+    uint32_t nextBatch = 0;
+    for(uint32_t i=0; i < count; ++i){
+        const DrawItem& item = m_items[m_entries[i].item];
+        if(item.transparent != transparent){
+            transparent = item.transparent;
+            state.SetDepthState(transparent ? transparentDepth : opaqueDepth);
+            state.SetBlendState(transparent ? blend : BlendState());
+        }
+        state.BindTexture(0, item.texture);
+        state.BindVertexArray(item.vertexArray);
+        ++m_drawCount;
+        if(nextBatch < m_batches.size() && m_batches[nextBatch].first == i){
+            const Batch& batch = m_batches[nextBatch++];
+            item.instancedShader->Bind();
+            // Point the vertex array's instance attributes at this batch's
+            // matrices, one column each, moving on once per instance. (Set
+            // every time, as the vertex array may have been used for
+            // another batch, or be a new one under a reused name.)
+            state.BindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+            for(GLuint column=0; column < 4; ++column){
+                GLuint location = INSTANCE_MODEL_LOCATION + column;
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                      (void*)((batch.firstInstance*sizeof(glm::mat4)) + column*sizeof(glm::vec4)));
+                glVertexAttribDivisor(location, 1);
+            }
+            glDrawElementsInstanced(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, nullptr, batch.count);
+            // The vertex array is the mesh's own, which is drawn without
+            // instancing too, so leave it as it was
+            for(GLuint column=0; column < 4; ++column){
+                GLuint location = INSTANCE_MODEL_LOCATION + column;
+                glVertexAttribDivisor(location, 0);
+                glDisableVertexAttribArray(location);
+            }
+            i += batch.count-1;
+            continue;
+        }
+        item.shader->Bind();
+        item.shader->SetUniformMatrix4fv(item.modelUniform, &(*item.model)[0][0]);
+        glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, nullptr);
+    }
+    if(transparent){
+        state.SetDepthState(opaqueDepth);
+        state.SetBlendState(BlendState());
+    }
+}
@@ -1,10 +1,19 @@
 #include "Renderer.hpp"
+#include "GLState.hpp"
+#include "TransformHierarchy.hpp"
+#include "Frustum.hpp"
+#include "JobSystem.hpp"
+
+#include <chrono>
+#include <algorithm>
 
 
 // Sets the height and width of our renderer
 Renderer::Renderer(unsigned int w, unsigned int h){
     m_screenWidth = w;
     m_screenHeight = h;
+    // The same projection the sample uses
+    m_projection = glm::perspective(glm::radians(45.0f), (float)w/(float)h, 0.1f, 100.0f);
 
     // By default create one camera per render
     // TODO: You could abstract out further functions to create
@@ -34,19 +43,30 @@ Renderer::~Renderer(){
 }
 
 void Renderer::Update(){
-    // Here we apply the projection matrix which creates perspective.
-    // The first argument is 'field of view'
-    // Then perspective
-    // Then the near and far clipping plane.
-    // Note I cannot see anything closer than 0.1f units from the screen.
-    m_projectionMatrix = glm::perspective(glm::radians(45.0f),((float)m_screenWidth)/((float)m_screenHeight),0.1f,512.0f);
-
     // Perform the update
-    if(m_root!=nullptr){
-        // TODO: By default, we will only have one camera
-        //       You may otherwise not want to hardcode
-        //       a value of '0' here.
-        m_root->Update(m_projectionMatrix, m_cameras[0]);
+    // (The projection and view matrices for the camera are in the
+    //  FrameData uniform buffer, filled in once per frame.)
+    if(m_root!=nullptr || m_entities.GetCount() > 0){
+        // Work out the world matrices of the nodes that moved
+        TransformHierarchy::Instance().UpdateParallel();
+        // Then which nodes are in view (Update and Draw skip the others)
+        auto cullStart = std::chrono::steady_clock::now();
+        glm::mat4 frustumMatrix = m_projection * m_cameras[0]->GetWorldToViewmatrix();
+        Frustum frustum(frustumMatrix);
+        unsigned int visible = TransformHierarchy::Instance().Cull(frustum);
+        m_culled = TransformHierarchy::Instance().GetCount() - visible;
+        m_cullMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-cullStart).count();
+        // Then which of those are behind the occluders
+        m_occluded = 0;
+        if(m_occlusion.GetOccluderCount() > 0){
+            auto occlusionStart = std::chrono::steady_clock::now();
+            m_occlusion.Rasterize(frustumMatrix, TransformHierarchy::Instance());
+            m_occluded = visible - m_occlusion.Cull(TransformHierarchy::Instance());
+            m_occlusionMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-occlusionStart).count();
+        }
+        if(m_root!=nullptr){
+            m_root->Update();
+        }
     }
 }
 
@@ -69,11 +89,13 @@ void Renderer::Render(){
 
     // What we are doing, is telling opengl to create a depth(or Z-buffer) 
     // for us that is stored every frame.
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_TEXTURE_2D); 
+    // (GLState only makes the calls for what changed since last frame.)
+    DepthState depth;
+    depth.test = true;
+    GLState::Instance().SetDepthState(depth);
     // This is the background of the screen.
-    glViewport(0, 0, m_screenWidth, m_screenHeight);
-    glClearColor( 0.01f, 0.01f, 0.01f, 1.f );
+    GLState::Instance().Viewport(0, 0, m_screenWidth, m_screenHeight);
+    GLState::Instance().ClearColor( 0.01f, 0.01f, 0.01f, 1.f );
     // Clear color buffer and Depth Buffer
     // Remember that the 'depth buffer' is our
     // z-buffer that figures out how far away items are every frame
@@ -90,16 +112,28 @@ void Renderer::Render(){
     // Test to see if the 'w' key is pressed for a quick view to toggle
     // the wireframe view.
     const Uint8* currentKeyStates = SDL_GetKeyboardState( NULL );
+    RasterState raster;
     if( currentKeyStates[ SDL_SCANCODE_W ] )
     {
-        glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);
+        raster.polygonMode = GL_LINE;
     }else{
-        glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
+        raster.polygonMode = GL_FILL;
     }
+    GLState::Instance().SetRasterState(raster);
     
-    // Now we render our objects from our scenegraph
-    if(m_root!=nullptr){
-        m_root->Draw();
+    // Now we render our objects from our scenegraph: collect them, then
+    // draw them sorted by their state and depth
+    if(m_parallelRecording){
+        RecordParallel();
+        m_commandPlayer.Replay(m_commandLists);
+    }else{
+        m_queue.Begin(m_cameras[0]->GetWorldToViewmatrix());
+        if(m_root!=nullptr){
+            m_root->Draw(m_queue);
+        }
+        m_entities.Draw(m_queue);
+        m_queue.Sort();
+        m_queue.Submit();
     }
 
     // Finish with our framebuffer
@@ -107,13 +141,14 @@ void Renderer::Render(){
     // Now draw a new scene
     // We do not need depth since we are drawing a '2D'
     // image over our screen.
-    glDisable(GL_DEPTH_TEST);
+    depth.test = false;
+    GLState::Instance().SetDepthState(depth);
     // Clear everything away
     // Clear the screen color, and typically I do this
     // to something 'different' than our original as an
     // indication that I am in a FBO. But you may choose
     // to match the glClearColor
-    glClearColor(1.0f,1.0f,1.0f,1.0f);
+    GLState::Instance().ClearColor(1.0f,1.0f,1.0f,1.0f);
     // We only have 'color' in our buffer that is stored
     glClear(GL_COLOR_BUFFER_BIT); 
     // Use our new 'simple screen shader'
@@ -124,6 +159,63 @@ void Renderer::Render(){
     m_framebuffers[0]->m_fboShader->Unbind();
 }
 
+// The root's children are split into as many parts as there are threads
+// (the workers, and this one, which helps while it waits), each recorded
+// into its own list by a job, and so are the entities' rows. Replaying the
+// lists in order draws the nodes in the same order as recording them all
+// on one thread would.
+void Renderer::RecordParallel(){
+    auto recordStart = std::chrono::steady_clock::now();
+    static const std::vector<SceneNode*> noChildren;
+    const std::vector<SceneNode*>& children = m_root!=nullptr ? m_root->GetChildren() : noChildren;
+    uint32_t threads = JobSystem::Instance().GetWorkerCount()+1;
+    uint32_t parts = std::min<uint32_t>(threads, children.size());
+    uint32_t entityParts = std::min<uint32_t>(threads, m_entities.GetCount());
+    m_commandLists.resize(1+parts+entityParts);
+    m_commandLists[0].Reset();
+    if(m_root!=nullptr){
+        m_root->Record(m_commandLists[0], false);
+    }
+    std::vector<JobHandle> jobs;
+    jobs.reserve(parts+entityParts);
+    for(uint32_t part=0; part < parts; ++part){
+        uint32_t first = children.size()*part/parts;
+        uint32_t last = children.size()*(part+1)/parts;
+        CommandList* list = &m_commandLists[part+1];
+        jobs.push_back(JobSystem::Instance().Submit([&children, list, first, last](){
+            list->Reset();
+            for(uint32_t i=first; i < last; ++i){
+                children[i]->Record(*list);
+            }
+        }));
+    }
+    for(uint32_t part=0; part < entityParts; ++part){
+        uint32_t first = m_entities.GetCount()*part/entityParts;
+        uint32_t last = m_entities.GetCount()*(part+1)/entityParts;
+        CommandList* list = &m_commandLists[1+parts+part];
+        jobs.push_back(JobSystem::Instance().Submit([this, list, first, last](){
+            list->Reset();
+            m_entities.Record(*list, first, last);
+        }));
+    }
+    for(const JobHandle& job : jobs){
+        JobSystem::Instance().Wait(job);
+    }
+    m_recordMs = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-recordStart).count();
+}
+
+// The object's geometry is copied, and drawn each frame where the node is
+void Renderer::AddOccluder(SceneNode& node){
+    std::shared_ptr<Object> object = node.GetObject();
+    if(object == nullptr){
+        return;
+    }
+    Geometry& geometry = object->GetGeometry();
+    m_occlusion.AddOccluder(geometry.GetBufferDataPtr(), geometry.GetBufferDataSize()/Geometry::FLOATS_PER_VERTEX,
+                            Geometry::FLOATS_PER_VERTEX, geometry.GetIndicesDataPtr(), geometry.GetIndicesSize(),
+                            node.GetTransform());
+}
+
 // Determines what the root is of the renderer, so the
 // scene can be drawn.
 void Renderer::setRoot(std::shared_ptr<SceneNode> startingNode){
@@ -4,7 +4,17 @@
 #include "Texture.hpp"
 #include "ShaderManager.hpp"
 #include "MeshMaker.hpp"
+#include "Model.hpp"
+#include "AssetLoader.hpp"
+#include "JobSystem.hpp"
+#include "VirtualFileSystem.hpp"
+#include "FileWatcher.hpp"
 #include "FBO.hpp"
+#include "UniformBuffer.hpp"
+#include "ProgramCache.hpp"
+#include "GLState.hpp"
+#include "TransformHierarchy.hpp"
+#include "RenderQueue.hpp"
 // Include the 'Renderer.hpp' which deteremines what
 // the graphics API is going to be for OpenGL
 #include "Renderer.hpp"
@@ -19,6 +29,7 @@
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
 
 
 #include <glm/glm.hpp>
@@ -31,14 +42,25 @@ std::shared_ptr<FBO> g_depthFBO;
 std::shared_ptr<MeshMaker> g_plane;
 std::shared_ptr<MeshMaker> g_cube;
 std::shared_ptr<MeshMaker> g_light;
+std::shared_ptr<Model> g_house;
+std::shared_ptr<Model> g_tree;
+std::shared_ptr<Model> g_chapel;
+std::shared_ptr<Model> g_windmill;
+// The floor's and the cubes' model matrices. They do not move, and the
+// render queue keeps pointers to them until it draws.
+glm::mat4 g_planeModel;
+glm::mat4 g_cubeModels[3];
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
-void renderScene(const Shader &shader);
+void renderScene(RenderQueue& queue, ShaderHandle shaderHandle, ShaderHandle instancedHandle,
+                 const glm::mat4& view, GLuint texture);
 
 // Initialization function
 // Returns a true or false value based on successful completion of setup.
 // Takes in dimensions of window.
 SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
+    // Used to measure how long it takes until the first frame is shown
+    m_startTime = SDL_GetPerformanceCounter();
 	// The window we'll be rendering to
 	m_window = NULL;
 
@@ -86,6 +108,15 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
         exit(EXIT_FAILURE);
     }
 
+    // Keep linked shader programs on the disk, so that later runs do not
+    // have to compile them
+    ProgramCache::Instance().Enable("./cache/programs", SDL_GL_GetProcAddress);
+    // and build the ones that are not there in the background, if the
+    // driver can
+    if(!Shader::EnableParallelCompile(SDL_GL_GetProcAddress)){
+        SDL_Log("No KHR_parallel_shader_compile, shaders are built as they are first used");
+    }
+
     // If initialization succeeds then print out a list of errors in the constructor.
     SDL_Log("SDLGraphicsProgram::SDLGraphicsProgram - No SDL, GLAD, or OpenGL errors detected during initialization\n\n");
 
@@ -100,36 +131,74 @@ SDLGraphicsProgram::~SDLGraphicsProgram(){
 	SDL_DestroyWindow( m_window );
 	// Point m_window to NULL to ensure it points to nothing.
 	m_window = nullptr;
+    // Stop the worker threads before SDL goes away
+    JobSystem::Instance().Shutdown();
 	//Quit SDL subsystems
 	SDL_Quit();
 }
 
 
-// renders the 3D scene
+// renders a model standing on the floor at 'position', scaled so
+// that its largest side is 'size' long
 // --------------------
-void renderScene(std::string shadername)
+void renderModel(Shader& shader, UniformHandle modelUniform, const std::shared_ptr<Model>& m, glm::vec3 position, float size)
 {
+    if(m == nullptr || !m->IsReady()){
+        return;
+    }
+    glm::vec3 boundsMin = glm::make_vec3(m->GetBoundsMin());
+    glm::vec3 boundsMax = glm::make_vec3(m->GetBoundsMax());
+    glm::vec3 extent = boundsMax - boundsMin;
+    float largest = std::max(extent.x, std::max(extent.y, extent.z));
+    glm::vec3 bottomCenter((boundsMin.x+boundsMax.x)*0.5f, boundsMin.y, (boundsMin.z+boundsMax.z)*0.5f);
+
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), position + glm::vec3(0.0f,-0.5f,0.0f));
+    model = glm::scale(model, glm::vec3(largest > 0.0f ? size/largest : 1.0f));
+    model = glm::translate(model, -bottomCenter);
+    shader.SetUniformMatrix4fv(modelUniform, &model[0][0]);
+    m->RenderMesh();
+}
+
+// renders the 3D scene, seen through 'view', with the shader of
+// 'shaderHandle' (and 'instancedHandle', the same shader built with
+// INSTANCED)
+// --------------------
+void renderScene(RenderQueue& queue, ShaderHandle shaderHandle, ShaderHandle instancedHandle,
+                 const glm::mat4& view, GLuint texture)
+{
+    Shader* shader = ShaderManager::Instance().GetShader(shaderHandle);
+    // Looked up once per pass (the name is hashed at compile time)
+    UniformHandle modelUniform = shader->GetUniform(UniformHash("model"));
+    // The floor and the cubes go through the queue. The cubes share a
+    // mesh and a texture, so they are drawn with one instanced draw.
+    DrawItem item;
+    item.shader = shader;
+    item.shaderIndex = shaderHandle.index;
+    item.instancedShader = ShaderManager::Instance().GetShader(instancedHandle);
+    item.modelUniform = modelUniform;
+    item.texture = texture;
+    queue.Begin(view);
     // floor
-    glm::mat4 model = glm::mat4(1.0f);
-	ShaderManager::Instance().GetShader(shadername)->SetUniformMatrix4fv("model", &model[0][0]);
-	g_plane->RenderMesh();
+    item.model = &g_planeModel;
+    item.vertexArray = g_plane->GetVertexArray();
+    item.indexCount = g_plane->GetIndicesCount();
+    queue.Add(item, glm::vec3(g_planeModel[3]));
     // cubes
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0));
-    model = glm::scale(model, glm::vec3(0.5f));
-    ShaderManager::Instance().GetShader(shadername)->SetUniformMatrix4fv("model", &model[0][0]);
-    g_cube->RenderMesh();
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
-    model = glm::scale(model, glm::vec3(0.5f));
-    ShaderManager::Instance().GetShader(shadername)->SetUniformMatrix4fv("model", &model[0][0]);
-    g_cube->RenderMesh();
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(-1.0f, 0.0f, 2.0));
-    model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-    model = glm::scale(model, glm::vec3(0.25));
-    ShaderManager::Instance().GetShader(shadername)->SetUniformMatrix4fv("model", &model[0][0]);
-    g_cube->RenderMesh();
+    item.vertexArray = g_cube->GetVertexArray();
+    item.indexCount = g_cube->GetIndicesCount();
+    for(const glm::mat4& model : g_cubeModels){
+        item.model = &model;
+        queue.Add(item, glm::vec3(model[3]));
+    }
+    queue.Sort();
+    queue.Submit();
+    // models loaded from .obj files, which bind their own textures
+    // (one draw per material). Each is drawn once it has finished loading.
+    shader->Bind();
+    renderModel(*shader, modelUniform, g_house,    glm::vec3(-3.0f, 0.0f, -2.0f), 2.0f);
+    renderModel(*shader, modelUniform, g_tree,     glm::vec3( 3.5f, 0.0f, -3.0f), 3.0f);
+    renderModel(*shader, modelUniform, g_chapel,   glm::vec3(-4.0f, 0.0f,  3.0f), 2.5f);
+    renderModel(*shader, modelUniform, g_windmill, glm::vec3( 4.0f, 0.0f,  3.0f), 3.0f);
 }
 
 
@@ -141,22 +210,52 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
     
     // configure global opengl state
     // -----------------------------
-    glEnable(GL_DEPTH_TEST);
+    // (Every bind and enable goes through GLState, which skips the ones
+    //  that would not change anything.)
+    DepthState depthState;
+    depthState.test = true;
+    GLState::Instance().SetDepthState(depthState);
+
+    // If the assets have been packed (see tools/packer.cpp), read them from
+    // the archive. Anything that is not in it still comes from the disk.
+    // The archive was packed from the 'cpp' folder, two levels up.
+    VirtualFileSystem::Instance().Mount("./assets/assets.pack", "./../../");
 
     // build and compile shaders
     // -------------------------
+    // (Loaded from the program cache if they were built on an earlier run.)
+    // This only starts building them: the driver compiles them while we
+    // load everything else, and each is waited for when first used.
+    Uint64 shaderStart = SDL_GetPerformanceCounter();
     // Setup shaders for the node.
-	ShaderManager::Instance().CreateNewShader("shadowmapping",
+    // Soft shadow edges, from a 3x3 kernel (a constant in the shader)
+	ShaderHandle shadowHandle = ShaderManager::Instance().CreateNewShader("shadowmapping",
 											  "./shaders/3.1.3.shadow_mapping.vs",
-    										  "./shaders/3.1.3.shadow_mapping.fs");  
+    										  "./shaders/3.1.3.shadow_mapping.fs",
+											  ShaderDefines().Set("PCF_RADIUS", 1));  
 
-	ShaderManager::Instance().CreateNewShader("shadowmappingdepth",
+	ShaderHandle depthHandle = ShaderManager::Instance().CreateNewShader("shadowmappingdepth",
 											  "./shaders/3.1.3.shadow_mapping_depth.vs",
 											  "./shaders/3.1.3.shadow_mapping_depth.fs");
 
-	ShaderManager::Instance().CreateNewShader("shadowmappingdepthdebug",
+	// and both again reading the model matrix per instance, for the cubes
+	ShaderHandle shadowInstancedHandle = ShaderManager::Instance().GetShaderVariant(
+											  "./shaders/3.1.3.shadow_mapping.vs",
+											  "./shaders/3.1.3.shadow_mapping.fs",
+											  ShaderDefines().Set("PCF_RADIUS", 1).Set("INSTANCED", 1));
+	ShaderHandle depthInstancedHandle = ShaderManager::Instance().GetShaderVariant(
+											  "./shaders/3.1.3.shadow_mapping_depth.vs",
+											  "./shaders/3.1.3.shadow_mapping_depth.fs",
+											  ShaderDefines().Set("INSTANCED", 1));
+
+	ShaderHandle debugHandle = ShaderManager::Instance().CreateNewShader("shadowmappingdepthdebug",
 											  "./shaders/3.1.3.debug_quad.vs",
 											  "./shaders/3.1.3.debug_quad_depth.fs");
+    // and the terrain's (its entity is made further down), lit by both
+    // of our point lights
+    ShaderDefines terrainDefines = ShaderDefines().Set("LIGHT_COUNT", 2);
+    ShaderManager::Instance().GetShaderVariant("./shaders/vert.glsl","./shaders/frag.glsl", terrainDefines);
+    SDL_Log("Started building the shaders in %.1f ms", (SDL_GetPerformanceCounter()-shaderStart)*1000.0/SDL_GetPerformanceFrequency());
 
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
@@ -167,9 +266,25 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
     g_cube = std::make_shared<MeshMaker>(VERTEXLAYOUTS::VERTEX3TN);
     g_cube->CreateCube(1.0f,1.0f,1.0f);
 
+    g_planeModel = glm::mat4(1.0f);
+    g_cubeModels[0] = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.5f, 0.0));
+    g_cubeModels[0] = glm::scale(g_cubeModels[0], glm::vec3(0.5f));
+    g_cubeModels[1] = glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 1.0));
+    g_cubeModels[1] = glm::scale(g_cubeModels[1], glm::vec3(0.5f));
+    g_cubeModels[2] = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 0.0f, 2.0));
+    g_cubeModels[2] = glm::rotate(g_cubeModels[2], glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+    g_cubeModels[2] = glm::scale(g_cubeModels[2], glm::vec3(0.25));
+
     g_light= std::make_shared<MeshMaker>(VERTEXLAYOUTS::VERTEX3TN);
     g_light->CreateCube(0.5f,0.5f,0.5f);
 
+    // Models loaded from .obj files, with their .mtl materials.
+    // These load in the background, and appear once they are ready.
+    g_house    = AssetLoader::Instance().LoadModelAsync("./../../common/objects/house/house_obj.obj");
+    g_tree     = AssetLoader::Instance().LoadModelAsync("./../../common/objects/Tree/HandpaintedTree.obj");
+    g_chapel   = AssetLoader::Instance().LoadModelAsync("./../../common/objects/chapel/chapel_obj.obj");
+    g_windmill = AssetLoader::Instance().LoadModelAsync("./../../common/objects/windmill/windmill.obj");
+
     // load textures
     // -------------
     // Create a texture
@@ -181,19 +296,26 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
     g_depthFBO->CreateDepthMapFBO(m_width,m_height);
 
 
-    // shader configuration
-    // --------------------
-	ShaderManager::Instance().UseShader("shadowmapping");
-	ShaderManager::Instance().GetShader("shadowmapping")->SetUniform1i("diffuseTexture", 0);
-	ShaderManager::Instance().GetShader("shadowmapping")->SetUniform1i("shadowMap", 1);
-
-	ShaderManager::Instance().UseShader("shadowmappingdepthdebug");
-	ShaderManager::Instance().GetShader("shadowmappingdepthdebug")->SetUniform1i("depthMap", 0);
-
     // lighting info
     // -------------
     glm::vec3 lightPos(-2.0f, 4.0f, -1.0f);
 
+    // Look up the shaders, and the uniforms set every frame, only once.
+    // (Both stay valid if the shaders are hot reloaded.)
+    Shader* shadowShader = ShaderManager::Instance().GetShader(shadowHandle);
+    Shader* debugShader  = ShaderManager::Instance().GetShader(debugHandle);
+    UniformHandle shadowModelUniform = shadowShader->GetUniform("model");
+
+    // The camera, shadow and light data every shader reads. These are
+    // filled in once per frame, so the only uniform set per draw is the
+    // model matrix.
+    FrameData frameData{};
+    LightData lightData{};
+    UniformBuffer frameDataBuffer(FRAME_DATA_BINDING, sizeof(FrameData));
+    UniformBuffer lightDataBuffer(LIGHT_DATA_BINDING, sizeof(LightData));
+    // Sorts (and instances) the draws of each pass over the scene
+    RenderQueue sceneQueue;
+
 
     // Create a renderer
     std::shared_ptr<Renderer> renderer = std::make_shared<Renderer>(m_width,m_height);    
@@ -201,11 +323,22 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
     std::shared_ptr<Terrain> myTerrain = std::make_shared<Terrain>(512,512,"./../../common/textures/terrain2.ppm");
     myTerrain->LoadTextures("./../../common/textures/colormap.ppm","./../../common/textures/detailmap.ppm");
 
-    // Create a node for our terrain 
-    std::shared_ptr<SceneNode> terrainNode;
-    terrainNode = std::make_shared<SceneNode>(myTerrain,"./shaders/vert.glsl","./shaders/frag.glsl");
-    // Set our SceneTree up
-    renderer->setRoot(terrainNode);
+    // Make our terrain an entity (see EntityStore.hpp), which the renderer
+    // draws straight from its arrays
+    // (Loading its material does not bind the shaders, so nothing here
+    //  waits for the driver: the first frame's Bind does.)
+    MaterialComponent terrainMaterial = MaterialComponent::Load("./shaders/vert.glsl","./shaders/frag.glsl",terrainDefines);
+    terrainMaterial.texture = myTerrain->GetDiffuseTexture();
+    renderer->GetEntities().Create(MeshComponent::FromObject(*myTerrain), terrainMaterial, myTerrain->GetBounds());
+
+    // shader configuration
+    // --------------------
+	for(Shader* shader : {shadowShader, ShaderManager::Instance().GetShader(shadowInstancedHandle)}){
+		shader->SetSampler("diffuseTexture", 0);
+		shader->SetSampler("shadowMap", 1);
+	}
+
+	debugShader->SetSampler("depthMap", 0);
 
 
     // Set a default position for our camera
@@ -229,11 +362,25 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
     const Uint8* keyboardState = SDL_GetKeyboardState(NULL);
 
     // While application is running
+    // Frame times (without the SDL_Delay) while assets are still loading
+    bool firstFrame = true;
+    bool loading = true;
+    unsigned int loadingFrames = 0;
+    double loadingTotalMs = 0.0, loadingWorstMs = 0.0;
+    // The GL state calls of the first frame after loading, are logged
+    bool logStateStats = false;
+
     while(!quit){
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        GLState::Instance().ResetStats();
+        // Reload anything that was saved since the last frame
+        FileWatcher::Instance().Update();
+        // Finish a few milliseconds worth of background loading
+        AssetLoader::Instance().Update(2.0);
         // For our terrain setup the identity transform each frame
         // By default set the terrain node to the identity
         // matrix.
-//        terrainNode->GetLocalTransform().LoadIdentity();
+//        TransformHierarchy::Instance().SetPosition(renderer->GetEntities().GetTransform(terrainEntity), glm::vec3(0.0f));
         // Invoke(i.e. call) the callback function
         callback();
 
@@ -277,7 +424,7 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
 
         // render
         // ------
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        GLState::Instance().ClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // change light position over time
@@ -289,57 +436,71 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
         if (time > 360){
             time =0.0f;
         }
-        // 1. render depth of scene to texture (from light's perspective)
-        // --------------------------------------------------------------
+        // Work out the camera and the light for this frame
+        // --------------------------------------------------
+        Camera* camera = renderer->GetCamera(0);
         glm::mat4 lightProjection, lightView;
-        glm::mat4 lightSpaceMatrix;
         float near_plane = 1.0f, far_plane = 7.5f;
         lightProjection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
         lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
-        lightSpaceMatrix = lightProjection * lightView;
-        // render scene from light's point of view
-		
-		ShaderManager::Instance().UseShader("shadowmappingdepth");
-		ShaderManager::Instance().GetShader("shadowmappingdepth")->SetUniformMatrix4fv("lightSpaceMatrix", &lightSpaceMatrix[0][0]);
-
+        // For now, //45.0f is the FOV
+        frameData.projection = glm::perspective(glm::radians(45.0f), (float)m_width/ (float)m_height, 0.1f, 100.0f);
+        frameData.view = camera->GetWorldToViewmatrix();
+        frameData.lightSpaceMatrix = lightProjection * lightView;
+        frameData.viewPos = glm::vec4(camera->GetEyeXPosition(),camera->GetEyeYPosition(),camera->GetEyeZPosition(),1.0f);
+        frameData.lightPos = glm::vec4(lightPos, 1.0f);
+        frameData.shadowNearPlane = near_plane;
+        frameData.shadowFarPlane = far_plane;
+        frameData.shadowPCFRadius = 1;
+        frameDataBuffer.Update(frameData);
+
+        // Two point lights that follow the camera, for the terrain
+        glm::vec3 inFrontOfCamera = glm::vec3(frameData.viewPos) +
+            glm::vec3(camera->GetViewXDirection(),camera->GetViewYDirection(),camera->GetViewZDirection());
+        // Create a first 'light'
+        lightData.pointLights[0].lightColor = glm::vec3(1.0f,1.0f,1.0f);
+        lightData.pointLights[0].lightPos = inFrontOfCamera;
+        lightData.pointLights[0].ambientIntensity = 0.9f;
+        lightData.pointLights[0].specularStrength = 0.5f;
+        lightData.pointLights[0].constant = 1.0f;
+        lightData.pointLights[0].linear = 0.003f;
+        lightData.pointLights[0].quadratic = 0.0f;
+        // Create a second light
+        lightData.pointLights[1].lightColor = glm::vec3(1.0f,0.0f,0.0f);
+        lightData.pointLights[1].lightPos = inFrontOfCamera;
+        lightData.pointLights[1].ambientIntensity = 0.9f;
+        lightData.pointLights[1].specularStrength = 0.5f;
+        lightData.pointLights[1].constant = 1.0f;
+        lightData.pointLights[1].linear = 0.09f;
+        lightData.pointLights[1].quadratic = 0.032f;
+        lightData.lightCount = 2;
+        lightDataBuffer.Update(lightData);
 
+        // 1. render depth of scene to texture (from light's perspective)
+        // --------------------------------------------------------------
+        // render scene from light's point of view
         g_depthFBO->Bind();
             glClear(GL_DEPTH_BUFFER_BIT);
-            glActiveTexture(GL_TEXTURE0);
-            brickTexture.Bind();
-            renderScene("shadowmappingdepth");
+            renderScene(sceneQueue, depthHandle, depthInstancedHandle, lightView, brickTexture.GetID());
         g_depthFBO->Unbind();
 
         // reset viewport
-        glViewport(0, 0, m_width, m_height);
+        GLState::Instance().Viewport(0, 0, m_width, m_height);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 2. render scene as normal using the generated depth/shadow map  
         // --------------------------------------------------------------
-        glViewport(0, 0, m_width, m_height);
+        GLState::Instance().Viewport(0, 0, m_width, m_height);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 
-		ShaderManager::Instance().UseShader("shadowmapping");
-        // For now, //45.0f is the FOV
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)m_width/ (float)m_height, 0.1f, 100.0f);
-        glm::mat4 view = renderer->GetCamera(0)->GetWorldToViewmatrix();
-		ShaderManager::Instance().GetShader("shadowmapping")->SetUniformMatrix4fv("projection", &projection[0][0]);
-		ShaderManager::Instance().GetShader("shadowmapping")->SetUniformMatrix4fv("view", &view[0][0]);
-        // set light uniforms
-		ShaderManager::Instance().GetShader("shadowmapping")->SetUniform3f("viewPos", renderer->GetCamera(0)->GetEyeXPosition(),renderer->GetCamera(0)->GetEyeYPosition(),renderer->GetCamera(0)->GetEyeZPosition());
-		ShaderManager::Instance().GetShader("shadowmapping")->SetUniform3f("lightPos", lightPos[0],lightPos[1],lightPos[2]);
-		ShaderManager::Instance().GetShader("shadowmapping")->SetUniformMatrix4fv("lightSpaceMatrix", &lightSpaceMatrix[0][0]);
-
-        glActiveTexture(GL_TEXTURE0);
-        brickTexture.Bind();
         g_depthFBO->BindTexture(1);
-		renderScene("shadowmapping");
+		renderScene(sceneQueue, shadowHandle, shadowInstancedHandle, frameData.view, brickTexture.GetID());
         // Final render our light, which we do not want in our shadow pass
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(lightPos[0],lightPos[1],lightPos[2]));
         model = glm::scale(model, glm::vec3(0.5f));
-        ShaderManager::Instance().GetShader("shadowmapping")->SetUniformMatrix4fv("model", &model[0][0]);
+        shadowShader->SetUniformMatrix4fv(shadowModelUniform, &model[0][0]);
         g_light->RenderMesh();
 
         // Update our scene through our renderer
@@ -348,13 +509,35 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
         //renderer->Render();
         // render Depth map to quad for visual debugging
         // ---------------------------------------------
-		ShaderManager::Instance().UseShader("shadowmappingdepthdebug");
-		ShaderManager::Instance().GetShader("shadowmappingdepthdebug")->SetUniform1f("near_plane", near_plane);
-		ShaderManager::Instance().GetShader("shadowmappingdepthdebug")->SetUniform1f("far_plane", far_plane);
-        glActiveTexture(GL_TEXTURE0);
+		debugShader->Bind();
         g_depthFBO->BindTexture(0);
 
 
+        // Measure the frame before we sleep
+        double frameMs = (SDL_GetPerformanceCounter()-frameStart)*1000.0/SDL_GetPerformanceFrequency();
+        if(firstFrame){
+            double startupMs = (SDL_GetPerformanceCounter()-m_startTime)*1000.0/SDL_GetPerformanceFrequency();
+            SDL_Log("Time to first frame: %.1f ms", startupMs);
+            firstFrame = false;
+        }
+        if(logStateStats){
+            SDL_Log("GL state calls in one frame:\n%s", GLState::Instance().StatsToString().c_str());
+            SDL_Log("Culled %u of %u nodes in %.3f ms", renderer->GetCulledCount(),
+                    TransformHierarchy::Instance().GetCount(), renderer->GetCullMilliseconds());
+            logStateStats = false;
+        }
+        if(loading){
+            ++loadingFrames;
+            loadingTotalMs += frameMs;
+            loadingWorstMs = std::max(loadingWorstMs, frameMs);
+            if(!AssetLoader::Instance().IsBusy()){
+                SDL_Log("Loading finished: %u frames, average %.2f ms, worst %.2f ms per frame",
+                        loadingFrames, loadingTotalMs/loadingFrames, loadingWorstMs);
+                loading = false;
+                logStateStats = true;
+            }
+        }
+
         // Delay to slow things down just a bit!
         SDL_Delay(25);  // TODO: You can change this or implement a frame
                         // independent movement method if you like.
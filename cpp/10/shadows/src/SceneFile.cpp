@@ -0,0 +1,360 @@
+#include "SceneFile.hpp"
+#include "ShaderManager.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
+
+// The arrays are written and read as they are in memory
+static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::quat) == 16, "glm must not pad its vectors");
+static_assert(sizeof(Bounds) == 28 && std::is_trivially_copyable<Bounds>::value, "Bounds are copied as bytes");
+static_assert(std::is_trivially_copyable<LightData>::value, "LightData is copied as bytes");
+
+// Rounds 'value' up to the next multiple of 16
+static uint64_t Align16(uint64_t value){
+    return (value + 15) & ~uint64_t(15);
+}
+
+// The strings of a file, each kept once
+class StringTable{
+public:
+    uint32_t Add(const std::string& text){
+        auto found = m_offsets.find(text);
+        if(found != m_offsets.end()){
+            return found->second;
+        }
+        uint32_t offset = m_bytes.size();
+        m_bytes.insert(m_bytes.end(), text.begin(), text.end());
+        m_bytes.push_back('\0');
+        m_offsets[text] = offset;
+        return offset;
+    }
+    const std::vector<char>& GetBytes() const { return m_bytes; }
+private:
+    std::vector<char> m_bytes;
+    std::unordered_map<std::string, uint32_t> m_offsets;
+};
+
+// Turns ShaderDefines::GetKey's "NAME=VALUE;..." back into defines
+static ShaderDefines DefinesFromKey(const std::string& key){
+    ShaderDefines defines;
+    std::size_t start = 0;
+    while(start < key.size()){
+        std::size_t end = key.find(';', start);
+        if(end == std::string::npos){
+            end = key.size();
+        }
+        std::size_t equals = key.find('=', start);
+        if(equals != std::string::npos && equals < end){
+            defines.Set(key.substr(start, equals-start), key.substr(equals+1, end-equals-1));
+        }
+        start = end+1;
+    }
+    return defines;
+}
+
+bool WriteSceneFile(const std::string& filename, const EntityStore& entities, const LightData& lights,
+                    const SceneFileNames& names){
+    // (1) ======= The nodes the entities are placed by: theirs and their
+    //             ancestors. Kept in the hierarchy's order, they are still
+    //             depth first, and each one's parent is kept with it.
+    TransformHierarchy& transforms = entities.GetTransformHierarchy();
+    TransformHierarchy::NodeArrays all = transforms.GetNodeArrays();
+    uint32_t entityCount = entities.GetCount();
+    // Each node's place in the file (or NO_PARENT if it is left out)
+    std::vector<uint32_t> kept(all.count, TransformHierarchy::NO_PARENT);
+    for(TransformHandle transform : entities.GetTransforms()){
+        for(uint32_t slot = transforms.GetOrder(transform);
+            slot != TransformHierarchy::NO_PARENT && kept[slot] == TransformHierarchy::NO_PARENT; slot = all.parent[slot]){
+            kept[slot] = 0;
+        }
+    }
+    std::vector<uint32_t> parents;
+    std::vector<glm::vec3> positions, scales, boundsCenters, boundsExtents;
+    std::vector<glm::quat> rotations;
+    for(uint32_t slot=0; slot < all.count; ++slot){
+        if(kept[slot] == TransformHierarchy::NO_PARENT){
+            continue;
+        }
+        kept[slot] = parents.size();
+        parents.push_back(all.parent[slot] != TransformHierarchy::NO_PARENT ? kept[all.parent[slot]]
+                                                                             : TransformHierarchy::NO_PARENT);
+        positions.push_back(all.position[slot]);
+        rotations.push_back(all.rotation[slot]);
+        scales.push_back(all.scale[slot]);
+        boundsCenters.push_back(all.boundsCenter[slot]);
+        boundsExtents.push_back(all.boundsExtent[slot]);
+    }
+    TransformHierarchy::NodeArrays nodes{(uint32_t)parents.size(), parents.data(), positions.data(), rotations.data(),
+                                         scales.data(), boundsCenters.data(), boundsExtents.data()};
+
+    // (2) ======= The rest is looked up entity by entity
+    StringTable strings;
+    std::vector<uint32_t> entityNodes(entityCount), entityMeshes(entityCount), entityMaterials(entityCount);
+    std::vector<uint32_t> meshTable, textureTable;
+    std::vector<SceneFileMaterial> materialTable;
+    std::unordered_map<GLuint, uint32_t> meshIndex, textureIndex;
+    std::map<std::tuple<uint32_t,GLuint,bool>, uint32_t> materialIndex;
+    for(uint32_t row=0; row < entityCount; ++row){
+        entityNodes[row] = kept[transforms.GetOrder(entities.GetTransforms()[row])];
+
+        const MeshComponent& mesh = entities.GetMeshes()[row];
+        auto mesh_ = meshIndex.find(mesh.vertexArray);
+        if(mesh_ == meshIndex.end()){
+            auto name = names.meshes.find(mesh.vertexArray);
+            if(name == names.meshes.end()){
+                std::cout << "WriteSceneFile: no name for the mesh of vertex array " << mesh.vertexArray << std::endl;
+                return false;
+            }
+            mesh_ = meshIndex.emplace(mesh.vertexArray, meshTable.size()).first;
+            meshTable.push_back(strings.Add(name->second));
+        }
+        entityMeshes[row] = mesh_->second;
+
+        const MaterialComponent& material = entities.GetMaterials()[row];
+        auto key = std::make_tuple(material.shaderIndex, material.texture, material.transparent);
+        auto material_ = materialIndex.find(key);
+        if(material_ == materialIndex.end()){
+            SceneFileMaterial saved{};
+            saved.texture = SCENEFILE_NO_TEXTURE;
+            if(material.texture != 0){
+                auto texture = textureIndex.find(material.texture);
+                if(texture == textureIndex.end()){
+                    auto path = names.textures.find(material.texture);
+                    if(path == names.textures.end()){
+                        std::cout << "WriteSceneFile: no path for texture " << material.texture << std::endl;
+                        return false;
+                    }
+                    texture = textureIndex.emplace(material.texture, textureTable.size()).first;
+                    textureTable.push_back(strings.Add(path->second));
+                }
+                saved.texture = texture->second;
+            }
+            std::string vertex, fragment;
+            ShaderDefines defines;
+            ShaderManager::Instance().GetShaderFiles(ShaderHandle{material.shaderIndex}, vertex, fragment, defines);
+            saved.vertexShader = strings.Add(vertex);
+            saved.fragmentShader = strings.Add(fragment);
+            saved.defines = strings.Add(defines.GetKey());
+            saved.transparent = material.transparent;
+            material_ = materialIndex.emplace(key, materialTable.size()).first;
+            materialTable.push_back(saved);
+        }
+        entityMaterials[row] = material_->second;
+    }
+
+    // (3) ======= Fill in the header and work out where everything goes
+    SceneFileHeader header{};
+    std::memcpy(header.magic, SCENEFILE_MAGIC, 4);
+    header.version       = SCENEFILE_VERSION;
+    header.nodeCount     = nodes.count;
+    header.entityCount   = entityCount;
+    header.meshCount     = meshTable.size();
+    header.textureCount  = textureTable.size();
+    header.materialCount = materialTable.size();
+    header.stringBytes   = strings.GetBytes().size();
+
+    uint64_t offset = Align16(sizeof(SceneFileHeader));
+    header.parentOffset         = offset; offset = Align16(offset + nodes.count*sizeof(uint32_t));
+    header.positionOffset       = offset; offset = Align16(offset + nodes.count*sizeof(glm::vec3));
+    header.rotationOffset       = offset; offset = Align16(offset + nodes.count*sizeof(glm::quat));
+    header.scaleOffset          = offset; offset = Align16(offset + nodes.count*sizeof(glm::vec3));
+    header.boundsCenterOffset   = offset; offset = Align16(offset + nodes.count*sizeof(glm::vec3));
+    header.boundsExtentOffset   = offset; offset = Align16(offset + nodes.count*sizeof(glm::vec3));
+    header.entityNodeOffset     = offset; offset = Align16(offset + entityCount*sizeof(uint32_t));
+    header.entityMeshOffset     = offset; offset = Align16(offset + entityCount*sizeof(uint32_t));
+    header.entityMaterialOffset = offset; offset = Align16(offset + entityCount*sizeof(uint32_t));
+    header.entityBoundsOffset   = offset; offset = Align16(offset + entityCount*sizeof(Bounds));
+    header.meshOffset           = offset; offset = Align16(offset + meshTable.size()*sizeof(uint32_t));
+    header.textureOffset        = offset; offset = Align16(offset + textureTable.size()*sizeof(uint32_t));
+    header.materialOffset       = offset; offset = Align16(offset + materialTable.size()*sizeof(SceneFileMaterial));
+    header.stringOffset         = offset; offset = Align16(offset + strings.GetBytes().size());
+    header.lightOffset          = offset; offset = Align16(offset + sizeof(LightData));
+    header.fileSize             = offset;
+
+    // (4) ======= Write it out
+    std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+    if(!out.is_open()){
+        std::cout << "WriteSceneFile: unable to open " << filename << std::endl;
+        return false;
+    }
+    auto write = [&out](uint64_t at, const void* data, uint64_t bytes){
+        // Pad with zeros up to the aligned start of this section
+        static const char zeros[16] = {};
+        while((uint64_t)out.tellp() < at){
+            out.write(zeros, std::min<uint64_t>(16, at-(uint64_t)out.tellp()));
+        }
+        out.write(static_cast<const char*>(data), bytes);
+    };
+    write(0, &header, sizeof(header));
+    write(header.parentOffset, nodes.parent, nodes.count*sizeof(uint32_t));
+    write(header.positionOffset, nodes.position, nodes.count*sizeof(glm::vec3));
+    write(header.rotationOffset, nodes.rotation, nodes.count*sizeof(glm::quat));
+    write(header.scaleOffset, nodes.scale, nodes.count*sizeof(glm::vec3));
+    write(header.boundsCenterOffset, nodes.boundsCenter, nodes.count*sizeof(glm::vec3));
+    write(header.boundsExtentOffset, nodes.boundsExtent, nodes.count*sizeof(glm::vec3));
+    write(header.entityNodeOffset, entityNodes.data(), entityCount*sizeof(uint32_t));
+    write(header.entityMeshOffset, entityMeshes.data(), entityCount*sizeof(uint32_t));
+    write(header.entityMaterialOffset, entityMaterials.data(), entityCount*sizeof(uint32_t));
+    write(header.entityBoundsOffset, entities.GetBoundsArray().data(), entityCount*sizeof(Bounds));
+    write(header.meshOffset, meshTable.data(), meshTable.size()*sizeof(uint32_t));
+    write(header.textureOffset, textureTable.data(), textureTable.size()*sizeof(uint32_t));
+    write(header.materialOffset, materialTable.data(), materialTable.size()*sizeof(SceneFileMaterial));
+    write(header.stringOffset, strings.GetBytes().data(), strings.GetBytes().size());
+    write(header.lightOffset, &lights, sizeof(LightData));
+    write(header.fileSize, nullptr, 0);
+    return out.good();
+}
+
+SceneFile::SceneFile(){
+}
+
+bool SceneFile::Open(const std::string& filename){
+    m_header = nullptr;
+    if(!m_file.Open(filename)){
+        std::cout << "SceneFile: unable to open " << filename << std::endl;
+        return false;
+    }
+    if(m_file.Size() < sizeof(SceneFileHeader)){
+        std::cout << "SceneFile: " << filename << " is too small" << std::endl;
+        return false;
+    }
+    const SceneFileHeader* header = reinterpret_cast<const SceneFileHeader*>(m_file.Data());
+    if(std::memcmp(header->magic, SCENEFILE_MAGIC, 4) != 0 || header->version != SCENEFILE_VERSION){
+        std::cout << "SceneFile: " << filename << " is not a version " << SCENEFILE_VERSION << " scene file" << std::endl;
+        return false;
+    }
+    // Every section must be inside the file, and aligned for its type
+    struct Section{ uint64_t offset; uint64_t bytes; };
+    const Section sections[] = {
+        {header->parentOffset,          header->nodeCount*sizeof(uint32_t)},
+        {header->positionOffset,        header->nodeCount*sizeof(glm::vec3)},
+        {header->rotationOffset,        header->nodeCount*sizeof(glm::quat)},
+        {header->scaleOffset,           header->nodeCount*sizeof(glm::vec3)},
+        {header->boundsCenterOffset,    header->nodeCount*sizeof(glm::vec3)},
+        {header->boundsExtentOffset,    header->nodeCount*sizeof(glm::vec3)},
+        {header->entityNodeOffset,      header->entityCount*sizeof(uint32_t)},
+        {header->entityMeshOffset,      header->entityCount*sizeof(uint32_t)},
+        {header->entityMaterialOffset,  header->entityCount*sizeof(uint32_t)},
+        {header->entityBoundsOffset,    header->entityCount*sizeof(Bounds)},
+        {header->meshOffset,            header->meshCount*sizeof(uint32_t)},
+        {header->textureOffset,         header->textureCount*sizeof(uint32_t)},
+        {header->materialOffset,        header->materialCount*sizeof(SceneFileMaterial)},
+        {header->stringOffset,          header->stringBytes},
+        {header->lightOffset,           sizeof(LightData)},
+    };
+    if(header->fileSize > m_file.Size()){
+        std::cout << "SceneFile: " << filename << " is cut short" << std::endl;
+        return false;
+    }
+    for(const Section& section : sections){
+        if(section.offset % 16 != 0 || section.offset > header->fileSize || section.bytes > header->fileSize - section.offset){
+            std::cout << "SceneFile: " << filename << " has a section outside of the file" << std::endl;
+            return false;
+        }
+    }
+    m_header = header;
+
+    // And every index must point at something, so that loading need not
+    // check. The nodes are in depth first order, as the hierarchy keeps
+    // them (so each subtree is one range of them).
+    if(!TransformHierarchy::IsDepthFirst(header->nodeCount, At<uint32_t>(header->parentOffset))){
+        m_header = nullptr;
+    }
+    const uint32_t* entityNodes = At<uint32_t>(header->entityNodeOffset);
+    const uint32_t* entityMeshes = At<uint32_t>(header->entityMeshOffset);
+    const uint32_t* entityMaterials = At<uint32_t>(header->entityMaterialOffset);
+    for(uint32_t i=0; i < header->entityCount; ++i){
+        if(entityNodes[i] >= header->nodeCount || entityMeshes[i] >= header->meshCount ||
+           entityMaterials[i] >= header->materialCount){
+            m_header = nullptr;
+        }
+    }
+    const char* strings = At<char>(header->stringOffset);
+    auto isString = [&](uint32_t offset){ return offset < header->stringBytes; };
+    if(header->stringBytes > 0 && strings[header->stringBytes-1] != '\0'){
+        m_header = nullptr;
+    }
+    for(uint32_t i=0; i < header->meshCount; ++i){
+        if(!isString(At<uint32_t>(header->meshOffset)[i])){
+            m_header = nullptr;
+        }
+    }
+    for(uint32_t i=0; i < header->textureCount; ++i){
+        if(!isString(At<uint32_t>(header->textureOffset)[i])){
+            m_header = nullptr;
+        }
+    }
+    for(uint32_t i=0; i < header->materialCount; ++i){
+        const SceneFileMaterial& material = At<SceneFileMaterial>(header->materialOffset)[i];
+        if(!isString(material.vertexShader) || !isString(material.fragmentShader) || !isString(material.defines) ||
+           (material.texture != SCENEFILE_NO_TEXTURE && material.texture >= header->textureCount)){
+            m_header = nullptr;
+        }
+    }
+    if(m_header == nullptr){
+        std::cout << "SceneFile: " << filename << " refers to something it does not have" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+TransformHierarchy::NodeArrays SceneFile::GetNodes() const{
+    TransformHierarchy::NodeArrays nodes;
+    nodes.count = m_header->nodeCount;
+    nodes.parent = At<uint32_t>(m_header->parentOffset);
+    nodes.position = At<glm::vec3>(m_header->positionOffset);
+    nodes.rotation = At<glm::quat>(m_header->rotationOffset);
+    nodes.scale = At<glm::vec3>(m_header->scaleOffset);
+    nodes.boundsCenter = At<glm::vec3>(m_header->boundsCenterOffset);
+    nodes.boundsExtent = At<glm::vec3>(m_header->boundsExtentOffset);
+    return nodes;
+}
+
+Entity SceneFile::Instantiate(EntityStore& entities, LightData& lights, const SceneFileAssets& assets) const{
+    // (1) ======= What the tables name, once each
+    std::vector<MeshComponent> meshes(m_header->meshCount);
+    for(uint32_t i=0; i < m_header->meshCount; ++i){
+        meshes[i] = assets.mesh(String(At<uint32_t>(m_header->meshOffset)[i]));
+    }
+    std::vector<GLuint> textures(m_header->textureCount);
+    for(uint32_t i=0; i < m_header->textureCount; ++i){
+        textures[i] = assets.texture(String(At<uint32_t>(m_header->textureOffset)[i]));
+    }
+    std::vector<MaterialComponent> materials(m_header->materialCount);
+    for(uint32_t i=0; i < m_header->materialCount; ++i){
+        const SceneFileMaterial& saved = At<SceneFileMaterial>(m_header->materialOffset)[i];
+        materials[i] = MaterialComponent::Load(String(saved.vertexShader), String(saved.fragmentShader),
+                                               DefinesFromKey(String(saved.defines)));
+        materials[i].texture = saved.texture != SCENEFILE_NO_TEXTURE ? textures[saved.texture] : 0;
+        materials[i].transparent = saved.transparent != 0;
+    }
+
+    // (2) ======= The nodes, copied straight from the file
+    TransformHandle firstNode = entities.GetTransformHierarchy().Append(GetNodes());
+
+    // (3) ======= The entities: the indices into the tables turned into
+    //             what they point at, then copied into the store
+    uint32_t count = m_header->entityCount;
+    const uint32_t* entityNodes = At<uint32_t>(m_header->entityNodeOffset);
+    const uint32_t* entityMeshes = At<uint32_t>(m_header->entityMeshOffset);
+    const uint32_t* entityMaterials = At<uint32_t>(m_header->entityMaterialOffset);
+    std::vector<TransformHandle> entityTransforms(count);
+    std::vector<MeshComponent> entityMeshComponents(count);
+    std::vector<MaterialComponent> entityMaterialComponents(count);
+    for(uint32_t i=0; i < count; ++i){
+        entityTransforms[i].index = firstNode.index + entityNodes[i];
+        entityMeshComponents[i] = meshes[entityMeshes[i]];
+        entityMaterialComponents[i] = materials[entityMaterials[i]];
+    }
+    Entity first = entities.Append(count, entityTransforms.data(), entityMeshComponents.data(),
+                                   entityMaterialComponents.data(), At<Bounds>(m_header->entityBoundsOffset));
+
+    std::memcpy(&lights, At<LightData>(m_header->lightOffset), sizeof(LightData));
+    return first;
+}
@@ -1,24 +1,52 @@
 #include "SceneNode.hpp"
+#include "ShaderManager.hpp"
 
 #include <string>
 #include <iostream>
 
 // The constructor
-SceneNode::SceneNode(std::shared_ptr<Object> ob, std::string vertShader, std::string fragShader){
+SceneNode::SceneNode(std::shared_ptr<Object> ob, std::string vertShader, std::string fragShader,
+                     const ShaderDefines& defines){
 	std::cout << "(SceneNode.cpp) Constructor called\n";
 	m_object = ob;
 
     // By default no parent.
     m_parent = nullptr;
+    m_transform = TransformHierarchy::Instance().Create();
+    // Lets the renderer skip the object when it is out of view
+    if(m_object != nullptr){
+        TransformHierarchy::Instance().SetBounds(m_transform, m_object->GetBounds());
+    }
 	
-    // Create shader
-    m_shader = std::make_shared<Shader>();
-	// Setup shaders for the node.
-	std::string vertexShader   = m_shader->LoadShaderAsString(vertShader);
-	std::string fragmentShader = m_shader->LoadShaderAsString(fragShader);
+    // Get our shader. Nodes using the same shader files (and defines)
+    // share one program, which is only compiled for the first of them.
+    m_shaderHandle = ShaderManager::Instance().GetShaderVariant(vertShader, fragShader, defines);
+    m_shader = ShaderManager::Instance().GetShader(m_shaderHandle);
+    // and the same shader reading the model matrix per instance, so that
+    // nodes sharing this one's object can be drawn together
+    ShaderDefines instancedDefines = defines;
+    instancedDefines.Set("INSTANCED", 1);
+    m_instancedShader = ShaderManager::Instance().GetShader(
+        ShaderManager::Instance().GetShaderVariant(vertShader, fragShader, instancedDefines));
+    // and reading it from a uniform buffer, for drawing from command lists
+    ShaderDefines objectDataDefines = defines;
+    objectDataDefines.Set("OBJECT_DATA", 1);
+    m_objectDataShader = ShaderManager::Instance().GetShader(
+        ShaderManager::Instance().GetShaderVariant(vertShader, fragShader, objectDataDefines));
 
-	// Actually create our shader
-	m_shader->CreateShader(vertexShader,fragmentShader);       
+    // The texture slots never change, so they only need to be set once.
+    // For our object, we apply the texture in the following way
+    // Note that we set the value to 0, because we have bound
+    // our texture to slot 0. (SetSampler does not bind the shader, so
+    // this does not wait for the driver to build it.)
+    for(Shader* shader : {m_shader, m_instancedShader, m_objectDataShader}){
+        shader->SetSampler("u_DiffuseMap",0);
+        // TODO: This assumes every SceneNode is a 'Terrain' so this shader setup code
+        //       needs to be moved preferably to 'Object' or 'Terrain'
+        shader->SetSampler("u_DetailMap",1);
+    }
+    // Find the uniform we set every frame
+    m_model = m_shader->GetUniform("model");
 }
 
 // The destructor 
@@ -37,94 +65,81 @@ void SceneNode::AddChild(SceneNode* n){
 	// object, which is a pointer to our current
 	// SceneNode.
 	n->m_parent = this;
+	// Its transform is now relative to ours
+	TransformHierarchy::Instance().SetParent(n->m_transform, m_transform);
 	// Add a child node into our SceneNode
 	m_children.push_back(n);
 }
 
-// Draw simply draws the current nodes
-// object and all of its children. This is done by calling directly
-// the objects draw method.
-void SceneNode::Draw(){
-	// Bind the shader for this node or series of nodes
-	m_shader->Bind();
-	// Render our object
+// Draw adds the current node's object, and those of all of its
+// children, to the queue. The queue draws them later, in the order
+// that changes the least state.
+void SceneNode::Draw(RenderQueue& queue){
 	if(m_object!=nullptr){
-		// Render our object
-		m_object->Render();
+		// Add our object, unless it is out of view (see Renderer::Update).
+		// Its children have their own bounds, so they are still visited.
+		TransformHierarchy& transforms = TransformHierarchy::Instance();
+		if(transforms.IsVisible(m_transform)){
+			DrawItem item;
+			item.shader = m_shader;
+			item.shaderIndex = m_shaderHandle.index;
+			item.modelUniform = m_model;
+			item.model = &transforms.GetWorldMatrix(m_transform);
+			item.vertexArray = m_object->GetVertexArray();
+			item.texture = m_object->GetDiffuseTexture();
+			item.indexCount = m_object->GetIndexCount();
+			item.transparent = m_object->IsTransparent();
+			item.instancedShader = m_instancedShader;
+			glm::vec3 center, extent;
+			transforms.GetWorldBounds(m_transform, center, extent);
+			queue.Add(item, center);
+		}
 		// For any 'child nodes' also call the drawing routine.
 		for(int i =0; i < m_children.size(); ++i){
-			m_children[0]->Draw();
+			m_children[i]->Draw(queue);
 		}
 	}	
 }
 
+// Record is the same as Draw, but for a command list, which draws in
+// the order the nodes are recorded.
+void SceneNode::Record(CommandList& list, bool children) const{
+	if(m_object!=nullptr){
+		const TransformHierarchy& transforms = TransformHierarchy::Instance();
+		if(transforms.IsVisible(m_transform)){
+			list.SetTransparent(m_object->IsTransparent());
+			list.BindShader(m_objectDataShader);
+			list.BindTexture(m_object->GetDiffuseTexture());
+			list.BindVertexArray(m_object->GetVertexArray());
+			list.BindObjectData(transforms.GetWorldMatrix(m_transform));
+			list.DrawElements(m_object->GetIndexCount());
+		}
+		if(children){
+			for(int i =0; i < m_children.size(); ++i){
+				m_children[i]->Record(list);
+			}
+		}
+	}
+}
+
 // Update simply updates the current nodes
-// object. This is done by calling directly
-// the objects update method.
-// TODO: Consider not passting projection and camera here
-void SceneNode::Update(glm::mat4 projectionMatrix, Camera* camera){
+// object.
+// (The camera and lights come from the FrameData and LightData uniform
+//  buffers, which are set once per frame, and the model matrix is set
+//  when the object is drawn.)
+void SceneNode::Update(){
     if(m_object!=nullptr){
         // TODO: Implement here!
-    
-        m_object->Bind();
-    	// Now apply our shader 
-		m_shader->Bind();
-    	// Set the uniforms in our current shader
-
-        // For our object, we apply the texture in the following way
-        // Note that we set the value to 0, because we have bound
-        // our texture to slot 0.
-        m_shader->SetUniform1i("u_DiffuseMap",0);  
-        // TODO: This assumes every SceneNode is a 'Terrain' so this shader setup code
-        //       needs to be moved preferably to 'Object' or 'Terrain'
-        m_shader->SetUniform1i("u_DetailMap",1);  
-        // Set the MVP Matrix for our object
-        // Send it into our shader
-        m_shader->SetUniformMatrix4fv("model", &m_worldTransform.GetInternalMatrix()[0][0]);
-        m_shader->SetUniformMatrix4fv("view", &camera->GetWorldToViewmatrix()[0][0]);
-        m_shader->SetUniformMatrix4fv("projection", &projectionMatrix[0][0]);
 
-        // Create a 'light'
-        // Create a first 'light'
-        m_shader->SetUniform3f("pointLights[0].lightColor",1.0f,1.0f,1.0f);
-        m_shader->SetUniform3f("pointLights[0].lightPos",
-           camera->GetEyeXPosition() + camera->GetViewXDirection(),
-           camera->GetEyeYPosition() + camera->GetViewYDirection(),
-           camera->GetEyeZPosition() + camera->GetViewZDirection());
-        m_shader->SetUniform1f("pointLights[0].ambientIntensity",0.9f);
-        m_shader->SetUniform1f("pointLights[0].specularStrength",0.5f);
-        m_shader->SetUniform1f("pointLights[0].constant",1.0f);
-        m_shader->SetUniform1f("pointLights[0].linear",0.003f);
-        m_shader->SetUniform1f("pointLights[0].quadratic",0.0f);
-		
-		// Create a second light
-        m_shader->SetUniform3f("pointLights[1].lightColor",1.0f,0.0f,0.0f);
-        m_shader->SetUniform3f("pointLights[1].lightPos",
-           camera->GetEyeXPosition() + camera->GetViewXDirection(),
-           camera->GetEyeYPosition() + camera->GetViewYDirection(),
-           camera->GetEyeZPosition() + camera->GetViewZDirection());
-        m_shader->SetUniform1f("pointLights[1].ambientIntensity",0.9f);
-        m_shader->SetUniform1f("pointLights[1].specularStrength",0.5f);
-        m_shader->SetUniform1f("pointLights[1].constant",1.0f);
-        m_shader->SetUniform1f("pointLights[1].linear",0.09f);
-        m_shader->SetUniform1f("pointLights[1].quadratic",0.032f);
-
-	
 		// Iterate through all of the children
 		for(int i =0; i < m_children.size(); ++i){
-			m_children[0]->Update(projectionMatrix, camera);
+			m_children[i]->Update();
 		}
 	}
 }
 
-// Returns the actual local transform stored in our SceneNode
-// which can then be modified
-Transform& SceneNode::GetLocalTransform(){
-    return m_localTransform; 
-}
-
-// Returns the worled  transform stored in our SceneNode
-// which can then be modified
-Transform& SceneNode::GetWorldTransform(){
-    return m_worldTransform; 
+// Returns the node's transform, whose position, rotation and scale
+// can then be modified through the TransformHierarchy
+TransformHandle SceneNode::GetTransform() const{
+    return m_transform;
 }
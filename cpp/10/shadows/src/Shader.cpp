@@ -1,28 +1,21 @@
 #include "Shader.hpp"
+#include "VirtualFileSystem.hpp"
+#include "UniformBuffer.hpp"
+#include "ProgramCache.hpp"
+#include "GLState.hpp"
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 // TODO: Need to move this into its own namespace
 std::string LoadShaderAsString(const std::string& fname){
 		std::string result;
-		// 1.) Get every line of data
-		std::string line;
-		std::ifstream myFile(fname.c_str());
-
-		if(myFile.is_open()){
-			while(getline(myFile,line)){
-					result += line + '\n';
-					// SDL_Log(line); 	// Uncomment this if you want to see
-										// the shader code get printed out.
-			}
-		}
-		else{
+		// Read the whole file (from the disk, or a mounted archive)
+		if(!VirtualFileSystem::Instance().ReadFile(fname, result)){
 			SDL_Log("LoadShader: file not found. Try an absolute file path to see if the file exists");
             std::cout << "\tMissing Shader file: " << fname << std::endl;
 		}
-		// Close file
-		myFile.close();
 		return result;
 }
 
@@ -32,18 +25,33 @@ Shader::Shader(){}
 // Destructor
 Shader::~Shader(){
 	// Deallocate Program
-	glDeleteProgram(m_shaderID);
+	if(m_shaderID != 0){
+		GLState::Instance().ForgetProgram(m_shaderID);
+		glDeleteProgram(m_shaderID);
+	}
+	// and one that was still being built
+	if(m_pendingProgram != 0){
+		glDeleteProgram(m_pendingProgram);
+		if(!m_pendingCached){
+			glDeleteShader(m_pendingVertexShader);
+			glDeleteShader(m_pendingFragmentShader);
+		}
+	}
 }
 
 // Use our shader
-void Shader::Bind() const{
-	glUseProgram(m_shaderID);
+void Shader::Bind(){
+	// The first time, wait for the driver to finish building it
+	if(m_pendingProgram != 0){
+		FinishCreateShader();
+	}
+	GLState::Instance().UseProgram(m_shaderID);
 }
 
 
 // Turns off our shader
 void Shader::Unbind() const{
-	glUseProgram(0);
+	GLState::Instance().UseProgram(0);
 }
 
 void Shader::Log(const char* system, const char* message){
@@ -55,54 +63,283 @@ void Shader::Log(const char* system, const char* message){
 // 		 parsing the file, and then appending to the string.
 std::string Shader::LoadShaderAsString(const std::string& fname){
 		std::string result;
-		// 1.) Get every line of data
-		std::string line;
-		std::ifstream myFile(fname.c_str());
-
-		if(myFile.is_open()){
-			while(getline(myFile,line)){
-					result += line + '\n';
-					// SDL_Log(line); 	// Uncomment this if you want to see
-										// the shader code get printed out.
-			}
-		}
-		else{
+		// Read the whole file (from the disk, or a mounted archive)
+		if(!VirtualFileSystem::Instance().ReadFile(fname, result)){
 			Log("LoadShader","file not found. Try an absolute file path to see if the file exists");
             std::cout << "\tMissing Shader file: " << fname << std::endl;
 		}
-		// Close file
-		myFile.close();
 		return result;
 }
 
 
-void Shader::CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource){
+// From KHR_parallel_shader_compile, which glad's 3.3 header does not have
+#define COMPLETION_STATUS_KHR 0x91B1
+
+bool Shader::s_parallelCompile = false;
+
+bool Shader::EnableParallelCompile(GLADloadproc load){
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for(GLint i=0; i < count; ++i){
+        std::string extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if(extension == "GL_KHR_parallel_shader_compile" || extension == "GL_ARB_parallel_shader_compile"){
+            s_parallelCompile = true;
+        }
+    }
+    if(!s_parallelCompile){
+        return false;
+    }
+    // Let the driver decide how many threads to use
+    typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+    MaxShaderCompilerThreadsProc maxThreads = (MaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsKHR");
+    if(maxThreads == nullptr){
+        maxThreads = (MaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsARB");
+    }
+    if(maxThreads != nullptr){
+        maxThreads(0xFFFFFFFF);
+    }
+    return true;
+}
+
+bool Shader::CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource){
+    BeginCreateShader(vertexShaderSource, fragmentShaderSource);
+    return FinishCreateShader();
+}
+
+void Shader::BeginCreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource){
+    // Only one program is built at a time
+    if(m_pendingProgram != 0){
+        FinishCreateShader();
+    }
+
+    // If these shaders were built before (on this driver), the linked
+    // program is loaded from the cache instead of being compiled again
+    m_pendingProgram = ProgramCache::Instance().Load(vertexShaderSource, fragmentShaderSource);
+    m_pendingCached = m_pendingProgram != 0;
+    if(m_pendingCached){
+        return;
+    }
 
     // Create a new program
-    unsigned int program = glCreateProgram();
+    m_pendingProgram = glCreateProgram();
     // Compile our shaders
-    unsigned int myVertexShader = CompileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    unsigned int myFragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    // Nothing here asks for the result, so a driver that compiles on its
+    // own threads can get on with it while we do something else.
+    m_pendingVertexShader = CompileShader(GL_VERTEX_SHADER, vertexShaderSource);
+    m_pendingFragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
     // Link our program
-    // These have been compiled already.
-    glAttachShader(program,myVertexShader);
-    glAttachShader(program,myFragmentShader);
+    glAttachShader(m_pendingProgram,m_pendingVertexShader);
+    glAttachShader(m_pendingProgram,m_pendingFragmentShader);
     // Link our programs that have been 'attached'
-    glLinkProgram(program);
-    glValidateProgram(program);
+    ProgramCache::Instance().PrepareToLink(m_pendingProgram);
+    glLinkProgram(m_pendingProgram);
+    if(ProgramCache::Instance().IsEnabled()){
+        m_pendingVertexSource = vertexShaderSource;
+        m_pendingFragmentSource = fragmentShaderSource;
+    }
+}
 
-    // Once the shaders have been linked in, we can delete them.
-    glDetachShader(program,myVertexShader);
-    glDetachShader(program,myFragmentShader);
+bool Shader::IsReady(){
+    if(m_pendingProgram == 0 || m_pendingCached || !s_parallelCompile){
+        return true;
+    }
+    GLint done = GL_FALSE;
+    glGetProgramiv(m_pendingProgram, COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
 
-    glDeleteShader(myVertexShader);
-    glDeleteShader(myFragmentShader);
+bool Shader::FinishCreateShader(){
+    if(m_pendingProgram == 0){
+        return true;
+    }
+    unsigned int program = m_pendingProgram;
+    m_pendingProgram = 0;
+
+    if(!m_pendingCached){
+        // These wait for the driver, if it is still working
+        CheckCompileStatus(m_pendingVertexShader, GL_VERTEX_SHADER);
+        CheckCompileStatus(m_pendingFragmentShader, GL_FRAGMENT_SHADER);
+        glValidateProgram(program);
+
+        // Once the shaders have been linked in, we can delete them.
+        glDetachShader(program,m_pendingVertexShader);
+        glDetachShader(program,m_pendingFragmentShader);
+
+        glDeleteShader(m_pendingVertexShader);
+        glDeleteShader(m_pendingFragmentShader);
+        m_pendingVertexShader = 0;
+        m_pendingFragmentShader = 0;
+    }
 
     if(!CheckLinkStatus(program)){
         Log("CreateShader","ERROR, shader did not link! Were there compile errors in the shader?");
+        m_pendingVertexSource.clear();
+        m_pendingFragmentSource.clear();
+        if(m_shaderID != 0){
+            // Keep using the program we already have
+            glDeleteProgram(program);
+            return false;
+        }
+        m_shaderID = program;
+        return false;
+    }
+
+    if(!m_pendingCached){
+        ProgramCache::Instance().Store(m_pendingVertexSource, m_pendingFragmentSource, program);
+        m_pendingVertexSource.clear();
+        m_pendingFragmentSource.clear();
     }
 
+    // Swap in the new program
+    if(m_shaderID != 0){
+        GLState::Instance().ForgetProgram(m_shaderID);
+        glDeleteProgram(m_shaderID);
+    }
     m_shaderID = program;
+    Reflect();
+    return true;
+}
+
+void Shader::Reflect(){
+    m_uniforms.clear();
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(m_shaderID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_shaderID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+    for(GLint i=0; i < count; ++i){
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_shaderID, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+        GLint location = glGetUniformLocation(m_shaderID, name.c_str());
+        if(location < 0){
+            continue; // Part of a uniform block, which has no location
+        }
+        // Arrays are listed once, as "name[0]"
+        bool isArray = name.size() > 3 && name.compare(name.size()-3, 3, "[0]") == 0;
+        m_uniforms.push_back({UniformHash(name), location, type, name});
+        if(isArray){
+            std::string base = name.substr(0, name.size()-3);
+            m_uniforms.push_back({UniformHash(base), location, type, base});
+            for(GLint element=1; element < size; ++element){
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                m_uniforms.push_back({UniformHash(elementName),
+                                      glGetUniformLocation(m_shaderID, elementName.c_str()),
+                                      type, elementName});
+            }
+        }
+    }
+    std::sort(m_uniforms.begin(), m_uniforms.end(),
+              [](const UniformInfo& a, const UniformInfo& b){ return a.hash < b.hash; });
+
+    // Connect the shared uniform blocks to their buffers' binding points
+    GLint blockCount = 0;
+    glGetProgramiv(m_shaderID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    for(GLint i=0; i < blockCount; ++i){
+        // (The length includes the terminating null)
+        GLint nameLength = 0;
+        glGetActiveUniformBlockiv(m_shaderID, (GLuint)i, GL_UNIFORM_BLOCK_NAME_LENGTH, &nameLength);
+        std::vector<GLchar> blockName(nameLength > 0 ? nameLength : 1);
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(m_shaderID, (GLuint)i, (GLsizei)blockName.size(), &length, blockName.data());
+        GLuint binding = 0;
+        GLint expectedSize = 0;
+        if(!GetUniformBlock(std::string(blockName.data(), length), binding, expectedSize)){
+            Log("Reflect","ERROR, the shader uses a uniform block we do not know about");
+            continue;
+        }
+        // If the GLSL block and the C++ struct disagree, the data would be garbage
+        GLint size = 0;
+        glGetActiveUniformBlockiv(m_shaderID, (GLuint)i, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+        if(size > expectedSize){
+            Log("Reflect","ERROR, a uniform block in the shader does not match its struct in UniformBuffer.hpp");
+        }
+        glUniformBlockBinding(m_shaderID, (GLuint)i, binding);
+    }
+
+    // Point the handles at the new program's locations
+    for(std::size_t i=0; i < m_handleHashes.size(); ++i){
+        m_handleLocations[i] = -1;
+        m_handleTypes[i] = 0;
+        for(const UniformInfo& info : m_uniforms){
+            if(info.hash == m_handleHashes[i]){
+                m_handleLocations[i] = info.location;
+                m_handleTypes[i] = info.type;
+                break;
+            }
+        }
+    }
+
+    // A rebuilt program starts with every uniform at 0, so give it back
+    // the ints (texture slots) that were set once when setting up
+    if(!m_intValues.empty()){
+        GLState::Instance().UseProgram(m_shaderID);
+        for(const std::pair<uint32_t,int>& value : m_intValues){
+            if(m_handleLocations[value.first] >= 0){
+                glUniform1i(m_handleLocations[value.first], value.second);
+            }
+        }
+    }
+}
+
+GLint Shader::GetUniformLocation(std::string_view name) const{
+    uint64_t hash = UniformHash(name);
+    auto found = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), hash,
+                                  [](const UniformInfo& info, uint64_t hash){ return info.hash < hash; });
+    // Two names could share a hash, so compare the name too
+    for(; found != m_uniforms.end() && found->hash == hash; ++found){
+        if(found->name == name){
+            return found->location;
+        }
+    }
+    return -1;
+}
+
+UniformHandle Shader::GetUniform(std::string_view name){
+    return GetUniform(UniformHash(name));
+}
+
+UniformHandle Shader::GetUniform(uint64_t nameHash){
+    for(std::size_t i=0; i < m_handleHashes.size(); ++i){
+        if(m_handleHashes[i] == nameHash){
+            return UniformHandle{(uint32_t)i};
+        }
+    }
+    GLint location = -1;
+    GLenum type = 0;
+    auto found = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), nameHash,
+                                  [](const UniformInfo& info, uint64_t hash){ return info.hash < hash; });
+    if(found != m_uniforms.end() && found->hash == nameHash){
+        location = found->location;
+        type = found->type;
+    }
+    m_handleHashes.push_back(nameHash);
+    m_handleLocations.push_back(location);
+    m_handleTypes.push_back(type);
+    return UniformHandle{(uint32_t)(m_handleHashes.size()-1)};
+}
+
+bool Shader::CheckType(UniformHandle uniform, GLenum type){
+    // Not in the shader, so there is nothing to set
+    if(m_handleLocations[uniform.index] < 0){
+        return false;
+    }
+#ifndef NDEBUG
+    GLenum declared = m_handleTypes[uniform.index];
+    // Samplers are set with an int
+    bool sampler = type == GL_INT && (declared == GL_SAMPLER_2D || declared == GL_SAMPLER_CUBE ||
+                                      declared == GL_SAMPLER_2D_SHADOW);
+    if(declared != 0 && declared != type && !sampler){
+        Log("SetUniform","ERROR, uniform is being set with the wrong type");
+        return false;
+    }
+#else
+    (void)uniform;
+    (void)type;
+#endif
+    return true;
 }
 
 
@@ -120,8 +357,14 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
   // The source of our shader
   glShaderSource(id, 1, &src, nullptr);
   // Now compile our shader
+  // (The result is checked in CheckCompileStatus, once it is needed.)
   glCompileShader(id);
 
+  return id;
+}
+
+// Check to see if compiling was successful
+bool Shader::CheckCompileStatus(GLuint id, GLenum type){
   // Retrieve the result of our compilation
   int result;
   // This code is returning any compilation errors that may have occurred!
@@ -140,12 +383,10 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
       }
       // Reclaim our memory
       delete[] errorMessages;
-      // Delete our broken shader
-      glDeleteShader(id);
-      return 0;
+      return false;
   }
 
-  return id;
+  return true;
 }
 
 // Check to see if linking was successful
@@ -178,30 +419,76 @@ GLuint Shader::GetID() const{
 
 
 // Set our uniforms for our shader.
-void Shader::SetUniformMatrix4fv(const GLchar* name, const GLfloat* value){
-    // Note that we are now 'looking' inside the shader for a particular
-    // variable. This means the name has to exactly match!
-    GLint location = glGetUniformLocation(m_shaderID,name);
-
-    // Now update this information through our uniforms.
+void Shader::SetUniformMatrix4fv(UniformHandle uniform, const GLfloat* value){
     // glUniformMatrix4v means a 4x4 matrix of floats
-    glUniformMatrix4fv(location, 1, GL_FALSE, value);
+    if(CheckType(uniform, GL_FLOAT_MAT4)){
+        glUniformMatrix4fv(m_handleLocations[uniform.index], 1, GL_FALSE, value);
+    }
+}
+
+// Set our uniforms for our shader (Useful for a vec3).
+void Shader::SetUniform3f(UniformHandle uniform, float v0, float v1, float v2){
+    if(CheckType(uniform, GL_FLOAT_VEC3)){
+        glUniform3f(m_handleLocations[uniform.index], v0, v1, v2);
+    }
+}
+
+// Sets 1 int value in our uniform (That is why the suffix is 1i).
+void Shader::RememberInt(UniformHandle uniform, int value){
+    for(std::pair<uint32_t,int>& intValue : m_intValues){
+        if(intValue.first == uniform.index){
+            intValue.second = value;
+            return;
+        }
+    }
+    m_intValues.push_back({uniform.index, value});
+}
+
+void Shader::SetUniform1i(UniformHandle uniform, int value){
+    // Remembered, in case the program is rebuilt
+    RememberInt(uniform, value);
+    if(CheckType(uniform, GL_INT)){
+        glUniform1i(m_handleLocations[uniform.index], value);
+    }
+}
+
+// Sets 1 float value in our uniform (That is why the suffix is 1f).
+void Shader::SetUniform1f(UniformHandle uniform, float value){
+    if(CheckType(uniform, GL_FLOAT)){
+        glUniform1f(m_handleLocations[uniform.index], value);
+    }
+}
+
+// Set our uniforms for our shader, by name.
+// Note that we are now 'looking' inside the shader for a particular
+// variable. This means the name has to exactly match!
+// (The handle is made once, and its type checked like any other.)
+void Shader::SetUniformMatrix4fv(const GLchar* name, const GLfloat* value){
+    SetUniformMatrix4fv(GetUniform(name), value);
 }
 
 // Set our uniforms for our shader (Useful for a vec3).
 void Shader::SetUniform3f(const GLchar* name, float v0, float v1, float v2){
-    GLint location = glGetUniformLocation(m_shaderID,name);
-    glUniform3f(location, v0, v1, v2);
+    SetUniform3f(GetUniform(name), v0, v1, v2);
 }
 
 // Sets 1 int value in our uniform (That is why the suffix is 1i).
 void Shader::SetUniform1i(const GLchar* name, int value){
-    GLint location = glGetUniformLocation(m_shaderID,name);
-    glUniform1i(location, value);
+    SetUniform1i(GetUniform(name), value);
+}
+
+void Shader::SetSampler(const GLchar* name, int slot){
+    UniformHandle uniform = GetUniform(name);
+    if(m_pendingProgram != 0){
+        // Reflect() sets it when the program is finished
+        RememberInt(uniform, slot);
+        return;
+    }
+    GLState::Instance().UseProgram(m_shaderID);
+    SetUniform1i(uniform, slot);
 }
 
 // Sets 1 float value in our uniform (That is why the suffix is 1f).
 void Shader::SetUniform1f(const GLchar* name, float value){
-    GLint location = glGetUniformLocation(m_shaderID,name);
-    glUniform1f(location, value);
+    SetUniform1f(GetUniform(name), value);
 }
@@ -0,0 +1,122 @@
+#include "ShaderPreprocessor.hpp"
+#include "VirtualFileSystem.hpp"
+
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+
+ShaderDefines& ShaderDefines::Set(const std::string& name, const std::string& value){
+    auto found = std::lower_bound(values.begin(), values.end(), name,
+                                  [](const std::pair<std::string,std::string>& define, const std::string& name){
+                                      return define.first < name;
+                                  });
+    if(found != values.end() && found->first == name){
+        found->second = value;
+    }else{
+        values.insert(found, {name, value});
+    }
+    return *this;
+}
+
+ShaderDefines& ShaderDefines::Set(const std::string& name, int value){
+    return Set(name, std::to_string(value));
+}
+
+std::string ShaderDefines::GetKey() const{
+    std::string key;
+    for(const std::pair<std::string,std::string>& define : values){
+        key += define.first + "=" + define.second + ";";
+    }
+    return key;
+}
+
+// Tells the compiler where the next line came from
+static std::string LineDirective(int line, std::size_t file){
+    return "#line " + std::to_string(line) + " " + std::to_string(file) + "\n";
+}
+
+// The text after any spaces at the start of a line
+static std::string_view TrimStart(std::string_view line){
+    std::size_t start = line.find_first_not_of(" \t");
+    return start == std::string_view::npos ? std::string_view() : line.substr(start);
+}
+
+// Appends 'path' to 'output', pasting in its #includes. 'defines' is only
+// given for the shader itself, not the files it includes.
+static void AppendFile(const std::string& path, const ShaderDefines* defines,
+                       std::vector<std::string>& files, std::string& output){
+    std::string source;
+    if(!VirtualFileSystem::Instance().ReadFile(path, source)){
+        std::cout << "PreprocessShader: missing file " << path << std::endl;
+        return;
+    }
+    std::size_t fileIndex = files.size();
+    files.push_back(path);
+
+    std::string defineLines;
+    if(defines != nullptr){
+        for(const std::pair<std::string,std::string>& define : defines->values){
+            defineLines += "#define " + define.first + " " + define.second + "\n";
+        }
+        // Without a #version they can go first
+        if(source.find("#version") == std::string::npos){
+            output += defineLines + LineDirective(1, fileIndex);
+            defineLines.clear();
+        }
+    }
+
+    int lineNumber = 1;
+    std::size_t start = 0;
+    while(start < source.size()){
+        std::size_t end = source.find('\n', start);
+        if(end == std::string::npos){
+            end = source.size();
+        }
+        std::string_view line(source.data()+start, end-start);
+        std::string_view directive = TrimStart(line);
+
+        if(directive.rfind("#include", 0) == 0){
+            std::size_t open = directive.find('"');
+            std::size_t close = open == std::string_view::npos ? open : directive.find('"', open+1);
+            if(close == std::string_view::npos){
+                std::cout << "PreprocessShader: expected #include \"file\" in " << path << " line " << lineNumber << std::endl;
+            }else{
+                // Relative to the file including it
+                std::filesystem::path included = std::filesystem::path(path).parent_path() /
+                                                 std::string(directive.substr(open+1, close-open-1));
+                std::string includedPath = included.lexically_normal().generic_string();
+                bool seen = std::any_of(files.begin(), files.end(), [&](const std::string& file){
+                    return std::filesystem::path(file).lexically_normal().generic_string() == includedPath;
+                });
+                if(!seen){
+                    output += LineDirective(1, files.size());
+                    AppendFile(includedPath, nullptr, files, output);
+                }
+            }
+            output += LineDirective(lineNumber+1, fileIndex);
+        }else{
+            output.append(line);
+            output += '\n';
+            if(!defineLines.empty() && directive.rfind("#version", 0) == 0){
+                output += defineLines + LineDirective(lineNumber+1, fileIndex);
+                defineLines.clear();
+            }
+        }
+        start = end+1;
+        ++lineNumber;
+    }
+}
+
+std::string PreprocessShader(const std::string& path, const ShaderDefines& defines,
+                             std::vector<std::string>* files){
+    std::vector<std::string> read;
+    std::string output;
+    AppendFile(path, &defines, read, output);
+    if(read.empty()){
+        return "";
+    }
+    if(files != nullptr){
+        *files = std::move(read);
+    }
+    return output;
+}
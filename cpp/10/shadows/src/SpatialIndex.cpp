@@ -0,0 +1,559 @@
+#include "SpatialIndex.hpp"
+#include "JobSystem.hpp"
+
+#include "glm/geometric.hpp"
+#include "glm/common.hpp"
+#include "glm/vec2.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+// Cells' coordinates are packed into 64 bit keys, 20 bits per axis (and
+// the level, for the octree)
+static constexpr uint32_t MAX_DEPTH = 20;
+static constexpr uint32_t COORDINATE_BITS = 20;
+static constexpr uint64_t COORDINATE_MASK = (1ull << COORDINATE_BITS) - 1;
+// MoveMany() splits its objects into jobs of this many
+static constexpr uint32_t MOVE_JOB_SIZE = 8192;
+
+// A ray, with what the box tests need worked out once
+struct Ray{
+    glm::vec3 origin;
+    glm::vec3 direction;
+    glm::vec3 inverse;
+    float length;
+};
+
+static Ray MakeRay(const glm::vec3& origin, const glm::vec3& direction, float length){
+    Ray ray{origin, direction, glm::vec3(0.0f), length};
+    for(int axis=0; axis < 3; ++axis){
+        ray.inverse[axis] = direction[axis] != 0.0f ? 1.0f/direction[axis] : std::numeric_limits<float>::infinity();
+    }
+    return ray;
+}
+
+static bool Touches(const Ray& ray, const glm::vec3& center, const glm::vec3& extent){
+    float enter = 0.0f, leave = ray.length;
+    for(int axis=0; axis < 3; ++axis){
+        float offset = center[axis] - ray.origin[axis];
+        if(ray.direction[axis] == 0.0f){
+            if(std::abs(offset) > extent[axis]){
+                return false;
+            }
+            continue;
+        }
+        float t0 = (offset - extent[axis])*ray.inverse[axis];
+        float t1 = (offset + extent[axis])*ray.inverse[axis];
+        enter = std::max(enter, std::min(t0, t1));
+        leave = std::min(leave, std::max(t0, t1));
+    }
+    return enter <= leave;
+}
+
+static bool Touches(const glm::vec3& sphereCenter, float radius, const glm::vec3& center, const glm::vec3& extent){
+    glm::vec3 outside = glm::max(glm::abs(sphereCenter - center) - extent, glm::vec3(0.0f));
+    return glm::dot(outside, outside) <= radius*radius;
+}
+
+// Calls work(begin, end) over [0, count), split into jobs on the JobSystem
+// when there is enough of it
+template<typename Work>
+static void ForEachRange(uint32_t count, const Work& work){
+    if(count <= MOVE_JOB_SIZE){
+        work(0, count);
+        return;
+    }
+    std::vector<JobHandle> jobs;
+    for(uint32_t begin=0; begin < count; begin += MOVE_JOB_SIZE){
+        uint32_t end = std::min(count, begin + MOVE_JOB_SIZE);
+        jobs.push_back(JobSystem::Instance().Submit([&work, begin, end](){
+            work(begin, end);
+        }));
+    }
+    for(const JobHandle& job : jobs){
+        JobSystem::Instance().Wait(job);
+    }
+}
+
+/*** LooseOctree ***/
+
+LooseOctree::LooseOctree(const glm::vec3& center, float halfSize, uint32_t depth)
+    : m_min(center - glm::vec3(halfSize)), m_size(halfSize*2.0f), m_depth(std::min(depth, MAX_DEPTH)){
+    Node root;
+    std::fill(root.children, root.children+8, NONE);
+    root.parent = NONE;
+    root.count = 0;
+    root.center = center;
+    root.looseHalfSize = m_size;
+    m_nodes.push_back(root);
+}
+
+uint64_t LooseOctree::CellOf(const glm::vec3& center, const glm::vec3& extent) const{
+    glm::vec3 local = (center - m_min)/m_size;
+    if(!(local.x >= 0.0f && local.x < 1.0f && local.y >= 0.0f && local.y < 1.0f && local.z >= 0.0f && local.z < 1.0f)){
+        // Outside (or not a number): the root
+        return 0;
+    }
+    // The deepest level whose cells are at least as wide as the object
+    float size = 2.0f*std::max(extent.x, std::max(extent.y, extent.z));
+    uint32_t level = m_depth;
+    if(size > 0.0f){
+        float levels = std::floor(std::log2(m_size/size));
+        level = levels < 0.0f ? 0 : std::min(m_depth, (uint32_t)levels);
+        while(level > 0 && std::ldexp(m_size, -(int)level) < size){
+            --level;
+        }
+    }
+    uint32_t cells = 1u << level;
+    uint64_t x = std::min<uint32_t>(local.x*cells, cells-1);
+    uint64_t y = std::min<uint32_t>(local.y*cells, cells-1);
+    uint64_t z = std::min<uint32_t>(local.z*cells, cells-1);
+    return (uint64_t)level << (3*COORDINATE_BITS) | x << (2*COORDINATE_BITS) | y << COORDINATE_BITS | z;
+}
+
+void LooseOctree::Link(uint32_t object){
+    uint64_t cell = m_entries[object].cell;
+    uint32_t level = cell >> (3*COORDINATE_BITS);
+    uint32_t x = (cell >> (2*COORDINATE_BITS)) & COORDINATE_MASK;
+    uint32_t y = (cell >> COORDINATE_BITS) & COORDINATE_MASK;
+    uint32_t z = cell & COORDINATE_MASK;
+
+    uint32_t node = 0;
+    ++m_nodes[0].count;
+    for(uint32_t depth=1; depth <= level; ++depth){
+        uint32_t shift = level - depth;
+        uint32_t child = ((x >> shift) & 1) | ((y >> shift) & 1) << 1 | ((z >> shift) & 1) << 2;
+        uint32_t next = m_nodes[node].children[child];
+        if(next == NONE){
+            if(m_freeNodes.empty()){
+                next = m_nodes.size();
+                m_nodes.emplace_back();
+            }else{
+                next = m_freeNodes.back();
+                m_freeNodes.pop_back();
+            }
+            Node& created = m_nodes[next];
+            float cellSize = std::ldexp(m_size, -(int)depth);
+            std::fill(created.children, created.children+8, NONE);
+            created.parent = node;
+            created.count = 0;
+            created.center = m_min + (glm::vec3(x >> shift, y >> shift, z >> shift) + 0.5f)*cellSize;
+            created.looseHalfSize = cellSize;
+            m_nodes[node].children[child] = next;
+        }
+        node = next;
+        ++m_nodes[node].count;
+    }
+    Entry& entry = m_entries[object];
+    entry.node = node;
+    entry.slot = m_nodes[node].objects.size();
+    m_nodes[node].objects.push_back(object);
+}
+
+void LooseOctree::Unlink(uint32_t object){
+    const Entry& entry = m_entries[object];
+    std::vector<uint32_t>& objects = m_nodes[entry.node].objects;
+    uint32_t last = objects.back();
+    objects[entry.slot] = last;
+    m_entries[last].slot = entry.slot;
+    objects.pop_back();
+
+    for(uint32_t node = entry.node; node != NONE;){
+        Node& current = m_nodes[node];
+        uint32_t parent = current.parent;
+        if(--current.count == 0 && node != 0){
+            // Its children were freed as they emptied, before it
+            uint32_t* children = m_nodes[parent].children;
+            *std::find(children, children+8, node) = NONE;
+            m_freeNodes.push_back(node);
+        }
+        node = parent;
+    }
+}
+
+SpatialHandle LooseOctree::Insert(const glm::vec3& center, const glm::vec3& extent){
+    uint32_t object;
+    if(m_freeEntries.empty()){
+        object = m_entries.size();
+        m_entries.emplace_back();
+    }else{
+        object = m_freeEntries.back();
+        m_freeEntries.pop_back();
+    }
+    Entry& entry = m_entries[object];
+    entry.center = center;
+    entry.extent = extent;
+    entry.cell = CellOf(center, extent);
+    Link(object);
+    ++m_count;
+    return SpatialHandle{object};
+}
+
+void LooseOctree::Move(SpatialHandle object, const glm::vec3& center, const glm::vec3& extent){
+    Entry& entry = m_entries[object.index];
+    entry.center = center;
+    entry.extent = extent;
+    uint64_t cell = CellOf(center, extent);
+    if(cell != entry.cell){
+        Unlink(object.index);
+        entry.cell = cell;
+        Link(object.index);
+    }
+}
+
+void LooseOctree::Remove(SpatialHandle object){
+    Unlink(object.index);
+    m_entries[object.index].node = NONE;
+    m_freeEntries.push_back(object.index);
+    --m_count;
+}
+
+void LooseOctree::MoveMany(uint32_t count, const SpatialHandle* objects, const glm::vec3* centers, const glm::vec3* extents){
+    // The new boxes and cells as jobs (each writes only its own objects),
+    // then the objects that changed cell are moved one after the other
+    m_newCells.resize(count);
+    ForEachRange(count, [&](uint32_t begin, uint32_t end){
+        for(uint32_t i=begin; i < end; ++i){
+            Entry& entry = m_entries[objects[i].index];
+            entry.center = centers[i];
+            entry.extent = extents[i];
+            m_newCells[i] = CellOf(centers[i], extents[i]);
+        }
+    });
+    for(uint32_t i=0; i < count; ++i){
+        Entry& entry = m_entries[objects[i].index];
+        if(m_newCells[i] != entry.cell){
+            Unlink(objects[i].index);
+            entry.cell = m_newCells[i];
+            Link(objects[i].index);
+        }
+    }
+}
+
+template<typename Test>
+void LooseOctree::Query(const Test& test, std::vector<SpatialHandle>& results) const{
+    results.clear();
+    // Each node visited puts at most 8 children on the stack, and takes
+    // itself off
+    uint32_t stack[8*(MAX_DEPTH+1)];
+    uint32_t size = 0;
+    // The root holds what is outside the cube too, so it is not tested
+    stack[size++] = 0;
+    while(size > 0){
+        const Node& node = m_nodes[stack[--size]];
+        for(uint32_t object : node.objects){
+            const Entry& entry = m_entries[object];
+            if(test(entry.center, entry.extent)){
+                results.push_back(SpatialHandle{object});
+            }
+        }
+        for(uint32_t child : node.children){
+            if(child != NONE && test(m_nodes[child].center, glm::vec3(m_nodes[child].looseHalfSize))){
+                stack[size++] = child;
+            }
+        }
+    }
+}
+
+void LooseOctree::QueryFrustum(const Frustum& frustum, std::vector<SpatialHandle>& results) const{
+    Query([&frustum](const glm::vec3& center, const glm::vec3& extent){
+        return frustum.IsVisible(center, extent);
+    }, results);
+}
+
+void LooseOctree::QuerySphere(const glm::vec3& center, float radius, std::vector<SpatialHandle>& results) const{
+    Query([&center, radius](const glm::vec3& boxCenter, const glm::vec3& extent){
+        return Touches(center, radius, boxCenter, extent);
+    }, results);
+}
+
+void LooseOctree::QueryRay(const glm::vec3& origin, const glm::vec3& direction, float length,
+                           std::vector<SpatialHandle>& results) const{
+    Ray ray = MakeRay(origin, direction, length);
+    Query([&ray](const glm::vec3& center, const glm::vec3& extent){
+        return Touches(ray, center, extent);
+    }, results);
+}
+
+/*** HashGrid ***/
+
+// Coordinates are kept within what a key holds, around 0
+static constexpr int32_t COORDINATE_OFFSET = 1 << (COORDINATE_BITS-1);
+
+static uint64_t Key(int32_t x, int32_t y, int32_t z){
+    auto pack = [](int32_t coordinate){
+        return (uint64_t)(std::clamp(coordinate, -COORDINATE_OFFSET, COORDINATE_OFFSET-1) + COORDINATE_OFFSET);
+    };
+    return pack(x) << (2*COORDINATE_BITS) | pack(y) << COORDINATE_BITS | pack(z);
+}
+
+static glm::ivec3 Coordinates(uint64_t key){
+    return glm::ivec3((int32_t)((key >> (2*COORDINATE_BITS)) & COORDINATE_MASK) - COORDINATE_OFFSET,
+                      (int32_t)((key >> COORDINATE_BITS) & COORDINATE_MASK) - COORDINATE_OFFSET,
+                      (int32_t)(key & COORDINATE_MASK) - COORDINATE_OFFSET);
+}
+
+HashGrid::HashGrid(float cellSize) : m_cellSize(cellSize){
+}
+
+uint64_t HashGrid::CellOf(const glm::vec3& point) const{
+    glm::vec3 cell = glm::floor(point/m_cellSize);
+    // Clamped as floats first, as a far away point would not fit an int
+    cell = glm::clamp(cell, glm::vec3(-COORDINATE_OFFSET), glm::vec3(COORDINATE_OFFSET-1));
+    return Key(cell.x, cell.y, cell.z);
+}
+
+void HashGrid::Link(const CellObject& object){
+    Entry& entry = m_entries[object.object];
+    auto found = m_cellIndex.try_emplace(entry.cell, m_cells.size());
+    if(found.second){
+        m_cells.push_back(Cell{entry.cell, {}, 0});
+        m_cellLow = glm::min(m_cellLow, Coordinates(entry.cell));
+        m_cellHigh = glm::max(m_cellHigh, Coordinates(entry.cell));
+    }
+    Cell& cell = m_cells[found.first->second];
+    entry.cellIndex = found.first->second;
+    entry.slot = cell.objects.size();
+    cell.objects.push_back(object);
+    m_maxExtent = glm::max(m_maxExtent, object.extent);
+}
+
+void HashGrid::Unlink(uint32_t object){
+    const Entry& entry = m_entries[object];
+    uint32_t index = entry.cellIndex;
+    Cell& cell = m_cells[index];
+    cell.objects[entry.slot] = cell.objects.back();
+    m_entries[cell.objects[entry.slot].object].slot = entry.slot;
+    cell.objects.pop_back();
+    if(cell.objects.empty()){
+        // The last cell takes its place
+        m_cellIndex.erase(cell.key);
+        if(index != m_cells.size()-1){
+            m_cells[index] = std::move(m_cells.back());
+            m_cellIndex[m_cells[index].key] = index;
+            for(const CellObject& moved : m_cells[index].objects){
+                m_entries[moved.object].cellIndex = index;
+            }
+        }
+        m_cells.pop_back();
+    }
+}
+
+SpatialHandle HashGrid::Insert(const glm::vec3& center, const glm::vec3& extent){
+    uint32_t object;
+    if(m_freeEntries.empty()){
+        object = m_entries.size();
+        m_entries.emplace_back();
+    }else{
+        object = m_freeEntries.back();
+        m_freeEntries.pop_back();
+    }
+    Entry& entry = m_entries[object];
+    entry.cell = CellOf(center);
+    entry.used = true;
+    Link(CellObject{center, extent, object});
+    ++m_count;
+    return SpatialHandle{object};
+}
+
+void HashGrid::Move(SpatialHandle object, const glm::vec3& center, const glm::vec3& extent){
+    Entry& entry = m_entries[object.index];
+    uint64_t cell = CellOf(center);
+    if(cell != entry.cell){
+        Unlink(object.index);
+        entry.cell = cell;
+        Link(CellObject{center, extent, object.index});
+    }else{
+        m_cells[entry.cellIndex].objects[entry.slot] = CellObject{center, extent, object.index};
+        m_maxExtent = glm::max(m_maxExtent, extent);
+    }
+}
+
+void HashGrid::Remove(SpatialHandle object){
+    Unlink(object.index);
+    m_entries[object.index].used = false;
+    m_freeEntries.push_back(object.index);
+    --m_count;
+}
+
+void HashGrid::MoveMany(uint32_t count, const SpatialHandle* objects, const glm::vec3* centers, const glm::vec3* extents){
+    // Those that stay in their cells are updated where they are (no two
+    // share a slot), the others are moved after
+    m_newCells.resize(count);
+    ForEachRange(count, [&](uint32_t begin, uint32_t end){
+        for(uint32_t i=begin; i < end; ++i){
+            const Entry& entry = m_entries[objects[i].index];
+            m_newCells[i] = CellOf(centers[i]);
+            if(m_newCells[i] == entry.cell){
+                m_cells[entry.cellIndex].objects[entry.slot] = CellObject{centers[i], extents[i], objects[i].index};
+            }
+        }
+    });
+    for(uint32_t i=0; i < count; ++i){
+        Entry& entry = m_entries[objects[i].index];
+        m_maxExtent = glm::max(m_maxExtent, extents[i]);
+        if(m_newCells[i] != entry.cell){
+            Unlink(objects[i].index);
+            entry.cell = m_newCells[i];
+            Link(CellObject{centers[i], extents[i], objects[i].index});
+        }
+    }
+}
+
+template<typename Test>
+void HashGrid::TestCell(const Cell& cell, const Test& test, std::vector<SpatialHandle>& results) const{
+    for(const CellObject& object : cell.objects){
+        if(test(object.center, object.extent)){
+            results.push_back(SpatialHandle{object.object});
+        }
+    }
+}
+
+template<typename Test>
+void HashGrid::QueryCell(uint64_t key, const Test& test, std::vector<SpatialHandle>& results) const{
+    auto found = m_cellIndex.find(key);
+    if(found == m_cellIndex.end()){
+        return;
+    }
+    const Cell& cell = m_cells[found->second];
+    if(cell.query == m_query){
+        return;
+    }
+    cell.query = m_query;
+    TestCell(cell, test, results);
+}
+
+void HashGrid::QueryFrustum(const Frustum& frustum, std::vector<SpatialHandle>& results) const{
+    results.clear();
+    auto test = [&frustum](const glm::vec3& center, const glm::vec3& extent){
+        return frustum.IsVisible(center, extent);
+    };
+    glm::vec3 reach = glm::vec3(m_cellSize*0.5f) + m_maxExtent;
+    // The cells whose objects may reach the box around the frustum, and
+    // that are within the ones that have held objects
+    glm::vec3 boundsMin, boundsMax;
+    glm::vec3 cells(INFINITY);
+    glm::ivec3 low(0), high(-1);
+    if(m_count > 0 && frustum.GetBounds(boundsMin, boundsMax)){
+        glm::vec3 lowCell = glm::clamp(glm::floor((boundsMin - m_maxExtent)/m_cellSize),
+                                       glm::vec3(m_cellLow), glm::vec3(m_cellHigh) + 1.0f);
+        glm::vec3 highCell = glm::clamp(glm::floor((boundsMax + m_maxExtent)/m_cellSize),
+                                        glm::vec3(m_cellLow) - 1.0f, glm::vec3(m_cellHigh));
+        low = glm::ivec3(lowCell);
+        high = glm::ivec3(highCell);
+        cells = glm::max(highCell - lowCell + 1.0f, glm::vec3(0.0f));
+    }
+    if(cells.x*cells.y*cells.z > m_cells.size()){
+        // Fewer cells hold something than there are to look up, so test
+        // each of those, as a box as big as its objects may reach
+        for(const Cell& cell : m_cells){
+            if(test((glm::vec3(Coordinates(cell.key)) + 0.5f)*m_cellSize, reach)){
+                TestCell(cell, test, results);
+            }
+        }
+        return;
+    }
+    // Each column of cells along z is tested first, then its cells
+    ++m_query;
+    float columnCenter = (low.z + high.z + 1)*0.5f*m_cellSize;
+    glm::vec3 columnReach(reach.x, reach.y, (high.z - low.z + 1)*0.5f*m_cellSize + m_maxExtent.z);
+    for(int32_t x=low.x; x <= high.x; ++x){
+        for(int32_t y=low.y; y <= high.y; ++y){
+            glm::vec2 cellXY = (glm::vec2(x, y) + 0.5f)*m_cellSize;
+            if(!test(glm::vec3(cellXY, columnCenter), columnReach)){
+                continue;
+            }
+            for(int32_t z=low.z; z <= high.z; ++z){
+                if(test(glm::vec3(cellXY, (z + 0.5f)*m_cellSize), reach)){
+                    QueryCell(Key(x, y, z), test, results);
+                }
+            }
+        }
+    }
+}
+
+void HashGrid::QuerySphere(const glm::vec3& center, float radius, std::vector<SpatialHandle>& results) const{
+    results.clear();
+    auto test = [&center, radius](const glm::vec3& boxCenter, const glm::vec3& extent){
+        return Touches(center, radius, boxCenter, extent);
+    };
+    // The cells whose objects may reach the sphere
+    glm::vec3 low = glm::floor((center - radius - m_maxExtent)/m_cellSize);
+    glm::vec3 high = glm::floor((center + radius + m_maxExtent)/m_cellSize);
+    glm::vec3 cells = high - low + 1.0f;
+    if(cells.x*cells.y*cells.z > m_cells.size()){
+        // Fewer cells hold something than there are to look up
+        glm::vec3 reach = glm::vec3(m_cellSize*0.5f) + m_maxExtent;
+        for(const Cell& cell : m_cells){
+            if(test((glm::vec3(Coordinates(cell.key)) + 0.5f)*m_cellSize, reach)){
+                TestCell(cell, test, results);
+            }
+        }
+        return;
+    }
+    ++m_query;
+    for(int32_t x=low.x; x <= (int32_t)high.x; ++x){
+        for(int32_t y=low.y; y <= (int32_t)high.y; ++y){
+            for(int32_t z=low.z; z <= (int32_t)high.z; ++z){
+                QueryCell(Key(x, y, z), test, results);
+            }
+        }
+    }
+}
+
+void HashGrid::QueryRay(const glm::vec3& origin, const glm::vec3& direction, float length,
+                        std::vector<SpatialHandle>& results) const{
+    results.clear();
+    Ray ray = MakeRay(origin, direction, length);
+    auto test = [&ray](const glm::vec3& center, const glm::vec3& extent){
+        return Touches(ray, center, extent);
+    };
+    // Objects reach this many cells out of their own, so the cells around
+    // each one the ray passes through are looked at too
+    int32_t around = std::ceil(std::max(m_maxExtent.x, std::max(m_maxExtent.y, m_maxExtent.z))/m_cellSize);
+    uint32_t perStep = (2*around+1)*(2*around+1)*(2*around+1);
+    if(perStep > m_cells.size() || around > 4){
+        glm::vec3 reach = glm::vec3(m_cellSize*0.5f) + m_maxExtent;
+        for(const Cell& cell : m_cells){
+            if(test((glm::vec3(Coordinates(cell.key)) + 0.5f)*m_cellSize, reach)){
+                TestCell(cell, test, results);
+            }
+        }
+        return;
+    }
+
+    // Steps from cell to cell along the ray: t is how far along it is,
+    // and next[axis] the t where it crosses into the next cell on that axis
+    ++m_query;
+    glm::ivec3 cell = glm::floor(origin/m_cellSize);
+    glm::ivec3 step(0);
+    glm::vec3 next(std::numeric_limits<float>::infinity());
+    glm::vec3 across(std::numeric_limits<float>::infinity());
+    for(int axis=0; axis < 3; ++axis){
+        if(direction[axis] > 0.0f){
+            step[axis] = 1;
+            next[axis] = ((cell[axis]+1)*m_cellSize - origin[axis])*ray.inverse[axis];
+            across[axis] = m_cellSize*ray.inverse[axis];
+        }else if(direction[axis] < 0.0f){
+            step[axis] = -1;
+            next[axis] = (cell[axis]*m_cellSize - origin[axis])*ray.inverse[axis];
+            across[axis] = -m_cellSize*ray.inverse[axis];
+        }
+    }
+    while(true){
+        for(int32_t x=-around; x <= around; ++x){
+            for(int32_t y=-around; y <= around; ++y){
+                for(int32_t z=-around; z <= around; ++z){
+                    QueryCell(Key(cell.x+x, cell.y+y, cell.z+z), test, results);
+                }
+            }
+        }
+        int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+        if(!(next[axis] <= length)){
+            break;
+        }
+        cell[axis] += step[axis];
+        next[axis] += across[axis];
+    }
+}
@@ -6,6 +6,7 @@
 
 
 #include "Texture.hpp"
+#include "GLState.hpp"
 
 #include <stdio.h>
 #include <string.h>
@@ -29,6 +30,7 @@ Texture::Texture(std::string file){
 // Default Destructor
 Texture::~Texture(){
 	// Delete our texture from the GPU
+	GLState::Instance().ForgetTexture(m_textureID);
 	glDeleteTextures(1,&m_textureID);
 
     // Delete our image
@@ -45,14 +47,19 @@ void Texture::LoadTexture(const std::string filepath){
     // This method loads .ppm files of pixel data
     m_image = new Image(filepath);
     m_image->LoadPPM(true);
+    Upload(*m_image);
+}
 
-    glEnable(GL_TEXTURE_2D); 
+void Texture::Upload(Image& image){
 	// Generate a buffer for our texture
-    glGenTextures(1,&m_textureID);
+    // (A new one even when reloading, the old one is
+    //  swapped out once the new one is complete.)
+    GLuint textureID = 0;
+    glGenTextures(1,&textureID);
     // Similar to our vertex buffers, we now 'select'
     // a texture we want to bind to.
     // Note the type of data is 'GL_TEXTURE_2D'
-    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    GLState::Instance().BindTexture(0, textureID);
 	// Now we are going to setup some information about
 	// our textures.
 	// There are four parameters that must be set.
@@ -67,17 +74,24 @@ void Texture::LoadTexture(const std::string filepath){
 	glTexImage2D(GL_TEXTURE_2D,
 							0 ,
 						GL_RGB,
-                        m_image->GetWidth(),
-                        m_image->GetHeight(),
+                        image.GetWidth(),
+                        image.GetHeight(),
 						0,
 						GL_RGB,
 						GL_UNSIGNED_BYTE,
-						 m_image->GetPixelDataPtr()); // Here is the raw pixel data
+						 image.GetPixelDataPtr()); // Here is the raw pixel data
     // We are done with our texture data so we can unbind.
     // Generate a mipmap
     glGenerateMipmap(GL_TEXTURE_2D);                        
 	// We are done with our texture data so we can unbind.    
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::Instance().BindTexture(0, 0);
+
+    // Swap in the new texture
+    if(m_textureID != 0){
+        GLState::Instance().ForgetTexture(m_textureID);
+        glDeleteTextures(1,&m_textureID);
+    }
+    m_textureID = textureID;
 }
 
 
@@ -90,13 +104,13 @@ void Texture::Bind(unsigned int slot) const{
 	// be multiple at once.
 	// At the time of writing, OpenGL supports 8-32 depending
 	// on your hardware.
-    glEnable(GL_TEXTURE_2D);
-	glActiveTexture(GL_TEXTURE0+slot);
-	glBindTexture(GL_TEXTURE_2D, m_textureID);
+	// (Nothing is called if the texture is already bound to the slot, and
+	//  the active slot only changes when something has to be bound.)
+	GLState::Instance().BindTexture(slot, m_textureID);
 }
 
-void Texture::Unbind(){
-	glBindTexture(GL_TEXTURE_2D, 0);
+void Texture::Unbind(unsigned int slot){
+	GLState::Instance().BindTexture(slot, 0);
 }
 
 
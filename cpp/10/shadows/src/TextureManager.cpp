@@ -0,0 +1,64 @@
+#include "TextureManager.hpp"
+#include "UploadQueue.hpp"
+#include "Image.hpp"
+#include "FileWatcher.hpp"
+
+#include <chrono>
+
+std::shared_ptr<Texture> TextureManager::GetTextureAsync(const std::string& filepath, JobHandle& job){
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto found = m_textures.find(filepath);
+	if(found != m_textures.end()){
+		job = m_jobs[filepath];
+		return found->second;
+	}
+	std::shared_ptr<Texture> texture = nullptr;
+	job = nullptr;
+	if(filepath.size() > 4 && filepath.compare(filepath.size()-4, 4, ".ppm")==0){
+		texture = std::make_shared<Texture>();
+		job = JobSystem::Instance().Submit([texture, filepath](){
+			// Reading and decoding the file happens here, on a worker...
+			std::shared_ptr<Image> image = std::make_shared<Image>(filepath);
+			image->LoadPPM(true);
+			// ...and only the OpenGL part on the render thread
+			UploadQueue::Instance().Push([texture, image](){
+				texture->Upload(*image);
+			});
+		});
+	}else{
+		std::cout << "Error, unable to load texture (only .ppm is supported): " << filepath << std::endl;
+	}
+	// Failures are remembered too, so we only report them once
+	m_textures[filepath] = texture;
+	m_jobs[filepath] = job;
+	if(texture != nullptr){
+		FileWatcher::Instance().Watch(filepath, this, [this, filepath](){ ReloadTexture(filepath); });
+	}
+	return texture;
+}
+
+void TextureManager::ReloadTexture(const std::string& filepath){
+	std::shared_ptr<Texture> texture;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		texture = m_textures[filepath];
+	}
+	if(texture == nullptr){
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+	JobSystem::Instance().Submit([texture, filepath, start](){
+		std::shared_ptr<Image> image = std::make_shared<Image>(filepath);
+		image->LoadPPM(true);
+		UploadQueue::Instance().Push([texture, image, filepath, start](){
+			texture->Upload(*image);
+			double ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+			std::cout << "TextureManager: reloaded " << filepath << " in " << ms << " ms" << std::endl;
+		});
+	});
+}
+
+void TextureManager::ExecuteUploads(const std::shared_ptr<Texture>& texture){
+	while(!texture->IsReady() && UploadQueue::Instance().Execute(0.0) > 0){
+	}
+}
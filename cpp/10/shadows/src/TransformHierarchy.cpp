@@ -0,0 +1,421 @@
+#include "TransformHierarchy.hpp"
+#include "JobSystem.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+// The extent of a node without bounds: big enough to reach into any
+// frustum, small enough to stay finite once scaled
+static const float UNBOUNDED = 1e30f;
+
+TransformHierarchy::TransformHierarchy(){
+}
+
+TransformHierarchy::~TransformHierarchy(){
+}
+
+TransformHandle TransformHierarchy::Create(TransformHandle parent){
+    uint32_t slot = m_parent.size();
+    uint32_t parentSlot = parent.IsValid() ? Slot(parent) : NONE;
+    TransformHandle node;
+    node.index = m_slot.size();
+    m_slot.push_back(slot);
+    m_handle.push_back(node.index);
+    m_parent.push_back(parentSlot);
+    m_subtreeSize.push_back(1);
+    m_position.push_back(glm::vec3(0.0f));
+    m_rotation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    m_scale.push_back(glm::vec3(1.0f));
+    m_world.push_back(glm::mat4(1.0f));
+    m_boundsCenter.push_back(glm::vec3(0.0f));
+    m_boundsExtent.push_back(glm::vec3(UNBOUNDED));
+    for(int axis=0; axis < 3; ++axis){
+        m_worldCenter[axis].push_back(0.0f);
+        m_worldExtent[axis].push_back(UNBOUNDED);
+    }
+    m_visible.push_back(1);
+    m_dirty.push_back(1);
+    m_rangesValid = false;
+
+    // Still in depth first order if the parent's subtree ends at the back
+    // of the arrays (e.g. when a tree is built depth first, or for a root)
+    if(m_sorted && parentSlot != NONE){
+        if(parentSlot + m_subtreeSize[parentSlot] == slot){
+            for(uint32_t ancestor = parentSlot; ancestor != NONE; ancestor = m_parent[ancestor]){
+                m_subtreeSize[ancestor]++;
+            }
+        }else{
+            m_sorted = false;
+        }
+    }
+    return node;
+}
+
+TransformHierarchy::NodeArrays TransformHierarchy::GetNodeArrays(){
+    Sort();
+    NodeArrays nodes;
+    nodes.count = m_parent.size();
+    nodes.parent = m_parent.data();
+    nodes.position = m_position.data();
+    nodes.rotation = m_rotation.data();
+    nodes.scale = m_scale.data();
+    nodes.boundsCenter = m_boundsCenter.data();
+    nodes.boundsExtent = m_boundsExtent.data();
+    return nodes;
+}
+
+// The new nodes go at the back of the arrays, their parents before them,
+// so the arrays stay in depth first order if they were, and the new
+// nodes are
+TransformHandle TransformHierarchy::Append(const NodeArrays& nodes){
+    uint32_t first = m_parent.size();
+    uint32_t end = first + nodes.count;
+    TransformHandle firstNode;
+    firstNode.index = m_slot.size();
+
+    m_parent.insert(m_parent.end(), nodes.parent, nodes.parent + nodes.count);
+    for(uint32_t i=first; i < end; ++i){
+        if(m_parent[i] != NONE){
+            m_parent[i] += first;
+        }
+    }
+    m_subtreeSize.resize(end, 1);
+    for(uint32_t i=end; i-- > first;){
+        if(m_parent[i] != NONE){
+            m_subtreeSize[m_parent[i]] += m_subtreeSize[i];
+        }
+    }
+    m_position.insert(m_position.end(), nodes.position, nodes.position + nodes.count);
+    m_rotation.insert(m_rotation.end(), nodes.rotation, nodes.rotation + nodes.count);
+    m_scale.insert(m_scale.end(), nodes.scale, nodes.scale + nodes.count);
+    m_world.resize(end, glm::mat4(1.0f));
+    m_boundsCenter.insert(m_boundsCenter.end(), nodes.boundsCenter, nodes.boundsCenter + nodes.count);
+    m_boundsExtent.insert(m_boundsExtent.end(), nodes.boundsExtent, nodes.boundsExtent + nodes.count);
+    // Worked out by the next update, as every new node is dirty
+    for(int axis=0; axis < 3; ++axis){
+        m_worldCenter[axis].resize(end, 0.0f);
+        m_worldExtent[axis].resize(end, UNBOUNDED);
+    }
+    m_visible.resize(end, 1);
+    m_dirty.resize(end, 1);
+    m_slot.reserve(m_slot.size() + nodes.count);
+    m_handle.reserve(end);
+    for(uint32_t i=0; i < nodes.count; ++i){
+        m_slot.push_back(first + i);
+        m_handle.push_back(firstNode.index + i);
+    }
+    if(!IsDepthFirst(nodes.count, nodes.parent)){
+        m_sorted = false;
+    }
+    m_rangesValid = false;
+    return firstNode;
+}
+
+bool TransformHierarchy::IsDepthFirst(uint32_t count, const uint32_t* parent){
+    // The nodes from the last node up to its root
+    std::vector<uint32_t> ancestors;
+    for(uint32_t i=0; i < count; ++i){
+        if(parent[i] == NO_PARENT){
+            ancestors.clear();
+        }else{
+            while(!ancestors.empty() && ancestors.back() != parent[i]){
+                ancestors.pop_back();
+            }
+            if(ancestors.empty()){
+                return false;
+            }
+        }
+        ancestors.push_back(i);
+    }
+    return true;
+}
+
+void TransformHierarchy::SetParent(TransformHandle node, TransformHandle parent){
+    uint32_t slot = Slot(node);
+    m_parent[slot] = parent.IsValid() ? Slot(parent) : NONE;
+    m_dirty[slot] = 1;
+    m_sorted = false;
+    m_rangesValid = false;
+}
+
+TransformHandle TransformHierarchy::GetParent(TransformHandle node) const{
+    TransformHandle parent;
+    uint32_t parentSlot = m_parent[Slot(node)];
+    if(parentSlot != NONE){
+        parent.index = m_handle[parentSlot];
+    }
+    return parent;
+}
+
+void TransformHierarchy::SetPosition(TransformHandle node, const glm::vec3& position){
+    uint32_t slot = Slot(node);
+    m_position[slot] = position;
+    m_dirty[slot] = 1;
+}
+
+void TransformHierarchy::SetRotation(TransformHandle node, const glm::quat& rotation){
+    uint32_t slot = Slot(node);
+    m_rotation[slot] = rotation;
+    m_dirty[slot] = 1;
+}
+
+void TransformHierarchy::SetScale(TransformHandle node, const glm::vec3& scale){
+    uint32_t slot = Slot(node);
+    m_scale[slot] = scale;
+    m_dirty[slot] = 1;
+}
+
+const glm::vec3& TransformHierarchy::GetPosition(TransformHandle node) const{
+    return m_position[Slot(node)];
+}
+
+const glm::quat& TransformHierarchy::GetRotation(TransformHandle node) const{
+    return m_rotation[Slot(node)];
+}
+
+const glm::vec3& TransformHierarchy::GetScale(TransformHandle node) const{
+    return m_scale[Slot(node)];
+}
+
+const glm::mat4& TransformHierarchy::GetWorldMatrix(TransformHandle node) const{
+    return m_world[Slot(node)];
+}
+
+void TransformHierarchy::SetBounds(TransformHandle node, const Bounds& bounds){
+    uint32_t slot = Slot(node);
+    if(bounds.IsEmpty()){
+        m_boundsCenter[slot] = glm::vec3(0.0f);
+        m_boundsExtent[slot] = glm::vec3(UNBOUNDED);
+    }else{
+        m_boundsCenter[slot] = bounds.Center();
+        m_boundsExtent[slot] = bounds.Extent();
+    }
+    m_dirty[slot] = 1;
+}
+
+void TransformHierarchy::Hide(TransformHandle node){
+    // Negative, so the box reaches away from every plane
+    uint32_t slot = Slot(node);
+    m_boundsCenter[slot] = glm::vec3(0.0f);
+    m_boundsExtent[slot] = glm::vec3(-UNBOUNDED);
+    m_dirty[slot] = 1;
+}
+
+bool TransformHierarchy::HasChildren(TransformHandle node){
+    Sort();
+    return m_subtreeSize[Slot(node)] > 1;
+}
+
+void TransformHierarchy::GetWorldBounds(TransformHandle node, glm::vec3& center, glm::vec3& extent) const{
+    uint32_t slot = Slot(node);
+    center = glm::vec3(m_worldCenter[0][slot], m_worldCenter[1][slot], m_worldCenter[2][slot]);
+    extent = glm::vec3(m_worldExtent[0][slot], m_worldExtent[1][slot], m_worldExtent[2][slot]);
+}
+
+uint32_t TransformHierarchy::Cull(const Frustum& frustum){
+    Sort();
+    return frustum.Cull(m_parent.size(), m_worldCenter[0].data(), m_worldCenter[1].data(), m_worldCenter[2].data(),
+                        m_worldExtent[0].data(), m_worldExtent[1].data(), m_worldExtent[2].data(),
+                        m_visible.data());
+}
+
+// Reorders 'values' so that values[i] becomes what was at values[order[i]]
+template<typename T>
+static void Permute(std::vector<T>& values, const std::vector<uint32_t>& order){
+    std::vector<T> sorted;
+    sorted.reserve(values.size());
+    for(uint32_t old : order){
+        sorted.push_back(values[old]);
+    }
+    values.swap(sorted);
+}
+
+void TransformHierarchy::Sort(){
+    if(m_sorted){
+        return;
+    }
+    uint32_t count = m_parent.size();
+    // The children of each slot, in slot order
+    std::vector<uint32_t> firstChild(count+1, 0);
+    for(uint32_t parent : m_parent){
+        if(parent != NONE){
+            firstChild[parent+1]++;
+        }
+    }
+    for(uint32_t i=0; i < count; ++i){
+        firstChild[i+1] += firstChild[i];
+    }
+    std::vector<uint32_t> children(firstChild[count]);
+    std::vector<uint32_t> filled(firstChild.begin(), firstChild.end()-1);
+    for(uint32_t i=0; i < count; ++i){
+        if(m_parent[i] != NONE){
+            children[filled[m_parent[i]]++] = i;
+        }
+    }
+
+    // Depth first, one root after the other
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    std::vector<uint32_t> stack;
+    for(uint32_t root=0; root < count; ++root){
+        if(m_parent[root] != NONE){
+            continue;
+        }
+        stack.push_back(root);
+        while(!stack.empty()){
+            uint32_t slot = stack.back();
+            stack.pop_back();
+            order.push_back(slot);
+            // Pushed backwards, so the first child comes out first
+            for(uint32_t child = firstChild[slot+1]; child > firstChild[slot]; --child){
+                stack.push_back(children[child-1]);
+            }
+        }
+    }
+    // Anything missing is its own ancestor
+    assert(order.size() == count && "a node is below itself");
+
+    std::vector<uint32_t> newSlot(count);
+    for(uint32_t i=0; i < count; ++i){
+        newSlot[order[i]] = i;
+    }
+    Permute(m_parent, order);
+    for(uint32_t& parent : m_parent){
+        if(parent != NONE){
+            parent = newSlot[parent];
+        }
+    }
+    Permute(m_position, order);
+    Permute(m_rotation, order);
+    Permute(m_scale, order);
+    Permute(m_world, order);
+    Permute(m_boundsCenter, order);
+    Permute(m_boundsExtent, order);
+    for(int axis=0; axis < 3; ++axis){
+        Permute(m_worldCenter[axis], order);
+        Permute(m_worldExtent[axis], order);
+    }
+    Permute(m_visible, order);
+    Permute(m_dirty, order);
+    Permute(m_handle, order);
+    for(uint32_t i=0; i < count; ++i){
+        m_slot[m_handle[i]] = i;
+    }
+    // Children come after their parents, so walking backwards adds each
+    // subtree up before its root is reached
+    m_subtreeSize.assign(count, 1);
+    for(uint32_t i=count; i-- > 0;){
+        if(m_parent[i] != NONE){
+            m_subtreeSize[m_parent[i]] += m_subtreeSize[i];
+        }
+    }
+    m_sorted = true;
+    m_rangesValid = false;
+}
+
+uint32_t TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end){
+    uint32_t updated = 0;
+    for(uint32_t i=begin; i < end; ++i){
+        uint32_t parent = m_parent[i];
+        // A moved parent moves its children too. (Its flag is cleared only
+        // once the whole update is done.)
+        if(parent != NONE && m_dirty[parent]){
+            m_dirty[i] = 1;
+        }
+        if(!m_dirty[i]){
+            continue;
+        }
+        // Scale, then rotate, then translate
+        glm::mat4 local = glm::mat4_cast(m_rotation[i]);
+        local[0] *= m_scale[i].x;
+        local[1] *= m_scale[i].y;
+        local[2] *= m_scale[i].z;
+        local[3] = glm::vec4(m_position[i], 1.0f);
+        const glm::mat4& world = m_world[i] = parent != NONE ? m_world[parent] * local : local;
+        // The box around the moved box (Arvo): its center moves with the
+        // node, and each axis of the new box reaches as far as the
+        // rotated and scaled axes of the old one together
+        glm::vec3 center = glm::vec3(world * glm::vec4(m_boundsCenter[i], 1.0f));
+        const glm::vec3& extent = m_boundsExtent[i];
+        for(int axis=0; axis < 3; ++axis){
+            m_worldCenter[axis][i] = center[axis];
+            m_worldExtent[axis][i] = std::abs(world[0][axis])*extent.x + std::abs(world[1][axis])*extent.y +
+                                     std::abs(world[2][axis])*extent.z;
+        }
+        ++updated;
+    }
+    return updated;
+}
+
+void TransformHierarchy::ClearRange(uint32_t begin, uint32_t end){
+    for(uint32_t i=begin; i < end; ++i){
+        m_dirty[i] = 0;
+    }
+}
+
+void TransformHierarchy::Update(){
+    Sort();
+    m_updated = UpdateRange(0, m_parent.size());
+    ClearRange(0, m_parent.size());
+}
+
+void TransformHierarchy::BuildRanges(){
+    m_serial.clear();
+    m_ranges.clear();
+    uint32_t count = m_parent.size();
+    uint32_t i = 0;
+    while(i < count){
+        uint32_t size = m_subtreeSize[i];
+        if(size > m_jobSize){
+            // Too big for one job: update this node first, and split up
+            // the subtrees below it
+            m_serial.push_back(i);
+            ++i;
+            continue;
+        }
+        // Small neighbouring subtrees (e.g. leaves) share a job
+        if(!m_ranges.empty() && m_ranges.back().second == i &&
+           m_ranges.back().second - m_ranges.back().first + size <= m_jobSize){
+            m_ranges.back().second += size;
+        }else{
+            m_ranges.push_back({i, i+size});
+        }
+        i += size;
+    }
+    m_rangesValid = true;
+}
+
+void TransformHierarchy::UpdateParallel(){
+    Sort();
+    if(!m_rangesValid){
+        BuildRanges();
+    }
+    if(m_ranges.size() < 2){
+        Update();
+        return;
+    }
+    // The nodes above the subtrees, in order, so each one's parent is
+    // ready before it
+    uint32_t updated = 0;
+    for(uint32_t slot : m_serial){
+        updated += UpdateRange(slot, slot+1);
+    }
+    // The subtrees only read their own nodes and those serial ones
+    std::atomic<uint32_t> updatedByJobs{0};
+    std::vector<JobHandle> jobs;
+    jobs.reserve(m_ranges.size());
+    for(const std::pair<uint32_t,uint32_t>& range : m_ranges){
+        jobs.push_back(JobSystem::Instance().Submit([this, range, &updatedByJobs](){
+            updatedByJobs += UpdateRange(range.first, range.second);
+            ClearRange(range.first, range.second);
+        }));
+    }
+    for(const JobHandle& job : jobs){
+        JobSystem::Instance().Wait(job);
+    }
+    for(uint32_t slot : m_serial){
+        m_dirty[slot] = 0;
+    }
+    m_updated = updated + updatedByJobs.load();
+}
@@ -0,0 +1,50 @@
+#include "UniformBuffer.hpp"
+#include "GLState.hpp"
+
+#include <iostream>
+
+bool GetUniformBlock(const std::string& name, GLuint& binding, GLint& size){
+    if(name == "FrameData"){
+        binding = FRAME_DATA_BINDING;
+        size = sizeof(FrameData);
+        return true;
+    }
+    if(name == "LightData"){
+        binding = LIGHT_DATA_BINDING;
+        size = sizeof(LightData);
+        return true;
+    }
+    if(name == "ObjectData"){
+        binding = OBJECT_DATA_BINDING;
+        size = sizeof(ObjectData);
+        return true;
+    }
+    return false;
+}
+
+UniformBuffer::UniformBuffer(GLuint binding, GLsizeiptr size) : m_binding(binding), m_size(size){
+    glGenBuffers(1, &m_bufferID);
+    GLState::Instance().BindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    // The buffer stays attached to its binding point, so every shader
+    // using the block sees it without any further calls
+    GLState::Instance().BindBufferBase(GL_UNIFORM_BUFFER, binding, m_bufferID);
+}
+
+UniformBuffer::~UniformBuffer(){
+    GLState::Instance().ForgetBuffer(m_bufferID);
+    glDeleteBuffers(1, &m_bufferID);
+}
+
+void UniformBuffer::Update(const void* data, GLsizeiptr size){
+    if(size != m_size){
+        std::cout << "UniformBuffer: expected " << m_size << " bytes for binding " << m_binding
+                  << ", not " << size << std::endl;
+        return;
+    }
+    GLState::Instance().BindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+    // Replacing the whole buffer (rather than glBufferSubData) lets the
+    // driver hand us fresh memory if the GPU is still reading last frame's
+    // data, instead of waiting for it
+    glBufferData(GL_UNIFORM_BUFFER, size, data, GL_STREAM_DRAW);
+}
@@ -0,0 +1,41 @@
+#include "UploadQueue.hpp"
+
+#include <chrono>
+
+void UploadQueue::Push(std::function<void()> upload){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_uploads.push_back(std::move(upload));
+}
+
+unsigned int UploadQueue::Execute(double budgetMilliseconds){
+    auto start = std::chrono::steady_clock::now();
+    unsigned int count = 0;
+    while(true){
+        std::function<void()> upload;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_uploads.empty()){
+                break;
+            }
+            upload = std::move(m_uploads.front());
+            m_uploads.pop_front();
+        }
+        // Run without holding the lock, so workers can keep pushing
+        upload();
+        ++count;
+        double elapsed = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+        if(elapsed >= budgetMilliseconds){
+            break;
+        }
+    }
+    return count;
+}
+
+unsigned int UploadQueue::ExecuteAll(){
+    return Execute(1e30);
+}
+
+unsigned int UploadQueue::GetPendingCount() const{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_uploads.size();
+}
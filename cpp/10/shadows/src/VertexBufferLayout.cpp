@@ -1,4 +1,5 @@
 #include "VertexBufferLayout.hpp"
+#include "GLState.hpp"
 #include <iostream>
 
 
@@ -8,29 +9,29 @@ VertexBufferLayout::VertexBufferLayout(){
 VertexBufferLayout::~VertexBufferLayout(){
     // Delete our buffers that we have previously allocated
     // http://docs.gl/gl3/glDeleteBuffers
+    GLState::Instance().ForgetBuffer(m_vertexPositionBuffer);
+    GLState::Instance().ForgetBuffer(m_indexBufferObject);
     glDeleteBuffers(1,&m_vertexPositionBuffer);
     glDeleteBuffers(1,&m_indexBufferObject);
 }
 
 
 void VertexBufferLayout::Bind(){
-    // Bind to our vertex array
-    glBindVertexArray(m_VAOId);
-    // Bind to our vertex information
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
-    // Bind to the elements we are drawing
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+    // Bind to our vertex array. That is all drawing needs: the vertex
+    // array remembers our vertex information, and the elements we are
+    // drawing.
+    GLState::Instance().BindVertexArray(m_VAOId);
 }
 
 // Note: Calling Unbind is rarely done, if you need
 // to draw something else then just bind to new buffer.
 void VertexBufferLayout::Unbind(){
         // Bind to our vertex array
-        glBindVertexArray(0);
+        GLState::Instance().BindVertexArray(0);
         // Bind to our vertex information
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, 0);
         // Bind to the elements we are drawing
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 
@@ -44,7 +45,7 @@ void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount,unsigned
         // VertexArrays
         glGenVertexArrays(1, &m_VAOId);
 
-        glBindVertexArray(m_VAOId);
+        GLState::Instance().BindVertexArray(m_VAOId);
 
         // Vertex Buffer Object (VBO)
         // Create a buffer (note we’ll see this pattern of code often in OpenGL)
@@ -55,7 +56,7 @@ void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount,unsigned
                                                 // use our selected(or binded)
                                                 //  buffer with the arguments passed 
                                                 // into the function.
-        glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
         glBufferData(GL_ARRAY_BUFFER, vcount*sizeof(float), vdata, GL_STATIC_DRAW);
 
         glEnableVertexAttribArray(0);
@@ -96,7 +97,7 @@ void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount,unsigned
         static_assert(sizeof(unsigned int)==sizeof(GLuint),"Gluint not same size!");
 
         glGenBuffers(1, &m_indexBufferObject);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+        GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount*sizeof(unsigned int), idata,GL_STATIC_DRAW);
     }
 
@@ -111,7 +112,7 @@ void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount,unsigned
         // VertexArrays
         glGenVertexArrays(1, &m_VAOId);
 
-        glBindVertexArray(m_VAOId);
+        GLState::Instance().BindVertexArray(m_VAOId);
 
         // Vertex VertexBufferLayout Object (VBO)
         // Create a buffer (note we’ll see this pattern of code often in OpenGL)
@@ -122,7 +123,7 @@ void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount,unsigned
                                                 // use our selected(or binded)
                                                 //  buffer with the arguments passed 
                                                 // into the function.
-        glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
         glBufferData(GL_ARRAY_BUFFER, vcount*sizeof(float), vdata, GL_STATIC_DRAW);
 
         glEnableVertexAttribArray(0);
@@ -172,7 +173,7 @@ void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount,unsigned
         static_assert(sizeof(unsigned int)==sizeof(GLuint),"Gluint not same size!");
 
         glGenBuffers(1, &m_indexBufferObject);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+        GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount*sizeof(unsigned int), idata,GL_STATIC_DRAW);
     }
 
@@ -193,7 +194,7 @@ void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount,unsigned i
         // VertexArrays
         glGenVertexArrays(1, &m_VAOId);
 
-        glBindVertexArray(m_VAOId);
+        GLState::Instance().BindVertexArray(m_VAOId);
 
         // Vertex Buffer Object (VBO)
         // Create a buffer (note we’ll see this pattern of code often in OpenGL)
@@ -204,7 +205,7 @@ void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount,unsigned i
                                                 // use our selected(or binded)
                                                 //  buffer with the arguments passed 
                                                 // into the function.
-        glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
         glBufferData(GL_ARRAY_BUFFER, vcount*sizeof(float), vdata, GL_STATIC_DRAW);
 
         glEnableVertexAttribArray(0);
@@ -262,6 +263,6 @@ void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount,unsigned i
 
 		// Setup an index buffer
         glGenBuffers(1, &m_indexBufferObject);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+        GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount*sizeof(unsigned int), idata,GL_STATIC_DRAW);
     }
@@ -0,0 +1,88 @@
+#include "VirtualFileSystem.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+
+VirtualFileSystem::VirtualFileSystem(){
+}
+
+VirtualFileSystem::~VirtualFileSystem(){
+}
+
+bool VirtualFileSystem::Mount(const std::string& archivePath, const std::string& root){
+	Unmount();
+	std::unique_ptr<Archive> archive = std::make_unique<Archive>();
+	if(!archive->Open(archivePath)){
+		return false;
+	}
+	m_archive = std::move(archive);
+	m_root = std::filesystem::absolute(root).lexically_normal().generic_string();
+	std::cout << "VirtualFileSystem: mounted " << archivePath << " ("
+	          << m_archive->GetEntryCount() << " files)" << std::endl;
+
+	// Send the .obj and .mtl loaders (MappedFile) through the archive too.
+	// Archive data is only unmapped by Unmount, which clears the hook first.
+	MappedFile::SetOpenHook([this](const std::string& filename, std::vector<char>& storage,
+	                               const char*& data, std::size_t& size){
+		return ReadFromArchive(filename, storage, data, size);
+	});
+	return true;
+}
+
+void VirtualFileSystem::Unmount(){
+	MappedFile::SetOpenHook(nullptr);
+	m_archive.reset();
+	m_root.clear();
+}
+
+std::string VirtualFileSystem::ArchivePath(const std::string& path) const{
+	if(m_root.empty()){
+		return "";
+	}
+	std::filesystem::path relative = std::filesystem::absolute(path).lexically_normal().lexically_relative(m_root);
+	std::string name = relative.generic_string();
+	// Outside of the root folder
+	if(name.empty() || name.compare(0, 2, "..") == 0){
+		return "";
+	}
+	return name;
+}
+
+bool VirtualFileSystem::ReadFromArchive(const std::string& path, std::vector<char>& storage,
+                                        const char*& data, std::size_t& size) const{
+	if(m_archive == nullptr){
+		return false;
+	}
+	const ArchiveEntry* entry = m_archive->Find(ArchivePath(path));
+	return entry != nullptr && m_archive->Read(*entry, storage, data, size);
+}
+
+bool VirtualFileSystem::ReadFile(const std::string& path, std::vector<char>& storage,
+                                 const char*& data, std::size_t& size) const{
+	if(ReadFromArchive(path, storage, data, size)){
+		return true;
+	}
+	// Not packed, so try the disk
+	std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+	if(!file.is_open()){
+		return false;
+	}
+	storage.resize((std::size_t)file.tellg());
+	file.seekg(0);
+	file.read(storage.data(), storage.size());
+	data = storage.data();
+	size = storage.size();
+	return true;
+}
+
+bool VirtualFileSystem::ReadFile(const std::string& path, std::string& contents) const{
+	std::vector<char> storage;
+	const char* data = nullptr;
+	std::size_t size = 0;
+	if(!ReadFile(path, storage, data, size)){
+		return false;
+	}
+	contents.assign(data, size);
+	return true;
+}
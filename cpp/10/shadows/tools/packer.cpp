@@ -0,0 +1,100 @@
+// Packs files into a single archive that the program can read its assets
+// from (see include/Archive.hpp and include/VirtualFileSystem.hpp).
+//
+// Usage:
+//      ./bin/packer <archive> <root> <file or folder>... [--compress]
+//
+// Paths are stored relative to <root>, so they match what the program asks
+// for. To pack everything the shadows sample uses (run from cpp/10/shadows):
+//
+//      ./bin/packer ./assets/assets.pack ./../../ ./../../common/objects ./../../common/textures ./shaders --compress
+#include "Archive.hpp"
+#include "mappedfile.hpp"
+
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv){
+    std::vector<std::string> arguments;
+    bool compress = false;
+    for(int i=1; i < argc; ++i){
+        std::string argument = argv[i];
+        if(argument == "--compress"){
+            compress = true;
+        }else{
+            arguments.push_back(argument);
+        }
+    }
+    if(arguments.size() < 3){
+        std::cout << "usage: packer <archive> <root> <file or folder>... [--compress]" << std::endl;
+        return 1;
+    }
+    const std::string output = arguments[0];
+    const fs::path root = fs::absolute(arguments[1]).lexically_normal();
+    const fs::path outputPath = fs::absolute(output).lexically_normal();
+
+    // Find every file. Sorted, so packing the same files twice gives the same archive.
+    std::vector<fs::path> files;
+    for(std::size_t i=2; i < arguments.size(); ++i){
+        fs::path path = fs::absolute(arguments[i]).lexically_normal();
+        if(fs::is_directory(path)){
+            for(const fs::directory_entry& entry : fs::recursive_directory_iterator(path)){
+                if(entry.is_regular_file()){
+                    files.push_back(entry.path().lexically_normal());
+                }
+            }
+        }else if(fs::is_regular_file(path)){
+            files.push_back(path);
+        }else{
+            std::cout << "packer: " << arguments[i] << " does not exist" << std::endl;
+            return 1;
+        }
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+
+    auto start = std::chrono::steady_clock::now();
+    ArchiveWriter writer;
+    if(!writer.Begin(output)){
+        return 1;
+    }
+    unsigned int count = 0;
+    for(const fs::path& path : files){
+        if(path == outputPath){
+            continue; // Do not pack the archive into itself
+        }
+        std::string name = path.lexically_relative(root).generic_string();
+        if(name.empty() || name.compare(0, 2, "..") == 0){
+            std::cout << "packer: " << path.string() << " is not inside " << root.string() << std::endl;
+            return 1;
+        }
+        MappedFile file;
+        if(!file.Open(path.string())){
+            std::cout << "packer: unable to read " << path.string() << std::endl;
+            return 1;
+        }
+        if(!writer.AddFile(name, file.Data(), file.Size(), compress)){
+            return 1;
+        }
+        ++count;
+    }
+    if(!writer.Finish()){
+        return 1;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+
+    std::cout << "Packed " << count << " files into " << output << " in " << ms << " ms" << std::endl;
+    std::cout << "\t" << writer.GetTotalSize()/1024 << " KB of files, "
+              << writer.GetStoredSize()/1024 << " KB stored";
+    if(writer.GetTotalSize() > 0){
+        std::cout << " (" << 100.0*writer.GetStoredSize()/writer.GetTotalSize() << "%)";
+    }
+    std::cout << std::endl;
+    return 0;
+}